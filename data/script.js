@@ -19,6 +19,7 @@ let movementState = 'IDLE';
 let isConnected = false;
 let presets = [];
 let systemConfig = {};
+let calibrationJobId = null;
 
 // DOM Elements (cached on load)
 let elements = {};
@@ -200,6 +201,16 @@ function connectSSE() {
         }
     });
     
+    // Calibration job progress events
+    eventSource.addEventListener('calibration_progress', (e) => {
+        try {
+            const data = JSON.parse(e.data);
+            handleCalibrationProgress(data);
+        } catch (err) {
+            console.error('Failed to parse calibration_progress:', err);
+        }
+    });
+    
     // WiFi status events
     eventSource.addEventListener('wifi_status', (e) => {
         try {
@@ -327,6 +338,26 @@ function handlePresetUpdated(data) {
     showToast(`Preset ${data.slot} updated`, 'success');
 }
 
+/**
+ * Handle calibration job progress events from SSE
+ */
+function handleCalibrationProgress(data) {
+    if (data.jobId !== calibrationJobId) return;
+    
+    if (data.state === 'running') {
+        elements.calibrationStatus.textContent =
+            `Calibrating... ${data.samples} samples, ±${data.stdErrorMm.toFixed(2)} mm`;
+    } else if (data.state === 'succeeded') {
+        calibrationJobId = null;
+        showToast(`Calibration successful (${data.samples} samples)`, 'success');
+        fetchConfig();
+    } else if (data.state === 'failed') {
+        calibrationJobId = null;
+        showToast(data.message || 'Calibration failed', 'error');
+        fetchConfig();
+    }
+}
+
 /**
  * Handle WiFi status events from SSE
  */
@@ -414,9 +445,9 @@ async function fetchConfig() {
         }
         
         // Update calibration status
-        if (systemConfig.calibration_constant !== undefined) {
+        if (systemConfig.calibrationOffsetMm !== undefined) {
             elements.calibrationStatus.textContent = 
-                `Current calibration constant: ${systemConfig.calibration_constant} cm`;
+                `Current calibration offset: ${systemConfig.calibrationOffsetMm} mm`;
         }
     } catch (err) {
         console.error('Failed to fetch config:', err);
@@ -572,13 +603,14 @@ async function sendCalibration(knownHeight) {
             body: JSON.stringify({ height: knownHeight }),
         });
         
+        const data = await response.json();
         if (!response.ok) {
-            const data = await response.json();
-            throw new Error(data.error || 'Calibration failed');
+            throw new Error(data.message || 'Calibration failed');
         }
         
-        showToast('Calibration successful', 'success');
-        fetchConfig();
+        // Runs in the background; progress arrives as calibration_progress events
+        calibrationJobId = data.jobId;
+        elements.calibrationStatus.textContent = 'Calibrating... keep the desk still';
     } catch (err) {
         console.error('Calibration failed:', err);
         showToast(err.message, 'error');
@@ -693,7 +725,7 @@ function updatePresetConfigForm() {
         item.innerHTML = `
             <span>Slot ${slot}:</span>
             <input type="text" placeholder="Name" value="${preset.name || ''}" data-slot="${slot}" data-field="name">
-            <input type="number" placeholder="Height" value="${preset.height_cm || ''}" min="50" max="125" data-slot="${slot}" data-field="height">
+            <input type="number" placeholder="Height" value="${preset.height_cm || ''}" min="50" max="125" step="0.1" data-slot="${slot}" data-field="height">
             <span>cm</span>
             <button type="button" class="btn btn-primary btn-save-preset" data-slot="${slot}">Save</button>
         `;
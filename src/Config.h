@@ -25,6 +25,13 @@
 constexpr uint8_t PIN_I2C_SDA = 21;
 constexpr uint8_t PIN_I2C_SCL = 22;
 
+/**
+ * VL53L5CX INT (data-ready) pin
+ * Open-drain, active low: the sensor pulls it low when a new frame is ready.
+ * Requires a pull-up (internal pull-up is enabled in firmware).
+ */
+constexpr uint8_t PIN_SENSOR_INT = 4;
+
 /**
  * MOSFET control pins for desk motor
  * These pins control N-channel MOSFETs that switch the motor power
@@ -34,6 +41,16 @@ constexpr uint8_t PIN_I2C_SCL = 22;
 constexpr uint8_t PIN_MOTOR_UP = 25;
 constexpr uint8_t PIN_MOTOR_DOWN = 26;
 
+/**
+ * LEDC PWM on the motor pins (DriveMode::PWM)
+ * One channel per pin; 20 kHz is above hearing, and 10 bits fits under
+ * the 80 MHz APB clock at that frequency (4000 counts)
+ */
+constexpr uint8_t MOTOR_PWM_CHANNEL_UP = 0;
+constexpr uint8_t MOTOR_PWM_CHANNEL_DOWN = 1;
+constexpr uint32_t MOTOR_PWM_FREQUENCY_HZ = 20000;
+constexpr uint8_t MOTOR_PWM_RESOLUTION_BITS = 10;
+
 // =============================================================================
 // VL53L5CX Sensor Configuration
 // =============================================================================
@@ -48,22 +65,159 @@ constexpr uint8_t VL53L5CX_I2C_ADDRESS = 0x29;
  */
 constexpr uint32_t I2C_FREQUENCY = 400000;
 
+/**
+ * I2C clock for the VL53L5CX firmware upload in sensor_.begin() (~84 KB,
+ * the longest step of boot). 1 MHz Fast-mode Plus cuts it to well under
+ * half; if bring-up fails at this speed (long wires, weak pull-ups) it is
+ * retried at I2C_FREQUENCY. Ranging always runs at I2C_FREQUENCY.
+ */
+constexpr uint32_t I2C_FIRMWARE_UPLOAD_FREQUENCY = 1000000;
+
+/**
+ * Sensor readout profile (compile-time, see utils/SensorReadout.h)
+ * platformio.ini disables unused ULD outputs with VL53L5CX_DISABLE_*
+ * flags. The default lean profile keeps sigma/signal/ambient for the
+ * confidence-weighted consensus; esp32dev_minimal_readout also drops
+ * them and reads only distance and target status.
+ */
+#if defined(VL53L5CX_DISABLE_RANGE_SIGMA_MM) || \
+    defined(VL53L5CX_DISABLE_SIGNAL_PER_SPAD) || \
+    defined(VL53L5CX_DISABLE_AMBIENT_PER_SPAD)
+#define SENSOR_READOUT_HAS_CONFIDENCE 0
+#else
+#define SENSOR_READOUT_HAS_CONFIDENCE 1
+#endif
+
 /**
  * Sensor sampling interval in milliseconds
  * 200ms = 5 Hz sampling rate per PERF-002
  */
 constexpr uint16_t SENSOR_SAMPLE_INTERVAL_MS = 200;
 
+/**
+ * Sensor acquisition mode
+ * true  = dedicated FreeRTOS task woken by the INT pin data-ready edge;
+ *         frames are processed and published within a few milliseconds
+ * false = loop() polls isDataReady() every SENSOR_SAMPLE_INTERVAL_MS;
+ *         a frame can wait up to one full interval before it is read
+ */
+constexpr bool SENSOR_USE_DATA_READY_INTERRUPT = true;
+
+/**
+ * Ranging frequencies per movement activity (see HeightController::RangingProfile)
+ * Idle desk: 1 Hz keeps the reading fresh with minimal I2C/CPU load.
+ * Moving/stabilizing desk: 15 Hz so the desk stops close to target
+ * (15 Hz is also the 8x8 resolution maximum).
+ */
+constexpr uint8_t RANGING_FREQUENCY_IDLE_HZ = 1;
+constexpr uint8_t RANGING_FREQUENCY_ACTIVE_HZ = 15;
+
+/**
+ * Ranging frequency the configured filter window is expressed in
+ * (5 Hz = SENSOR_SAMPLE_INTERVAL_MS). The window is rescaled by
+ * active_hz / reference_hz so the filter time constant stays the same.
+ */
+constexpr uint8_t RANGING_FREQUENCY_REFERENCE_HZ = 5;
+
+/**
+ * Acquisition task settings (interrupt mode only)
+ * The results buffer is a HeightController member, so the stack only
+ * holds consensus scratch arrays and logging buffers.
+ * Priority is above loop() (1) so a frame is never queued behind WiFi work.
+ */
+constexpr uint32_t SENSOR_TASK_STACK_SIZE = 6144;
+constexpr uint8_t SENSOR_TASK_PRIORITY = 3;
+constexpr uint8_t SENSOR_TASK_CORE = 1;
+
+/**
+ * Control task settings (see ControlTask.h)
+ * HeightController::update() and MovementController::update() run every
+ * CONTROL_PERIOD_MS on a vTaskDelayUntil schedule, on the APP core next
+ * to the acquisition task and above it in priority, so a published frame
+ * is acted on within one period. loop(), AsyncTCP and the WiFi events run
+ * on the PRO core (ARDUINO_RUNNING_CORE=0 etc. in platformio.ini), so web
+ * traffic never competes with the control loop for its core.
+ *
+ * Core 1 is shared with the acquisition task on purpose. The only other
+ * core runs WiFi and lwIP at priorities 18-23, so either task would get
+ * their jitter there. A pass without a new frame is tens of microseconds,
+ * so it preempts acquisition only briefly, and the I2C transfers are
+ * interrupt driven. The period is one FreeRTOS tick (CONFIG_FREERTOS_HZ
+ * 1000), the finest vTaskDelayUntil can schedule; it keeps the obstruction
+ * frame to motor-off latency under 1 ms (asserted in the desk simulator).
+ * Not yet measured on hardware: GET /control under web load gives the
+ * p99/max jitter and the longest pass.
+ */
+constexpr uint32_t CONTROL_TASK_STACK_SIZE = 4096;
+constexpr uint8_t CONTROL_TASK_PRIORITY = 5;
+constexpr uint8_t CONTROL_TASK_CORE = 1;
+constexpr uint16_t CONTROL_PERIOD_MS = 1;
+
+/**
+ * Longest MovementController::update() spins for a lock held by a web
+ * call before skipping the pass. Web calls hold it for microseconds, so
+ * a skip (and the safety checks it misses) means something is wrong;
+ * GET /control counts them as skippedPasses.
+ */
+constexpr uint16_t MOVEMENT_LOCK_WAIT_US = 200;
+
+/**
+ * Control period jitter histogram (see utils/PeriodJitter.h)
+ * Jitter |period - CONTROL_PERIOD_MS| in CONTROL_JITTER_BIN_US bins; the
+ * last bin is open-ended, so the p99 resolves up to 2 ms
+ */
+constexpr uint16_t CONTROL_JITTER_BIN_US = 50;
+constexpr uint8_t CONTROL_JITTER_BINS = 41;
+
+/**
+ * Movement status changes queued from the control task for loop() to
+ * publish over SSE (messages longer than this are truncated)
+ */
+constexpr uint8_t STATUS_EVENT_QUEUE_LENGTH = 8;
+constexpr uint8_t STATUS_EVENT_MESSAGE_MAX = 80;
+
+/**
+ * Log lines from other tasks queued for loop() to print (see Logger.h)
+ * Serial.printf blocks once the UART FIFO is full, so only the loop task
+ * writes to Serial. Longer messages are truncated; a full queue drops
+ * the line and the count is logged.
+ */
+constexpr uint8_t LOG_QUEUE_LENGTH = 16;
+constexpr uint8_t LOG_QUEUE_MESSAGE_MAX = 120;
+
+/**
+ * Sensor supervisor (see utils/SensorSupervisor.h)
+ * A frame is overdue after one frame period plus the margin; that many
+ * consecutive failed reads also count as a fault.
+ */
+constexpr uint16_t SENSOR_STARVATION_MARGIN_MS = 250;
+constexpr uint8_t SENSOR_MAX_CONSECUTIVE_ERRORS = 3;
+
+/**
+ * Time a recovery step gets to produce a frame before the next step.
+ * Recovery ranges at the active rate (~67 ms per frame). The sensor reset
+ * step includes the firmware upload and backs off (doubling) while it
+ * keeps failing, e.g. with the sensor unplugged.
+ */
+constexpr uint32_t SENSOR_RECOVERY_STEP_WAIT_MS = 200;
+constexpr uint32_t SENSOR_RECOVERY_RESET_WAIT_MS = 2000;
+constexpr uint32_t SENSOR_RECOVERY_MAX_BACKOFF_MS = 30000;
+
+/**
+ * SCL pulses to free a slave holding SDA low mid-transfer (8 data bits + ACK)
+ */
+constexpr uint8_t I2C_RECOVERY_CLOCK_PULSES = 9;
+
 // =============================================================================
 // Height Calculation Defaults
 // =============================================================================
 
 /**
- * Default calibration constant in centimeters
- * Formula: height_cm = calibration_constant_cm - (sensor_reading_mm / 10)
+ * Default calibration offset in millimeters
+ * Formula: height_mm = calibration_offset_mm + sensor_reading_mm
  * Value 0 indicates uncalibrated system - calibration required before use
  */
-constexpr uint16_t DEFAULT_CALIBRATION_CONSTANT_CM = 0;
+constexpr int16_t DEFAULT_CALIBRATION_OFFSET_MM = 0;
 
 /**
  * Minimum allowed target height in centimeters (per FR-014)
@@ -81,6 +235,29 @@ constexpr uint16_t DEFAULT_MAX_HEIGHT_CM = 125;
  */
 constexpr uint16_t DEFAULT_TOLERANCE_MM = 10;
 
+/**
+ * Calibration job sampling (POST /calibrate)
+ * Consensus distances are averaged until the standard error of the mean
+ * drops below the target, but never fewer than MIN or more than MAX
+ * samples. The sensor ranges at the active rate while a job runs.
+ */
+constexpr uint16_t CALIBRATION_MIN_SAMPLES = 10;
+constexpr uint16_t CALIBRATION_MAX_SAMPLES = 150;
+constexpr float CALIBRATION_TARGET_STDERR_MM = 0.5f;
+
+/**
+ * A job that reaches CALIBRATION_MAX_SAMPLES without converging still
+ * succeeds if its standard error is within this bound (desk vibrating
+ * slightly); above it the desk is assumed to be moving and the job fails.
+ */
+constexpr float CALIBRATION_ACCEPT_STDERR_MM = 2.0f;
+
+/**
+ * Calibration job fails if it has not finished within this time
+ * (too few reliable consensus frames)
+ */
+constexpr unsigned long CALIBRATION_TIMEOUT_MS = 20000;
+
 // =============================================================================
 // Movement Control Defaults
 // =============================================================================
@@ -99,6 +276,99 @@ constexpr uint16_t DEFAULT_STABILIZATION_DURATION_MS = 2000;
  */
 constexpr uint16_t DEFAULT_MOVEMENT_TIMEOUT_MS = 30000;
 
+/**
+ * Motor cut-off rule (runtime selectable, persisted in NVS)
+ * 0 = tolerance: motor runs until the reading is within tolerance (original behaviour)
+ * 1 = predictive: motor is cut the learned stop distance ahead of the target
+ */
+constexpr uint8_t DEFAULT_STOP_MODE = 1;
+
+/**
+ * Initial stop distances in mm, learned per direction and persisted in NVS
+ * How far the reading still moves after the motor is cut: filter lag,
+ * motor response and coast (~20-25 mm on a 35-40 mm/s desk with the
+ * default moving average)
+ */
+constexpr uint16_t DEFAULT_STOP_DISTANCE_UP_MM = 20;
+constexpr uint16_t DEFAULT_STOP_DISTANCE_DOWN_MM = 20;
+constexpr uint16_t MAX_STOP_DISTANCE_MM = 60;
+
+/**
+ * Share of a move's stop error applied to the stop distance, in percent
+ * 50 halves the error with every move and averages out the scatter of
+ * single stops
+ */
+constexpr uint8_t STOP_DISTANCE_LEARN_PERCENT = 50;
+
+/**
+ * Speed toward the target (mm/s, Kalman estimate) the desk must have
+ * before the predictive cut applies; slower starts use the tolerance rule
+ */
+constexpr uint16_t PREDICTIVE_STOP_MIN_SPEED_MM_S = 15;
+
+/**
+ * The desk is at rest after a cut once the reading has stayed within
+ * STOP_REST_BAND_MM for STOP_REST_MS
+ * Judged on the reading rather than the velocity estimate, which rings
+ * for over a second after a hard stop
+ */
+constexpr uint16_t STOP_REST_BAND_MM = 2;
+constexpr uint16_t STOP_REST_MS = 300;
+
+/**
+ * Longest wait for the desk to come to rest after a predictive cut
+ */
+constexpr uint16_t STOP_SETTLE_TIMEOUT_MS = 2500;
+
+/**
+ * Motor drive (runtime selectable, persisted in NVS, applied at the next move)
+ * 0 = switched: motor pins fully on or off with digitalWrite (original behaviour)
+ * 1 = PWM: LEDC duty with soft start, approach slow-down and soft stop
+ *     (see utils/MotorRamp.h); faults and emergency stop still cut at once
+ */
+constexpr uint8_t DEFAULT_DRIVE_MODE = 0;
+
+/**
+ * PWM ramp times in milliseconds, zero to full duty and back
+ * Capped so a soft stop ends inside MOTION_STOP_GRACE_MS and a soft start
+ * is at full duty before MOTION_START_GRACE_MS
+ */
+constexpr uint16_t DEFAULT_RAMP_UP_MS = 400;
+constexpr uint16_t DEFAULT_RAMP_DOWN_MS = 250;
+constexpr uint16_t MAX_RAMP_MS = 800;
+
+/**
+ * Distance before the cut point in mm at which the PWM duty starts scaling down
+ * (0 = no slow-down)
+ */
+constexpr uint16_t DEFAULT_SLOWDOWN_DISTANCE_MM = 50;
+constexpr uint16_t MAX_SLOWDOWN_DISTANCE_MM = 200;
+
+/**
+ * Lowest PWM duty in percent: the motor stalls under load below it
+ * Also the approach speed at the cut (about 21-24 mm/s on a 35-40 mm/s
+ * desk), which keeps the desk above the stall and predictive stop speeds
+ */
+constexpr uint8_t MOTOR_MIN_DUTY_PERCENT = 60;
+
+/**
+ * Time both PWM channels stay at zero when the motor reverses
+ * The LEDC applies a duty at the end of a PWM period (50 us), so the old
+ * channel's zero has long taken effect; the desk controller responds in
+ * about 50 ms and coasts to a stop from full speed in about 130 ms
+ * (300 mm/s^2), so the new direction starts from standstill. With the
+ * longest ramp the soft start still reaches full duty inside
+ * MOTION_START_GRACE_MS, which runs from the reversal.
+ */
+constexpr uint16_t MOTOR_REVERSE_REST_MS = 200;
+
+/**
+ * Distance before the cut the PWM slow-down reaches the minimum duty
+ * The desk is then cut at a steady speed, so the reading lags it by the
+ * same amount every time and the learned stop distance holds
+ */
+constexpr uint16_t MOTOR_CRAWL_DISTANCE_MM = 15;
+
 // =============================================================================
 // Sensor Filtering Defaults
 // =============================================================================
@@ -120,6 +390,66 @@ constexpr uint8_t MAX_FILTER_WINDOW_SIZE = 10;
  */
 constexpr uint8_t MIN_FILTER_WINDOW_SIZE = 3;
 
+/**
+ * Largest window after rescaling to the active ranging frequency
+ * (MAX_FILTER_WINDOW_SIZE samples at the reference rate)
+ */
+constexpr uint8_t MAX_SCALED_FILTER_WINDOW_SIZE =
+    MAX_FILTER_WINDOW_SIZE * RANGING_FREQUENCY_ACTIVE_HZ / RANGING_FREQUENCY_REFERENCE_HZ;
+
+/**
+ * Moving average window selection (runtime selectable, persisted in NVS)
+ * 0 = fixed: the configured filter window size (original behaviour)
+ * 1 = adaptive: sized from the measured consensus noise, within
+ *     MIN_FILTER_WINDOW_SIZE..MAX_FILTER_WINDOW_SIZE
+ */
+constexpr uint8_t DEFAULT_FILTER_WINDOW_MODE = 0;
+
+/**
+ * Residual noise (1-sigma, mm) the adaptive window aims for after averaging
+ * Window = (noise / target)^2: a clean 1.5 mm floor gets 3 samples, a
+ * 3 mm carpet gets 9
+ */
+constexpr float ADAPTIVE_WINDOW_TARGET_NOISE_MM = 1.0f;
+
+/**
+ * Frames the consensus noise estimate averages over (exponential, 1/N)
+ * 64 = ~4 s at 15 Hz, ~1 min at 1 Hz idle; the estimate then scatters by
+ * ~18% (1-sigma, in variance) on a steady floor
+ */
+constexpr uint8_t ADAPTIVE_WINDOW_NOISE_FRAMES = 64;
+
+/**
+ * Hysteresis between window sizes in percent of the noise estimate
+ * The window changes only once the noise is this far outside the range
+ * the current window is sized for; 30% keeps the estimate's own scatter
+ * (~2.5 sigma) from toggling the window
+ */
+constexpr uint8_t ADAPTIVE_WINDOW_HYSTERESIS_PERCENT = 30;
+
+/**
+ * Temporal filter stage (runtime selectable, persisted in NVS)
+ * 0 = moving average (original behaviour)
+ * 1 = constant-velocity Kalman filter (low lag while moving)
+ */
+constexpr uint8_t DEFAULT_TEMPORAL_FILTER = 0;
+
+/**
+ * Kalman process noise: 1-sigma acceleration in mm/s^2
+ * Higher = follows speed changes faster, less smoothing during maneuvers
+ */
+constexpr uint16_t DEFAULT_KALMAN_PROCESS_NOISE = 100;
+constexpr uint16_t MIN_KALMAN_PROCESS_NOISE = 1;
+constexpr uint16_t MAX_KALMAN_PROCESS_NOISE = 2000;
+
+/**
+ * Kalman measurement noise: 1-sigma of the zone consensus in mm
+ * Typical per-frame consensus sigma is 1-2 mm (see estimatedSigmaMm)
+ */
+constexpr uint16_t DEFAULT_KALMAN_MEASUREMENT_NOISE = 2;
+constexpr uint16_t MIN_KALMAN_MEASUREMENT_NOISE = 1;
+constexpr uint16_t MAX_KALMAN_MEASUREMENT_NOISE = 50;
+
 // =============================================================================
 // Multi-Zone Filtering Configuration (per 002-multi-zone-filtering feature)
 // =============================================================================
@@ -133,19 +463,144 @@ constexpr uint8_t MIN_FILTER_WINDOW_SIZE = 3;
  */
 constexpr uint16_t MULTI_ZONE_OUTLIER_THRESHOLD_MM = 30;
 
+/**
+ * Outlier threshold rule (runtime selectable, persisted in NVS)
+ * 0 = fixed MULTI_ZONE_OUTLIER_THRESHOLD_MM (original behaviour)
+ * 1 = adaptive: MULTI_ZONE_MAD_SCALE robust sigmas of the frame
+ *     (1.4826 x median absolute deviation), clamped to the configured bounds
+ */
+constexpr uint8_t DEFAULT_OUTLIER_RULE = 0;
+
+/**
+ * Robust sigmas a zone may deviate from the median (adaptive rule)
+ * 3.5 rather than the textbook 3: the MAD of 10-16 zones taken about
+ * their own median reads low, so 3 would still clip a noisy floor
+ */
+constexpr float MULTI_ZONE_MAD_SCALE = 3.5f;
+
+/**
+ * Adaptive threshold bounds in millimeters
+ * Lower bound: floor texture and mats that should always pass (a quiet
+ * short-range frame would otherwise reject a 5 mm bump)
+ * Upper bound: keeps obvious obstructions out even on very noisy frames
+ */
+constexpr uint16_t DEFAULT_OUTLIER_MIN_MM = 15;
+constexpr uint16_t DEFAULT_OUTLIER_MAX_MM = 60;
+constexpr uint16_t MIN_OUTLIER_BOUND_MM = 5;
+constexpr uint16_t MAX_OUTLIER_BOUND_MM = 200;
+
+/**
+ * Sensor zone grid (compile-time)
+ * Default 4x4 = 16 zones. Build with -DSENSOR_ZONES_8X8 for 8x8 = 64 zones,
+ * which rejects cable trays and chair legs much better but is limited to
+ * 15 Hz ranging and transfers ~4x more data per frame.
+ * All zone buffers are sized from this, so the 4x4 build pays nothing.
+ */
+#ifdef SENSOR_ZONES_8X8
+constexpr uint8_t MULTI_ZONE_GRID_SIZE = 8;
+#else
+constexpr uint8_t MULTI_ZONE_GRID_SIZE = 4;
+#endif
+
+/**
+ * Total number of zones for the selected grid (16 or 64)
+ * Equals the VL53L5CX_RESOLUTION_* value passed to setResolution()
+ */
+constexpr uint8_t MULTI_ZONE_TOTAL_ZONES = MULTI_ZONE_GRID_SIZE * MULTI_ZONE_GRID_SIZE;
+
+static_assert(MULTI_ZONE_TOTAL_ZONES == 16 || RANGING_FREQUENCY_ACTIVE_HZ <= 15,
+              "VL53L5CX 8x8 ranging is limited to 15 Hz");
+
 /**
  * Minimum number of valid zones required for reliable consensus
  * Below this threshold, reading is marked INVALID
  * 
- * Rationale: 4 zones (25%) provides meaningful multi-zone benefit while
- * tolerating up to 75% zone failures per FR-007 and SC-005
+ * Rationale: 25% of zones (4 in 4x4, 16 in 8x8) provides meaningful
+ * multi-zone benefit while tolerating up to 75% zone failures per FR-007
+ * and SC-005
+ */
+constexpr uint8_t MULTI_ZONE_MIN_VALID_ZONES = MULTI_ZONE_TOTAL_ZONES / 4;
+
+/**
+ * Zone consensus estimator (runtime selectable, persisted in NVS)
+ * 0 = median outlier filter + plain mean (original behaviour)
+ * 1 = median outlier filter + confidence-weighted mean
+ * 2 = RANSAC floor-plane fit, distance along the sensor axis
+ */
+constexpr uint8_t DEFAULT_CONSENSUS_METHOD = 0;
+
+/**
+ * Floor applied to range_sigma_mm before weighting
+ * Prevents a single zone reporting sigma 0 from taking all the weight
+ */
+constexpr uint16_t WEIGHTED_CONSENSUS_MIN_SIGMA_MM = 2;
+
+/**
+ * Signal/ambient ratio at which a zone keeps half its weight
+ * Weight is scaled by snr / (snr + knee), so sunlit zones are down-weighted
+ * beyond what their sigma already reflects
+ */
+constexpr float WEIGHTED_CONSENSUS_SNR_KNEE = 1.0f;
+
+/**
+ * VL53L5CX field of view across the zone grid in degrees (square)
+ * Zone centers are SENSOR_FOV_DEG / MULTI_ZONE_GRID_SIZE apart; the plane
+ * fit uses them as the zones' ray angles
+ */
+constexpr float SENSOR_FOV_DEG = 45.0f;
+
+/**
+ * RANSAC hypotheses per frame for the floor-plane consensus
+ * With 25% of zones obstructed a 3-zone sample is clean 42% of the time;
+ * 16 tries all miss with probability 2e-4 (and stop early once a plane
+ * explains every zone)
+ */
+constexpr uint8_t PLANE_FIT_RANSAC_ITERATIONS = 16;
+
+/**
+ * Per-zone temporal filter ahead of the consensus (runtime selectable,
+ * persisted in NVS)
+ * 0 = none (original behaviour)
+ * 1 = exponential per zone, with dropout bridging
+ */
+constexpr uint8_t DEFAULT_ZONE_FILTER = 0;
+
+/**
+ * Per-zone smoothing factor alpha = 1 / 2^shift
+ * 1 = alpha 0.5: one frame of lag (~3 mm at 40 mm/s and 15 Hz)
+ */
+constexpr uint8_t ZONE_FILTER_SHIFT = 1;
+
+/**
+ * Frames a zone that dropped out keeps feeding its last estimate to the
+ * consensus (3 = 200 ms at 15 Hz); longer gaps drop the zone
+ */
+constexpr uint8_t ZONE_FILTER_HOLD_FRAMES = 3;
+
+/**
+ * Frames observed by a zone mask learning run (POST /zonemask)
+ * Sensor ranges at the active rate while learning: 150 frames = 10 s at 15 Hz
+ */
+constexpr uint16_t ZONE_MASK_LEARN_FRAMES = 150;
+
+/**
+ * Upper bound for a learning run requested over the API
+ */
+constexpr uint16_t ZONE_MASK_MAX_LEARN_FRAMES = 3000;
+
+/**
+ * A zone is masked if it was invalid or further than the frame's outlier
+ * threshold from the floor in at least this
+ * percentage of learning frames. Intermittent obstructions (chair legs,
+ * feet) stay below it and keep being handled by the outlier filter.
  */
-constexpr uint8_t MULTI_ZONE_MIN_VALID_ZONES = 4;
+constexpr uint8_t ZONE_MASK_INCONSISTENT_PERCENT = 90;
 
 /**
- * Total number of zones in 4x4 sensor resolution mode
+ * Zones that always stay unmasked (half the grid), so a bad learning
+ * run cannot starve the consensus
  */
-constexpr uint8_t MULTI_ZONE_TOTAL_ZONES = 16;
+constexpr uint8_t ZONE_MASK_MIN_UNMASKED_ZONES = MULTI_ZONE_TOTAL_ZONES / 2;
 
 // =============================================================================
 // WiFi Configuration
@@ -246,6 +701,45 @@ constexpr uint16_t SENSOR_MIN_VALID_MM = 10;
  */
 constexpr uint16_t READING_STALE_TIMEOUT_MS = 1000;
 
+// =============================================================================
+// Warm Restart Configuration
+// =============================================================================
+
+/**
+ * Restore the last height reading, filter samples and movement target from
+ * RTC memory after a software, watchdog or panic reset. The restored
+ * reading bridges the gap until the first frame after the reset.
+ */
+constexpr bool WARM_RESTART_ENABLED = true;
+
+/**
+ * Layout version of the RTC retained state (utils/RetainedState.h).
+ * Bump when a retained struct changes meaning without changing size.
+ */
+constexpr uint32_t RETAINED_STATE_VERSION = 1;
+
+// =============================================================================
+// Frame Trace Configuration
+// =============================================================================
+
+/**
+ * Stream buffer between the acquisition path and the trace sink. At 15 Hz
+ * a 4x4 trace needs ~350 B/s and an 8x8 trace ~1.5 KB/s, so this covers
+ * several seconds of a stalled live client before frames are dropped.
+ */
+constexpr size_t TRACE_BUFFER_BYTES = 8192;
+
+/**
+ * SPIFFS file a recorded trace is written to (GET /trace downloads it)
+ */
+constexpr const char* TRACE_FILE_PATH = "/trace.bin";
+
+/**
+ * Largest trace file; recording stops when reached (~25 min of 4x4 at
+ * 15 Hz, much longer at the 1 Hz idle rate)
+ */
+constexpr size_t TRACE_FILE_MAX_BYTES = 512 * 1024;
+
 // =============================================================================
 // Debug and Logging Configuration
 // =============================================================================
@@ -260,6 +754,11 @@ constexpr uint32_t SERIAL_BAUD_RATE = 115200;
  */
 #define DEBUG_LOGGING_ENABLED
 
+/**
+ * Boot timeline capacity (setup() phases recorded for GET /boot)
+ */
+constexpr uint8_t BOOT_TIMELINE_MAX_PHASES = 16;
+
 #ifdef DEBUG_LOGGING_ENABLED
     #define DEBUG_PRINT(x) Serial.print(x)
     #define DEBUG_PRINTLN(x) Serial.println(x)
@@ -285,4 +784,49 @@ constexpr uint16_t LARGE_CHANGE_THRESHOLD_CM = 30;
  */
 constexpr uint16_t EMERGENCY_STOP_DEBOUNCE_MS = 100;
 
+/**
+ * Obstruction detection while lowering (see utils/ObstructionDetector.h)
+ * A zone reading this much shorter than the floor sees something under the
+ * desk. Well above zone noise and floor tilt, below a shoe box.
+ */
+constexpr uint16_t OBSTRUCTION_MARGIN_MM = 100;
+
+/**
+ * Adjacent zones that must newly read short before lowering is stopped
+ * One zone is left to noise; at 8x8 an object covers ~4x the zones
+ */
+constexpr uint8_t OBSTRUCTION_MIN_ZONES = (MULTI_ZONE_GRID_SIZE == 8) ? 4 : 2;
+
+/**
+ * Motion monitor (see utils/MotionMonitor.h): consecutive frames a stall,
+ * runaway or wrong direction must persist before the move is failed
+ * (runtime configurable, persisted in NVS). 5 frames = 333 ms at 15 Hz.
+ */
+constexpr uint8_t DEFAULT_MOTION_FAULT_FRAMES = 5;
+constexpr uint8_t MIN_MOTION_FAULT_FRAMES = 2;
+constexpr uint8_t MAX_MOTION_FAULT_FRAMES = 30;
+
+/**
+ * Time after the motor is switched on, or reversed, before its motion is
+ * judged: motor response, soft start, the switch to active ranging and
+ * the velocity estimate catching up (~600 ms to full speed)
+ */
+constexpr uint16_t MOTION_START_GRACE_MS = 800;
+
+/**
+ * Time after the motor is switched off before continued motion counts as
+ * a runaway: coast plus the velocity estimate decaying (~550 ms)
+ */
+constexpr uint16_t MOTION_STOP_GRACE_MS = 1000;
+
+/**
+ * Speeds (mm/s, Kalman estimate, desk full speed 35-40 mm/s)
+ * Stall: slower than this toward the target with the motor on
+ * Wrong direction: faster than this away from it with the motor on
+ * Runaway: faster than this in the last driven direction with the motor off
+ */
+constexpr uint16_t MOTION_STALL_SPEED_MM_S = 10;
+constexpr uint16_t MOTION_WRONG_DIRECTION_SPEED_MM_S = 10;
+constexpr uint16_t MOTION_RUNAWAY_SPEED_MM_S = 15;
+
 #endif // CONFIG_H
@@ -0,0 +1,130 @@
+/**
+ * @file ControlTask.cpp
+ * @brief Implementation of the fixed-period control task
+ */
+
+#include "ControlTask.h"
+#include "utils/Logger.h"
+
+static const char* TAG = "ControlTask";
+
+ControlTask::ControlTask(HeightController& heightController, MovementController& movementController)
+    : heightController_(heightController)
+    , movementController_(movementController)
+    , task_(nullptr)
+    , jitter_((uint32_t)CONTROL_PERIOD_MS * 1000)
+    , maxBusyUs_(0)
+    , skippedPasses_(0)
+    , lastSensorUpdateMs_(0)
+    , resetRequested_(false)
+{
+}
+
+bool ControlTask::start() {
+    if (task_ != nullptr) {
+        return true;
+    }
+    
+    BaseType_t created = xTaskCreatePinnedToCore(taskEntry, "control",
+                                                 CONTROL_TASK_STACK_SIZE, this,
+                                                 CONTROL_TASK_PRIORITY, &task_,
+                                                 CONTROL_TASK_CORE);
+    if (created != pdPASS) {
+        Logger::error(TAG, "Failed to create control task");
+        task_ = nullptr;
+        return false;
+    }
+    
+    Logger::info(TAG, "Control task started (%u ms period, core %d, priority %d)",
+                 (unsigned)CONTROL_PERIOD_MS, CONTROL_TASK_CORE, CONTROL_TASK_PRIORITY);
+    return true;
+}
+
+bool ControlTask::isRunning() const {
+    return task_ != nullptr;
+}
+
+void ControlTask::taskEntry(void* param) {
+    static_cast<ControlTask*>(param)->run();
+}
+
+void ControlTask::run() {
+    // Absolute schedule: a late pass doesn't push the following ones back
+    TickType_t lastWake = xTaskGetTickCount();
+    for (;;) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(CONTROL_PERIOD_MS));
+        tick();
+    }
+}
+
+void ControlTask::tick() {
+    uint32_t wakeUs = micros();
+    if (resetRequested_) {
+        jitter_.reset();
+        maxBusyUs_ = 0;
+        skippedPasses_ = 0;
+        resetRequested_ = false;
+    }
+    jitter_.record(wakeUs);
+    
+    // Polled mode only: the acquisition task publishes frames on its own,
+    // and its update() is a no-op. A pending ranging profile switch is
+    // applied without waiting for the interval.
+    uint32_t now = millis();
+    if (!heightController_.isAcquisitionTaskRunning() &&
+        (heightController_.isRangingProfilePending() ||
+         now - lastSensorUpdateMs_ >= heightController_.getSampleIntervalMs())) {
+        lastSensorUpdateMs_ = now;
+        heightController_.update();
+    }
+    
+    // Skipped while a web call holds the controller; the next pass catches up
+    if (!movementController_.update()) {
+        skippedPasses_++;
+    }
+    
+    uint32_t busyUs = micros() - wakeUs;
+    if (busyUs > maxBusyUs_) {
+        maxBusyUs_ = busyUs;
+    }
+}
+
+void ControlTask::resetStats() {
+    resetRequested_ = true;
+}
+
+const PeriodJitter& ControlTask::getJitter() const {
+    return jitter_;
+}
+
+uint32_t ControlTask::getMaxBusyUs() const {
+    return maxBusyUs_;
+}
+
+uint32_t ControlTask::getSkippedPasses() const {
+    return skippedPasses_;
+}
+
+String ControlTask::toJson() const {
+    // Read while the task keeps recording: fields may be one pass apart
+    String json = "{";
+    json += "\"task\":" + String(isRunning() ? "true" : "false") + ",";
+    json += "\"core\":" + String(CONTROL_TASK_CORE) + ",";
+    json += "\"priority\":" + String(CONTROL_TASK_PRIORITY) + ",";
+    json += "\"periodUs\":" + String(jitter_.getNominalUs()) + ",";
+    json += "\"samples\":" + String(jitter_.getCount()) + ",";
+    json += "\"period\":{";
+    json += "\"minUs\":" + String(jitter_.getMinPeriodUs()) + ",";
+    json += "\"avgUs\":" + String(jitter_.getAvgPeriodUs()) + ",";
+    json += "\"maxUs\":" + String(jitter_.getMaxPeriodUs());
+    json += "},";
+    json += "\"jitter\":{";
+    json += "\"avgUs\":" + String(jitter_.getAvgJitterUs()) + ",";
+    json += "\"p99Us\":" + String(jitter_.getP99JitterUs()) + ",";
+    json += "\"maxUs\":" + String(jitter_.getMaxJitterUs());
+    json += "},";
+    json += "\"maxBusyUs\":" + String(maxBusyUs_) + ",";
+    json += "\"skippedPasses\":" + String(skippedPasses_);
+    json += "}";
+    return json;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file ControlTask.h
+ * @brief Fixed-period control loop in a FreeRTOS task pinned to the APP core
+ *
+ * Runs HeightController::update() and MovementController::update() every
+ * CONTROL_PERIOD_MS on a vTaskDelayUntil schedule, at a priority above
+ * the acquisition task and loop(). The network side (loop() with the WiFi
+ * manager and SSE publishing, AsyncTCP, WiFi events) runs on the PRO
+ * core, so web traffic doesn't delay a control pass. Movement status
+ * changes raised in a pass are handed to loop() through a queue (see
+ * main.cpp) instead of being sent from the task.
+ *
+ * Every wake-up is timed (utils/PeriodJitter.h); GET /control reports the
+ * period and jitter statistics.
+ *
+ * If the task can't be created, loop() calls tick() every pass instead
+ * and the statistics show the loop's own period.
+ */
+
+#ifndef CONTROL_TASK_H
+#define CONTROL_TASK_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "Config.h"
+#include "HeightController.h"
+#include "MovementController.h"
+#include "utils/PeriodJitter.h"
+
+/**
+ * @class ControlTask
+ * @brief Owner of the control loop schedule
+ *
+ * Usage:
+ *   ControlTask control(heightController, movementController);
+ *   if (!control.start()) {
+ *       // In loop:
+ *       control.tick();
+ *   }
+ */
+class ControlTask {
+public:
+    /**
+     * @brief Construct control task
+     * @param heightController Height sensor, updated when it is polled
+     * @param movementController Movement state machine, updated every pass
+     */
+    ControlTask(HeightController& heightController, MovementController& movementController);
+    
+    /**
+     * @brief Create the task pinned to CONTROL_TASK_CORE
+     * @return true if the task is running
+     */
+    bool start();
+    
+    /**
+     * @brief Check if the control loop runs in its own task
+     * @return false when loop() has to call tick()
+     */
+    bool isRunning() const;
+    
+    /**
+     * @brief One control pass (the task body, or loop() as a fallback)
+     *
+     * With the acquisition task running, the height reading is published
+     * by that task and only the movement state machine is updated. In
+     * polled mode the sensor is read at its sample interval, as before.
+     */
+    void tick();
+    
+    /**
+     * @brief Clear the statistics at the next pass (safe from any task)
+     */
+    void resetStats();
+    
+    /**
+     * @brief Period and jitter statistics
+     */
+    const PeriodJitter& getJitter() const;
+    
+    /**
+     * @brief Longest control pass since the last reset
+     * @return Microseconds from wake-up to the end of the pass
+     */
+    uint32_t getMaxBusyUs() const;
+    
+    /**
+     * @brief Movement passes skipped since the last reset
+     * @return Passes where a web call held the movement controller
+     */
+    uint32_t getSkippedPasses() const;
+    
+    /**
+     * @brief Serialize the schedule and statistics (GET /control)
+     * @return JSON object string
+     */
+    String toJson() const;
+    
+private:
+    HeightController& heightController_;
+    MovementController& movementController_;
+    TaskHandle_t task_;
+    PeriodJitter jitter_;
+    uint32_t maxBusyUs_;
+    uint32_t skippedPasses_;
+    uint32_t lastSensorUpdateMs_;
+    volatile bool resetRequested_;
+    
+    /**
+     * @brief FreeRTOS task entry point
+     * @param param ControlTask instance
+     */
+    static void taskEntry(void* param);
+    
+    /**
+     * @brief Task body: tick() every CONTROL_PERIOD_MS (never returns)
+     */
+    void run();
+};
+
+#endif // CONTROL_TASK_H
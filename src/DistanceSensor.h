@@ -0,0 +1,101 @@
+/**
+ * @file DistanceSensor.h
+ * @brief Multi-zone distance sensor interface used by HeightController
+ *
+ * HeightController only needs a handful of operations from the ToF
+ * sensor: bring-up, ranging at a frequency, data-ready polling, reading
+ * a frame of per-zone results and the I2C recovery steps. Keeping them
+ * behind this interface lets the firmware use VL53L5CXSensor while native
+ * closed-loop tests use the desk simulator (utils/DeskSimulator.h).
+ */
+
+#ifndef DISTANCE_SENSOR_H
+#define DISTANCE_SENSOR_H
+
+#include <stdint.h>
+#include "Config.h"
+
+/**
+ * @struct ZoneFrame
+ * @brief One ranging frame, one target per zone (zone order)
+ *
+ * Holds the outputs the consensus stage reads; the confidence fields only
+ * exist in builds that read them out (SENSOR_READOUT_HAS_CONFIDENCE).
+ */
+struct ZoneFrame {
+    uint8_t target_status[MULTI_ZONE_TOTAL_ZONES];     ///< VL53L5CX target status (5/9 = valid)
+    int16_t distance_mm[MULTI_ZONE_TOTAL_ZONES];       ///< Distance to target
+#if SENSOR_READOUT_HAS_CONFIDENCE
+    uint16_t range_sigma_mm[MULTI_ZONE_TOTAL_ZONES];   ///< Range noise estimate
+    uint32_t signal_per_spad[MULTI_ZONE_TOTAL_ZONES];  ///< Return signal (kcps/SPAD)
+    uint32_t ambient_per_spad[MULTI_ZONE_TOTAL_ZONES]; ///< Ambient light (kcps/SPAD)
+#endif
+};
+
+/**
+ * @class DistanceSensor
+ * @brief Abstract multi-zone ranging sensor
+ *
+ * All methods are called from the acquisition path only (with
+ * HeightController's sensor mutex held).
+ */
+class DistanceSensor {
+public:
+    virtual ~DistanceSensor() {}
+    
+    /**
+     * @brief Reset the sensor, load its firmware and set the zone grid
+     *
+     * Used at boot and by the SENSOR_RESET recovery step.
+     *
+     * @param uploadUs Receives the bring-up duration including any retry
+     * @param uploadHz Receives the bus clock the bring-up succeeded at
+     * @return true if the sensor was detected and loaded
+     */
+    virtual bool begin(uint32_t& uploadUs, uint32_t& uploadHz) = 0;
+    
+    /**
+     * @brief (Re)start ranging at a frequency
+     *
+     * Stops ranging first if needed; a frame in flight is discarded.
+     *
+     * @param frequencyHz Ranging frequency
+     * @return true if the frequency was set and ranging started
+     */
+    virtual bool startRanging(uint8_t frequencyHz) = 0;
+    
+    /**
+     * @brief Check if a new frame can be read
+     */
+    virtual bool isDataReady() = 0;
+    
+    /**
+     * @brief Read the pending frame
+     * @param frame Receives the per-zone results
+     * @return true on success (false = bus or sensor error)
+     */
+    virtual bool readFrame(ZoneFrame& frame) = 0;
+    
+    /**
+     * @brief Free a bus held low by a device stuck mid-transfer
+     * @return true if the bus was stuck and clocked out
+     */
+    virtual bool clearBus() { return false; }
+    
+    /**
+     * @brief Tear down and re-create the bus driver
+     */
+    virtual void resetBus() {}
+    
+    /**
+     * @brief Bytes transferred per readFrame() (diagnostics)
+     */
+    virtual uint16_t getFrameBytes() const { return 0; }
+    
+    /**
+     * @brief Bus clock used while ranging (diagnostics, 0 = no bus)
+     */
+    virtual uint32_t getBusHz() const { return 0; }
+};
+
+#endif // DISTANCE_SENSOR_H
@@ -4,64 +4,147 @@
  */
 
 #include "HeightController.h"
+#include "TraceRecorder.h"
 #include "utils/Logger.h"
-#include <cstring>  // For memcpy in multi-zone filtering
+#include "utils/HeightUnits.h"
+#include "utils/SensorReadout.h"
 
 static const char* TAG = "HeightController";
 
-HeightController::HeightController()
-    : filter_(DEFAULT_FILTER_WINDOW_SIZE)  // Use default, init() will reconfigure
+HeightController* HeightController::isrInstance_ = nullptr;
+volatile uint32_t HeightController::dataReadyTimestampUs_ = 0;
+RTC_NOINIT_ATTR RetainedState<HeightController::RetainedHeight> HeightController::retained_;
+
+HeightController::HeightController(DistanceSensor& sensor)
+    : sensor_(sensor)
+    , filter_(DEFAULT_FILTER_WINDOW_SIZE)  // Use default, init() will reconfigure
+    , kalman_(DEFAULT_KALMAN_PROCESS_NOISE, DEFAULT_KALMAN_MEASUREMENT_NOISE)
     , sensorInitialized_(false)
+    , acquisitionTask_(nullptr)
+    , sensorMutex_(nullptr)
+    , readingMux_(portMUX_INITIALIZER_UNLOCKED)
+    , readingSequence_(0)
+    , maxLatencyUs_(0)
+    , requestedProfile_(RangingProfile::IDLE)
+    , activeProfile_(RangingProfile::IDLE)
+    , rangingFrequencyHz_(RANGING_FREQUENCY_IDLE_HZ)
+    , rangingStartMs_(0)
+    , configuredWindowSize_(DEFAULT_FILTER_WINDOW_SIZE)
+    , windowAdaptive_(false)
+    , consensusTimeUs_(0)
+    , maxConsensusTimeUs_(0)
+    , lastPlaneFit_()
+    , planeFallbacks_(0)
+    , obstructionWatch_(false)
+    , obstructionWatchId_(0)
+    , obstructionArmedId_(0)
+    , obstructionEventId_(0)
+    , obstructionEvent_()
+    , zoneFilterActive_(false)
+    , readoutTimeUs_(0)
+    , maxReadoutTimeUs_(0)
+    , firmwareUploadUs_(0)
+    , firmwareUploadHz_(0)
+    , firstValidReadingUs_(0)
+    , warmStart_(false)
+    , zoneMaskCommand_(ZoneMaskCommand::NONE)
+    , zoneMaskLearnFrames_(ZONE_MASK_LEARN_FRAMES)
+    , zoneMask_(0)
+    , zoneMaskDirty_(false)
+    , calibrationPending_(false)
+    , nextCalibrationJobId_(1)
+    , calibrationDeadlineMs_(0)
+    , traceRecorder_(nullptr)
 {
     // Initialize reading structure
     currentReading_.raw_distance_mm = 0;
     currentReading_.filtered_distance_mm = 0;
-    currentReading_.calculated_height_cm = 0;
+    currentReading_.calculated_height_mm = 0;
     currentReading_.timestamp_ms = 0;
+    currentReading_.latency_us = 0;
+    currentReading_.velocity_mm_s = 0;
     currentReading_.validity = ReadingValidity::INVALID;
+    
+    calibrationStatus_.job_id = 0;
+    calibrationStatus_.state = CalibrationState::IDLE;
+    calibrationStatus_.sequence = 0;
+    calibrationStatus_.known_height_mm = 0;
+    calibrationStatus_.samples = 0;
+    calibrationStatus_.mean_distance_mm = 0;
+    calibrationStatus_.std_error_mm = 0.0f;
+    calibrationStatus_.offset_mm = 0;
+    calibrationStatus_.error = "";
 }
 
-bool HeightController::init() {
-    Logger::info(TAG, "Initializing VL53L5CX sensor...");
+bool HeightController::init(bool warmReset) {
+    Logger::info(TAG, "Initializing distance sensor...");
+    
+    // Take the retained reading now and drop it from RTC memory, so a
+    // failed bring-up can't leave it for a later warm reset
+    RetainedHeight retained;
+    bool haveRetained = WARM_RESTART_ENABLED && warmReset && retained_.load(retained);
+    retained_.invalidate();
+    
+    // Serializes sensor access between update() and the acquisition task
+    if (sensorMutex_ == nullptr) {
+        sensorMutex_ = xSemaphoreCreateMutex();
+    }
     
     // Reconfigure filter with config value (SystemConfig now initialized)
     uint8_t configWindowSize = SystemConfig.getFilterWindowSize();
     if (configWindowSize != DEFAULT_FILTER_WINDOW_SIZE) {
-        filter_ = MovingAverageFilter(configWindowSize);
+        filter_.configure(configWindowSize);
         Logger::info(TAG, "Filter window size set to %d", configWindowSize);
     }
+    configuredWindowSize_ = filter_.getWindowSize();
+    // The adaptive window starts from the configured one until the noise
+    // estimate has warmed up
+    adaptiveWindow_.reset(configuredWindowSize_);
+    
+    // Learned static obstruction mask
+    zoneMask_ = SystemConfig.getZoneMask();
+    if (zoneMask_ != 0) {
+        Logger::info(TAG, "Zone mask: %d of %d zones masked",
+                     ZoneMaskLearner::countMasked(zoneMask_), MULTI_ZONE_TOTAL_ZONES);
+    }
     
-    // Initialize I2C
-    Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL);
-    Wire.setClock(I2C_FREQUENCY);
-    
-    // Initialize sensor
-    if (!sensor_.begin()) {
-        Logger::error(TAG, "VL53L5CX not detected! Check wiring.");
+    if (!sensor_.begin(firmwareUploadUs_, firmwareUploadHz_)) {
+        Logger::error(TAG, "Distance sensor not detected! Check wiring.");
         sensorInitialized_ = false;
         return false;
     }
     
-    // Configure for 4x4 resolution (lower power, faster)
-    // We only need single-zone distance for height measurement
-    sensor_.setResolution(VL53L5CX_RESOLUTION_4X4);
-    
-    // Set ranging frequency to match our sample interval
-    // 5Hz = 200ms interval
-    sensor_.setRangingFrequency(5);
-    
-    // Start ranging
-    sensor_.startRanging();
+    // Start at the idle rate; MovementController activity raises it
+    // via requestRangingProfile()
+    requestedProfile_ = RangingProfile::IDLE;
+    supervisor_.reset(millis());
+    restartRanging(RangingProfile::IDLE);
     
     sensorInitialized_ = true;
     Logger::info(TAG, "Sensor initialized successfully");
+    if (sensor_.getBusHz() > 0) {
+        Logger::info(TAG, "Readout: %u bytes/frame (~%lu us at %lu Hz I2C)",
+                     sensor_.getFrameBytes(),
+                     (unsigned long)SensorReadout::busTimeUs(sensor_.getFrameBytes(), sensor_.getBusHz()),
+                     (unsigned long)sensor_.getBusHz());
+    }
+#if !SENSOR_READOUT_HAS_CONFIDENCE
+    if (SystemConfig.getConsensusMethod() == ConsensusMethod::CONFIDENCE_WEIGHTED) {
+        Logger::warn(TAG, "Minimal readout profile: weighted consensus unavailable, using median-mean");
+    }
+#endif
+    
+    // Warm reset: publish the retained reading until the first frame arrives
+    if (haveRetained) {
+        warmStart_ = restoreRetainedState(retained);
+    }
     
     // Log calibration status
     if (!SystemConfig.isCalibrated()) {
         Logger::warn(TAG, "System not calibrated! Height readings will be inaccurate.");
     } else {
-        Logger::info(TAG, "Calibration constant: %d cm", 
-                     SystemConfig.getCalibrationConstant());
+        Logger::info(TAG, "Calibration offset: %d mm", 
+                     SystemConfig.getCalibrationOffsetMm());
     }
     
     return true;
@@ -73,228 +156,604 @@ void HeightController::update() {
         return;
     }
     
-    // Check if new data is available
-    if (!sensor_.isDataReady()) {
-        // No new data, check if current reading is stale
-        if (millis() - currentReading_.timestamp_ms > READING_STALE_TIMEOUT_MS) {
-            currentReading_.validity = ReadingValidity::STALE;
-        }
+    // Acquisition task owns the sensor once started
+    if (acquisitionTask_ != nullptr) {
         return;
     }
     
-    // Get raw sensor data structure
-    VL53L5CX_ResultsData results;
-    if (!sensor_.getRangingData(&results)) {
+    xSemaphoreTake(sensorMutex_, portMAX_DELAY);
+    
+    applyZoneMaskCommand();
+    serviceCalibration();
+    applyRangingProfile();
+    
+    // Polling mode: the frame may have been waiting up to one full interval,
+    // so latency here only covers read + processing time
+    if (sensor_.isDataReady()) {
+        processFrame(micros());
+    } else {
+        // No new data, check if current reading is stale
+        checkStale();
+    }
+    
+    superviseSensor();
+    xSemaphoreGive(sensorMutex_);
+}
+
+bool HeightController::startAcquisitionTask() {
+    if (!sensorInitialized_) {
+        Logger::error(TAG, "Cannot start acquisition task: sensor not initialized");
+        return false;
+    }
+    
+    if (acquisitionTask_ != nullptr) {
+        return true;
+    }
+    
+    isrInstance_ = this;
+    pinMode(PIN_SENSOR_INT, INPUT_PULLUP);
+    
+    BaseType_t created = xTaskCreatePinnedToCore(acquisitionTaskEntry, "sensor",
+                                                 SENSOR_TASK_STACK_SIZE, this,
+                                                 SENSOR_TASK_PRIORITY, &acquisitionTask_,
+                                                 SENSOR_TASK_CORE);
+    if (created != pdPASS) {
+        Logger::error(TAG, "Failed to create acquisition task");
+        acquisitionTask_ = nullptr;
+        return false;
+    }
+    
+    attachInterrupt(digitalPinToInterrupt(PIN_SENSOR_INT), onDataReadyISR, FALLING);
+    
+    // Drain any frame that became ready before the interrupt was attached
+    dataReadyTimestampUs_ = micros();
+    xTaskNotifyGive(acquisitionTask_);
+    
+    Logger::info(TAG, "Acquisition task started (INT pin %d, core %d)",
+                 PIN_SENSOR_INT, SENSOR_TASK_CORE);
+    return true;
+}
+
+bool HeightController::isAcquisitionTaskRunning() const {
+    return acquisitionTask_ != nullptr;
+}
+
+uint32_t HeightController::getReadingSequence() const {
+    return readingSequence_;
+}
+
+uint32_t HeightController::getMaxLatencyUs() const {
+    return maxLatencyUs_;
+}
+
+uint32_t HeightController::getFirmwareUploadUs() const {
+    return firmwareUploadUs_;
+}
+
+uint32_t HeightController::getFirmwareUploadHz() const {
+    return firmwareUploadHz_;
+}
+
+uint32_t HeightController::getFirstValidReadingUs() const {
+    return firstValidReadingUs_;
+}
+
+bool HeightController::isWarmStart() const {
+    return warmStart_;
+}
+
+void IRAM_ATTR HeightController::onDataReadyISR() {
+    dataReadyTimestampUs_ = micros();
+    
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    if (isrInstance_ != nullptr && isrInstance_->acquisitionTask_ != nullptr) {
+        vTaskNotifyGiveFromISR(isrInstance_->acquisitionTask_, &higherPriorityTaskWoken);
+    }
+    portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+void HeightController::acquisitionTaskEntry(void* param) {
+    static_cast<HeightController*>(param)->acquisitionLoop();
+}
+
+void HeightController::acquisitionLoop() {
+    for (;;) {
+        // Sleep until the data-ready edge (or a profile request); time out
+        // just after a frame is overdue so a silent sensor is flagged STALE
+        // and handed to the supervisor
+        uint32_t waitMs = getSampleIntervalMs() + SENSOR_STARVATION_MARGIN_MS;
+        bool notified = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs)) > 0;
+        uint32_t frameReadyUs = notified ? dataReadyTimestampUs_ : micros();
+        
+        xSemaphoreTake(sensorMutex_, portMAX_DELAY);
+        
+        applyZoneMaskCommand();
+        serviceCalibration();
+        
+        // A profile switch restarts ranging, so any edge timestamp is obsolete
+        if (applyRangingProfile()) {
+            frameReadyUs = micros();
+        }
+        
+        // Re-check: a profile switch may have discarded the frame, and a
+        // timeout may hide a missed edge
+        if (sensor_.isDataReady()) {
+            processFrame(frameReadyUs);
+        } else {
+            checkStale();
+        }
+        
+        superviseSensor();
+        xSemaphoreGive(sensorMutex_);
+    }
+}
+
+void HeightController::processFrame(uint32_t frameReadyUs) {
+    HeightReading reading = getReading();
+    
+    // Read into the persistent buffer; only the outputs enabled by the
+    // build's readout profile are transferred (see utils/SensorReadout.h)
+    uint32_t readoutStartUs = micros();
+    bool readOk = sensor_.readFrame(frame_);
+    readoutTimeUs_ = micros() - readoutStartUs;
+    if (readoutTimeUs_ > maxReadoutTimeUs_) {
+        maxReadoutTimeUs_ = readoutTimeUs_;
+    }
+    if (!readOk) {
+        supervisor_.onReadError();
         Logger::error(TAG, "Failed to get ranging data");
-        currentReading_.validity = ReadingValidity::INVALID;
+        reading.validity = ReadingValidity::INVALID;
+        publishReading(reading, frameReadyUs);
         return;
     }
     
-    currentReading_.timestamp_ms = millis();
+    reading.timestamp_ms = millis();
+    supervisor_.onFrame(reading.timestamp_ms);
+    
+    // Raw zones as read, tagged with the sequence number this frame is published under
+    if (traceRecorder_ != nullptr) {
+        traceRecorder_->record(frame_, frameReadyUs, readingSequence_ + 1, zoneMask_);
+    }
+    
+    // Obstruction watch on the zones as read: smoothing would spread the
+    // step of an object appearing over several frames
+    checkObstruction(frame_, frameReadyUs);
+    
+    bool wasLearning = zoneMaskLearner_.isActive();
+    uint32_t consensusStartUs = micros();
+    
+    // =========================================================================
+    // ZONE TEMPORAL STAGE (optional): per-zone smoothing, dropouts bridged
+    // After trace recording, so traces keep the zones as read
+    // =========================================================================
+    bool zoneFilterOn = (SystemConfig.getZoneFilter() == ZoneFilterMethod::EXPONENTIAL);
+    if (zoneFilterOn) {
+        // Estimates left from before the filter was switched off are stale
+        if (!zoneFilterActive_) {
+            zoneFilter_.reset();
+        }
+#if SENSOR_READOUT_HAS_CONFIDENCE
+        zoneFilter_.apply(frame_.target_status, frame_.distance_mm, frame_.range_sigma_mm);
+#else
+        zoneFilter_.apply(frame_.target_status, frame_.distance_mm);
+#endif
+    }
+    zoneFilterActive_ = zoneFilterOn;
     
     // =========================================================================
     // SPATIAL STAGE: Multi-zone consensus filtering
-    // Replaces single-zone readSensor() with 16-zone spatial filtering
+    // Replaces single-zone readSensor() with 16/64-zone spatial filtering
     // =========================================================================
-    lastConsensus_ = computeMultiZoneConsensus(results);
+    ConsensusResult consensus = computeMultiZoneConsensus(frame_);
+    consensusTimeUs_ = micros() - consensusStartUs;
+    if (consensusTimeUs_ > maxConsensusTimeUs_) {
+        maxConsensusTimeUs_ = consensusTimeUs_;
+    }
+    
+    // Outside the timed section: persisting the mask writes NVS
+    if (wasLearning && !zoneMaskLearner_.isActive()) {
+        finishZoneMaskLearning();
+    }
+    if (calibrationSampler_.isActive()) {
+        observeCalibration(consensus);
+    }
     
     // Check if consensus is reliable (>= 4 valid zones)
-    if (!lastConsensus_.is_reliable) {
-        currentReading_.validity = ReadingValidity::INVALID;
+    if (!consensus.is_reliable) {
+        adaptiveWindow_.restart();
+        reading.validity = ReadingValidity::INVALID;
+        lastConsensus_ = consensus;
+        publishReading(reading, frameReadyUs);
         Logger::warn(TAG, "Multi-zone consensus unreliable: %d zones valid", 
-                     lastConsensus_.valid_zone_count);
+                     consensus.valid_zone_count);
         return;
     }
     
     // Store consensus distance as raw reading for diagnostics
-    currentReading_.raw_distance_mm = lastConsensus_.consensus_distance_mm;
-    currentReading_.validity = ReadingValidity::VALID;
+    reading.raw_distance_mm = consensus.consensus_distance_mm;
+    reading.validity = ReadingValidity::VALID;
     
     // =========================================================================
-    // TEMPORAL STAGE: Moving average filter
-    // Smooth consensus output over time
+    // TEMPORAL STAGE: Moving average or constant-velocity Kalman filter
+    // Both are fed every frame so switching methods needs no warm-up
     // =========================================================================
-    filter_.addSample(lastConsensus_.consensus_distance_mm);
-    currentReading_.filtered_distance_mm = filter_.getAverage();
+    updateFilterWindow(consensus.consensus_distance_mm);
+    filter_.addSample(consensus.consensus_distance_mm);
+    kalman_.setNoise(SystemConfig.getKalmanProcessNoise(), SystemConfig.getKalmanMeasurementNoise());
+    kalman_.update(consensus.consensus_distance_mm, frameReadyUs);
+    
+    reading.velocity_mm_s = kalman_.getVelocity();
+    if (SystemConfig.getTemporalFilter() == TemporalFilterMethod::KALMAN) {
+        reading.filtered_distance_mm = kalman_.getDistance();
+    } else {
+        reading.filtered_distance_mm = filter_.getAverage();
+    }
     
     // Calculate height from filtered distance
-    currentReading_.calculated_height_cm = calculateHeight(currentReading_.filtered_distance_mm);
-    
-    Logger::debug(TAG, "Consensus: %dmm (%d zones, %d outliers), Filtered: %dmm, Height: %dcm",
-                  lastConsensus_.consensus_distance_mm,
-                  lastConsensus_.valid_zone_count,
-                  lastConsensus_.outlier_count,
-                  currentReading_.filtered_distance_mm, 
-                  currentReading_.calculated_height_cm);
+    reading.calculated_height_mm = calculateHeight(reading.filtered_distance_mm);
+    
+    lastConsensus_ = consensus;
+    publishReading(reading, frameReadyUs);
+    
+    Logger::debug(TAG, "Consensus: %dmm (%d zones, %d outliers), Filtered: %dmm, Height: %dmm, Latency: %luus",
+                  consensus.consensus_distance_mm,
+                  consensus.valid_zone_count,
+                  consensus.outlier_count,
+                  reading.filtered_distance_mm, 
+                  reading.calculated_height_mm,
+                  (unsigned long)reading.latency_us);
 }
 
-uint16_t HeightController::readSensor() {
-    VL53L5CX_ResultsData results;
-    
-    if (!sensor_.getRangingData(&results)) {
-        Logger::error(TAG, "Failed to get ranging data");
-        return 0;
+void HeightController::checkObstruction(const ZoneFrame& frame, uint32_t frameReadyUs) {
+    if (!obstructionWatch_) {
+        if (obstructionDetector_.isArmed()) {
+            obstructionDetector_.disarm();
+        }
+        return;
+    }
+    uint32_t watchId = obstructionWatchId_;
+    if (watchId != obstructionArmedId_) {
+        obstructionDetector_.arm();
+        obstructionArmedId_ = watchId;
     }
     
-    // For 4x4 resolution, zones are numbered 0-15
-    // Center zones are approximately 5, 6, 9, 10
-    // Use zone 5 as representative center zone
-    uint8_t centerZone = 5;
-    
-    // Get target status - valid statuses are 5 (100% valid) and others
-    // Status 0 means no target detected, 255 means invalid
-    uint8_t status = results.target_status[VL53L5CX_NB_TARGET_PER_ZONE * centerZone];
-    uint16_t distance = results.distance_mm[VL53L5CX_NB_TARGET_PER_ZONE * centerZone];
-    
-    // Log for debugging - reduce frequency to avoid spam
-    static unsigned long lastDebugLog = 0;
-    if (millis() - lastDebugLog > 2000) {
-        Logger::debug(TAG, "Zone %d: status=%d, distance=%d mm", centerZone, status, distance);
-        lastDebugLog = millis();
+    // Floor from the previous frame: an object under most of the zones
+    // takes over this frame's median
+    if (!lastConsensus_.is_reliable ||
+        lastConsensus_.consensus_distance_mm <= OBSTRUCTION_MARGIN_MM) {
+        return;
     }
+    const uint16_t floor_mm = lastConsensus_.consensus_distance_mm;
+    const uint16_t near_mm = floor_mm - OBSTRUCTION_MARGIN_MM;
     
-    // Valid status codes: 5 = 100% valid, 6 = 50% valid, 9 = valid with wrap
-    // Status 0 or 255 = invalid
-    if (status == 0 || status == 255) {
-        return 0;
+    uint64_t nearZones = 0;
+    for (uint8_t zone = 0; zone < MULTI_ZONE_TOTAL_ZONES; zone++) {
+        if (zoneMask_ & (1ULL << zone)) {
+            continue;
+        }
+        int16_t distance_signed = frame.distance_mm[zone];
+        uint16_t distance = (distance_signed > 0) ? static_cast<uint16_t>(distance_signed) : 0;
+        if (ZoneConsensus::isZoneValid(frame.target_status[zone], distance) && distance < near_mm) {
+            nearZones |= 1ULL << zone;
+        }
+    }
+    if (!obstructionDetector_.update(nearZones)) {
+        return;
     }
     
-    return distance;
+    // No logging here: the movement controller acts on the published
+    // event and reports it once the motor is off
+    uint64_t zones = obstructionDetector_.getZones();
+    uint16_t clearance = floor_mm;
+    for (uint8_t zone = 0; zone < MULTI_ZONE_TOTAL_ZONES; zone++) {
+        if ((zones & (1ULL << zone)) && static_cast<uint16_t>(frame.distance_mm[zone]) < clearance) {
+            clearance = static_cast<uint16_t>(frame.distance_mm[zone]);
+        }
+    }
+    ObstructionEvent event;
+    event.frame_ready_us = frameReadyUs;
+    event.sequence = readingSequence_ + 1;
+    event.zone_count = ObstructionDetector::countZones(zones);
+    event.new_zone_count = obstructionDetector_.getNewZoneCount();
+    event.clearance_mm = clearance;
+    event.floor_mm = floor_mm;
+    
+    portENTER_CRITICAL(&readingMux_);
+    obstructionEvent_ = event;
+    obstructionEventId_ = watchId;
+    portEXIT_CRITICAL(&readingMux_);
 }
 
-ReadingValidity HeightController::validateReading(uint16_t reading) const {
-    // Check for sensor error conditions
-    if (reading == 0) {
-        return ReadingValidity::INVALID;
-    }
+void HeightController::publishReading(HeightReading& reading, uint32_t frameReadyUs) {
+    reading.latency_us = micros() - frameReadyUs;
+    
+    portENTER_CRITICAL(&readingMux_);
+    currentReading_ = reading;
+    readingSequence_ = readingSequence_ + 1;
+    portEXIT_CRITICAL(&readingMux_);
     
-    if (reading < SENSOR_MIN_VALID_MM) {
-        return ReadingValidity::INVALID;
+    if (firstValidReadingUs_ == 0 && reading.validity == ReadingValidity::VALID) {
+        firstValidReadingUs_ = micros();
     }
     
-    if (reading > SENSOR_MAX_RANGE_MM) {
-        return ReadingValidity::INVALID;
+    if (reading.latency_us > maxLatencyUs_) {
+        maxLatencyUs_ = reading.latency_us;
     }
     
-    return ReadingValidity::VALID;
+    retainState(reading);
 }
 
-uint16_t HeightController::calculateHeight(uint16_t filtered_mm) const {
-    int16_t calibration = (int16_t)SystemConfig.getCalibrationConstant();
-    
-    // If not calibrated, return 0
-    if (calibration == 0) {
-        return 0;
+void HeightController::retainState(const HeightReading& reading) {
+    if (!WARM_RESTART_ENABLED) {
+        return;
     }
     
-    // For floor-pointing sensor mounted under desk:
-    // height_cm = calibration_constant + (sensor_reading_mm / 10)
-    // When desk goes UP, distance to floor INCREASES, so height increases
-    int16_t distance_cm = filtered_mm / 10;
-    int16_t height = calibration + distance_cm;
+    RetainedHeight retained = {};
+    retained.reading = reading;
+    retained.filterSampleCount = filter_.getSamples(retained.filterSamples,
+                                                    MovingAverageFilter::capacity());
+    retained_.save(retained);
+}
+
+bool HeightController::restoreRetainedState(const RetainedHeight& retained) {
+    if (retained.reading.validity != ReadingValidity::VALID ||
+        retained.filterSampleCount > MovingAverageFilter::capacity()) {
+        Logger::info(TAG, "Warm restart: no valid reading retained");
+        return false;
+    }
     
-    // Clamp to reasonable range (0-200cm)
-    if (height < 0) {
-        height = 0;
+    // Replayed oldest first; init() may have shrunk the window to the
+    // idle rate, in which case the newest samples are kept
+    for (uint8_t i = 0; i < retained.filterSampleCount; i++) {
+        filter_.addSample(retained.filterSamples[i]);
     }
-    if (height > 200) {
-        height = 200;
+    kalman_.reset();
+    kalman_.update(retained.reading.raw_distance_mm, micros());
+    
+    HeightReading reading = retained.reading;
+    if (SystemConfig.getTemporalFilter() == TemporalFilterMethod::KALMAN) {
+        reading.filtered_distance_mm = kalman_.getDistance();
+    } else {
+        reading.filtered_distance_mm = filter_.getAverage();
     }
+    reading.calculated_height_mm = calculateHeight(reading.filtered_distance_mm);
+    reading.timestamp_ms = millis();
+    reading.velocity_mm_s = 0;
+    publishReading(reading, micros());
     
-    return (uint16_t)height;
+    Logger::info(TAG, "Warm restart: restored height %u mm (%u filter samples)",
+                 reading.calculated_height_mm, filter_.getSampleCount());
+    return true;
 }
 
-uint16_t HeightController::getCurrentHeight() const {
-    return currentReading_.calculated_height_cm;
+void HeightController::watchForObstruction(bool watch) {
+    portENTER_CRITICAL(&readingMux_);
+    if (watch) {
+        obstructionWatchId_ = obstructionWatchId_ + 1;
+    }
+    obstructionWatch_ = watch;
+    portEXIT_CRITICAL(&readingMux_);
 }
 
-uint16_t HeightController::getRawDistance() const {
-    return currentReading_.raw_distance_mm;
+bool HeightController::getObstruction(ObstructionEvent& event) const {
+    portENTER_CRITICAL(&readingMux_);
+    bool detected = obstructionWatch_ && obstructionEventId_ != 0 &&
+                    obstructionEventId_ == obstructionWatchId_;
+    if (detected) {
+        event = obstructionEvent_;
+    }
+    portEXIT_CRITICAL(&readingMux_);
+    return detected;
 }
 
-uint16_t HeightController::getFilteredDistance() const {
-    return currentReading_.filtered_distance_mm;
+void HeightController::requestRangingProfile(RangingProfile profile) {
+    if (profile == requestedProfile_) {
+        return;
+    }
+    
+    requestedProfile_ = profile;
+    
+    // Wake the task so the switch doesn't wait for the next idle-rate frame
+    if (acquisitionTask_ != nullptr) {
+        xTaskNotifyGive(acquisitionTask_);
+    }
 }
 
-bool HeightController::isValid() const {
-    return currentReading_.validity == ReadingValidity::VALID;
+bool HeightController::isRangingProfilePending() const {
+    return desiredProfile() != activeProfile_;
 }
 
-const HeightReading& HeightController::getReading() const {
-    return currentReading_;
+RangingProfile HeightController::desiredProfile() const {
+    // Learn and calibrate at the active rate so a job takes seconds, not
+    // minutes; recover at it so the first good frame comes within ~67 ms
+    if (zoneMaskLearner_.isActive() || calibrationSampler_.isActive() ||
+        supervisor_.isRecovering()) {
+        return RangingProfile::ACTIVE;
+    }
+    return requestedProfile_;
 }
 
-ReadingValidity HeightController::getValidity() const {
-    return currentReading_.validity;
+RangingProfile HeightController::getRangingProfile() const {
+    return activeProfile_;
 }
 
-void HeightController::resetFilter() {
-    filter_.reset();
-    Logger::info(TAG, "Filter reset");
+uint8_t HeightController::getRangingFrequency() const {
+    return rangingFrequencyHz_;
 }
 
-bool HeightController::calibrate(uint16_t known_height_cm) {
-    // For floor-pointing sensor under desk:
-    // calibration_constant = known_height - (sensor_reading / 10)
-    // This offset accounts for sensor mounting position
-    
-    if (!sensorInitialized_) {
-        Logger::error(TAG, "Cannot calibrate: sensor not initialized");
+uint16_t HeightController::getSampleIntervalMs() const {
+    return 1000 / rangingFrequencyHz_;
+}
+
+bool HeightController::applyRangingProfile() {
+    // Recovery steps restart ranging themselves
+    RangingProfile profile = desiredProfile();
+    if (profile == activeProfile_ || !sensorInitialized_ || supervisor_.isRecovering()) {
         return false;
     }
     
-    // Take a few readings to get stable measurement
-    uint32_t sum = 0;
-    int validReadings = 0;
-    const int NUM_SAMPLES = 10;
-    
-    Logger::info(TAG, "Calibrating at known height: %d cm", known_height_cm);
-    
-    for (int i = 0; i < NUM_SAMPLES; i++) {
-        // Wait for fresh data
-        while (!sensor_.isDataReady()) {
-            delay(10);
-        }
-        
-        uint16_t raw = readSensor();
-        if (validateReading(raw) == ReadingValidity::VALID) {
-            sum += raw;
-            validReadings++;
-        }
-        
-        delay(50);  // Brief pause between readings
+    if (!restartRanging(profile)) {
+        // Keep the old frequency; don't retry on every frame
+        requestedProfile_ = activeProfile_;
+        return false;
     }
+    return true;
+}
+
+bool HeightController::restartRanging(RangingProfile profile) {
+    uint8_t frequencyHz = (profile == RangingProfile::ACTIVE) ?
+                          RANGING_FREQUENCY_ACTIVE_HZ : RANGING_FREQUENCY_IDLE_HZ;
     
-    if (validReadings < NUM_SAMPLES / 2) {
-        Logger::error(TAG, "Calibration failed: too few valid readings (%d/%d)",
-                      validReadings, NUM_SAMPLES);
+    bool ok = sensor_.startRanging(frequencyHz);
+    rangingStartMs_ = millis();
+    supervisor_.onRangingStart(rangingStartMs_);
+    
+    if (!ok) {
+        Logger::error(TAG, "Failed to restart ranging at %d Hz", frequencyHz);
         return false;
     }
     
-    uint16_t avg_reading_mm = sum / validReadings;
+    activeProfile_ = profile;
+    rangingFrequencyHz_ = frequencyHz;
     
-    // calibration_constant = known_height - (sensor_reading / 10)
-    // This gives us the offset to add to future readings
-    int16_t calibration_constant = (int16_t)known_height_cm - (int16_t)(avg_reading_mm / 10);
+    filter_.resize(scaledWindowSize(frequencyHz));
     
-    Logger::info(TAG, "Calibration: avg reading = %d mm, constant = %d cm",
-                 avg_reading_mm, calibration_constant);
+    Logger::info(TAG, "Ranging profile %s: %d Hz, filter window %d",
+                 profile == RangingProfile::ACTIVE ? "ACTIVE" : "IDLE",
+                 frequencyHz, filter_.getWindowSize());
+    return true;
+}
+
+uint8_t HeightController::scaledWindowSize(uint8_t frequencyHz) const {
+    // Same time constant: window_s = reference_window / reference_hz
+    uint8_t reference = windowAdaptive_ ? adaptiveWindow_.getWindow() : configuredWindowSize_;
+    return (reference * frequencyHz + RANGING_FREQUENCY_REFERENCE_HZ / 2) /
+           RANGING_FREQUENCY_REFERENCE_HZ;
+}
+
+void HeightController::updateFilterWindow(uint16_t consensus_mm) {
+    bool changed = adaptiveWindow_.update(consensus_mm);
+    bool adaptive = (SystemConfig.getFilterWindowMode() == FilterWindowMode::ADAPTIVE);
+    if (adaptive == windowAdaptive_ && !(adaptive && changed)) {
+        return;
+    }
     
-    // Save to system configuration
-    if (!SystemConfig.setCalibrationConstant(calibration_constant)) {
-        Logger::error(TAG, "Failed to save calibration constant");
-        return false;
+    windowAdaptive_ = adaptive;
+    filter_.resize(scaledWindowSize(rangingFrequencyHz_));
+    Logger::info(TAG, "Filter window %d (%s, consensus noise %.2f mm)",
+                 filter_.getWindowSize(), adaptive ? "adaptive" : "fixed",
+                 adaptiveWindow_.getNoiseMm());
+}
+
+void HeightController::superviseSensor() {
+    SensorRecoveryAction action = supervisor_.poll(millis(), getSampleIntervalMs());
+    if (action == SensorRecoveryAction::NONE) {
+        return;
     }
     
-    // Reset filter to start fresh with calibrated readings
-    resetFilter();
+    Logger::warn(TAG, "Sensor fault (%lu read errors so far), recovery step: %s",
+                 (unsigned long)supervisor_.getReadErrorCount(),
+                 SensorSupervisor::actionName(action));
+    
+    // Zone estimates predate the fault; don't bridge across it
+    zoneFilter_.reset();
+    adaptiveWindow_.restart();
+    
+    uint32_t startUs = micros();
+    bool ok = true;
+    switch (action) {
+        case SensorRecoveryAction::BUS_CLEAR:
+            sensor_.clearBus();
+            break;
+            
+        case SensorRecoveryAction::WIRE_REINIT:
+            sensor_.resetBus();
+            break;
+            
+        case SensorRecoveryAction::SENSOR_RESET: {
+            // Boot timing (GET /boot) keeps the init() upload
+            uint32_t uploadUs, uploadHz;
+            ok = sensor_.begin(uploadUs, uploadHz);
+            break;
+        }
+        
+        default:
+            break;
+    }
     
-    Logger::info(TAG, "Calibration successful!");
-    return true;
+    // Every step ends with a ranging restart at the active rate; the
+    // supervisor escalates if no frame follows
+    if (ok) {
+        ok = restartRanging(desiredProfile());
+    }
+    Logger::info(TAG, "Recovery step %s %s in %lu us",
+                 SensorSupervisor::actionName(action), ok ? "done" : "failed",
+                 (unsigned long)(micros() - startUs));
+}
+
+unsigned long HeightController::getStaleTimeoutMs() const {
+    unsigned long twoFrames = 2UL * getSampleIntervalMs();
+    return (twoFrames > READING_STALE_TIMEOUT_MS) ? twoFrames : READING_STALE_TIMEOUT_MS;
+}
+
+void HeightController::checkStale() {
+    // A ranging restart (profile switch) drops the frame in flight: give
+    // the new rate two periods to deliver before the old reading goes stale
+    unsigned long now = millis();
+    bool restarted = (now - rangingStartMs_ <= 2UL * getSampleIntervalMs());
+    portENTER_CRITICAL(&readingMux_);
+    if (now - currentReading_.timestamp_ms > getStaleTimeoutMs() && !restarted) {
+        currentReading_.validity = ReadingValidity::STALE;
+    }
+    portEXIT_CRITICAL(&readingMux_);
+}
+
+uint16_t HeightController::calculateHeight(uint16_t filtered_mm) const {
+    // For floor-pointing sensor mounted under desk:
+    // height_mm = calibration_offset_mm + sensor_reading_mm
+    // When desk goes UP, distance to floor INCREASES, so height increases.
+    // Returns 0 when uncalibrated; clamped to 0-2000 mm.
+    return HeightUnits::heightFromDistance(SystemConfig.getCalibrationOffsetMm(), filtered_mm);
+}
+
+uint16_t HeightController::getCurrentHeightMm() const {
+    return currentReading_.calculated_height_mm;
+}
+
+uint16_t HeightController::getRawDistance() const {
+    return currentReading_.raw_distance_mm;
+}
+
+uint16_t HeightController::getFilteredDistance() const {
+    return currentReading_.filtered_distance_mm;
+}
+
+bool HeightController::isValid() const {
+    return currentReading_.validity == ReadingValidity::VALID;
+}
+
+HeightReading HeightController::getReading() const {
+    portENTER_CRITICAL(&readingMux_);
+    HeightReading snapshot = currentReading_;
+    portEXIT_CRITICAL(&readingMux_);
+    return snapshot;
+}
+
+ReadingValidity HeightController::getValidity() const {
+    return currentReading_.validity;
+}
+
+void HeightController::resetFilter() {
+    // Caller must hold sensorMutex_ if the acquisition task is running
+    filter_.reset();
+    kalman_.reset();
+    zoneFilter_.reset();
+    adaptiveWindow_.restart();
+    Logger::info(TAG, "Filter reset");
 }
 
 bool HeightController::isSensorReady() const {
-    return sensorInitialized_;
+    return sensorInitialized_ && !supervisor_.isRecovering();
 }
 
 unsigned long HeightController::getReadingAge() const {
@@ -303,11 +762,17 @@ unsigned long HeightController::getReadingAge() const {
 
 String HeightController::toJson() const {
     String json = "{";
-    json += "\"height\":" + String(currentReading_.calculated_height_cm) + ",";
+    json += "\"height\":" + String(HeightUnits::mmToCm(currentReading_.calculated_height_mm), 1) + ",";
+    json += "\"heightMm\":" + String(currentReading_.calculated_height_mm) + ",";
     json += "\"rawDistance\":" + String(currentReading_.raw_distance_mm) + ",";
     json += "\"filteredDistance\":" + String(currentReading_.filtered_distance_mm) + ",";
     json += "\"valid\":" + String(isValid() ? "true" : "false") + ",";
-    json += "\"age\":" + String(getReadingAge());
+    json += "\"age\":" + String(getReadingAge()) + ",";
+    json += "\"latencyUs\":" + String(currentReading_.latency_us) + ",";
+    json += "\"velocity\":" + String(currentReading_.velocity_mm_s) + ",";
+    json += "\"maxLatencyUs\":" + String(maxLatencyUs_) + ",";
+    json += "\"interruptMode\":" + String(isAcquisitionTaskRunning() ? "true" : "false") + ",";
+    json += "\"rangingHz\":" + String(rangingFrequencyHz_);
     json += "}";
     return json;
 }
@@ -328,12 +793,13 @@ const ConsensusResult& HeightController::getLastConsensus() const {
     return lastConsensus_;
 }
 
+uint32_t HeightController::getConsensusTimeUs() const {
+    return consensusTimeUs_;
+}
+
 String HeightController::getZoneDiagnostics() const {
-    // Get fresh sensor data for diagnostics
-    VL53L5CX_ResultsData results;
-    
-    // Note: This is a const method, so we can't call sensor_.getRangingData()
-    // Instead, return cached info from lastConsensus_ plus general structure
+    // Const method: report cached info from lastConsensus_ rather than
+    // reading the sensor
     String json = "{";
     json += "\"validZones\":" + String(lastConsensus_.valid_zone_count) + ",";
     json += "\"outliers\":" + String(lastConsensus_.outlier_count) + ",";
@@ -341,7 +807,71 @@ String HeightController::getZoneDiagnostics() const {
     json += "\"reliable\":" + String(lastConsensus_.is_reliable ? "true" : "false") + ",";
     json += "\"totalZones\":" + String(MULTI_ZONE_TOTAL_ZONES) + ",";
     json += "\"minValidZones\":" + String(MULTI_ZONE_MIN_VALID_ZONES) + ",";
-    json += "\"outlierThresholdMm\":" + String(MULTI_ZONE_OUTLIER_THRESHOLD_MM);
+    json += "\"outlierRule\":\"" + String(SystemConfig.getOutlierThreshold() == OutlierThresholdMethod::ADAPTIVE ? "adaptive" : "fixed") + "\",";
+    json += "\"outlierThresholdMm\":" + String(lastConsensus_.outlier_threshold_mm) + ",";
+    ConsensusMethod method = SystemConfig.getConsensusMethod();
+    if (!SENSOR_READOUT_HAS_CONFIDENCE && method == ConsensusMethod::CONFIDENCE_WEIGHTED) {
+        method = ConsensusMethod::MEDIAN_MEAN;
+    }
+    json += "\"consensusMethod\":\"" + String(consensusMethodName(method)) + "\",";
+    if (method == ConsensusMethod::PLANE_FIT) {
+        json += "\"floorPlane\":{";
+        json += "\"ok\":" + String(lastPlaneFit_.ok ? "true" : "false") + ",";
+        json += "\"inliers\":" + String(lastPlaneFit_.inlier_count) + ",";
+        json += "\"tiltXDeg\":" + String(lastPlaneFit_.tilt_x_deg, 2) + ",";
+        json += "\"tiltYDeg\":" + String(lastPlaneFit_.tilt_y_deg, 2) + ",";
+        json += "\"residualMm\":" + String(lastPlaneFit_.residual_mm, 2) + ",";
+        json += "\"fallbacks\":" + String(planeFallbacks_);
+        json += "},";
+    }
+    json += "\"zoneFilter\":\"" + String(zoneFilterActive_ ? "exponential" : "none") + "\",";
+    json += "\"bridgedZones\":" + String(zoneFilterActive_ ? zoneFilter_.getBridgedCount() : 0) + ",";
+    json += "\"estimatedSigmaMm\":" + String(lastConsensus_.estimated_sigma_mm, 2) + ",";
+    json += "\"filterWindowMode\":\"" + String(windowAdaptive_ ? "adaptive" : "fixed") + "\",";
+    json += "\"filterWindow\":" + String(filter_.getWindowSize()) + ",";
+    json += "\"adaptiveWindow\":" + String(adaptiveWindow_.getWindow()) + ",";
+    json += "\"consensusNoiseMm\":" + String(adaptiveWindow_.getNoiseMm(), 2) + ",";
+    json += "\"filterWindowSwitches\":" + String(adaptiveWindow_.getSwitchCount()) + ",";
+    json += "\"consensusTimeUs\":" + String(consensusTimeUs_) + ",";
+    json += "\"maxConsensusTimeUs\":" + String(maxConsensusTimeUs_) + ",";
+    uint64_t mask = getZoneMask();
+    char maskHex[19];
+    snprintf(maskHex, sizeof(maskHex), "0x%08lx%08lx",
+             (unsigned long)(mask >> 32), (unsigned long)(mask & 0xFFFFFFFFUL));
+    json += "\"zoneMask\":\"" + String(maskHex) + "\",";
+    json += "\"maskedZones\":" + String(ZoneMaskLearner::countMasked(mask)) + ",";
+    json += "\"zoneMaskLearning\":" + String(isZoneMaskLearning() ? "true" : "false") + ",";
+    json += "\"zoneMaskProgress\":\"" + String(zoneMaskLearner_.getFramesObserved()) + "/" +
+            String(zoneMaskLearner_.getTargetFrames()) + "\",";
+    json += "\"readoutBytes\":" + String(sensor_.getFrameBytes()) + ",";
+    uint32_t busHz = sensor_.getBusHz();
+    uint32_t busUs = (busHz > 0) ? SensorReadout::busTimeUs(sensor_.getFrameBytes(), busHz) : 0;
+    json += "\"readoutBusUs\":" + String(busUs) + ",";
+    json += "\"readoutTimeUs\":" + String(readoutTimeUs_) + ",";
+    json += "\"maxReadoutTimeUs\":" + String(maxReadoutTimeUs_) + ",";
+    json += "\"framePeriodUs\":" + String(1000000UL / rangingFrequencyHz_) + ",";
+    
+    // Supervisor: faults, recovery steps run and detection-to-first-frame times
+    json += "\"sensorHealth\":{";
+    json += "\"recovering\":" + String(supervisor_.isRecovering() ? "true" : "false") + ",";
+    json += "\"step\":\"" + String(SensorSupervisor::actionName(supervisor_.getStep())) + "\",";
+    json += "\"starvations\":" + String(supervisor_.getStarvationCount()) + ",";
+    json += "\"errorFaults\":" + String(supervisor_.getErrorFaultCount()) + ",";
+    json += "\"readErrors\":" + String(supervisor_.getReadErrorCount()) + ",";
+    json += "\"recoveries\":" + String(supervisor_.getRecoveryCount()) + ",";
+    json += "\"busClears\":" + String(supervisor_.getActionCount(SensorRecoveryAction::BUS_CLEAR)) + ",";
+    json += "\"wireReinits\":" + String(supervisor_.getActionCount(SensorRecoveryAction::WIRE_REINIT)) + ",";
+    json += "\"sensorResets\":" + String(supervisor_.getActionCount(SensorRecoveryAction::SENSOR_RESET)) + ",";
+    json += "\"lastRecoveryMs\":" + String(supervisor_.getLastRecoveryMs()) + ",";
+    json += "\"maxRecoveryMs\":" + String(supervisor_.getMaxRecoveryMs()) + ",";
+    json += "\"recoveryHistogram\":[";
+    for (uint8_t bin = 0; bin < SensorSupervisor::HISTOGRAM_BINS; bin++) {
+        if (bin > 0) json += ",";
+        uint32_t bound = SensorSupervisor::getHistogramBoundMs(bin);
+        json += "{\"ltMs\":" + (bound > 0 ? String(bound) : String("null")) + ",";
+        json += "\"count\":" + String(supervisor_.getHistogramCount(bin)) + "}";
+    }
+    json += "]}";
     json += "}";
     return json;
 }
@@ -350,102 +880,22 @@ String HeightController::getZoneDiagnostics() const {
 // Multi-Zone Filtering Implementation (per 002-multi-zone-filtering feature)
 // =============================================================================
 
-uint16_t HeightController::computeMedian(uint16_t* values, uint8_t count) {
-    if (count == 0) {
-        return 0;
-    }
-    if (count == 1) {
-        return values[0];
-    }
-    
-    // In-place insertion sort - fast for small arrays (n ≤ 16)
-    for (uint8_t i = 1; i < count; i++) {
-        uint16_t key = values[i];
-        int8_t j = i - 1;
-        while (j >= 0 && values[j] > key) {
-            values[j + 1] = values[j];
-            j--;
-        }
-        values[j + 1] = key;
-    }
-    
-    // Return middle element
-    // For even count: return lower middle (index count/2 - 1)
-    // For odd count: return middle (index count/2)
-    if (count % 2 == 0) {
-        return values[count / 2 - 1];
-    } else {
-        return values[count / 2];
-    }
-}
-
-uint16_t HeightController::computeMean(uint16_t* values, uint8_t count) {
-    if (count == 0) {
-        return 0;
-    }
-    
-    // Use uint32_t accumulator for overflow safety
-    // Max possible: 16 zones × 65535 = 1,048,560 (fits in uint32_t)
-    uint32_t sum = 0;
-    for (uint8_t i = 0; i < count; i++) {
-        sum += values[i];
-    }
-    
-    return static_cast<uint16_t>(sum / count);
-}
-
-void HeightController::filterOutliers(uint16_t* values, uint8_t count, uint16_t median,
-                                       bool* keep_flags, uint8_t& kept_count) {
-    kept_count = 0;
-    
-    for (uint8_t i = 0; i < count; i++) {
-        // Calculate absolute deviation from median
-        uint16_t deviation;
-        if (values[i] >= median) {
-            deviation = values[i] - median;
-        } else {
-            deviation = median - values[i];
-        }
-        
-        // Keep if within threshold (inclusive)
-        if (deviation <= MULTI_ZONE_OUTLIER_THRESHOLD_MM) {
-            keep_flags[i] = true;
-            kept_count++;
-        } else {
-            keep_flags[i] = false;
-        }
-    }
-}
-
-bool HeightController::isZoneValid(uint8_t status, uint16_t distance) const {
-    // Reject explicit invalid status codes
-    if (status == 0 || status == 255) {
-        return false;
-    }
-    
-    // Accept only high-confidence status codes: 5, 6, 9
-    // Per spec clarification: reject undefined codes (1-4, 7-8, 10+) conservatively
-    if (status != 5 && status != 6 && status != 9) {
-        return false;
-    }
-    
-    // Range validation
-    if (distance < SENSOR_MIN_VALID_MM || distance > SENSOR_MAX_RANGE_MM) {
-        return false;
-    }
-    
-    return true;
-}
-
-ConsensusResult HeightController::computeMultiZoneConsensus(const VL53L5CX_ResultsData& results) {
-    ConsensusResult consensus;
-    consensus.consensus_distance_mm = 0;
-    consensus.valid_zone_count = 0;
-    consensus.outlier_count = 0;
-    consensus.is_reliable = false;
-    
-    // Step 1: Extract and validate all 16 zones
+ConsensusResult HeightController::computeMultiZoneConsensus(const ZoneFrame& frame) {
+#if SENSOR_READOUT_HAS_CONFIDENCE
+    const bool weighted =
+        (SystemConfig.getConsensusMethod() == ConsensusMethod::CONFIDENCE_WEIGHTED);
+#else
+    // Minimal readout profile: no sigma/signal/ambient to weight with
+    const bool weighted = false;
+#endif
+    
+    // Step 1: Extract and validate all zones
     uint16_t valid_distances[MULTI_ZONE_TOTAL_ZONES];
+    uint8_t valid_zones[MULTI_ZONE_TOTAL_ZONES];
+#if SENSOR_READOUT_HAS_CONFIDENCE
+    uint16_t valid_sigmas[MULTI_ZONE_TOTAL_ZONES];
+#endif
+    float valid_weights[MULTI_ZONE_TOTAL_ZONES];
     uint8_t valid_count = 0;
     
     // Debug: Log all zone values periodically
@@ -456,21 +906,34 @@ ConsensusResult HeightController::computeMultiZoneConsensus(const VL53L5CX_Resul
     }
     
     for (uint8_t zone = 0; zone < MULTI_ZONE_TOTAL_ZONES; zone++) {
-        // Access zone data (NB_TARGET_PER_ZONE = 1 in our config)
-        uint8_t status = results.target_status[zone * VL53L5CX_NB_TARGET_PER_ZONE];
-        int16_t distance_signed = results.distance_mm[zone * VL53L5CX_NB_TARGET_PER_ZONE];
+        // Learned static obstructions are skipped before validation
+        if (zoneMask_ & (1ULL << zone)) {
+            continue;
+        }
+        
+        uint8_t status = frame.target_status[zone];
+        int16_t distance_signed = frame.distance_mm[zone];
         
         // Convert to unsigned (negative values are invalid)
         uint16_t distance = (distance_signed > 0) ? static_cast<uint16_t>(distance_signed) : 0;
+        bool valid = ZoneConsensus::isZoneValid(status, distance);
         
         if (logZones) {
             Logger::debug(TAG, "Zone %2d: status=%d, dist=%4dmm %s", 
-                         zone, status, distance,
-                         isZoneValid(status, distance) ? "VALID" : "invalid");
+                         zone, status, distance, valid ? "VALID" : "invalid");
         }
         
-        if (isZoneValid(status, distance)) {
+        if (valid) {
             valid_distances[valid_count] = distance;
+            valid_zones[valid_count] = zone;
+#if SENSOR_READOUT_HAS_CONFIDENCE
+            valid_sigmas[valid_count] = frame.range_sigma_mm[zone];
+            if (weighted) {
+                valid_weights[valid_count] = ZoneConsensus::zoneWeight(frame.range_sigma_mm[zone],
+                                                                       frame.signal_per_spad[zone],
+                                                                       frame.ambient_per_spad[zone]);
+            }
+#endif
             valid_count++;
         }
     }
@@ -479,51 +942,303 @@ ConsensusResult HeightController::computeMultiZoneConsensus(const VL53L5CX_Resul
         lastZoneLog = millis();
     }
     
-    consensus.valid_zone_count = valid_count;
+    // Steps 2-5: minimum zones, median, outlier rejection, (weighted) mean.
+    // Without confidence fields there are no sigmas: estimated sigma stays 0.
+#if SENSOR_READOUT_HAS_CONFIDENCE
+    const uint16_t* sigmas = valid_sigmas;
+#else
+    const uint16_t* sigmas = nullptr;
+#endif
+    ZoneConsensus::OutlierRule rule = {
+        SystemConfig.getOutlierThreshold() == OutlierThresholdMethod::ADAPTIVE,
+        SystemConfig.getOutlierMinMm(),
+        SystemConfig.getOutlierMaxMm()
+    };
+    uint16_t median = 0;
+    ConsensusResult consensus = ZoneConsensus::combine(valid_distances, sigmas,
+                                                       weighted ? valid_weights : nullptr,
+                                                       valid_count, MULTI_ZONE_MIN_VALID_ZONES,
+                                                       &median, rule);
     
-    // Step 2: Check minimum zone threshold
     if (valid_count < MULTI_ZONE_MIN_VALID_ZONES) {
         Logger::warn(TAG, "Insufficient valid zones: %d (min %d)", 
                      valid_count, MULTI_ZONE_MIN_VALID_ZONES);
-        consensus.is_reliable = false;
         return consensus;
     }
     
-    // Step 3: Compute median (need copy since computeMedian sorts in-place)
-    uint16_t median_input[MULTI_ZONE_TOTAL_ZONES];
-    memcpy(median_input, valid_distances, valid_count * sizeof(uint16_t));
-    uint16_t median = computeMedian(median_input, valid_count);
-    
-    // Step 4: Filter outliers
-    bool keep_flags[MULTI_ZONE_TOTAL_ZONES];
-    uint8_t kept_count = 0;
-    filterOutliers(valid_distances, valid_count, median, keep_flags, kept_count);
-    
-    consensus.outlier_count = valid_count - kept_count;
+    if (zoneMaskLearner_.isActive()) {
+        observeZoneMask(frame, median, consensus.outlier_threshold_mm);
+    }
     
-    // Step 5: Compute mean of non-outliers
-    if (kept_count == 0) {
+    if (!consensus.is_reliable) {
         // Edge case: all valid zones are outliers (should be rare)
         Logger::warn(TAG, "All %d valid zones are outliers!", valid_count);
-        consensus.is_reliable = false;
         return consensus;
     }
     
-    // Collect non-outlier values
-    uint16_t kept_values[MULTI_ZONE_TOTAL_ZONES];
-    uint8_t kept_index = 0;
-    for (uint8_t i = 0; i < valid_count; i++) {
-        if (keep_flags[i]) {
-            kept_values[kept_index++] = valid_distances[i];
+    // Plane fit over all valid zones, not just the ones near the median:
+    // on a tilted floor the edge zones are genuine floor. Same threshold,
+    // measured from the plane instead of the median.
+    if (SystemConfig.getConsensusMethod() == ConsensusMethod::PLANE_FIT) {
+        lastPlaneFit_ = floorPlane_.fit(valid_zones, valid_distances, valid_count,
+                                        consensus.outlier_threshold_mm, median);
+        if (lastPlaneFit_.ok && lastPlaneFit_.inlier_count >= MULTI_ZONE_MIN_VALID_ZONES) {
+            consensus.consensus_distance_mm = lastPlaneFit_.axis_distance_mm;
+            consensus.outlier_count = valid_count - lastPlaneFit_.inlier_count;
+        } else {
+            // Keep the median-mean result
+            planeFallbacks_++;
         }
     }
     
-    consensus.consensus_distance_mm = computeMean(kept_values, kept_count);
-    consensus.is_reliable = true;
-    
-    Logger::debug(TAG, "Multi-zone consensus: %dmm (%d zones, %d outliers, median %dmm)",
+    Logger::debug(TAG, "Multi-zone consensus: %dmm (%d zones, %d outliers, median %dmm, threshold %dmm)",
                   consensus.consensus_distance_mm, valid_count, 
-                  consensus.outlier_count, median);
+                  consensus.outlier_count, median, consensus.outlier_threshold_mm);
     
     return consensus;
 }
+
+// =============================================================================
+// Learned Zone Mask
+// =============================================================================
+
+void HeightController::startZoneMaskLearning(uint16_t frames) {
+    if (frames == 0) {
+        frames = ZONE_MASK_LEARN_FRAMES;
+    }
+    if (frames > ZONE_MASK_MAX_LEARN_FRAMES) {
+        frames = ZONE_MASK_MAX_LEARN_FRAMES;
+    }
+    
+    portENTER_CRITICAL(&readingMux_);
+    zoneMaskLearnFrames_ = frames;
+    zoneMaskCommand_ = ZoneMaskCommand::LEARN;
+    portEXIT_CRITICAL(&readingMux_);
+    
+    // Wake the task so the switch to the active rate happens now
+    if (acquisitionTask_ != nullptr) {
+        xTaskNotifyGive(acquisitionTask_);
+    }
+}
+
+void HeightController::clearZoneMask() {
+    portENTER_CRITICAL(&readingMux_);
+    zoneMaskCommand_ = ZoneMaskCommand::CLEAR;
+    portEXIT_CRITICAL(&readingMux_);
+    
+    if (acquisitionTask_ != nullptr) {
+        xTaskNotifyGive(acquisitionTask_);
+    }
+}
+
+bool HeightController::isZoneMaskLearning() const {
+    return zoneMaskCommand_ == ZoneMaskCommand::LEARN || zoneMaskLearner_.isActive();
+}
+
+uint64_t HeightController::getZoneMask() const {
+    // 64-bit value written by the acquisition task
+    portENTER_CRITICAL(&readingMux_);
+    uint64_t mask = zoneMask_;
+    portEXIT_CRITICAL(&readingMux_);
+    return mask;
+}
+
+void HeightController::setTraceRecorder(TraceRecorder* recorder) {
+    traceRecorder_ = recorder;
+}
+
+void HeightController::applyZoneMaskCommand() {
+    portENTER_CRITICAL(&readingMux_);
+    ZoneMaskCommand command = zoneMaskCommand_;
+    uint16_t frames = zoneMaskLearnFrames_;
+    zoneMaskCommand_ = ZoneMaskCommand::NONE;
+    portEXIT_CRITICAL(&readingMux_);
+    
+    if (command == ZoneMaskCommand::LEARN) {
+        zoneMaskLearner_.start(frames);
+        Logger::info(TAG, "Zone mask learning started (%d frames)", frames);
+    } else if (command == ZoneMaskCommand::CLEAR) {
+        zoneMaskLearner_.cancel();
+        portENTER_CRITICAL(&readingMux_);
+        zoneMask_ = 0;
+        zoneMaskDirty_ = true;
+        portEXIT_CRITICAL(&readingMux_);
+        Logger::info(TAG, "Zone mask cleared");
+    }
+}
+
+void HeightController::observeZoneMask(const ZoneFrame& frame, uint16_t floor_mm,
+                                       uint16_t threshold_mm) {
+    for (uint8_t zone = 0; zone < MULTI_ZONE_TOTAL_ZONES; zone++) {
+        int16_t distance_signed = frame.distance_mm[zone];
+        uint16_t distance = (distance_signed > 0) ? static_cast<uint16_t>(distance_signed) : 0;
+        
+        bool consistent = false;
+        if (ZoneConsensus::isZoneValid(frame.target_status[zone], distance)) {
+            uint16_t deviation = (distance >= floor_mm) ? distance - floor_mm : floor_mm - distance;
+            consistent = (deviation <= threshold_mm);
+        }
+        zoneMaskLearner_.observe(zone, consistent);
+    }
+    zoneMaskLearner_.endFrame();
+}
+
+void HeightController::finishZoneMaskLearning() {
+    uint64_t mask = zoneMaskLearner_.computeMask(ZONE_MASK_INCONSISTENT_PERCENT,
+                                                 ZONE_MASK_MIN_UNMASKED_ZONES);
+    
+    portENTER_CRITICAL(&readingMux_);
+    zoneMask_ = mask;
+    zoneMaskDirty_ = true;
+    portEXIT_CRITICAL(&readingMux_);
+    
+    Logger::info(TAG, "Zone mask learned over %d frames: %d of %d zones masked",
+                 zoneMaskLearner_.getFramesObserved(),
+                 ZoneMaskLearner::countMasked(mask), MULTI_ZONE_TOTAL_ZONES);
+}
+
+void HeightController::persistZoneMask() {
+    if (!zoneMaskDirty_) {
+        return;
+    }
+    // Flag cleared with the copy: a mask changed during the write is saved next time
+    portENTER_CRITICAL(&readingMux_);
+    uint64_t mask = zoneMask_;
+    zoneMaskDirty_ = false;
+    portEXIT_CRITICAL(&readingMux_);
+    
+    if (!SystemConfig.setZoneMask(mask)) {
+        Logger::error(TAG, "Failed to persist zone mask");
+    }
+}
+
+// =============================================================================
+// Calibration Job
+// =============================================================================
+
+uint32_t HeightController::startCalibration(uint16_t known_height_mm) {
+    if (!sensorInitialized_) {
+        Logger::error(TAG, "Cannot calibrate: sensor not initialized");
+        return 0;
+    }
+    
+    uint32_t jobId = 0;
+    portENTER_CRITICAL(&readingMux_);
+    if (calibrationStatus_.state != CalibrationState::RUNNING) {
+        jobId = nextCalibrationJobId_++;
+        calibrationStatus_.job_id = jobId;
+        calibrationStatus_.state = CalibrationState::RUNNING;
+        calibrationStatus_.sequence++;
+        calibrationStatus_.known_height_mm = known_height_mm;
+        calibrationStatus_.samples = 0;
+        calibrationStatus_.mean_distance_mm = 0;
+        calibrationStatus_.std_error_mm = 0.0f;
+        calibrationStatus_.offset_mm = 0;
+        calibrationStatus_.error = "";
+        calibrationPending_ = true;
+    }
+    portEXIT_CRITICAL(&readingMux_);
+    
+    if (jobId == 0) {
+        Logger::warn(TAG, "Calibration already running");
+        return 0;
+    }
+    
+    Logger::info(TAG, "Calibration job %lu queued at known height: %d mm",
+                 (unsigned long)jobId, known_height_mm);
+    
+    // Wake the task so the switch to the active rate happens now
+    if (acquisitionTask_ != nullptr) {
+        xTaskNotifyGive(acquisitionTask_);
+    }
+    return jobId;
+}
+
+CalibrationStatus HeightController::getCalibrationStatus() const {
+    portENTER_CRITICAL(&readingMux_);
+    CalibrationStatus snapshot = calibrationStatus_;
+    portEXIT_CRITICAL(&readingMux_);
+    return snapshot;
+}
+
+void HeightController::serviceCalibration() {
+    if (calibrationPending_) {
+        calibrationPending_ = false;
+        calibrationSampler_.start(CALIBRATION_MIN_SAMPLES, CALIBRATION_MAX_SAMPLES,
+                                  CALIBRATION_TARGET_STDERR_MM);
+        calibrationDeadlineMs_ = millis() + CALIBRATION_TIMEOUT_MS;
+        return;
+    }
+    
+    if (calibrationSampler_.isActive() &&
+        static_cast<long>(millis() - calibrationDeadlineMs_) >= 0) {
+        calibrationSampler_.cancel();
+        Logger::error(TAG, "Calibration failed: timed out with %d reliable frames",
+                      calibrationSampler_.getCount());
+        failCalibration("Timed out waiting for reliable sensor frames");
+    }
+}
+
+void HeightController::observeCalibration(const ConsensusResult& consensus) {
+    if (!consensus.is_reliable) {
+        return;
+    }
+    
+    bool done = calibrationSampler_.addSample(consensus.consensus_distance_mm);
+    float stdErr = calibrationSampler_.getStdErrMm();
+    
+    portENTER_CRITICAL(&readingMux_);
+    calibrationStatus_.samples = calibrationSampler_.getCount();
+    calibrationStatus_.mean_distance_mm = calibrationSampler_.getMeanMm();
+    calibrationStatus_.std_error_mm = (calibrationSampler_.getCount() < 2) ? 0.0f : stdErr;
+    calibrationStatus_.sequence++;
+    portEXIT_CRITICAL(&readingMux_);
+    
+    if (done) {
+        finishCalibration();
+    }
+}
+
+void HeightController::finishCalibration() {
+    uint16_t avg_reading_mm = calibrationSampler_.getMeanMm();
+    float stdErr = calibrationSampler_.getStdErrMm();
+    
+    if (!calibrationSampler_.isConverged() && stdErr > CALIBRATION_ACCEPT_STDERR_MM) {
+        Logger::error(TAG, "Calibration failed: readings unstable (std error %.2f mm over %d samples)",
+                      stdErr, calibrationSampler_.getCount());
+        failCalibration("Readings unstable - keep the desk still");
+        return;
+    }
+    
+    uint16_t known_height_mm = getCalibrationStatus().known_height_mm;
+    
+    // calibration_offset_mm = known_height_mm - sensor_reading_mm
+    // This gives us the offset to add to future readings
+    int16_t calibration_offset = HeightUnits::calibrationOffset(known_height_mm, avg_reading_mm);
+    
+    Logger::info(TAG, "Calibration: avg reading = %d mm (%d samples, std error %.2f mm), offset = %d mm",
+                 avg_reading_mm, calibrationSampler_.getCount(), stdErr, calibration_offset);
+    
+    // RAM only: loop() saves it (no flash write with the sensor mutex held)
+    SystemConfig.learnCalibrationOffsetMm(calibration_offset);
+    
+    // Reset filter to start fresh with calibrated readings
+    // (caller holds sensorMutex_)
+    resetFilter();
+    
+    portENTER_CRITICAL(&readingMux_);
+    calibrationStatus_.offset_mm = calibration_offset;
+    calibrationStatus_.state = CalibrationState::SUCCEEDED;
+    calibrationStatus_.sequence++;
+    portEXIT_CRITICAL(&readingMux_);
+    
+    Logger::info(TAG, "Calibration successful!");
+}
+
+void HeightController::failCalibration(const char* reason) {
+    portENTER_CRITICAL(&readingMux_);
+    calibrationStatus_.state = CalibrationState::FAILED;
+    calibrationStatus_.error = reason;
+    calibrationStatus_.sequence++;
+    portEXIT_CRITICAL(&readingMux_);
+}
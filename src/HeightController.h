@@ -3,12 +3,20 @@
  * @brief Height measurement controller with VL53L5CX sensor integration
  * 
  * Responsible for:
- * - VL53L5CX ToF sensor initialization and reading
- * - Moving average filtering of sensor data
+ * - Multi-zone ToF sensor initialization and reading (DistanceSensor:
+ *   VL53L5CXSensor on the device, the desk simulator in native tests)
+ * - Moving average filtering of sensor data, optionally with the window
+ *   sized from the measured consensus noise (utils/NoiseAdaptiveWindow.h)
  * - Height calculation using calibration formula
  * - Validity checking of readings
+ * - Optional data-ready interrupt driven acquisition task
+ * - Supervision: frame starvation / I2C error detection with escalating
+ *   in-place recovery (see utils/SensorSupervisor.h)
+ * - Obstruction watch on the raw zones while the desk is lowering
+ *   (see utils/ObstructionDetector.h)
  * 
- * Per FR-001: height_cm = calibration_constant_cm - (sensor_reading_mm / 10)
+ * Per FR-001: height derived from the filtered floor distance and the
+ * calibration offset, kept in mm end to end (see utils/HeightUnits.h)
  * Per FR-001a: Moving average filter applied to smooth sensor noise
  */
 
@@ -16,10 +24,25 @@
 #define HEIGHT_CONTROLLER_H
 
 #include <Arduino.h>
-#include <SparkFun_VL53L5CX_Library.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
 #include "Config.h"
 #include "SystemConfiguration.h"
+#include "DistanceSensor.h"
 #include "utils/MovingAverageFilter.h"
+#include "utils/NoiseAdaptiveWindow.h"
+#include "utils/ObstructionDetector.h"
+#include "utils/VelocityKalmanFilter.h"
+#include "utils/ZoneMaskLearner.h"
+#include "utils/CalibrationSampler.h"
+#include "utils/FloorPlane.h"
+#include "utils/RetainedState.h"
+#include "utils/SensorSupervisor.h"
+#include "utils/ZoneConsensus.h"
+#include "utils/ZoneTemporalFilter.h"
+
+class TraceRecorder;
 
 /**
  * @enum ReadingValidity
@@ -31,30 +54,67 @@ enum class ReadingValidity : uint8_t {
     STALE       ///< Reading is too old (> 1000ms)
 };
 
+/**
+ * @enum RangingProfile
+ * @brief Sensor ranging rate selected from movement activity
+ */
+enum class RangingProfile : uint8_t {
+    IDLE,       ///< Desk stationary: RANGING_FREQUENCY_IDLE_HZ
+    ACTIVE      ///< Desk moving or stabilizing: RANGING_FREQUENCY_ACTIVE_HZ
+};
+
 /**
  * @struct HeightReading
  * @brief Complete height measurement data per data-model.md Section 1
  */
 struct HeightReading {
     uint16_t raw_distance_mm;         ///< Unprocessed sensor reading
-    uint16_t filtered_distance_mm;    ///< After moving average
-    uint16_t calculated_height_cm;    ///< Final desk height
+    uint16_t filtered_distance_mm;    ///< After temporal filter (moving average or Kalman)
+    uint16_t calculated_height_mm;    ///< Final desk height (mm; cm only in JSON)
     unsigned long timestamp_ms;       ///< When reading was captured
+    uint32_t latency_us;              ///< Data-ready to publish latency
+    int16_t velocity_mm_s;            ///< Kalman velocity estimate (positive = rising)
     ReadingValidity validity;         ///< Reading quality status
 };
 
 /**
- * @struct ConsensusResult
- * @brief Multi-zone consensus result per data-model.md Section 2
- * 
- * Aggregated distance estimate from multiple valid zones after outlier filtering.
- * Used for spatial filtering stage before temporal moving average.
+ * @enum CalibrationState
+ * @brief Lifecycle of a calibration job
+ */
+enum class CalibrationState : uint8_t {
+    IDLE,       ///< No job since boot
+    RUNNING,    ///< Collecting consensus samples
+    SUCCEEDED,  ///< Offset computed and saved
+    FAILED      ///< Timed out, too noisy or could not be saved
+};
+
+/**
+ * @struct CalibrationStatus
+ * @brief Snapshot of the current/last calibration job (API and SSE)
+ */
+struct CalibrationStatus {
+    uint32_t job_id;                  ///< Returned by startCalibration(), 0 = none
+    CalibrationState state;
+    uint32_t sequence;                ///< Bumped on every change (SSE progress)
+    uint16_t known_height_mm;         ///< Height entered by the user
+    uint16_t samples;                 ///< Reliable consensus frames collected
+    uint16_t mean_distance_mm;        ///< Running mean of the samples
+    float std_error_mm;               ///< Standard error of the mean (0 until 2 samples)
+    int16_t offset_mm;                ///< Saved offset (SUCCEEDED only)
+    const char* error;                ///< Failure reason (FAILED only)
+};
+
+/**
+ * @struct ObstructionEvent
+ * @brief Object detected under the desk while it was lowering
  */
-struct ConsensusResult {
-    uint16_t consensus_distance_mm;   ///< Median-filtered mean of valid zones
-    uint8_t valid_zone_count;         ///< Number of zones that passed validation (0-16)
-    uint8_t outlier_count;            ///< Number of zones excluded as outliers
-    bool is_reliable;                 ///< true if >= 4 valid zones (per FR-007)
+struct ObstructionEvent {
+    uint32_t frame_ready_us;          ///< Data-ready time of the frame that showed it
+    uint32_t sequence;                ///< Reading sequence that frame was published under
+    uint8_t zone_count;               ///< Zones in the cluster that tripped the detector
+    uint8_t new_zone_count;           ///< Of those, zones not short in the reference frame
+    uint16_t clearance_mm;            ///< Sensor to the nearest zone of the cluster
+    uint16_t floor_mm;                ///< Floor distance it was compared with
 };
 
 /**
@@ -62,41 +122,146 @@ struct ConsensusResult {
  * @brief Manages height sensing and calculation
  * 
  * Usage:
- *   HeightController height;
+ *   VL53L5CXSensor tofSensor;
+ *   HeightController height(tofSensor);
  *   if (height.init()) {
  *       // In loop every 200ms:
  *       height.update();
  *       if (height.isValid()) {
- *           uint16_t h = height.getCurrentHeight();
+ *           uint16_t h = height.getCurrentHeightMm();
  *       }
  *   }
+ * 
+ * Interrupt mode (SENSOR_USE_DATA_READY_INTERRUPT):
+ *   height.init();
+ *   height.startAcquisitionTask();  // Frames are published by the task
+ *   // In loop: react when getReadingSequence() changes
  */
 class HeightController {
 public:
     /**
      * @brief Construct HeightController
+     * @param sensor Distance sensor to range with (must outlive the controller)
      */
-    HeightController();
+    explicit HeightController(DistanceSensor& sensor);
     
     /**
      * @brief Initialize sensor and I2C
+     * 
+     * After a warm reset the last reading and filter samples are restored
+     * from RTC memory once the sensor is up, so a VALID height is
+     * published before the first new frame.
+     * 
+     * @param warmReset true after a software/watchdog/panic reset
      * @return true if sensor initialized successfully
      */
-    bool init();
+    bool init(bool warmReset = false);
     
     /**
-     * @brief Update sensor reading (call at 5Hz / 200ms intervals)
+     * @brief Update sensor reading (call every getSampleIntervalMs())
      * 
      * Reads sensor, applies filter, calculates height.
      * Call this from main loop.
      */
     void update();
     
+    /**
+     * @brief Start the data-ready interrupt driven acquisition task
+     * 
+     * Attaches a falling-edge interrupt to PIN_SENSOR_INT and creates a
+     * FreeRTOS task that reads, filters and publishes each frame as soon
+     * as the sensor signals it. update() must not be called afterwards.
+     * 
+     * @return true if the interrupt and task were set up
+     */
+    bool startAcquisitionTask();
+    
+    /**
+     * @brief Check if the acquisition task is running
+     * @return true if frames are published by the interrupt task
+     */
+    bool isAcquisitionTaskRunning() const;
+    
+    /**
+     * @brief Get publish sequence number
+     * 
+     * Incremented every time a frame is processed (valid or not).
+     * Lets the main loop react to new readings without polling the sensor.
+     * 
+     * @return uint32_t Monotonic frame counter
+     */
+    uint32_t getReadingSequence() const;
+    
+    /**
+     * @brief Get worst-case data-ready to publish latency since boot
+     * @return uint32_t Latency in microseconds
+     */
+    uint32_t getMaxLatencyUs() const;
+    
+    /**
+     * @brief Get duration of the sensor firmware upload in init()
+     * @return uint32_t Microseconds (including a fallback retry)
+     */
+    uint32_t getFirmwareUploadUs() const;
+    
+    /**
+     * @brief Get I2C clock the firmware upload succeeded at
+     * @return uint32_t Hz (I2C_FIRMWARE_UPLOAD_FREQUENCY or I2C_FREQUENCY)
+     */
+    uint32_t getFirmwareUploadHz() const;
+    
+    /**
+     * @brief Get time of the first VALID reading after boot
+     * @return uint32_t micros() timestamp, 0 if none yet
+     */
+    uint32_t getFirstValidReadingUs() const;
+    
+    /**
+     * @brief Check if init() restored the reading retained before a reset
+     * @return true if this boot started from the retained reading
+     */
+    bool isWarmStart() const;
+    
+    /**
+     * @brief Request a ranging profile (thread-safe, non-blocking)
+     * 
+     * The change is applied by the acquisition path (task or next update())
+     * so the sensor is only ever touched from one context. In interrupt mode
+     * the task is woken immediately.
+     * 
+     * @param profile Desired profile
+     */
+    void requestRangingProfile(RangingProfile profile);
+    
+    /**
+     * @brief Check if a requested profile has not been applied yet
+     * @return true if update() should run as soon as possible
+     */
+    bool isRangingProfilePending() const;
+    
+    /**
+     * @brief Get the ranging profile currently applied to the sensor
+     * @return RangingProfile Active profile
+     */
+    RangingProfile getRangingProfile() const;
+    
+    /**
+     * @brief Get current sensor ranging frequency
+     * @return uint8_t Frequency in Hz
+     */
+    uint8_t getRangingFrequency() const;
+    
+    /**
+     * @brief Get current frame period (control loop period in polling mode)
+     * @return uint16_t Period in ms
+     */
+    uint16_t getSampleIntervalMs() const;
+    
     /**
      * @brief Get current calculated height
-     * @return uint16_t Height in cm, or 0 if invalid
+     * @return uint16_t Height in mm, or 0 if uncalibrated
      */
-    uint16_t getCurrentHeight() const;
+    uint16_t getCurrentHeightMm() const;
     
     /**
      * @brief Get current raw distance reading
@@ -118,9 +283,13 @@ public:
     
     /**
      * @brief Get complete reading structure
-     * @return const HeightReading& Current reading data
+     * 
+     * Returns a consistent snapshot; safe to call while the acquisition
+     * task is publishing.
+     * 
+     * @return HeightReading Current reading data
      */
-    const HeightReading& getReading() const;
+    HeightReading getReading() const;
     
     /**
      * @brief Get reading validity status
@@ -128,6 +297,24 @@ public:
      */
     ReadingValidity getValidity() const;
     
+    /**
+     * @brief Start or stop watching for an obstruction (thread-safe, non-blocking)
+     * 
+     * Called by MovementController when lowering starts and ends. Each
+     * start re-arms the detector; the first frame after it is the
+     * reference for what already is under the desk.
+     * 
+     * @param watch true while the desk is lowering
+     */
+    void watchForObstruction(bool watch);
+    
+    /**
+     * @brief Get the obstruction detected since the last watchForObstruction(true)
+     * @param event Filled in if one was detected
+     * @return true if the detector tripped while watching
+     */
+    bool getObstruction(ObstructionEvent& event) const;
+    
     /**
      * @brief Reset filter and clear history
      * 
@@ -136,18 +323,27 @@ public:
     void resetFilter();
     
     /**
-     * @brief Perform calibration at known height
+     * @brief Start a calibration job at a known height
      * 
-     * Per FR-019: calibration_constant_cm = H_cm + (S_mm / 10)
+     * Per FR-019, in mm: calibration_offset_mm = H_mm - S_mm, where S_mm
+     * is the mean multi-zone consensus distance. The job runs on the
+     * acquisition path (ranging at the active rate) and returns at once;
+     * follow it with getCalibrationStatus(). Safe to call from any task.
      * 
-     * @param known_height_cm Actual desk height when calibrating
-     * @return true if calibration successful
+     * @param known_height_mm Actual desk height when calibrating
+     * @return uint32_t Job id, or 0 if the sensor is not ready or a job is running
+     */
+    uint32_t startCalibration(uint16_t known_height_mm);
+    
+    /**
+     * @brief Get a snapshot of the current/last calibration job
+     * @return CalibrationStatus Job status
      */
-    bool calibrate(uint16_t known_height_cm);
+    CalibrationStatus getCalibrationStatus() const;
     
     /**
      * @brief Check if sensor is initialized and operational
-     * @return true if sensor is ready
+     * @return true if sensor is ready (false while a fault is being recovered)
      */
     bool isSensorReady() const;
     
@@ -169,7 +365,7 @@ public:
     
     /**
      * @brief Get number of valid zones from last consensus computation
-     * @return uint8_t Count of zones that passed validation (0-16)
+     * @return uint8_t Count of zones that passed validation (0-MULTI_ZONE_TOTAL_ZONES)
      */
     uint8_t getValidZoneCount() const;
     
@@ -185,6 +381,49 @@ public:
      */
     const ConsensusResult& getLastConsensus() const;
     
+    /**
+     * @brief Get consensus computation time of the last frame (including the
+     *        per-zone filter when enabled)
+     * @return uint32_t Time in microseconds
+     */
+    uint32_t getConsensusTimeUs() const;
+    
+    /**
+     * @brief Start learning the static obstruction zone mask
+     * 
+     * Runs on the acquisition path over the next frames (ranging at the
+     * active rate meanwhile); the result is persisted in NVS by
+     * persistZoneMask(). Safe to call from any task.
+     * 
+     * @param frames Frames to observe (1-ZONE_MASK_MAX_LEARN_FRAMES)
+     */
+    void startZoneMaskLearning(uint16_t frames = ZONE_MASK_LEARN_FRAMES);
+    
+    /**
+     * @brief Clear the zone mask (and cancel learning). Safe from any task.
+     */
+    void clearZoneMask();
+    
+    /**
+     * @brief Check if a zone mask learning run is in progress or queued
+     * @return true while learning
+     */
+    bool isZoneMaskLearning() const;
+    
+    /**
+     * @brief Get zones currently skipped by the consensus
+     * @return uint64_t Bit n set = zone n masked
+     */
+    uint64_t getZoneMask() const;
+    
+    /**
+     * @brief Save a zone mask learned or cleared since the last call (from loop())
+     * 
+     * The acquisition path only changes the mask in RAM: an NVS write
+     * stalls both cores while it holds the sensor mutex.
+     */
+    void persistZoneMask();
+    
     /**
      * @brief Get zone diagnostics as JSON array
      * 
@@ -194,100 +433,326 @@ public:
      * @return String JSON array with zone details
      */
     String getZoneDiagnostics() const;
-
+    
+    /**
+     * @brief Set trace recorder (optional); every frame read is offered to it
+     * 
+     * Set before startAcquisitionTask().
+     * 
+     * @param recorder Pointer to the recorder, nullptr to disable
+     */
+    void setTraceRecorder(TraceRecorder* recorder);
+    
 private:
-    SparkFun_VL53L5CX sensor_;
+    DistanceSensor& sensor_;
     MovingAverageFilter filter_;
+    VelocityKalmanFilter kalman_;     ///< Always updated so velocity is available in either mode
     HeightReading currentReading_;
     bool sensorInitialized_;
     ConsensusResult lastConsensus_;  ///< Cached for diagnostics (P3)
     
+    // Interrupt acquisition state
+    TaskHandle_t acquisitionTask_;
+    SemaphoreHandle_t sensorMutex_;      ///< Serializes I2C access to sensor_
+    mutable portMUX_TYPE readingMux_;    ///< Guards currentReading_ snapshots
+    volatile uint32_t readingSequence_;
+    uint32_t maxLatencyUs_;
+    
+    // Adaptive ranging state
+    volatile RangingProfile requestedProfile_;
+    RangingProfile activeProfile_;
+    uint8_t rangingFrequencyHz_;
+    unsigned long rangingStartMs_;   ///< millis() of the last ranging (re)start
+    uint8_t configuredWindowSize_;   ///< Filter window at RANGING_FREQUENCY_REFERENCE_HZ
+    
+    // Noise-adaptive filter window (FilterWindowMode::ADAPTIVE); the noise
+    // estimate is fed in either mode so diagnostics always show it
+    NoiseAdaptiveWindow adaptiveWindow_;
+    bool windowAdaptive_;            ///< filter_ is sized from adaptiveWindow_
+    
+    // Per-frame spatial stage timing (zone filter + consensus, zone-count dependent)
+    uint32_t consensusTimeUs_;
+    uint32_t maxConsensusTimeUs_;
+    
+    // Frame buffer reused every frame (not on the task stack); only
+    // touched with sensorMutex_ held
+    ZoneFrame frame_;
+    
+    // Floor-plane consensus (ConsensusMethod::PLANE_FIT); last fit kept for diagnostics
+    FloorPlaneEstimator floorPlane_;
+    PlaneFit lastPlaneFit_;
+    uint32_t planeFallbacks_;        ///< Frames the fit failed and the mean was used
+    
+    // Obstruction watch while lowering; armed on the acquisition path
+    ObstructionDetector obstructionDetector_;
+    volatile bool obstructionWatch_;
+    volatile uint32_t obstructionWatchId_;   ///< Bumped by every watchForObstruction(true)
+    uint32_t obstructionArmedId_;            ///< Watch the detector is armed for
+    uint32_t obstructionEventId_;            ///< Watch obstructionEvent_ belongs to (0 = none)
+    ObstructionEvent obstructionEvent_;      ///< Guarded by readingMux_
+    
+    // Per-zone temporal stage ahead of the consensus (ZoneFilterMethod::EXPONENTIAL)
+    ZoneTemporalFilter zoneFilter_;
+    bool zoneFilterActive_;          ///< Ran on the previous frame (estimates are current)
+    
+    // Per-frame readFrame() time (I2C transfer + ULD parsing)
+    uint32_t readoutTimeUs_;
+    uint32_t maxReadoutTimeUs_;
+    
+    // Bring-up timing (GET /boot)
+    uint32_t firmwareUploadUs_;          ///< sensor_.begin() incl. any retry
+    uint32_t firmwareUploadHz_;          ///< I2C clock the upload succeeded at
+    volatile uint32_t firstValidReadingUs_;  ///< micros() of first VALID reading, 0 = none yet
+    bool warmStart_;                     ///< Reading restored from RTC memory in init()
+    
+    // Learned static obstruction mask (applied before zone validation)
+    enum class ZoneMaskCommand : uint8_t { NONE, LEARN, CLEAR };
+    volatile ZoneMaskCommand zoneMaskCommand_;  ///< Set by API, applied on the acquisition path
+    volatile uint16_t zoneMaskLearnFrames_;
+    uint64_t zoneMask_;
+    volatile bool zoneMaskDirty_;               ///< zoneMask_ changed, not yet saved
+    ZoneMaskLearner zoneMaskLearner_;
+    
+    // Fault detection and recovery; only touched with sensorMutex_ held
+    // (diagnostics read the counters without it)
+    SensorSupervisor supervisor_;
+    
+    // Calibration job (started by API, sampled on the acquisition path)
+    volatile bool calibrationPending_;
+    uint32_t nextCalibrationJobId_;
+    unsigned long calibrationDeadlineMs_;
+    CalibrationStatus calibrationStatus_;   ///< Guarded by readingMux_
+    CalibrationSampler calibrationSampler_;
+    
+    TraceRecorder* traceRecorder_;          ///< Raw frame trace (optional)
+    
+    static HeightController* isrInstance_;
+    static volatile uint32_t dataReadyTimestampUs_;
+    
     /**
-     * @brief Read raw value from sensor (legacy single-zone)
-     * @return uint16_t Distance in mm, or 0 on error
-     * @deprecated Use computeMultiZoneConsensus() instead
+     * @brief Reading and filter window retained across a warm reset
      */
-    uint16_t readSensor();
+    struct RetainedHeight {
+        HeightReading reading;
+        uint16_t filterSamples[MovingAverageFilter::capacity()];  ///< Oldest first
+        uint8_t filterSampleCount;
+    };
+    static RetainedState<RetainedHeight> retained_;  ///< In RTC memory (RTC_NOINIT_ATTR)
     
     /**
-     * @brief Validate a raw reading
-     * @param reading Raw sensor value in mm
-     * @return ReadingValidity Validity status
+     * @brief Data-ready ISR: timestamps the edge and wakes the task
      */
-    ReadingValidity validateReading(uint16_t reading) const;
+    static void IRAM_ATTR onDataReadyISR();
     
     /**
-     * @brief Calculate height from filtered distance
-     * @param filtered_mm Filtered distance in mm
-     * @return uint16_t Height in cm
+     * @brief FreeRTOS task entry point
+     * @param param HeightController instance
      */
-    uint16_t calculateHeight(uint16_t filtered_mm) const;
+    static void acquisitionTaskEntry(void* param);
     
-    // =========================================================================
-    // Multi-Zone Filtering Methods (per 002-multi-zone-filtering feature)
-    // =========================================================================
+    /**
+     * @brief Acquisition task body (never returns)
+     */
+    void acquisitionLoop();
     
     /**
-     * @brief Compute consensus distance from all 16 sensor zones
+     * @brief Read, filter and publish one frame
      * 
-     * Two-stage spatial filtering:
-     * 1. Validate each zone (status codes, range)
-     * 2. Compute median of valid zones
-     * 3. Filter outliers (>30mm from median)
-     * 4. Compute mean of remaining non-outliers
+     * Shared by the polling update() path and the acquisition task.
+     * Caller must hold sensorMutex_ and have confirmed data is ready.
      * 
-     * @param results Sensor data structure with 16 zones
-     * @return ConsensusResult with distance, counts, and reliability flag
+     * @param frameReadyUs micros() timestamp when the frame became ready
+     */
+    void processFrame(uint32_t frameReadyUs);
+    
+    /**
+     * @brief Run the obstruction detector on a raw frame while watching
+     *
+     * Zones much shorter than the previous frame's consensus are fed to
+     * the detector; when it trips the event is published for getObstruction().
+     *
+     * @param frame Zones as read, before the zone temporal filter
+     * @param frameReadyUs micros() timestamp when the frame became ready
+     */
+    void checkObstruction(const ZoneFrame& frame, uint32_t frameReadyUs);
+    
+    /**
+     * @brief Copy a finished reading into currentReading_ atomically
+     * @param reading Reading to publish
+     * @param frameReadyUs micros() timestamp when the frame became ready
      */
-    ConsensusResult computeMultiZoneConsensus(const VL53L5CX_ResultsData& results);
+    void publishReading(HeightReading& reading, uint32_t frameReadyUs);
     
     /**
-     * @brief Check if a single zone measurement is valid
+     * @brief Save the published reading and filter samples to RTC memory
+     * @param reading Reading just published
+     */
+    void retainState(const HeightReading& reading);
+    
+    /**
+     * @brief Restore a retained reading and filter samples (warm reset)
      * 
-     * Validates status codes (5, 6, 9 valid; 0, 255 invalid) and range.
+     * The height is recomputed with the current calibration offset and
+     * the Kalman filter restarts at the last distance with zero velocity
+     * (the reset switched the motors off).
      * 
-     * @param status Target status code from sensor
-     * @param distance Distance reading in mm
-     * @return true if zone passes validation
+     * @param retained Snapshot loaded from RTC memory
+     * @return true if a VALID reading was restored and published
+     */
+    bool restoreRetainedState(const RetainedHeight& retained);
+    
+    /**
+     * @brief Mark current reading STALE if no frame arrived in time
      */
-    bool isZoneValid(uint8_t status, uint16_t distance) const;
+    void checkStale();
     
     /**
-     * @brief Calculate median of an array (for outlier detection)
+     * @brief Get stale timeout for the current frame period
      * 
-     * Uses in-place insertion sort for small arrays.
-     * For even count, returns lower middle value.
+     * At least READING_STALE_TIMEOUT_MS, and never shorter than two frame
+     * periods so a 1 Hz idle rate doesn't flap between VALID and STALE.
      * 
-     * @param values Array of distances (may be modified)
-     * @param count Number of elements (1-16)
-     * @return Median value in mm
+     * @return unsigned long Timeout in ms
      */
-    static uint16_t computeMedian(uint16_t* values, uint8_t count);
+    unsigned long getStaleTimeoutMs() const;
     
     /**
-     * @brief Calculate arithmetic mean of an array
+     * @brief (Re)start ranging at a profile's frequency
      * 
-     * Uses uint32_t accumulator for overflow safety.
+     * Updates activeProfile_ and rescales the filter window on success.
+     * Caller must hold sensorMutex_.
      * 
-     * @param values Array of distances
-     * @param count Number of elements (1-16)
-     * @return Mean value in mm
+     * @param profile Profile to range at
+     * @return true if the frequency was set and ranging started
      */
-    static uint16_t computeMean(uint16_t* values, uint8_t count);
+    bool restartRanging(RangingProfile profile);
     
     /**
-     * @brief Filter outliers based on deviation from median
+     * @brief Run the supervisor and execute any recovery step it returns
      * 
-     * Marks zones as outliers if |value - median| > 30mm threshold.
+     * Called once per acquisition pass. Caller must hold sensorMutex_.
+     */
+    void superviseSensor();
+    
+    /**
+     * @brief Apply requestedProfile_ to the sensor if it changed
+     * 
+     * Restarts ranging at the new frequency and rescales the filter window
+     * so its time constant is unchanged. Caller must hold sensorMutex_.
+     * 
+     * @return true if the profile was changed
+     */
+    bool applyRangingProfile();
+    
+    /**
+     * @brief Filter window for a ranging frequency
+     * 
+     * The reference window (configured, or adaptive) scaled so the time
+     * constant is the same at every rate:
+     * window = reference_window * frequency / RANGING_FREQUENCY_REFERENCE_HZ
      * 
-     * @param values Array of distances
-     * @param count Number of elements
-     * @param median Pre-computed median value
-     * @param keep_flags Output array of bools (true = keep, false = outlier)
-     * @param kept_count Output count of non-outlier values
+     * @param frequencyHz Ranging frequency
+     * @return uint8_t Window in samples at that frequency
+     */
+    uint8_t scaledWindowSize(uint8_t frequencyHz) const;
+    
+    /**
+     * @brief Feed the noise estimate and resize the filter if needed
+     * 
+     * Resizes filter_ when the window mode was switched or the adaptive
+     * window changed; the newest samples are kept, so the output does not
+     * step. Caller must hold sensorMutex_.
+     * 
+     * @param consensus_mm Reliable consensus distance of this frame
+     */
+    void updateFilterWindow(uint16_t consensus_mm);
+    
+    /**
+     * @brief Profile the sensor should run at
+     * 
+     * requestedProfile_, forced to ACTIVE while a zone mask is learned,
+     * a calibration job runs or a sensor fault is recovered.
+     * 
+     * @return RangingProfile Desired profile
+     */
+    RangingProfile desiredProfile() const;
+    
+    /**
+     * @brief Apply a pending learn/clear request. Caller must hold sensorMutex_.
+     */
+    void applyZoneMaskCommand();
+    
+    /**
+     * @brief Feed one frame to the zone mask learner
+     * 
+     * Each zone counts as consistent if it is valid and within the
+     * frame's outlier threshold of the floor estimate. Masked zones are
+     * observed too, so a removed obstruction is unmasked by the next run.
+     * 
+     * @param frame Sensor data
+     * @param floor_mm Median of the unmasked valid zones
+     * @param threshold_mm Outlier threshold the consensus applied
+     */
+    void observeZoneMask(const ZoneFrame& frame, uint16_t floor_mm, uint16_t threshold_mm);
+    
+    /**
+     * @brief Compute, apply and persist the mask after a learning run
+     */
+    void finishZoneMaskLearning();
+    
+    /**
+     * @brief Start a pending calibration job and enforce the job timeout
+     * 
+     * Caller must hold sensorMutex_.
+     */
+    void serviceCalibration();
+    
+    /**
+     * @brief Feed one frame's consensus to the running calibration job
+     * @param consensus Consensus of the frame (unreliable frames are skipped)
+     */
+    void observeCalibration(const ConsensusResult& consensus);
+    
+    /**
+     * @brief Save the offset (or record the failure) when sampling ends
+     */
+    void finishCalibration();
+    
+    /**
+     * @brief Mark the running job FAILED and publish the reason
+     * @param reason Static failure message
+     */
+    void failCalibration(const char* reason);
+    
+    /**
+     * @brief Calculate height from filtered distance
+     * @param filtered_mm Filtered distance in mm
+     * @return uint16_t Height in mm
+     */
+    uint16_t calculateHeight(uint16_t filtered_mm) const;
+    
+    // =========================================================================
+    // Multi-Zone Filtering Methods (per 002-multi-zone-filtering feature)
+    // =========================================================================
+    
+    /**
+     * @brief Compute consensus distance from all MULTI_ZONE_TOTAL_ZONES zones
+     * 
+     * Two-stage spatial filtering:
+     * 1. Validate each zone (status codes, range), skipping masked zones
+     * 2. Compute median of valid zones
+     * 3. Filter outliers (>30mm from median, or the adaptive MAD threshold)
+     * 4. Compute (optionally confidence-weighted) mean of remaining non-outliers
+     * 
+     * Steps 2-4 are ZoneConsensus::combine(). With ConsensusMethod::PLANE_FIT
+     * the distance instead comes from a RANSAC floor plane over all valid
+     * zones (utils/FloorPlane.h), falling back to step 4 if no plane is
+     * found.
+     * 
+     * @param frame Sensor data (4x4 or 8x8 per build)
+     * @return ConsensusResult with distance, counts, and reliability flag
      */
-    static void filterOutliers(uint16_t* values, uint8_t count, uint16_t median,
-                               bool* keep_flags, uint8_t& kept_count);
+    ConsensusResult computeMultiZoneConsensus(const ZoneFrame& frame);
 };
 
 #endif // HEIGHT_CONTROLLER_H
@@ -5,50 +5,138 @@
 
 #include "MovementController.h"
 #include "utils/Logger.h"
+#include "utils/HeightUnits.h"
+#include <esp32-hal-ledc.h>
+#include <cstring>  // strncpy for the retained error message
 
 static const char* TAG = "MovementController";
 
+/**
+ * @brief Holds the controller's recursive mutex for a scope
+ * 
+ * No-op before init() created it (single-threaded setup).
+ */
+class MovementLock {
+public:
+    explicit MovementLock(SemaphoreHandle_t lock) : lock_(lock) {
+        if (lock_ != nullptr) {
+            xSemaphoreTakeRecursive(lock_, portMAX_DELAY);
+        }
+    }
+    
+    ~MovementLock() {
+        if (lock_ != nullptr) {
+            xSemaphoreGiveRecursive(lock_);
+        }
+    }
+    
+private:
+    SemaphoreHandle_t lock_;
+};
+
+RTC_NOINIT_ATTR RetainedState<MovementController::RetainedMovement> MovementController::retained_;
+
 MovementController::MovementController(HeightController& heightController)
     : heightController_(heightController)
+    , lock_(nullptr)
     , state_(MovementState::IDLE)
+    , fault_(MovementFault::NONE)
     , statusCallback_(nullptr)
+    , obstructionStops_(0)
+    , obstructionStopLatencyUs_(0)
+    , maxObstructionStopLatencyUs_(0)
+    , motionSequence_(0)
+    , driveMode_(DriveMode::SWITCHED)
+    , driveConfigured_(false)
+    , motorOn_(false)
+    , predictiveStopArmed_(false)
+    , stopLearnPending_(false)
+    , stopDirection_(MovementState::IDLE)
+    , stopRemainingMm_(0)
+    , lastStopOvershootMm_(0)
+    , restHeightMm_(0)
+    , restSinceMs_(0)
     , movementStartTime_(0)
     , stabilizationStartTime_(0)
 {
     // Initialize target as inactive - tolerance will be set in init()
     target_.active = false;
-    target_.target_height_cm = 0;
+    target_.target_height_mm = 0;
     target_.tolerance_mm = DEFAULT_TOLERANCE_MM;  // Use default, init() will update
     target_.source = TargetSource::MANUAL;
     target_.source_id = 0;
     target_.activation_timestamp = 0;
+    lastError_[0] = '\0';
 }
 
-void MovementController::init() {
-    // Configure motor control pins as outputs
-    pinMode(PIN_MOTOR_UP, OUTPUT);
-    pinMode(PIN_MOTOR_DOWN, OUTPUT);
+void MovementController::init(bool warmReset) {
+    // Serializes the control task's update() with web calls
+    if (lock_ == nullptr) {
+        lock_ = xSemaphoreCreateRecursiveMutex();
+    }
+    
+    // Configure motor control pins (outputs, or LEDC in PWM mode)
+    switchDrive();
+    MovementLock lock(lock_);
+    configureRamp();
     
     // Ensure motors are off at startup
     setMotorPins(MovementState::IDLE);
     
     // Update tolerance from config (SystemConfig now initialized)
     target_.tolerance_mm = SystemConfig.getTolerance();
+    motionMonitor_.setFaultFrames(SystemConfig.getMotionFaultFrames());
+    
+    Logger::info(TAG, "Initialized - UP pin: %d, DOWN pin: %d, Tolerance: %dmm, Drive: %s", 
+                 PIN_MOTOR_UP, PIN_MOTOR_DOWN, target_.tolerance_mm,
+                 driveMode_ == DriveMode::PWM ? "PWM" : "switched");
     
-    Logger::info(TAG, "Initialized - UP pin: %d, DOWN pin: %d, Tolerance: %dmm", 
-                 PIN_MOTOR_UP, PIN_MOTOR_DOWN, target_.tolerance_mm);
+    RetainedMovement retained;
+    if (WARM_RESTART_ENABLED && warmReset && retained_.load(retained)) {
+        restoreRetainedState(retained);
+    }
+    retainState();
+}
+
+bool MovementController::update() {
+    // Web calls hold the lock for a few microseconds (no I/O: logging is
+    // queued, the LEDC is set up outside it), so wait that long rather
+    // than skip the safety checks; never block
+    if (lock_ != nullptr && xSemaphoreTakeRecursive(lock_, 0) != pdTRUE) {
+        uint32_t startUs = micros();
+        while (xSemaphoreTakeRecursive(lock_, 0) != pdTRUE) {
+            if (micros() - startUs >= MOVEMENT_LOCK_WAIT_US) {
+                return false;
+            }
+        }
+    }
+    step();
+    if (lock_ != nullptr) {
+        xSemaphoreGiveRecursive(lock_);
+    }
+    return true;
 }
 
-void MovementController::update() {
+void MovementController::step() {
+    // First: an obstruction has to stop the desk on the frame that shows it
+    if (state_ == MovementState::MOVING_DOWN && checkObstruction()) {
+        return;
+    }
+    
     // Safety check: if sensor is not valid and we're moving, stop!
     if (!checkSensorValidity() && isMoving()) {
-        setState(MovementState::ERROR, "Sensor reading invalid during movement");
+        fail(MovementFault::SENSOR_INVALID, "Sensor reading invalid during movement");
+        return;
+    }
+    
+    // Motion that doesn't match the motor command
+    if (checkMotion()) {
         return;
     }
     
     // Check for timeout during movement
     if (isMoving() && checkTimeout()) {
-        setState(MovementState::ERROR, "Movement timeout - target not reached");
+        fail(MovementFault::TIMEOUT, "Movement timeout - target not reached");
         return;
     }
     
@@ -71,13 +159,21 @@ void MovementController::update() {
             handleErrorState();
             break;
     }
+    
+    rampMotor();
+}
+
+bool MovementController::setTargetHeight(uint16_t height_mm) {
+    switchDrive();
+    MovementLock lock(lock_);
+    return startMove(height_mm);
 }
 
-bool MovementController::setTargetHeight(uint16_t height_cm) {
+bool MovementController::startMove(uint16_t height_mm) {
     // Validate height against configured limits
-    if (!SystemConfig.isValidHeight(height_cm)) {
-        Logger::warn(TAG, "Invalid target height: %d cm (valid range: %d-%d)",
-                     height_cm, 
+    if (!SystemConfig.isValidHeightMm(height_mm)) {
+        Logger::warn(TAG, "Invalid target height: %d mm (valid range: %d-%d cm)",
+                     height_mm, 
                      SystemConfig.getMinHeight(), 
                      SystemConfig.getMaxHeight());
         return false;
@@ -86,7 +182,7 @@ bool MovementController::setTargetHeight(uint16_t height_cm) {
     // Check if system is calibrated
     if (!SystemConfig.isCalibrated()) {
         Logger::error(TAG, "Cannot set target: system not calibrated");
-        lastError_ = "System not calibrated";
+        setLastError("System not calibrated");
         return false;
     }
     
@@ -97,15 +193,17 @@ bool MovementController::setTargetHeight(uint16_t height_cm) {
     }
     
     // Set target
-    target_.target_height_cm = height_cm;
+    target_.target_height_mm = height_mm;
     target_.tolerance_mm = SystemConfig.getTolerance();
     target_.activation_timestamp = millis();
+    motionMonitor_.setFaultFrames(SystemConfig.getMotionFaultFrames());
+    configureRamp();
     target_.source = TargetSource::MANUAL;
     target_.source_id = 0;
     target_.active = true;
     
-    Logger::info(TAG, "Target set: %d cm (tolerance: ±%d mm)", 
-                 height_cm, target_.tolerance_mm);
+    Logger::info(TAG, "Target set: %d mm (tolerance: ±%d mm)", 
+                 height_mm, target_.tolerance_mm);
     
     // Determine initial direction and start moving
     MovementState direction = determineDirection();
@@ -118,25 +216,32 @@ bool MovementController::setTargetHeight(uint16_t height_cm) {
     }
     
     movementStartTime_ = millis();
+    predictiveStopArmed_ = true;
+    stopLearnPending_ = false;
     setState(direction, direction == MovementState::MOVING_UP ? 
              "Moving up to target" : "Moving down to target");
     
     return true;
 }
 
-bool MovementController::setTargetFromPreset(uint16_t height_cm, uint8_t preset_slot) {
-    if (!setTargetHeight(height_cm)) {
+bool MovementController::setTargetFromPreset(uint16_t height_mm, uint8_t preset_slot) {
+    switchDrive();
+    MovementLock lock(lock_);
+    
+    if (!startMove(height_mm)) {
         return false;
     }
     
     target_.source = TargetSource::PRESET;
     target_.source_id = preset_slot;
+    retainState();
     
-    Logger::info(TAG, "Target from preset %d: %d cm", preset_slot, height_cm);
+    Logger::info(TAG, "Target from preset %d: %d mm", preset_slot, height_mm);
     return true;
 }
 
 void MovementController::emergencyStop() {
+    MovementLock lock(lock_);
     Logger::warn(TAG, "EMERGENCY STOP triggered");
     
     // Immediately stop motors
@@ -144,19 +249,23 @@ void MovementController::emergencyStop() {
     
     // Clear target
     target_.active = false;
+    stopLearnPending_ = false;
     
     // Return to idle (not error - this was intentional stop)
     setState(MovementState::IDLE, "Emergency stop activated");
 }
 
 void MovementController::clearError() {
+    MovementLock lock(lock_);
     if (state_ != MovementState::ERROR) {
         return;
     }
     
     Logger::info(TAG, "Clearing error state");
     target_.active = false;
-    lastError_ = "";
+    stopLearnPending_ = false;
+    lastError_[0] = '\0';
+    fault_ = MovementFault::NONE;
     setState(MovementState::IDLE, "Error cleared");
 }
 
@@ -184,12 +293,47 @@ bool MovementController::hasError() const {
     return state_ == MovementState::ERROR;
 }
 
-const TargetHeight& MovementController::getTarget() const {
+TargetHeight MovementController::getTarget() const {
+    MovementLock lock(lock_);
     return target_;
 }
 
-const String& MovementController::getLastError() const {
-    return lastError_;
+String MovementController::getLastError() const {
+    MovementLock lock(lock_);
+    return String(lastError_);
+}
+
+MovementFault MovementController::getFault() const {
+    return fault_;
+}
+
+const char* MovementController::getFaultCode() const {
+    switch (fault_) {
+        case MovementFault::SENSOR_INVALID: return "SENSOR_FAILURE";
+        case MovementFault::TIMEOUT:        return "MOVEMENT_TIMEOUT";
+        case MovementFault::OBSTRUCTION:    return "OBSTRUCTION";
+        case MovementFault::INTERRUPTED:    return "MOVEMENT_INTERRUPTED";
+        case MovementFault::STALL:          return "MOTOR_STALL";
+        case MovementFault::WRONG_DIRECTION: return "WRONG_DIRECTION";
+        case MovementFault::RUNAWAY:        return "MOTOR_RUNAWAY";
+        case MovementFault::NONE:
+        default:                            return "";
+    }
+}
+
+uint32_t MovementController::getObstructionStopLatencyUs() const {
+    return obstructionStopLatencyUs_;
+}
+
+DriveMode MovementController::getDriveMode() const {
+    return driveMode_;
+}
+
+uint16_t MovementController::getMotorDuty() const {
+    if (driveMode_ == DriveMode::PWM) {
+        return ramp_.getDuty();
+    }
+    return motorOn_ ? MotorRamp::FULL_DUTY : 0;
 }
 
 void MovementController::setStatusCallback(MovementStatusCallback callback) {
@@ -200,6 +344,25 @@ void MovementController::setMotorPins(MovementState state) {
     // CRITICAL: Always ensure mutual exclusion
     // Never have both pins HIGH at the same time
     
+    int8_t drive = (state == MovementState::MOVING_UP) ? 1 :
+                   (state == MovementState::MOVING_DOWN) ? -1 : 0;
+    motionMonitor_.onDrive(drive, millis());
+    
+    if (driveMode_ == DriveMode::PWM) {
+        // Soft start into a move, soft stop into stabilizing; anything
+        // else (idle, error, emergency stop) cuts at once
+        if (drive != 0) {
+            ramp_.start(drive, millis());
+        } else if (state == MovementState::STABILIZING) {
+            ramp_.stop(millis());
+        } else {
+            ramp_.cut();
+        }
+        writeMotorDuty(ramp_.getDirection(), ramp_.getDuty());
+        return;
+    }
+    
+    motorOn_ = (drive != 0);
     switch (state) {
         case MovementState::MOVING_UP:
             digitalWrite(PIN_MOTOR_DOWN, LOW);  // Ensure DOWN is off first
@@ -226,7 +389,102 @@ void MovementController::setMotorPins(MovementState state) {
     }
 }
 
-void MovementController::setState(MovementState newState, const String& message) {
+void MovementController::configureRamp() {
+    ramp_.configure(SystemConfig.getRampUpMs(), SystemConfig.getRampDownMs(),
+                    SystemConfig.getSlowdownDistanceMm(),
+                    MOTOR_MIN_DUTY_PERCENT * MotorRamp::FULL_DUTY / 100,
+                    MOTOR_REVERSE_REST_MS);
+}
+
+void MovementController::switchDrive() {
+    DriveMode mode = SystemConfig.getDriveMode();
+    {
+        MovementLock lock(lock_);
+        bool parked = (state_ == MovementState::IDLE || state_ == MovementState::ERROR) &&
+                      ramp_.getDirection() == 0 && !ramp_.isReversing();
+        if (driveConfigured_ && (mode == driveMode_ || !parked)) {
+            return;
+        }
+    }
+    
+    // Unlocked: parked, only a web call can start the motor, and they
+    // all run in the task making this one
+    if (mode == DriveMode::PWM) {
+        ledcSetup(MOTOR_PWM_CHANNEL_UP, MOTOR_PWM_FREQUENCY_HZ, MOTOR_PWM_RESOLUTION_BITS);
+        ledcSetup(MOTOR_PWM_CHANNEL_DOWN, MOTOR_PWM_FREQUENCY_HZ, MOTOR_PWM_RESOLUTION_BITS);
+        ledcAttachPin(PIN_MOTOR_UP, MOTOR_PWM_CHANNEL_UP);
+        ledcAttachPin(PIN_MOTOR_DOWN, MOTOR_PWM_CHANNEL_DOWN);
+    } else if (driveConfigured_) {
+        // Back from PWM: both channels off, pins returned to GPIO
+        ledcWrite(MOTOR_PWM_CHANNEL_UP, 0);
+        ledcWrite(MOTOR_PWM_CHANNEL_DOWN, 0);
+        ledcDetachPin(PIN_MOTOR_UP);
+        ledcDetachPin(PIN_MOTOR_DOWN);
+    }
+    if (mode == DriveMode::SWITCHED) {
+        pinMode(PIN_MOTOR_UP, OUTPUT);
+        pinMode(PIN_MOTOR_DOWN, OUTPUT);
+    }
+    
+    MovementLock lock(lock_);
+    driveMode_ = mode;
+    driveConfigured_ = true;
+    ramp_.cut();
+    motorOn_ = false;
+    writeMotorDuty(0, 0);
+    if (mode == DriveMode::SWITCHED) {
+        digitalWrite(PIN_MOTOR_UP, LOW);
+        digitalWrite(PIN_MOTOR_DOWN, LOW);
+    }
+    Logger::info(TAG, "Motor drive: %s", mode == DriveMode::PWM ? "PWM" : "switched");
+}
+
+void MovementController::writeMotorDuty(int8_t direction, uint16_t duty) {
+    if (driveMode_ != DriveMode::PWM) {
+        return;
+    }
+    
+    // Same rule as the switched pins: the other direction goes to zero first
+    const uint32_t maxDuty = (1UL << MOTOR_PWM_RESOLUTION_BITS) - 1;
+    uint32_t counts = (uint32_t)duty * maxDuty / MotorRamp::FULL_DUTY;
+    if (direction > 0) {
+        ledcWrite(MOTOR_PWM_CHANNEL_DOWN, 0);
+        ledcWrite(MOTOR_PWM_CHANNEL_UP, counts);
+    } else if (direction < 0) {
+        ledcWrite(MOTOR_PWM_CHANNEL_UP, 0);
+        ledcWrite(MOTOR_PWM_CHANNEL_DOWN, counts);
+    } else {
+        ledcWrite(MOTOR_PWM_CHANNEL_UP, 0);
+        ledcWrite(MOTOR_PWM_CHANNEL_DOWN, 0);
+    }
+}
+
+void MovementController::rampMotor() {
+    if (driveMode_ != DriveMode::PWM || (ramp_.getDirection() == 0 && !ramp_.isReversing())) {
+        return;
+    }
+    
+    // Slow down toward where the motor will be cut (with a predictive
+    // stop, the stop distance ahead of the target), reaching the minimum
+    // duty a crawl distance before it
+    int32_t remaining = 0;
+    int32_t speed = 0;
+    if (isMoving()) {
+        getApproach(remaining, speed);
+        if (predictiveStopArmed_ && SystemConfig.getStopMode() == StopMode::PREDICTIVE) {
+            remaining -= (state_ == MovementState::MOVING_UP) ? SystemConfig.getStopDistanceUpMm()
+                                                              : SystemConfig.getStopDistanceDownMm();
+        }
+        remaining -= MOTOR_CRAWL_DISTANCE_MM;
+    }
+    uint16_t before = ramp_.getDuty();
+    uint16_t duty = ramp_.update(millis(), remaining);
+    if (duty != before || (ramp_.getDirection() == 0 && !ramp_.isReversing())) {
+        writeMotorDuty(ramp_.getDirection(), duty);
+    }
+}
+
+void MovementController::setState(MovementState newState, const char* message) {
     if (state_ != newState) {
         Logger::info(TAG, "State: %s -> %s (%s)", 
                      getStateString(), 
@@ -234,7 +492,7 @@ void MovementController::setState(MovementState newState, const String& message)
                      (newState == MovementState::MOVING_UP) ? "Moving Up" :
                      (newState == MovementState::MOVING_DOWN) ? "Moving Down" :
                      (newState == MovementState::STABILIZING) ? "Stabilizing" : "Error",
-                     message.c_str());
+                     message);
         
         MovementState oldState = state_;
         state_ = newState;
@@ -242,9 +500,16 @@ void MovementController::setState(MovementState newState, const String& message)
         // Update motor pins for new state
         setMotorPins(newState);
         
+        // Watch for obstructions exactly while lowering
+        if (newState == MovementState::MOVING_DOWN) {
+            heightController_.watchForObstruction(true);
+        } else if (oldState == MovementState::MOVING_DOWN) {
+            heightController_.watchForObstruction(false);
+        }
+        
         // If entering error state, record error message
         if (newState == MovementState::ERROR) {
-            lastError_ = message;
+            setLastError(message);
         }
         
         // If entering stabilizing, start timer
@@ -252,6 +517,8 @@ void MovementController::setState(MovementState newState, const String& message)
             stabilizationStartTime_ = millis();
         }
         
+        retainState();
+        
         // Notify callback
         if (statusCallback_ != nullptr) {
             statusCallback_(newState, message);
@@ -259,28 +526,204 @@ void MovementController::setState(MovementState newState, const String& message)
     }
 }
 
+void MovementController::retainState() {
+    if (!WARM_RESTART_ENABLED) {
+        return;
+    }
+    
+    RetainedMovement retained = {};
+    retained.target = target_;
+    retained.state = state_;
+    retained.fault = fault_;
+    strncpy(retained.error, lastError_, sizeof(retained.error) - 1);
+    retained_.save(retained);
+}
+
+void MovementController::restoreRetainedState(const RetainedMovement& retained) {
+    target_ = retained.target;
+    target_.activation_timestamp = millis();
+    
+    switch (retained.state) {
+        case MovementState::MOVING_UP:
+        case MovementState::MOVING_DOWN:
+            state_ = MovementState::ERROR;
+            fault_ = MovementFault::INTERRUPTED;
+            setLastError("Movement interrupted by restart");
+            Logger::warn(TAG, "Warm restart: move to %d mm interrupted, not resuming",
+                         target_.target_height_mm);
+            break;
+            
+        case MovementState::ERROR:
+            state_ = MovementState::ERROR;
+            fault_ = retained.fault;
+            setLastError(retained.error);
+            Logger::warn(TAG, "Warm restart: error state restored (%s)", lastError_);
+            break;
+            
+        case MovementState::STABILIZING:
+        case MovementState::IDLE:
+        default:
+            // Target was reached (or never set); nothing left to do
+            target_.active = false;
+            Logger::info(TAG, "Warm restart: idle, last target %d mm",
+                         target_.target_height_mm);
+            break;
+    }
+}
+
+void MovementController::fail(MovementFault fault, const char* message) {
+    fault_ = fault;
+    setState(MovementState::ERROR, message);
+}
+
+void MovementController::setLastError(const char* message) {
+    strncpy(lastError_, message, sizeof(lastError_) - 1);
+    lastError_[sizeof(lastError_) - 1] = '\0';
+}
+
+bool MovementController::checkObstruction() {
+    ObstructionEvent event;
+    if (!heightController_.getObstruction(event)) {
+        return false;
+    }
+    
+    setMotorPins(MovementState::ERROR);
+    obstructionStopLatencyUs_ = micros() - event.frame_ready_us;
+    if (obstructionStopLatencyUs_ > maxObstructionStopLatencyUs_) {
+        maxObstructionStopLatencyUs_ = obstructionStopLatencyUs_;
+    }
+    obstructionStops_++;
+    
+    Logger::warn(TAG, "Obstruction: %d zones (%d new) at %d mm, floor %d mm - stopped in %lu us",
+                 event.zone_count, event.new_zone_count, event.clearance_mm, event.floor_mm,
+                 (unsigned long)obstructionStopLatencyUs_);
+    fail(MovementFault::OBSTRUCTION, "Obstruction under desk - lowering stopped");
+    return true;
+}
+
+bool MovementController::checkMotion() {
+    bool watching = isMoving() || state_ == MovementState::STABILIZING;
+    uint32_t sequence = heightController_.getReadingSequence();
+    bool newFrame = (sequence != motionSequence_);
+    motionSequence_ = sequence;
+    if (!watching || !newFrame || !heightController_.isValid()) {
+        return false;
+    }
+    
+    int16_t velocity = heightController_.getReading().velocity_mm_s;
+    MotionFault motion = motionMonitor_.update(velocity, millis());
+    if (motion == MotionFault::NONE) {
+        return false;
+    }
+    
+    setMotorPins(MovementState::ERROR);
+    Logger::warn(TAG, "Motion fault in %s: %d mm/s at %d mm",
+                 getStateString(), velocity, heightController_.getCurrentHeightMm());
+    switch (motion) {
+        case MotionFault::STALL:
+            fail(MovementFault::STALL, "Desk not moving - motor stopped");
+            break;
+        case MotionFault::WRONG_DIRECTION:
+            fail(MovementFault::WRONG_DIRECTION, "Desk moving the wrong way - motor stopped");
+            break;
+        case MotionFault::RUNAWAY:
+        default:
+            fail(MovementFault::RUNAWAY, "Desk still moving after motor off");
+            break;
+    }
+    return true;
+}
+
 bool MovementController::isWithinTolerance() const {
     if (!target_.active) return false;
     
-    uint16_t currentHeight = heightController_.getCurrentHeight();
-    int16_t diff_mm = ((int16_t)target_.target_height_cm - (int16_t)currentHeight) * 10;
+    return HeightUnits::isWithinTolerance(target_.target_height_mm,
+                                          heightController_.getCurrentHeightMm(),
+                                          target_.tolerance_mm);
+}
+
+void MovementController::getApproach(int32_t& remainingMm, int32_t& speedMmS) const {
+    HeightReading reading = heightController_.getReading();
+    remainingMm = (int32_t)target_.target_height_mm - (int32_t)reading.calculated_height_mm;
+    speedMmS = reading.velocity_mm_s;
+    if (state_ == MovementState::MOVING_DOWN) {
+        remainingMm = -remainingMm;
+        speedMmS = -speedMmS;
+    }
+}
+
+bool MovementController::isPredictiveStopDue(int32_t remainingMm, int32_t speedMmS) const {
+    // Only once the desk is under way toward the target: the velocity
+    // estimate is what says the reading is lagging a moving desk
+    if (speedMmS < PREDICTIVE_STOP_MIN_SPEED_MM_S) {
+        return false;
+    }
+    
+    // Cut on the frame nearest the stop point rather than the first one
+    // past it: half a frame of travel early at the current speed
+    int32_t stopDistance = (state_ == MovementState::MOVING_UP)
+        ? SystemConfig.getStopDistanceUpMm()
+        : SystemConfig.getStopDistanceDownMm();
+    int32_t lead = speedMmS * (int32_t)heightController_.getSampleIntervalMs() / 2000;
+    return remainingMm <= stopDistance + lead;
+}
+
+bool MovementController::checkAtRest() {
+    unsigned long now = millis();
+    int32_t height = heightController_.getCurrentHeightMm();
+    if (height > restHeightMm_ + STOP_REST_BAND_MM || height < restHeightMm_ - STOP_REST_BAND_MM) {
+        restHeightMm_ = height;
+        restSinceMs_ = now;
+    }
+    return now - restSinceMs_ >= STOP_REST_MS;
+}
+
+void MovementController::learnStopDistance() {
+    stopLearnPending_ = false;
+    if (!heightController_.isValid()) {
+        return;
+    }
     
-    return abs(diff_mm) <= (int16_t)target_.tolerance_mm;
+    // Positive = came to rest past the target
+    bool up = (stopDirection_ == MovementState::MOVING_UP);
+    int32_t overshoot = (int32_t)heightController_.getCurrentHeightMm() - (int32_t)target_.target_height_mm;
+    if (!up) {
+        overshoot = -overshoot;
+    }
+    lastStopOvershootMm_ = (int16_t)overshoot;
+    
+    // How far the reading went after the cut is what the stop distance
+    // should have been; this also learns from cuts the tolerance band made
+    int32_t travel = stopRemainingMm_ + overshoot;
+    int32_t stopDistance = up ? SystemConfig.getStopDistanceUpMm() : SystemConfig.getStopDistanceDownMm();
+    int32_t learned = stopDistance + (travel - stopDistance) * STOP_DISTANCE_LEARN_PERCENT / 100;
+    if (learned < 0) learned = 0;
+    if (learned > MAX_STOP_DISTANCE_MM) learned = MAX_STOP_DISTANCE_MM;
+    
+    Logger::info(TAG, "Stopped %ld mm past the target after %ld mm coast %s, stop distance %ld -> %ld mm",
+                 (long)overshoot, (long)travel, up ? "up" : "down", (long)stopDistance, (long)learned);
+    // RAM only: loop() saves a changed value, at most one NVS write per move
+    if (learned != stopDistance) {
+        if (up) {
+            SystemConfig.learnStopDistanceUpMm((uint16_t)learned);
+        } else {
+            SystemConfig.learnStopDistanceDownMm((uint16_t)learned);
+        }
+    }
 }
 
 MovementState MovementController::determineDirection() const {
     if (!target_.active) return MovementState::IDLE;
     
-    uint16_t currentHeight = heightController_.getCurrentHeight();
+    uint16_t currentHeight = heightController_.getCurrentHeightMm();
     
     // Check if already within tolerance
-    int16_t diff_mm = ((int16_t)target_.target_height_cm - (int16_t)currentHeight) * 10;
-    
-    if (abs(diff_mm) <= (int16_t)target_.tolerance_mm) {
+    if (HeightUnits::isWithinTolerance(target_.target_height_mm, currentHeight,
+                                       target_.tolerance_mm)) {
         return MovementState::IDLE;  // Already at target
     }
     
-    if (target_.target_height_cm > currentHeight) {
+    if (target_.target_height_mm > currentHeight) {
         return MovementState::MOVING_UP;
     } else {
         return MovementState::MOVING_DOWN;
@@ -308,12 +751,35 @@ void MovementController::handleIdleState() {
         MovementState direction = determineDirection();
         if (direction != MovementState::IDLE) {
             movementStartTime_ = millis();
+            predictiveStopArmed_ = true;
+            stopLearnPending_ = false;
             setState(direction, "Starting movement to target");
         }
     }
 }
 
 void MovementController::handleMovingState() {
+    // Predictive stop, first leg of a move: cut the stop distance ahead of
+    // the target (or at the tolerance band if that comes first) and learn
+    // from where the desk comes to rest
+    if (predictiveStopArmed_ && SystemConfig.getStopMode() == StopMode::PREDICTIVE) {
+        int32_t remaining, speed;
+        getApproach(remaining, speed);
+        bool due = isPredictiveStopDue(remaining, speed);
+        if (due || isWithinTolerance()) {
+            predictiveStopArmed_ = false;
+            // A cut before the desk got up to speed says nothing about the stop distance
+            stopLearnPending_ = (speed >= PREDICTIVE_STOP_MIN_SPEED_MM_S);
+            stopDirection_ = state_;
+            stopRemainingMm_ = remaining;
+            restHeightMm_ = heightController_.getCurrentHeightMm();
+            restSinceMs_ = millis();
+            setState(MovementState::STABILIZING, due ? "Stop distance reached, stabilizing"
+                                                     : "Target reached, stabilizing");
+            return;
+        }
+    }
+    
     // Check if we've reached the target (within tolerance)
     if (isWithinTolerance()) {
         setState(MovementState::STABILIZING, "Target reached, stabilizing");
@@ -328,6 +794,15 @@ void MovementController::handleMovingState() {
 }
 
 void MovementController::handleStabilizingState() {
+    // After a predictive cut the desk is still coasting toward the target:
+    // judge (and learn from) where it comes to rest, not where it passes
+    if (stopLearnPending_) {
+        if (!checkAtRest() && millis() - stabilizationStartTime_ < STOP_SETTLE_TIMEOUT_MS) {
+            return;
+        }
+        learnStopDistance();
+    }
+    
     // Check if we're still within tolerance
     if (!isWithinTolerance()) {
         // Drifted outside tolerance, resume movement
@@ -345,27 +820,26 @@ void MovementController::handleStabilizingState() {
         // Stable for required duration - movement complete!
         target_.active = false;
         setState(MovementState::IDLE, "Target reached and stable");
-        Logger::info(TAG, "Movement complete at %d cm", 
-                     heightController_.getCurrentHeight());
+        Logger::info(TAG, "Movement complete at %d mm", 
+                     heightController_.getCurrentHeightMm());
     }
 }
 
 void MovementController::handleErrorState() {
-    // In ERROR state, motors should be off
-    // Wait for clearError() to be called
-    
-    // Ensure motors are definitely off
-    setMotorPins(MovementState::ERROR);
+    // Motors were cut on entry (setState(), or before it by the obstruction
+    // and motion checks); rewriting them every pass would only add work to
+    // the control period. Wait for clearError().
 }
 
 String MovementController::toJson() const {
+    MovementLock lock(lock_);
     String json = "{";
     json += "\"state\":\"" + String(getStateString()) + "\",";
     json += "\"isMoving\":" + String(isMoving() ? "true" : "false") + ",";
     json += "\"hasError\":" + String(hasError() ? "true" : "false") + ",";
     
     if (target_.active) {
-        json += "\"target\":" + String(target_.target_height_cm) + ",";
+        json += "\"target\":" + String(HeightUnits::mmToCm(target_.target_height_mm), 1) + ",";
         json += "\"targetSource\":\"" + String(target_.source == TargetSource::PRESET ? "preset" : "manual") + "\"";
     } else {
         json += "\"target\":null,";
@@ -373,9 +847,17 @@ String MovementController::toJson() const {
     }
     
     if (hasError()) {
-        json += ",\"error\":\"" + lastError_ + "\"";
+        json += ",\"error\":\"" + String(lastError_) + "\"";
+        json += ",\"errorCode\":\"" + String(getFaultCode()) + "\"";
     }
     
+    json += ",\"obstructionStops\":" + String(obstructionStops_);
+    json += ",\"obstructionStopLatencyUs\":" + String(obstructionStopLatencyUs_);
+    json += ",\"maxObstructionStopLatencyUs\":" + String(maxObstructionStopLatencyUs_);
+    json += ",\"lastStopOvershootMm\":" + String(lastStopOvershootMm_);
+    json += ",\"driveMode\":\"" + String(driveMode_ == DriveMode::PWM ? "pwm" : "switched") + "\"";
+    json += ",\"motorDuty\":" + String(getMotorDuty());
+    
     json += "}";
     return json;
 }
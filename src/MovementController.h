@@ -9,20 +9,50 @@
  * - STABILIZING: Within tolerance, waiting for stability confirmation
  * - ERROR: Movement stopped due to fault
  * 
+ * With StopMode::PREDICTIVE the motor is cut a learned stop distance
+ * ahead of the target instead of once the reading is within tolerance,
+ * since by then the filtered reading lags the desk and the desk coasts
+ * past. Where the desk comes to rest corrects that direction's stop
+ * distance after every move (kept in RAM, persisted to NVS from loop()).
+ * 
+ * With DriveMode::PWM the motor pins carry LEDC PWM instead of being
+ * switched: moves start and end on a ramp and slow down near the target
+ * (see utils/MotorRamp.h). Faults and emergency stop still cut at once.
+ * 
  * Safety features:
- * - Mutual exclusion (never both MOSFETs on)
+ * - Mutual exclusion (never both MOSFETs on, never both PWM channels
+ *   with a non-zero duty; a reversal drops the old direction at once)
  * - Timeout protection
  * - Sensor failure detection
+ * - Obstruction under the desk while lowering: motor cut on the frame
+ *   that shows it (see HeightController::getObstruction())
+ * - Stall, wrong direction and runaway from the measured velocity, within
+ *   a few frames (see utils/MotionMonitor.h)
  * - Emergency stop
+ * 
+ * Threading: update() runs in the control task (see ControlTask.h) while
+ * web handlers call the mutators from the AsyncTCP task on the other
+ * core. Every public method holds a recursive mutex, so the state, the
+ * target and the motor pins are only ever changed by one task at a time.
+ * update() waits at most MOVEMENT_LOCK_WAIT_US for the lock and skips
+ * the pass if a web call still holds it, so web traffic can't hold up the
+ * control schedule. Nothing slow runs with the lock held: log lines are
+ * queued for loop() (see Logger.h), the status callback only queues, and
+ * the LEDC setup for a drive mode change runs outside it.
  */
 
 #ifndef MOVEMENT_CONTROLLER_H
 #define MOVEMENT_CONTROLLER_H
 
 #include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include "Config.h"
 #include "SystemConfiguration.h"
 #include "HeightController.h"
+#include "utils/RetainedState.h"
+#include "utils/MotionMonitor.h"
+#include "utils/MotorRamp.h"
 
 /**
  * @enum MovementState
@@ -36,6 +66,21 @@ enum class MovementState : uint8_t {
     ERROR           ///< Movement stopped due to fault
 };
 
+/**
+ * @enum MovementFault
+ * @brief Why the controller entered ERROR (SSE error code)
+ */
+enum class MovementFault : uint8_t {
+    NONE,               ///< Not in ERROR
+    SENSOR_INVALID,     ///< Reading invalid or stale while moving
+    TIMEOUT,            ///< Target not reached within the movement timeout
+    OBSTRUCTION,        ///< Object detected under the desk while lowering
+    INTERRUPTED,        ///< Move cut short by a reset (restored after warm restart)
+    STALL,              ///< Motor on but the desk not moving
+    WRONG_DIRECTION,    ///< Motor on and the desk moving the other way
+    RUNAWAY             ///< Desk still moving after the motor was switched off
+};
+
 /**
  * @enum TargetSource
  * @brief How the target height was set per data-model.md Section 2
@@ -50,7 +95,7 @@ enum class TargetSource : uint8_t {
  * @brief Target height configuration per data-model.md Section 2
  */
 struct TargetHeight {
-    uint16_t target_height_cm;          ///< Desired height
+    uint16_t target_height_mm;          ///< Desired height (mm)
     uint16_t tolerance_mm;              ///< Acceptable deviation
     unsigned long activation_timestamp; ///< When target was set
     TargetSource source;                ///< How target was triggered
@@ -61,8 +106,11 @@ struct TargetHeight {
 /**
  * @typedef MovementStatusCallback
  * @brief Callback for movement status changes
+ * 
+ * Called from whichever task changed the state (usually the control
+ * task) with the controller locked; must not block.
  */
-typedef void (*MovementStatusCallback)(MovementState state, const String& message);
+typedef void (*MovementStatusCallback)(MovementState state, const char* message);
 
 /**
  * @class MovementController
@@ -71,7 +119,7 @@ typedef void (*MovementStatusCallback)(MovementState state, const String& messag
  * Usage:
  *   MovementController movement(heightController);
  *   movement.init();
- *   movement.setTargetHeight(75);
+ *   movement.setTargetHeight(750);  // mm
  *   // In loop:
  *   movement.update();
  */
@@ -85,31 +133,40 @@ public:
     
     /**
      * @brief Initialize GPIO pins
+     * 
+     * After a warm reset the target and state retained in RTC memory are
+     * restored. The reset switched the motors off, so a move in progress
+     * is not resumed: it comes back as ERROR with its target, like any
+     * other interrupted move.
+     * 
+     * @param warmReset true after a software/watchdog/panic reset
      */
-    void init();
+    void init(bool warmReset = false);
     
     /**
-     * @brief Update state machine (call from main loop at 5Hz)
+     * @brief Update state machine (call every control period)
      * 
      * Checks current height, manages state transitions,
      * controls motor pins.
+     * 
+     * @return false if a web call held the lock and the pass was skipped
      */
-    void update();
+    bool update();
     
     /**
      * @brief Set new target height (manual input)
-     * @param height_cm Target height in cm
+     * @param height_mm Target height in mm
      * @return true if target accepted, false if invalid
      */
-    bool setTargetHeight(uint16_t height_cm);
+    bool setTargetHeight(uint16_t height_mm);
     
     /**
      * @brief Set target height from preset
-     * @param height_cm Target height in cm
+     * @param height_mm Target height in mm
      * @param preset_slot Preset slot number (1-5)
      * @return true if target accepted
      */
-    bool setTargetFromPreset(uint16_t height_cm, uint8_t preset_slot);
+    bool setTargetFromPreset(uint16_t height_mm, uint8_t preset_slot);
     
     /**
      * @brief Emergency stop - immediately stop movement
@@ -149,15 +206,49 @@ public:
     
     /**
      * @brief Get current target (if any)
-     * @return const TargetHeight& Target information
+     * @return TargetHeight Copy of the target information
      */
-    const TargetHeight& getTarget() const;
+    TargetHeight getTarget() const;
     
     /**
      * @brief Get last error message
-     * @return const String& Error message
+     * @return String Copy of the error message
+     */
+    String getLastError() const;
+    
+    /**
+     * @brief Get why the controller is in ERROR
+     * @return MovementFault NONE unless in ERROR
+     */
+    MovementFault getFault() const;
+    
+    /**
+     * @brief Get the fault as an SSE/API error code
+     * @return const char* e.g. "OBSTRUCTION", "" if none
+     */
+    const char* getFaultCode() const;
+    
+    /**
+     * @brief Get obstruction-to-motor-off latency of the last obstruction stop
+     * 
+     * Measured from data-ready of the frame that showed the obstruction
+     * to the motor pins going low.
+     * 
+     * @return uint32_t Microseconds, 0 if there was none yet
      */
-    const String& getLastError() const;
+    uint32_t getObstructionStopLatencyUs() const;
+    
+    /**
+     * @brief Get the motor drive in effect
+     * @return DriveMode Mode the pins are set up for (changes apply at the next move)
+     */
+    DriveMode getDriveMode() const;
+    
+    /**
+     * @brief Get the PWM duty driving the motor
+     * @return uint16_t Permille, 0 when off; 1000 while on in switched mode
+     */
+    uint16_t getMotorDuty() const;
     
     /**
      * @brief Set callback for status changes
@@ -170,29 +261,148 @@ public:
      * @return String JSON representation
      */
     String toJson() const;
-
+    
+    static constexpr size_t ERROR_MESSAGE_MAX = 64;     ///< lastError_ incl. terminator
+    
 private:
     HeightController& heightController_;
+    mutable SemaphoreHandle_t lock_;    ///< Recursive; see the threading note above
     MovementState state_;
     TargetHeight target_;
-    String lastError_;
+    char lastError_[ERROR_MESSAGE_MAX]; ///< Fixed buffer: set in the control pass, no heap
+    MovementFault fault_;
     MovementStatusCallback statusCallback_;
     
+    // Obstruction stops since boot (GET /api/status)
+    uint32_t obstructionStops_;
+    uint32_t obstructionStopLatencyUs_;
+    uint32_t maxObstructionStopLatencyUs_;
+    
+    // Velocity check against the motor command, once per new frame
+    MotionMonitor motionMonitor_;
+    uint32_t motionSequence_;           ///< Reading sequence last checked
+    
+    // Motor drive (DriveMode::PWM ramps the duty)
+    DriveMode driveMode_;               ///< Mode the pins are set up for
+    bool driveConfigured_;              ///< Pins set up once
+    MotorRamp ramp_;
+    bool motorOn_;                      ///< Switched mode: a direction pin is high
+    
+    // Predictive stop (StopMode::PREDICTIVE)
+    bool predictiveStopArmed_;          ///< First leg of a move: cut at the stop distance
+    bool stopLearnPending_;             ///< Cut made, learn once the desk is at rest
+    MovementState stopDirection_;       ///< Direction of that cut
+    int32_t stopRemainingMm_;           ///< Distance to the target at that cut
+    int16_t lastStopOvershootMm_;       ///< Rest height past the target after the last cut
+    int32_t restHeightMm_;              ///< Reading the rest check holds against
+    unsigned long restSinceMs_;         ///< Since when the reading held within the band
+    
     unsigned long movementStartTime_;
     unsigned long stabilizationStartTime_;
     
+    /**
+     * @brief Target and state retained across a warm reset
+     */
+    struct RetainedMovement {
+        TargetHeight target;
+        MovementState state;
+        MovementFault fault;            ///< fault_ if state is ERROR
+        char error[48];                 ///< lastError_ (truncated) if state is ERROR
+    };
+    static RetainedState<RetainedMovement> retained_;  ///< In RTC memory (RTC_NOINIT_ATTR)
+    
+    /**
+     * @brief Save target and state to RTC memory
+     */
+    void retainState();
+    
+    /**
+     * @brief Restore target and state after a warm reset
+     * @param retained Snapshot loaded from RTC memory
+     */
+    void restoreRetainedState(const RetainedMovement& retained);
+    
     /**
      * @brief Set motor pins based on state
      * @param state Target state for pin configuration
      */
     void setMotorPins(MovementState state);
     
+    /**
+     * @brief Set the pins up for the configured drive mode (lock not held)
+     * 
+     * Switching between digitalWrite and LEDC only happens with the desk
+     * idle or in error and the motor off, so a mode change takes effect at
+     * the next move. The LEDC and GPIO setup runs outside the lock, so the
+     * control pass isn't held up by it.
+     */
+    void switchDrive();
+    
+    /**
+     * @brief Load the ramp settings for the next move
+     */
+    void configureRamp();
+    
+    /**
+     * @brief setTargetHeight() once the drive is set up, lock held
+     */
+    bool startMove(uint16_t height_mm);
+    
+    /**
+     * @brief Write the PWM duty for a direction, the other channel first to zero
+     * @param direction +1 up, -1 down, 0 both off
+     * @param duty Permille
+     */
+    void writeMotorDuty(int8_t direction, uint16_t duty);
+    
+    /**
+     * @brief Step the PWM ramp once per update (DriveMode::PWM)
+     */
+    void rampMotor();
+    
     /**
      * @brief Transition to new state
      * @param newState State to transition to
-     * @param message Status message
+     * @param message Status message (static string)
+     */
+    void setState(MovementState newState, const char* message);
+    
+    /**
+     * @brief Enter ERROR for a fault
+     * @param fault Reason (reported as the error code)
+     * @param message Status message (static string)
+     */
+    void fail(MovementFault fault, const char* message);
+    
+    /**
+     * @brief Copy an error message into lastError_ (truncated)
+     */
+    void setLastError(const char* message);
+    
+    /**
+     * @brief The update() pass, lock held
      */
-    void setState(MovementState newState, const String& message);
+    void step();
+    
+    /**
+     * @brief Stop lowering if the height controller saw an obstruction
+     * 
+     * Cuts the motor before anything else (logging, callbacks) so the
+     * measured latency is the one the desk sees.
+     * 
+     * @return true if lowering was stopped
+     */
+    bool checkObstruction();
+    
+    /**
+     * @brief Check the new frame's velocity against the motor command
+     * 
+     * Runs while moving and while stabilizing (runaway after the cut).
+     * Cuts the motor before anything else, as checkObstruction().
+     * 
+     * @return true if a stall, wrong direction or runaway stopped the move
+     */
+    bool checkMotion();
     
     /**
      * @brief Check if current height is within tolerance of target
@@ -200,6 +410,44 @@ private:
      */
     bool isWithinTolerance() const;
     
+    /**
+     * @brief Distance left to the target and speed toward it
+     * @param remainingMm Target minus reading in the direction of travel
+     * @param speedMmS Kalman velocity in the direction of travel
+     */
+    void getApproach(int32_t& remainingMm, int32_t& speedMmS) const;
+    
+    /**
+     * @brief Check if the motor should be cut ahead of the target
+     * 
+     * True once the desk moves toward the target at
+     * PREDICTIVE_STOP_MIN_SPEED_MM_S or more and is within the learned
+     * stop distance for its direction, brought forward by half a frame of
+     * travel so the cut lands on the frame nearest the stop point.
+     * 
+     * @param remainingMm Distance left (see getApproach())
+     * @param speedMmS Speed toward the target (see getApproach())
+     * @return true to cut the motor now
+     */
+    bool isPredictiveStopDue(int32_t remainingMm, int32_t speedMmS) const;
+    
+    /**
+     * @brief Track the reading after a cut until it holds still
+     * @return true once it stayed within STOP_REST_BAND_MM for STOP_REST_MS
+     */
+    bool checkAtRest();
+    
+    /**
+     * @brief Update the stop distance from where the desk came to rest
+     * 
+     * The reading's travel from the cut to rest is what the stop distance
+     * should have been; the stop distance for the cut's direction moves
+     * STOP_DISTANCE_LEARN_PERCENT of the way there. It is kept in RAM
+     * (SystemConfiguration::learnStopDistanceUpMm()); loop() saves it, so
+     * the control pass never waits on a flash write.
+     */
+    void learnStopDistance();
+    
     /**
      * @brief Determine direction to move based on current vs target
      * @return MovementState MOVING_UP, MOVING_DOWN, or IDLE (at target)
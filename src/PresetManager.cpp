@@ -6,6 +6,7 @@
 #include "PresetManager.h"
 #include "Config.h"
 #include "utils/Logger.h"
+#include "utils/HeightUnits.h"
 
 static const char* TAG = "PresetManager";
 
@@ -40,7 +41,7 @@ bool PresetManager::init() {
     return true;
 }
 
-bool PresetManager::savePreset(uint8_t slot, const char* name, float height_cm) {
+bool PresetManager::savePreset(uint8_t slot, const char* name, uint16_t height_mm) {
     // Validate slot
     if (!isValidSlot(slot)) {
         Logger::warn(TAG, "Invalid slot %d (must be 1-%d)", slot, MAX_PRESETS);
@@ -48,9 +49,9 @@ bool PresetManager::savePreset(uint8_t slot, const char* name, float height_cm)
     }
     
     // Validate height
-    if (!isValidHeight(height_cm)) {
-        Logger::warn(TAG, "Invalid height %.1f (must be %.0f-%.0f cm)", 
-                     height_cm, DEFAULT_MIN_HEIGHT_CM, DEFAULT_MAX_HEIGHT_CM);
+    if (!isValidHeight(height_mm)) {
+        Logger::warn(TAG, "Invalid height %d mm (must be %d-%d cm)", 
+                     height_mm, DEFAULT_MIN_HEIGHT_CM, DEFAULT_MAX_HEIGHT_CM);
         return false;
     }
     
@@ -58,7 +59,7 @@ bool PresetManager::savePreset(uint8_t slot, const char* name, float height_cm)
     Preset& preset = presets_[slot - 1];
     
     // Update preset data
-    preset.height_cm = height_cm;
+    preset.height_mm = height_mm;
     preset.last_modified_ms = millis();
     
     // Copy name with truncation if needed
@@ -75,8 +76,8 @@ bool PresetManager::savePreset(uint8_t slot, const char* name, float height_cm)
         return false;
     }
     
-    Logger::info(TAG, "Saved preset %d: '%s' = %.1f cm", 
-                 slot, preset.name, preset.height_cm);
+    Logger::info(TAG, "Saved preset %d: '%s' = %d mm", 
+                 slot, preset.name, preset.height_mm);
     return true;
 }
 
@@ -115,8 +116,9 @@ bool PresetManager::isValidSlot(uint8_t slot) {
     return slot >= 1 && slot <= MAX_PRESETS;
 }
 
-bool PresetManager::isValidHeight(float height_cm) {
-    return height_cm >= DEFAULT_MIN_HEIGHT_CM && height_cm <= DEFAULT_MAX_HEIGHT_CM;
+bool PresetManager::isValidHeight(uint16_t height_mm) {
+    return height_mm >= DEFAULT_MIN_HEIGHT_CM * HeightUnits::MM_PER_CM &&
+           height_mm <= DEFAULT_MAX_HEIGHT_CM * HeightUnits::MM_PER_CM;
 }
 
 uint8_t PresetManager::getEnabledCount() const {
@@ -138,8 +140,12 @@ void PresetManager::loadPreset(uint8_t slot) {
     
     Preset& preset = presets_[slot - 1];
     
-    // Load height (default to 0 if not found)
-    preset.height_cm = prefs_.getFloat(heightKey, 0.0f);
+    // Load height (default to 0 if not found); convert pre-mm entries once
+    if (!prefs_.isKey(heightKey) && migrateLegacyHeight(slot)) {
+        Logger::info(TAG, "Migrated preset %d height to %d mm", slot, preset.height_mm);
+    } else {
+        preset.height_mm = prefs_.getUShort(heightKey, 0);
+    }
     
     // Load name (default to empty string)
     String nameStr = prefs_.getString(nameKey, "");
@@ -147,15 +153,15 @@ void PresetManager::loadPreset(uint8_t slot) {
     preset.name[MAX_PRESET_NAME_LENGTH] = '\0';
     
     // Validate loaded height
-    if (preset.height_cm != 0.0f && !isValidHeight(preset.height_cm)) {
-        Logger::warn(TAG, "Preset %d has invalid height %.1f, resetting", 
-                     slot, preset.height_cm);
+    if (preset.height_mm != 0 && !isValidHeight(preset.height_mm)) {
+        Logger::warn(TAG, "Preset %d has invalid height %d mm, resetting", 
+                     slot, preset.height_mm);
         preset.reset();
     }
     
     if (preset.isEnabled()) {
-        Logger::debug(TAG, "Loaded preset %d: '%s' = %.1f cm", 
-                      slot, preset.name, preset.height_cm);
+        Logger::debug(TAG, "Loaded preset %d: '%s' = %d mm", 
+                      slot, preset.name, preset.height_mm);
     }
 }
 
@@ -169,7 +175,7 @@ bool PresetManager::writePreset(uint8_t slot) {
     const Preset& preset = presets_[slot - 1];
     
     // Write height
-    if (prefs_.putFloat(heightKey, preset.height_cm) == 0) {
+    if (prefs_.putUShort(heightKey, preset.height_mm) == 0) {
         Logger::error(TAG, "Failed to write height for preset %d", slot);
         return false;
     }
@@ -183,7 +189,29 @@ bool PresetManager::writePreset(uint8_t slot) {
     return true;
 }
 
+bool PresetManager::migrateLegacyHeight(uint8_t slot) {
+    char legacyKey[4], heightKey[4];
+    getLegacyHeightKey(slot, legacyKey);
+    getHeightKey(slot, heightKey);
+    
+    if (!prefs_.isKey(legacyKey)) {
+        return false;
+    }
+    
+    Preset& preset = presets_[slot - 1];
+    preset.height_mm = HeightUnits::cmToMm(prefs_.getFloat(legacyKey, 0.0f));
+    
+    if (prefs_.putUShort(heightKey, preset.height_mm) != 0) {
+        prefs_.remove(legacyKey);
+    }
+    return true;
+}
+
 void PresetManager::getHeightKey(uint8_t slot, char* key) {
+    snprintf(key, 4, "m%d", slot);
+}
+
+void PresetManager::getLegacyHeightKey(uint8_t slot, char* key) {
     snprintf(key, 4, "h%d", slot);
 }
 
@@ -3,7 +3,7 @@
  * @brief Height preset configuration management with NVS persistence
  * 
  * Manages up to 5 height presets that persist across reboots.
- * Each preset has a slot (1-5), name (max 16 chars), and height (50-125 cm).
+ * Each preset has a slot (1-5), name (max 16 chars), and height (500-1250 mm).
  * 
  * Per FR-009: Store up to 5 height presets
  * Per FR-010: User-defined labels for presets
@@ -27,14 +27,14 @@ constexpr uint8_t MAX_PRESET_NAME_LENGTH = 16;
 struct Preset {
     uint8_t slot;                           // Slot number (1-5)
     char name[MAX_PRESET_NAME_LENGTH + 1];  // User-defined label
-    float height_cm;                        // Target height in cm (0 = disabled)
+    uint16_t height_mm;                     // Target height in mm (0 = disabled)
     unsigned long last_modified_ms;         // Timestamp of last modification
     
     /**
      * @brief Check if preset is enabled (has valid height)
      */
     bool isEnabled() const {
-        return height_cm > 0;
+        return height_mm > 0;
     }
     
     /**
@@ -42,7 +42,7 @@ struct Preset {
      */
     void reset() {
         name[0] = '\0';
-        height_cm = 0.0f;
+        height_mm = 0;
         last_modified_ms = 0;
     }
 };
@@ -54,7 +54,7 @@ struct Preset {
  * Usage:
  *   PresetManager presets;
  *   presets.init();  // Load from NVS
- *   presets.savePreset(1, "Standing", 110.0f);
+ *   presets.savePreset(1, "Standing", 1100);  // mm
  *   Preset* p = presets.getPreset(1);
  */
 class PresetManager {
@@ -74,10 +74,10 @@ public:
      * @brief Save a preset to NVS
      * @param slot Slot number (1-5)
      * @param name User-defined label (max 16 chars)
-     * @param height_cm Target height (50-125 cm)
+     * @param height_mm Target height (500-1250 mm)
      * @return true if successful, false if invalid params or NVS error
      */
-    bool savePreset(uint8_t slot, const char* name, float height_cm);
+    bool savePreset(uint8_t slot, const char* name, uint16_t height_mm);
     
     /**
      * @brief Delete a preset (set to default/disabled)
@@ -108,10 +108,10 @@ public:
     
     /**
      * @brief Check if height is valid for preset
-     * @param height_cm Height to check
-     * @return true if height is within valid range (50-125)
+     * @param height_mm Height to check
+     * @return true if height is within valid range (500-1250 mm)
      */
-    static bool isValidHeight(float height_cm);
+    static bool isValidHeight(uint16_t height_mm);
     
     /**
      * @brief Get count of enabled presets
@@ -140,12 +140,26 @@ private:
     bool writePreset(uint8_t slot);
     
     /**
-     * @brief Generate NVS key for preset height
+     * @brief Convert a legacy float cm height entry to the mm key
+     * @param slot Slot number (1-5)
+     * @return true if a legacy entry was found
+     */
+    bool migrateLegacyHeight(uint8_t slot);
+    
+    /**
+     * @brief Generate NVS key for preset height (mm)
      * @param slot Slot number
      * @param key Output buffer (min 4 bytes)
      */
     static void getHeightKey(uint8_t slot, char* key);
     
+    /**
+     * @brief Generate NVS key for a pre-mm preset height (float cm)
+     * @param slot Slot number
+     * @param key Output buffer (min 4 bytes)
+     */
+    static void getLegacyHeightKey(uint8_t slot, char* key);
+    
     /**
      * @brief Generate NVS key for preset name
      * @param slot Slot number
@@ -5,6 +5,7 @@
 
 #include "SystemConfiguration.h"
 #include "utils/Logger.h"
+#include "utils/HeightUnits.h"
 
 static const char* TAG = "SystemConfig";
 
@@ -12,13 +13,33 @@ static const char* TAG = "SystemConfig";
 SystemConfiguration& SystemConfig = SystemConfiguration::getInstance();
 
 // NVS Keys
-static const char* KEY_CAL_CONST = "cal_const";
+static const char* KEY_CAL_MM = "cal_mm";
+static const char* KEY_CAL_CONST_LEGACY = "cal_const";  // cm, pre-mm firmware
 static const char* KEY_MIN_HEIGHT = "min_h";
 static const char* KEY_MAX_HEIGHT = "max_h";
 static const char* KEY_TOLERANCE = "tolerance";
 static const char* KEY_STAB_DUR = "stab_dur";
 static const char* KEY_MOVE_TIMEOUT = "move_timeout";
 static const char* KEY_FILTER_WIN = "filter_win";
+static const char* KEY_CONSENSUS = "consensus";
+static const char* KEY_TEMPORAL = "temporal";
+static const char* KEY_ZONE_FILTER = "zone_filter";
+static const char* KEY_OUTLIER_RULE = "outlier_rule";
+static const char* KEY_OUTLIER_MIN = "outlier_min";
+static const char* KEY_OUTLIER_MAX = "outlier_max";
+static const char* KEY_FILTER_MODE = "filter_mode";
+static const char* KEY_KF_PROCESS = "kf_process";
+static const char* KEY_KF_MEAS = "kf_meas";
+static const char* KEY_STOP_MODE = "stop_mode";
+static const char* KEY_STOP_UP = "stop_up";
+static const char* KEY_STOP_DOWN = "stop_down";
+static const char* KEY_MOTION_FRAMES = "motion_frames";
+static const char* KEY_DRIVE_MODE = "drive_mode";
+static const char* KEY_RAMP_UP = "ramp_up";
+static const char* KEY_RAMP_DOWN = "ramp_down";
+static const char* KEY_SLOWDOWN = "slowdown";
+static const char* KEY_ZONE_MASK = "zone_mask";
+static const char* KEY_ZONE_MASK_N = "zone_mask_n";
 
 SystemConfiguration::SystemConfiguration()
     : initialized_(false)
@@ -57,25 +78,69 @@ bool SystemConfiguration::init() {
 }
 
 void SystemConfiguration::applyDefaults() {
-    calibrationConstant_ = DEFAULT_CALIBRATION_CONSTANT_CM;
+    calibrationOffsetMm_ = DEFAULT_CALIBRATION_OFFSET_MM;
     minHeight_ = DEFAULT_MIN_HEIGHT_CM;
     maxHeight_ = DEFAULT_MAX_HEIGHT_CM;
     tolerance_ = DEFAULT_TOLERANCE_MM;
     stabilizationDuration_ = DEFAULT_STABILIZATION_DURATION_MS;
     movementTimeout_ = DEFAULT_MOVEMENT_TIMEOUT_MS;
     filterWindowSize_ = DEFAULT_FILTER_WINDOW_SIZE;
+    filterWindowMode_ = static_cast<FilterWindowMode>(DEFAULT_FILTER_WINDOW_MODE);
+    consensusMethod_ = static_cast<ConsensusMethod>(DEFAULT_CONSENSUS_METHOD);
+    temporalFilter_ = static_cast<TemporalFilterMethod>(DEFAULT_TEMPORAL_FILTER);
+    zoneFilter_ = static_cast<ZoneFilterMethod>(DEFAULT_ZONE_FILTER);
+    outlierThreshold_ = static_cast<OutlierThresholdMethod>(DEFAULT_OUTLIER_RULE);
+    outlierMinMm_ = DEFAULT_OUTLIER_MIN_MM;
+    outlierMaxMm_ = DEFAULT_OUTLIER_MAX_MM;
+    kalmanProcessNoise_ = DEFAULT_KALMAN_PROCESS_NOISE;
+    kalmanMeasurementNoise_ = DEFAULT_KALMAN_MEASUREMENT_NOISE;
+    stopMode_ = static_cast<StopMode>(DEFAULT_STOP_MODE);
+    stopDistanceUpMm_ = DEFAULT_STOP_DISTANCE_UP_MM;
+    stopDistanceDownMm_ = DEFAULT_STOP_DISTANCE_DOWN_MM;
+    calibrationOffsetDirty_ = false;
+    stopDistanceUpDirty_ = false;
+    stopDistanceDownDirty_ = false;
+    motionFaultFrames_ = DEFAULT_MOTION_FAULT_FRAMES;
+    driveMode_ = static_cast<DriveMode>(DEFAULT_DRIVE_MODE);
+    rampUpMs_ = DEFAULT_RAMP_UP_MS;
+    rampDownMs_ = DEFAULT_RAMP_DOWN_MS;
+    slowdownDistanceMm_ = DEFAULT_SLOWDOWN_DISTANCE_MM;
+    zoneMask_ = 0;
 }
 
 void SystemConfiguration::loadFromNVS() {
     // Load each value, falling back to current (default) value if not found
-    // Cast calibration constant to int16_t (can be negative for floor-mounted sensor)
-    calibrationConstant_ = (int16_t)preferences_.getUShort(KEY_CAL_CONST, (uint16_t)calibrationConstant_);
+    // Cast calibration offset to int16_t (can be negative for floor-mounted sensor)
+    if (preferences_.isKey(KEY_CAL_MM)) {
+        calibrationOffsetMm_ = (int16_t)preferences_.getUShort(KEY_CAL_MM, (uint16_t)calibrationOffsetMm_);
+    } else if (preferences_.isKey(KEY_CAL_CONST_LEGACY)) {
+        migrateCalibrationConstant();
+    }
     minHeight_ = preferences_.getUShort(KEY_MIN_HEIGHT, minHeight_);
     maxHeight_ = preferences_.getUShort(KEY_MAX_HEIGHT, maxHeight_);
     tolerance_ = preferences_.getUShort(KEY_TOLERANCE, tolerance_);
     stabilizationDuration_ = preferences_.getUShort(KEY_STAB_DUR, stabilizationDuration_);
     movementTimeout_ = preferences_.getUShort(KEY_MOVE_TIMEOUT, movementTimeout_);
     filterWindowSize_ = preferences_.getUChar(KEY_FILTER_WIN, filterWindowSize_);
+    uint8_t windowMode = preferences_.getUChar(KEY_FILTER_MODE, static_cast<uint8_t>(filterWindowMode_));
+    uint8_t method = preferences_.getUChar(KEY_CONSENSUS, static_cast<uint8_t>(consensusMethod_));
+    uint8_t temporal = preferences_.getUChar(KEY_TEMPORAL, static_cast<uint8_t>(temporalFilter_));
+    uint8_t zoneFilter = preferences_.getUChar(KEY_ZONE_FILTER, static_cast<uint8_t>(zoneFilter_));
+    uint8_t outlierRule = preferences_.getUChar(KEY_OUTLIER_RULE, static_cast<uint8_t>(outlierThreshold_));
+    outlierMinMm_ = preferences_.getUShort(KEY_OUTLIER_MIN, outlierMinMm_);
+    outlierMaxMm_ = preferences_.getUShort(KEY_OUTLIER_MAX, outlierMaxMm_);
+    kalmanProcessNoise_ = preferences_.getUShort(KEY_KF_PROCESS, kalmanProcessNoise_);
+    kalmanMeasurementNoise_ = preferences_.getUShort(KEY_KF_MEAS, kalmanMeasurementNoise_);
+    uint8_t stopMode = preferences_.getUChar(KEY_STOP_MODE, static_cast<uint8_t>(stopMode_));
+    stopDistanceUpMm_ = preferences_.getUShort(KEY_STOP_UP, stopDistanceUpMm_);
+    stopDistanceDownMm_ = preferences_.getUShort(KEY_STOP_DOWN, stopDistanceDownMm_);
+    motionFaultFrames_ = preferences_.getUChar(KEY_MOTION_FRAMES, motionFaultFrames_);
+    uint8_t driveMode = preferences_.getUChar(KEY_DRIVE_MODE, static_cast<uint8_t>(driveMode_));
+    rampUpMs_ = preferences_.getUShort(KEY_RAMP_UP, rampUpMs_);
+    rampDownMs_ = preferences_.getUShort(KEY_RAMP_DOWN, rampDownMs_);
+    slowdownDistanceMm_ = preferences_.getUShort(KEY_SLOWDOWN, slowdownDistanceMm_);
+    zoneMask_ = preferences_.getULong64(KEY_ZONE_MASK, zoneMask_);
+    uint8_t maskZones = preferences_.getUChar(KEY_ZONE_MASK_N, MULTI_ZONE_TOTAL_ZONES);
     // WiFi credentials are loaded from secrets.h at compile time, not from NVS
     
     // Validate and clamp filter window size
@@ -85,32 +150,148 @@ void SystemConfiguration::loadFromNVS() {
     if (filterWindowSize_ > MAX_FILTER_WINDOW_SIZE) {
         filterWindowSize_ = MAX_FILTER_WINDOW_SIZE;
     }
+    
+    // Unknown method values fall back to the original estimator
+    filterWindowMode_ = (windowMode == static_cast<uint8_t>(FilterWindowMode::ADAPTIVE))
+        ? FilterWindowMode::ADAPTIVE
+        : FilterWindowMode::FIXED;
+    if (method == static_cast<uint8_t>(ConsensusMethod::CONFIDENCE_WEIGHTED) ||
+        method == static_cast<uint8_t>(ConsensusMethod::PLANE_FIT)) {
+        consensusMethod_ = static_cast<ConsensusMethod>(method);
+    } else {
+        consensusMethod_ = ConsensusMethod::MEDIAN_MEAN;
+    }
+    temporalFilter_ = (temporal == static_cast<uint8_t>(TemporalFilterMethod::KALMAN))
+        ? TemporalFilterMethod::KALMAN
+        : TemporalFilterMethod::MOVING_AVERAGE;
+    zoneFilter_ = (zoneFilter == static_cast<uint8_t>(ZoneFilterMethod::EXPONENTIAL))
+        ? ZoneFilterMethod::EXPONENTIAL
+        : ZoneFilterMethod::NONE;
+    outlierThreshold_ = (outlierRule == static_cast<uint8_t>(OutlierThresholdMethod::ADAPTIVE))
+        ? OutlierThresholdMethod::ADAPTIVE
+        : OutlierThresholdMethod::FIXED;
+    
+    // Validate and clamp adaptive outlier bounds
+    if (outlierMinMm_ < MIN_OUTLIER_BOUND_MM || outlierMinMm_ > MAX_OUTLIER_BOUND_MM) {
+        outlierMinMm_ = DEFAULT_OUTLIER_MIN_MM;
+    }
+    if (outlierMaxMm_ < MIN_OUTLIER_BOUND_MM || outlierMaxMm_ > MAX_OUTLIER_BOUND_MM) {
+        outlierMaxMm_ = DEFAULT_OUTLIER_MAX_MM;
+    }
+    
+    // Validate and clamp Kalman noise parameters
+    if (kalmanProcessNoise_ < MIN_KALMAN_PROCESS_NOISE) {
+        kalmanProcessNoise_ = MIN_KALMAN_PROCESS_NOISE;
+    }
+    if (kalmanProcessNoise_ > MAX_KALMAN_PROCESS_NOISE) {
+        kalmanProcessNoise_ = MAX_KALMAN_PROCESS_NOISE;
+    }
+    if (kalmanMeasurementNoise_ < MIN_KALMAN_MEASUREMENT_NOISE) {
+        kalmanMeasurementNoise_ = MIN_KALMAN_MEASUREMENT_NOISE;
+    }
+    if (kalmanMeasurementNoise_ > MAX_KALMAN_MEASUREMENT_NOISE) {
+        kalmanMeasurementNoise_ = MAX_KALMAN_MEASUREMENT_NOISE;
+    }
+    
+    // Unknown cut-off rules fall back to the original one
+    stopMode_ = (stopMode == static_cast<uint8_t>(StopMode::PREDICTIVE))
+        ? StopMode::PREDICTIVE
+        : StopMode::TOLERANCE;
+    if (stopDistanceUpMm_ > MAX_STOP_DISTANCE_MM) {
+        stopDistanceUpMm_ = DEFAULT_STOP_DISTANCE_UP_MM;
+    }
+    if (stopDistanceDownMm_ > MAX_STOP_DISTANCE_MM) {
+        stopDistanceDownMm_ = DEFAULT_STOP_DISTANCE_DOWN_MM;
+    }
+    
+    // Validate and clamp motion fault frames
+    if (motionFaultFrames_ < MIN_MOTION_FAULT_FRAMES) {
+        motionFaultFrames_ = MIN_MOTION_FAULT_FRAMES;
+    }
+    if (motionFaultFrames_ > MAX_MOTION_FAULT_FRAMES) {
+        motionFaultFrames_ = MAX_MOTION_FAULT_FRAMES;
+    }
+    
+    // Unknown drive modes fall back to switching the pins
+    driveMode_ = (driveMode == static_cast<uint8_t>(DriveMode::PWM))
+        ? DriveMode::PWM
+        : DriveMode::SWITCHED;
+    if (rampUpMs_ > MAX_RAMP_MS) {
+        rampUpMs_ = MAX_RAMP_MS;
+    }
+    if (rampDownMs_ > MAX_RAMP_MS) {
+        rampDownMs_ = MAX_RAMP_MS;
+    }
+    if (slowdownDistanceMm_ > MAX_SLOWDOWN_DISTANCE_MM) {
+        slowdownDistanceMm_ = MAX_SLOWDOWN_DISTANCE_MM;
+    }
+    
+    // A mask learned on the other grid size (4x4 vs 8x8 build) is meaningless
+    if (maskZones != MULTI_ZONE_TOTAL_ZONES) {
+        zoneMask_ = 0;
+    }
+    zoneMask_ &= ~0ULL >> (64 - MULTI_ZONE_TOTAL_ZONES);
 }
 
 bool SystemConfiguration::isCalibrated() const {
-    return calibrationConstant_ != 0;
+    return calibrationOffsetMm_ != 0;
+}
+
+void SystemConfiguration::migrateCalibrationConstant() {
+    // Older firmware stored the constant in whole cm
+    int16_t legacy_cm = (int16_t)preferences_.getUShort(KEY_CAL_CONST_LEGACY, 0);
+    calibrationOffsetMm_ = (int16_t)(legacy_cm * (int16_t)HeightUnits::MM_PER_CM);
+    
+    if (saveUInt16(KEY_CAL_MM, (uint16_t)calibrationOffsetMm_)) {
+        preferences_.remove(KEY_CAL_CONST_LEGACY);
+        Logger::info(TAG, "Migrated calibration constant %d cm -> %d mm",
+                     legacy_cm, calibrationOffsetMm_);
+    }
 }
 
 // Getters
-int16_t SystemConfiguration::getCalibrationConstant() const { return calibrationConstant_; }
+int16_t SystemConfiguration::getCalibrationOffsetMm() const { return calibrationOffsetMm_; }
 uint16_t SystemConfiguration::getMinHeight() const { return minHeight_; }
 uint16_t SystemConfiguration::getMaxHeight() const { return maxHeight_; }
 uint16_t SystemConfiguration::getTolerance() const { return tolerance_; }
 uint16_t SystemConfiguration::getStabilizationDuration() const { return stabilizationDuration_; }
 uint16_t SystemConfiguration::getMovementTimeout() const { return movementTimeout_; }
 uint8_t SystemConfiguration::getFilterWindowSize() const { return filterWindowSize_; }
+FilterWindowMode SystemConfiguration::getFilterWindowMode() const { return filterWindowMode_; }
+ConsensusMethod SystemConfiguration::getConsensusMethod() const { return consensusMethod_; }
+TemporalFilterMethod SystemConfiguration::getTemporalFilter() const { return temporalFilter_; }
+ZoneFilterMethod SystemConfiguration::getZoneFilter() const { return zoneFilter_; }
+OutlierThresholdMethod SystemConfiguration::getOutlierThreshold() const { return outlierThreshold_; }
+uint16_t SystemConfiguration::getOutlierMinMm() const { return outlierMinMm_; }
+uint16_t SystemConfiguration::getOutlierMaxMm() const { return outlierMaxMm_; }
+uint16_t SystemConfiguration::getKalmanProcessNoise() const { return kalmanProcessNoise_; }
+uint16_t SystemConfiguration::getKalmanMeasurementNoise() const { return kalmanMeasurementNoise_; }
+StopMode SystemConfiguration::getStopMode() const { return stopMode_; }
+uint16_t SystemConfiguration::getStopDistanceUpMm() const { return stopDistanceUpMm_; }
+uint16_t SystemConfiguration::getStopDistanceDownMm() const { return stopDistanceDownMm_; }
+uint8_t SystemConfiguration::getMotionFaultFrames() const { return motionFaultFrames_; }
+DriveMode SystemConfiguration::getDriveMode() const { return driveMode_; }
+uint16_t SystemConfiguration::getRampUpMs() const { return rampUpMs_; }
+uint16_t SystemConfiguration::getRampDownMs() const { return rampDownMs_; }
+uint16_t SystemConfiguration::getSlowdownDistanceMm() const { return slowdownDistanceMm_; }
+uint64_t SystemConfiguration::getZoneMask() const { return zoneMask_; }
 
 // Setters with NVS persistence
-bool SystemConfiguration::setCalibrationConstant(int16_t value) {
+bool SystemConfiguration::setCalibrationOffsetMm(int16_t value) {
     // Store as uint16_t in NVS (bit pattern preserved)
-    if (saveUInt16(KEY_CAL_CONST, (uint16_t)value)) {
-        calibrationConstant_ = value;
-        Logger::info(TAG, "Calibration constant set to %d cm", value);
+    if (saveUInt16(KEY_CAL_MM, (uint16_t)value)) {
+        calibrationOffsetMm_ = value;
+        Logger::info(TAG, "Calibration offset set to %d mm", value);
         return true;
     }
     return false;
 }
 
+void SystemConfiguration::learnCalibrationOffsetMm(int16_t value) {
+    calibrationOffsetMm_ = value;
+    calibrationOffsetDirty_ = true;
+}
+
 bool SystemConfiguration::setMinHeight(uint16_t value) {
     if (value >= maxHeight_) {
         Logger::error(TAG, "Min height (%d) must be less than max height (%d)", value, maxHeight_);
@@ -189,10 +370,247 @@ bool SystemConfiguration::setFilterWindowSize(uint8_t value) {
     return false;
 }
 
+bool SystemConfiguration::setFilterWindowMode(FilterWindowMode mode) {
+    if (saveUInt8(KEY_FILTER_MODE, static_cast<uint8_t>(mode))) {
+        filterWindowMode_ = mode;
+        Logger::info(TAG, "Filter window mode set to %s",
+                     mode == FilterWindowMode::ADAPTIVE ? "adaptive" : "fixed");
+        return true;
+    }
+    return false;
+}
+
+bool SystemConfiguration::setConsensusMethod(ConsensusMethod method) {
+    if (saveUInt8(KEY_CONSENSUS, static_cast<uint8_t>(method))) {
+        consensusMethod_ = method;
+        Logger::info(TAG, "Consensus method set to %s", consensusMethodName(method));
+        return true;
+    }
+    return false;
+}
+
+bool SystemConfiguration::setTemporalFilter(TemporalFilterMethod method) {
+    if (saveUInt8(KEY_TEMPORAL, static_cast<uint8_t>(method))) {
+        temporalFilter_ = method;
+        Logger::info(TAG, "Temporal filter set to %s",
+                     method == TemporalFilterMethod::KALMAN ? "kalman" : "average");
+        return true;
+    }
+    return false;
+}
+
+bool SystemConfiguration::setZoneFilter(ZoneFilterMethod method) {
+    if (saveUInt8(KEY_ZONE_FILTER, static_cast<uint8_t>(method))) {
+        zoneFilter_ = method;
+        Logger::info(TAG, "Zone filter set to %s",
+                     method == ZoneFilterMethod::EXPONENTIAL ? "exponential" : "none");
+        return true;
+    }
+    return false;
+}
+
+bool SystemConfiguration::setOutlierThreshold(OutlierThresholdMethod method) {
+    if (saveUInt8(KEY_OUTLIER_RULE, static_cast<uint8_t>(method))) {
+        outlierThreshold_ = method;
+        Logger::info(TAG, "Outlier threshold set to %s",
+                     method == OutlierThresholdMethod::ADAPTIVE ? "adaptive" : "fixed");
+        return true;
+    }
+    return false;
+}
+
+bool SystemConfiguration::setOutlierMinMm(uint16_t value) {
+    // Clamp to valid range
+    if (value < MIN_OUTLIER_BOUND_MM) value = MIN_OUTLIER_BOUND_MM;
+    if (value > MAX_OUTLIER_BOUND_MM) value = MAX_OUTLIER_BOUND_MM;
+    
+    if (saveUInt16(KEY_OUTLIER_MIN, value)) {
+        outlierMinMm_ = value;
+        Logger::info(TAG, "Outlier threshold lower bound set to %d mm", value);
+        return true;
+    }
+    return false;
+}
+
+bool SystemConfiguration::setOutlierMaxMm(uint16_t value) {
+    // Clamp to valid range
+    if (value < MIN_OUTLIER_BOUND_MM) value = MIN_OUTLIER_BOUND_MM;
+    if (value > MAX_OUTLIER_BOUND_MM) value = MAX_OUTLIER_BOUND_MM;
+    
+    if (saveUInt16(KEY_OUTLIER_MAX, value)) {
+        outlierMaxMm_ = value;
+        Logger::info(TAG, "Outlier threshold upper bound set to %d mm", value);
+        return true;
+    }
+    return false;
+}
+
+bool SystemConfiguration::setKalmanProcessNoise(uint16_t value) {
+    // Clamp to valid range
+    if (value < MIN_KALMAN_PROCESS_NOISE) value = MIN_KALMAN_PROCESS_NOISE;
+    if (value > MAX_KALMAN_PROCESS_NOISE) value = MAX_KALMAN_PROCESS_NOISE;
+    
+    if (saveUInt16(KEY_KF_PROCESS, value)) {
+        kalmanProcessNoise_ = value;
+        Logger::info(TAG, "Kalman process noise set to %d mm/s^2", value);
+        return true;
+    }
+    return false;
+}
+
+bool SystemConfiguration::setKalmanMeasurementNoise(uint16_t value) {
+    // Clamp to valid range
+    if (value < MIN_KALMAN_MEASUREMENT_NOISE) value = MIN_KALMAN_MEASUREMENT_NOISE;
+    if (value > MAX_KALMAN_MEASUREMENT_NOISE) value = MAX_KALMAN_MEASUREMENT_NOISE;
+    
+    if (saveUInt16(KEY_KF_MEAS, value)) {
+        kalmanMeasurementNoise_ = value;
+        Logger::info(TAG, "Kalman measurement noise set to %d mm", value);
+        return true;
+    }
+    return false;
+}
+
+bool SystemConfiguration::setStopMode(StopMode mode) {
+    if (saveUInt8(KEY_STOP_MODE, static_cast<uint8_t>(mode))) {
+        stopMode_ = mode;
+        Logger::info(TAG, "Stop mode set to %s",
+                     mode == StopMode::PREDICTIVE ? "predictive" : "tolerance");
+        return true;
+    }
+    return false;
+}
+
+bool SystemConfiguration::setStopDistanceUpMm(uint16_t value) {
+    if (value > MAX_STOP_DISTANCE_MM) value = MAX_STOP_DISTANCE_MM;
+    
+    if (saveUInt16(KEY_STOP_UP, value)) {
+        stopDistanceUpMm_ = value;
+        Logger::info(TAG, "Stop distance up set to %d mm", value);
+        return true;
+    }
+    return false;
+}
+
+bool SystemConfiguration::setStopDistanceDownMm(uint16_t value) {
+    if (value > MAX_STOP_DISTANCE_MM) value = MAX_STOP_DISTANCE_MM;
+    
+    if (saveUInt16(KEY_STOP_DOWN, value)) {
+        stopDistanceDownMm_ = value;
+        Logger::info(TAG, "Stop distance down set to %d mm", value);
+        return true;
+    }
+    return false;
+}
+
+void SystemConfiguration::learnStopDistanceUpMm(uint16_t value) {
+    if (value > MAX_STOP_DISTANCE_MM) value = MAX_STOP_DISTANCE_MM;
+    stopDistanceUpMm_ = value;
+    stopDistanceUpDirty_ = true;
+}
+
+void SystemConfiguration::learnStopDistanceDownMm(uint16_t value) {
+    if (value > MAX_STOP_DISTANCE_MM) value = MAX_STOP_DISTANCE_MM;
+    stopDistanceDownMm_ = value;
+    stopDistanceDownDirty_ = true;
+}
+
+void SystemConfiguration::persistLearnedValues() {
+    // Flag cleared first: a value learned during the write is saved next time
+    if (calibrationOffsetDirty_) {
+        calibrationOffsetDirty_ = false;
+        if (saveUInt16(KEY_CAL_MM, (uint16_t)calibrationOffsetMm_)) {
+            Logger::info(TAG, "Calibration offset set to %d mm", calibrationOffsetMm_);
+        }
+    }
+    if (stopDistanceUpDirty_) {
+        stopDistanceUpDirty_ = false;
+        saveUInt16(KEY_STOP_UP, stopDistanceUpMm_);
+    }
+    if (stopDistanceDownDirty_) {
+        stopDistanceDownDirty_ = false;
+        saveUInt16(KEY_STOP_DOWN, stopDistanceDownMm_);
+    }
+}
+
+bool SystemConfiguration::setMotionFaultFrames(uint8_t value) {
+    // Clamp to valid range
+    if (value < MIN_MOTION_FAULT_FRAMES) value = MIN_MOTION_FAULT_FRAMES;
+    if (value > MAX_MOTION_FAULT_FRAMES) value = MAX_MOTION_FAULT_FRAMES;
+    
+    if (saveUInt8(KEY_MOTION_FRAMES, value)) {
+        motionFaultFrames_ = value;
+        Logger::info(TAG, "Motion fault frames set to %d", value);
+        return true;
+    }
+    return false;
+}
+
+bool SystemConfiguration::setDriveMode(DriveMode mode) {
+    if (saveUInt8(KEY_DRIVE_MODE, static_cast<uint8_t>(mode))) {
+        driveMode_ = mode;
+        Logger::info(TAG, "Drive mode set to %s", mode == DriveMode::PWM ? "pwm" : "switched");
+        return true;
+    }
+    return false;
+}
+
+bool SystemConfiguration::setRampUpMs(uint16_t value) {
+    if (value > MAX_RAMP_MS) value = MAX_RAMP_MS;
+    
+    if (saveUInt16(KEY_RAMP_UP, value)) {
+        rampUpMs_ = value;
+        Logger::info(TAG, "Ramp up set to %d ms", value);
+        return true;
+    }
+    return false;
+}
+
+bool SystemConfiguration::setRampDownMs(uint16_t value) {
+    if (value > MAX_RAMP_MS) value = MAX_RAMP_MS;
+    
+    if (saveUInt16(KEY_RAMP_DOWN, value)) {
+        rampDownMs_ = value;
+        Logger::info(TAG, "Ramp down set to %d ms", value);
+        return true;
+    }
+    return false;
+}
+
+bool SystemConfiguration::setSlowdownDistanceMm(uint16_t value) {
+    if (value > MAX_SLOWDOWN_DISTANCE_MM) value = MAX_SLOWDOWN_DISTANCE_MM;
+    
+    if (saveUInt16(KEY_SLOWDOWN, value)) {
+        slowdownDistanceMm_ = value;
+        Logger::info(TAG, "Slow-down distance set to %d mm", value);
+        return true;
+    }
+    return false;
+}
+
+bool SystemConfiguration::setZoneMask(uint64_t mask) {
+    if (preferences_.putULong64(KEY_ZONE_MASK, mask) == 0) {
+        Logger::error(TAG, "Failed to save %s", KEY_ZONE_MASK);
+        return false;
+    }
+    if (saveUInt8(KEY_ZONE_MASK_N, MULTI_ZONE_TOTAL_ZONES)) {
+        zoneMask_ = mask;
+        Logger::info(TAG, "Zone mask set to 0x%08lx%08lx",
+                     (unsigned long)(mask >> 32), (unsigned long)(mask & 0xFFFFFFFFUL));
+        return true;
+    }
+    return false;
+}
+
 bool SystemConfiguration::isValidHeight(uint16_t height) const {
     return height >= minHeight_ && height <= maxHeight_;
 }
 
+bool SystemConfiguration::isValidHeightMm(uint16_t height_mm) const {
+    return height_mm >= minHeight_ * HeightUnits::MM_PER_CM &&
+           height_mm <= maxHeight_ * HeightUnits::MM_PER_CM;
+}
+
 bool SystemConfiguration::factoryReset() {
     Logger::warn(TAG, "Factory reset initiated");
     
@@ -201,13 +619,32 @@ bool SystemConfiguration::factoryReset() {
     
     // Re-save defaults to NVS
     bool success = true;
-    success &= saveUInt16(KEY_CAL_CONST, calibrationConstant_);
+    success &= saveUInt16(KEY_CAL_MM, (uint16_t)calibrationOffsetMm_);
     success &= saveUInt16(KEY_MIN_HEIGHT, minHeight_);
     success &= saveUInt16(KEY_MAX_HEIGHT, maxHeight_);
     success &= saveUInt16(KEY_TOLERANCE, tolerance_);
     success &= saveUInt16(KEY_STAB_DUR, stabilizationDuration_);
     success &= saveUInt16(KEY_MOVE_TIMEOUT, movementTimeout_);
     success &= saveUInt8(KEY_FILTER_WIN, filterWindowSize_);
+    success &= saveUInt8(KEY_FILTER_MODE, static_cast<uint8_t>(filterWindowMode_));
+    success &= saveUInt8(KEY_CONSENSUS, static_cast<uint8_t>(consensusMethod_));
+    success &= saveUInt8(KEY_TEMPORAL, static_cast<uint8_t>(temporalFilter_));
+    success &= saveUInt8(KEY_ZONE_FILTER, static_cast<uint8_t>(zoneFilter_));
+    success &= saveUInt8(KEY_OUTLIER_RULE, static_cast<uint8_t>(outlierThreshold_));
+    success &= saveUInt16(KEY_OUTLIER_MIN, outlierMinMm_);
+    success &= saveUInt16(KEY_OUTLIER_MAX, outlierMaxMm_);
+    success &= saveUInt16(KEY_KF_PROCESS, kalmanProcessNoise_);
+    success &= saveUInt16(KEY_KF_MEAS, kalmanMeasurementNoise_);
+    success &= saveUInt8(KEY_STOP_MODE, static_cast<uint8_t>(stopMode_));
+    success &= saveUInt16(KEY_STOP_UP, stopDistanceUpMm_);
+    success &= saveUInt16(KEY_STOP_DOWN, stopDistanceDownMm_);
+    success &= saveUInt8(KEY_MOTION_FRAMES, motionFaultFrames_);
+    success &= saveUInt8(KEY_DRIVE_MODE, static_cast<uint8_t>(driveMode_));
+    success &= saveUInt16(KEY_RAMP_UP, rampUpMs_);
+    success &= saveUInt16(KEY_RAMP_DOWN, rampDownMs_);
+    success &= saveUInt16(KEY_SLOWDOWN, slowdownDistanceMm_);
+    success &= (preferences_.putULong64(KEY_ZONE_MASK, zoneMask_) != 0);
+    success &= saveUInt8(KEY_ZONE_MASK_N, MULTI_ZONE_TOTAL_ZONES);
     // Don't save empty WiFi credentials
     
     if (success) {
@@ -221,13 +658,27 @@ bool SystemConfiguration::factoryReset() {
 
 String SystemConfiguration::toJson() const {
     String json = "{";
-    json += "\"calibrationConstant\":" + String(calibrationConstant_) + ",";
+    json += "\"calibrationOffsetMm\":" + String(calibrationOffsetMm_) + ",";
     json += "\"minHeight\":" + String(minHeight_) + ",";
     json += "\"maxHeight\":" + String(maxHeight_) + ",";
     json += "\"tolerance\":" + String(tolerance_) + ",";
     json += "\"stabilizationDuration\":" + String(stabilizationDuration_) + ",";
     json += "\"movementTimeout\":" + String(movementTimeout_) + ",";
     json += "\"filterWindowSize\":" + String(filterWindowSize_) + ",";
+    json += "\"filterWindowMode\":\"" + String(filterWindowMode_ == FilterWindowMode::ADAPTIVE ? "adaptive" : "fixed") + "\",";
+    json += "\"consensusMethod\":\"" + String(consensusMethodName(consensusMethod_)) + "\",";
+    json += "\"zoneFilter\":\"" + String(zoneFilter_ == ZoneFilterMethod::EXPONENTIAL ? "exponential" : "none") + "\",";
+    json += "\"outlierThreshold\":\"" + String(outlierThreshold_ == OutlierThresholdMethod::ADAPTIVE ? "adaptive" : "fixed") + "\",";
+    json += "\"outlierMinMm\":" + String(outlierMinMm_) + ",";
+    json += "\"outlierMaxMm\":" + String(outlierMaxMm_) + ",";
+    json += "\"stopMode\":\"" + String(stopMode_ == StopMode::PREDICTIVE ? "predictive" : "tolerance") + "\",";
+    json += "\"stopDistanceUpMm\":" + String(stopDistanceUpMm_) + ",";
+    json += "\"stopDistanceDownMm\":" + String(stopDistanceDownMm_) + ",";
+    json += "\"motionFaultFrames\":" + String(motionFaultFrames_) + ",";
+    json += "\"driveMode\":\"" + String(driveMode_ == DriveMode::PWM ? "pwm" : "switched") + "\",";
+    json += "\"rampUpMs\":" + String(rampUpMs_) + ",";
+    json += "\"rampDownMs\":" + String(rampDownMs_) + ",";
+    json += "\"slowdownDistanceMm\":" + String(slowdownDistanceMm_) + ",";
     json += "\"isCalibrated\":" + String(isCalibrated() ? "true" : "false");
     json += "}";
     return json;
@@ -3,7 +3,7 @@
  * @brief System configuration management with NVS persistence
  * 
  * Manages all configurable parameters:
- * - Calibration constant for height calculation
+ * - Calibration offset for height calculation (mm)
  * - Safety limits (min/max height)
  * - Movement parameters (tolerance, stabilization, timeout)
  * - Filter settings
@@ -20,14 +20,89 @@
 #include <Preferences.h>
 #include "Config.h"
 
+/**
+ * @enum FilterWindowMode
+ * @brief How the moving average window is chosen
+ */
+enum class FilterWindowMode : uint8_t {
+    FIXED = 0,                ///< Configured filter window size
+    ADAPTIVE = 1              ///< Sized from the measured consensus noise, with hysteresis
+};
+
+/**
+ * @enum ConsensusMethod
+ * @brief Estimator used to combine surviving zones into one distance
+ */
+enum class ConsensusMethod : uint8_t {
+    MEDIAN_MEAN = 0,          ///< Equal-weight mean of non-outlier zones
+    CONFIDENCE_WEIGHTED = 1,  ///< Inverse-variance mean using sigma and signal/ambient
+    PLANE_FIT = 2             ///< RANSAC floor plane over the zone rays, distance on the sensor axis
+};
+
+/**
+ * @brief API name of a consensus method (POST /config "consensusMethod")
+ */
+inline const char* consensusMethodName(ConsensusMethod method) {
+    switch (method) {
+        case ConsensusMethod::CONFIDENCE_WEIGHTED: return "weighted";
+        case ConsensusMethod::PLANE_FIT:           return "plane";
+        default:                                   return "median";
+    }
+}
+
+/**
+ * @enum TemporalFilterMethod
+ * @brief Filter applied to the consensus distance over time
+ */
+enum class TemporalFilterMethod : uint8_t {
+    MOVING_AVERAGE = 0,       ///< Windowed mean, (N-1)/2 frames of lag
+    KALMAN = 1                ///< Constant-velocity Kalman, also estimates velocity
+};
+
+/**
+ * @enum ZoneFilterMethod
+ * @brief Filter applied to each zone over time, ahead of the consensus
+ */
+enum class ZoneFilterMethod : uint8_t {
+    NONE = 0,                 ///< Zones go to the consensus as read
+    EXPONENTIAL = 1           ///< Per-zone exponential filter, short dropouts bridged
+};
+
+/**
+ * @enum OutlierThresholdMethod
+ * @brief How the consensus decides which zones are outliers
+ */
+enum class OutlierThresholdMethod : uint8_t {
+    FIXED = 0,                ///< MULTI_ZONE_OUTLIER_THRESHOLD_MM from the median
+    ADAPTIVE = 1              ///< Scaled from the frame's median absolute deviation, clamped
+};
+
+/**
+ * @enum StopMode
+ * @brief When the motor is cut on the way to a target
+ */
+enum class StopMode : uint8_t {
+    TOLERANCE = 0,            ///< Once the reading is within tolerance
+    PREDICTIVE = 1            ///< The learned stop distance ahead of the target
+};
+
+/**
+ * @enum DriveMode
+ * @brief How the motor pins are driven
+ */
+enum class DriveMode : uint8_t {
+    SWITCHED = 0,             ///< Fully on or off (digitalWrite)
+    PWM = 1                   ///< LEDC duty with soft start, slow-down and soft stop
+};
+
 /**
  * @class SystemConfiguration
  * @brief Singleton for managing system configuration with NVS persistence
  * 
  * Usage:
  *   SystemConfig.init();  // Load from NVS or use defaults
- *   uint16_t cal = SystemConfig.getCalibrationConstant();
- *   SystemConfig.setCalibrationConstant(newValue);  // Auto-saves to NVS
+ *   int16_t cal = SystemConfig.getCalibrationOffsetMm();
+ *   SystemConfig.setCalibrationOffsetMm(newValue);  // Auto-saves to NVS
  */
 class SystemConfiguration {
 public:
@@ -45,7 +120,7 @@ public:
     
     /**
      * @brief Check if calibration has been performed
-     * @return true if calibration_constant != 0
+     * @return true if calibration offset != 0
      */
     bool isCalibrated() const;
     
@@ -54,10 +129,10 @@ public:
     // =========================================================================
     
     /**
-     * @brief Get calibration constant
-     * @return int16_t Calibration constant in cm (0 = uncalibrated)
+     * @brief Get calibration offset (height_mm = offset + distance_mm)
+     * @return int16_t Calibration offset in mm (0 = uncalibrated)
      */
-    int16_t getCalibrationConstant() const;
+    int16_t getCalibrationOffsetMm() const;
     
     /**
      * @brief Get minimum safe height
@@ -95,16 +170,132 @@ public:
      */
     uint8_t getFilterWindowSize() const;
     
+    /**
+     * @brief Get moving average window mode
+     * @return FilterWindowMode Active mode
+     */
+    FilterWindowMode getFilterWindowMode() const;
+    
+    /**
+     * @brief Get zone consensus estimator
+     * @return ConsensusMethod Active method
+     */
+    ConsensusMethod getConsensusMethod() const;
+    
+    /**
+     * @brief Get temporal filter stage
+     * @return TemporalFilterMethod Active method
+     */
+    TemporalFilterMethod getTemporalFilter() const;
+    
+    /**
+     * @brief Get per-zone temporal filter
+     * @return ZoneFilterMethod Active method
+     */
+    ZoneFilterMethod getZoneFilter() const;
+    
+    /**
+     * @brief Get outlier threshold rule
+     * @return OutlierThresholdMethod Active method
+     */
+    OutlierThresholdMethod getOutlierThreshold() const;
+    
+    /**
+     * @brief Get adaptive outlier threshold lower bound
+     * @return uint16_t Bound in mm
+     */
+    uint16_t getOutlierMinMm() const;
+    
+    /**
+     * @brief Get adaptive outlier threshold upper bound
+     * @return uint16_t Bound in mm
+     */
+    uint16_t getOutlierMaxMm() const;
+    
+    /**
+     * @brief Get Kalman process noise
+     * @return uint16_t Acceleration noise in mm/s^2
+     */
+    uint16_t getKalmanProcessNoise() const;
+    
+    /**
+     * @brief Get Kalman measurement noise
+     * @return uint16_t Measurement noise in mm
+     */
+    uint16_t getKalmanMeasurementNoise() const;
+    
+    /**
+     * @brief Get motor cut-off rule
+     * @return StopMode Active rule
+     */
+    StopMode getStopMode() const;
+    
+    /**
+     * @brief Get learned stop distance while rising
+     * @return uint16_t Distance in mm
+     */
+    uint16_t getStopDistanceUpMm() const;
+    
+    /**
+     * @brief Get learned stop distance while lowering
+     * @return uint16_t Distance in mm
+     */
+    uint16_t getStopDistanceDownMm() const;
+    
+    /**
+     * @brief Get consecutive frames before a motion fault stops the desk
+     * @return uint8_t Frames
+     */
+    uint8_t getMotionFaultFrames() const;
+    
+    /**
+     * @brief Get motor drive mode
+     * @return DriveMode Active mode
+     */
+    DriveMode getDriveMode() const;
+    
+    /**
+     * @brief Get PWM ramp time from zero to full duty
+     * @return uint16_t Time in ms
+     */
+    uint16_t getRampUpMs() const;
+    
+    /**
+     * @brief Get PWM ramp time from full duty to zero
+     * @return uint16_t Time in ms
+     */
+    uint16_t getRampDownMs() const;
+    
+    /**
+     * @brief Get distance to the target the PWM slow-down starts at
+     * @return uint16_t Distance in mm (0 = off)
+     */
+    uint16_t getSlowdownDistanceMm() const;
+    
+    /**
+     * @brief Get learned zone mask
+     * @return uint64_t Bit n set = zone n skipped by the consensus
+     */
+    uint64_t getZoneMask() const;
+    
     // =========================================================================
     // Setters (auto-save to NVS)
     // =========================================================================
     
     /**
-     * @brief Set calibration constant
-     * @param value Constant in cm
+     * @brief Set calibration offset
+     * @param value Offset in mm
      * @return true if saved successfully
      */
-    bool setCalibrationConstant(int16_t value);
+    bool setCalibrationOffsetMm(int16_t value);
+    
+    /**
+     * @brief Set the calibration offset measured by a calibration job, in RAM only
+     *
+     * Called from the acquisition task; persistLearnedValues() saves it.
+     * @param value Offset in mm
+     */
+    void learnCalibrationOffsetMm(int16_t value);
     
     /**
      * @brief Set minimum safe height
@@ -148,6 +339,152 @@ public:
      */
     bool setFilterWindowSize(uint8_t value);
     
+    /**
+     * @brief Set moving average window mode
+     * @param mode Mode to use from the next frame on
+     * @return true if saved successfully
+     */
+    bool setFilterWindowMode(FilterWindowMode mode);
+    
+    /**
+     * @brief Set zone consensus estimator
+     * @param method Method to use from the next frame on
+     * @return true if saved successfully
+     */
+    bool setConsensusMethod(ConsensusMethod method);
+    
+    /**
+     * @brief Set temporal filter stage
+     * @param method Method to use from the next frame on
+     * @return true if saved successfully
+     */
+    bool setTemporalFilter(TemporalFilterMethod method);
+    
+    /**
+     * @brief Set per-zone temporal filter
+     * @param method Method to use from the next frame on
+     * @return true if saved successfully
+     */
+    bool setZoneFilter(ZoneFilterMethod method);
+    
+    /**
+     * @brief Set outlier threshold rule
+     * @param method Method to use from the next frame on
+     * @return true if saved successfully
+     */
+    bool setOutlierThreshold(OutlierThresholdMethod method);
+    
+    /**
+     * @brief Set adaptive outlier threshold lower bound
+     * @param value Bound in mm (clamped to 5-200)
+     * @return true if saved successfully
+     */
+    bool setOutlierMinMm(uint16_t value);
+    
+    /**
+     * @brief Set adaptive outlier threshold upper bound
+     * @param value Bound in mm (clamped to 5-200)
+     * @return true if saved successfully
+     */
+    bool setOutlierMaxMm(uint16_t value);
+    
+    /**
+     * @brief Set Kalman process noise
+     * @param value Acceleration noise in mm/s^2 (clamped to 1-2000)
+     * @return true if saved successfully
+     */
+    bool setKalmanProcessNoise(uint16_t value);
+    
+    /**
+     * @brief Set Kalman measurement noise
+     * @param value Measurement noise in mm (clamped to 1-50)
+     * @return true if saved successfully
+     */
+    bool setKalmanMeasurementNoise(uint16_t value);
+    
+    /**
+     * @brief Set motor cut-off rule
+     * @param mode Rule to use
+     * @return true if saved successfully
+     */
+    bool setStopMode(StopMode mode);
+    
+    /**
+     * @brief Set stop distance while rising
+     * @param value Distance in mm (clamped to 0-60)
+     * @return true if saved successfully
+     */
+    bool setStopDistanceUpMm(uint16_t value);
+    
+    /**
+     * @brief Set stop distance while lowering
+     * @param value Distance in mm (clamped to 0-60)
+     * @return true if saved successfully
+     */
+    bool setStopDistanceDownMm(uint16_t value);
+    
+    /**
+     * @brief Update the learned stop distance while rising, in RAM only
+     *
+     * Called from the control pass; persistLearnedValues() saves it.
+     * @param value Distance in mm (clamped to 0-60)
+     */
+    void learnStopDistanceUpMm(uint16_t value);
+    
+    /**
+     * @brief Update the learned stop distance while lowering, in RAM only
+     * @param value Distance in mm (clamped to 0-60)
+     */
+    void learnStopDistanceDownMm(uint16_t value);
+    
+    /**
+     * @brief Save the calibration offset and stop distances learned since
+     *        the last call (from loop(), never from a real-time task)
+     */
+    void persistLearnedValues();
+    
+    /**
+     * @brief Set consecutive frames before a motion fault stops the desk
+     * @param value Frames (clamped to 2-30)
+     * @return true if saved successfully
+     */
+    bool setMotionFaultFrames(uint8_t value);
+    
+    /**
+     * @brief Set motor drive mode (applied at the next move)
+     * @param mode Mode to use
+     * @return true if saved successfully
+     */
+    bool setDriveMode(DriveMode mode);
+    
+    /**
+     * @brief Set PWM ramp time from zero to full duty
+     * @param value Time in ms (clamped to 0-800)
+     * @return true if saved successfully
+     */
+    bool setRampUpMs(uint16_t value);
+    
+    /**
+     * @brief Set PWM ramp time from full duty to zero
+     * @param value Time in ms (clamped to 0-800)
+     * @return true if saved successfully
+     */
+    bool setRampDownMs(uint16_t value);
+    
+    /**
+     * @brief Set distance to the target the PWM slow-down starts at
+     * @param value Distance in mm (clamped to 0-200, 0 = off)
+     * @return true if saved successfully
+     */
+    bool setSlowdownDistanceMm(uint16_t value);
+    
+    /**
+     * @brief Set learned zone mask (0 clears it)
+     * @param mask Bit n set = zone n masked (MULTI_ZONE_TOTAL_ZONES bits)
+     * @return true if saved successfully
+     */
+    bool setZoneMask(uint64_t mask);
+    
     // =========================================================================
     // Validation
     // =========================================================================
@@ -159,6 +496,13 @@ public:
      */
     bool isValidHeight(uint16_t height) const;
     
+    /**
+     * @brief Validate a millimeter height against current (cm) limits
+     * @param height_mm Height in mm
+     * @return true if min*10 <= height_mm <= max*10
+     */
+    bool isValidHeightMm(uint16_t height_mm) const;
+    
     /**
      * @brief Reset all settings to factory defaults
      * @return true if cleared successfully
@@ -170,7 +514,7 @@ public:
      * @return String JSON representation
      */
     String toJson() const;
-
+    
 private:
     // Singleton pattern
     SystemConfiguration();
@@ -182,19 +526,45 @@ private:
     bool initialized_;
     
     // Cached values (avoid frequent NVS reads)
-    int16_t calibrationConstant_;
+    int16_t calibrationOffsetMm_;
     uint16_t minHeight_;
     uint16_t maxHeight_;
     uint16_t tolerance_;
     uint16_t stabilizationDuration_;
     uint16_t movementTimeout_;
     uint8_t filterWindowSize_;
+    FilterWindowMode filterWindowMode_;
+    ConsensusMethod consensusMethod_;
+    TemporalFilterMethod temporalFilter_;
+    ZoneFilterMethod zoneFilter_;
+    OutlierThresholdMethod outlierThreshold_;
+    uint16_t outlierMinMm_;
+    uint16_t outlierMaxMm_;
+    uint16_t kalmanProcessNoise_;
+    uint16_t kalmanMeasurementNoise_;
+    StopMode stopMode_;
+    uint16_t stopDistanceUpMm_;
+    uint16_t stopDistanceDownMm_;
+    volatile bool calibrationOffsetDirty_;  ///< Learned, not yet saved
+    volatile bool stopDistanceUpDirty_;
+    volatile bool stopDistanceDownDirty_;
+    uint8_t motionFaultFrames_;
+    DriveMode driveMode_;
+    uint16_t rampUpMs_;
+    uint16_t rampDownMs_;
+    uint16_t slowdownDistanceMm_;
+    uint64_t zoneMask_;
     
     /**
      * @brief Load all values from NVS
      */
     void loadFromNVS();
     
+    /**
+     * @brief Convert a legacy cm calibration constant to the mm key
+     */
+    void migrateCalibrationConstant();
+    
     /**
      * @brief Apply factory defaults to cached values
      */
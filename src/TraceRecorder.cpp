@@ -0,0 +1,214 @@
+/**
+ * @file TraceRecorder.cpp
+ * @brief Implementation of the raw frame trace recorder
+ */
+
+#include "TraceRecorder.h"
+#include "utils/Logger.h"
+#include <SPIFFS.h>
+
+static const char* TAG = "TraceRecorder";
+
+TraceRecorder::TraceRecorder()
+    : buffer_(nullptr)
+    , sink_(TraceSink::NONE)
+    , recording_(false)
+    , headerPending_(false)
+    , liveClosed_(false)
+    , frames_(0)
+    , droppedFrames_(0)
+    , bytes_(0)
+    , limitReached_(false)
+{
+    memset(&frame_, 0, sizeof(frame_));
+}
+
+bool TraceRecorder::begin() {
+    buffer_ = xStreamBufferCreate(TRACE_BUFFER_BYTES, 1);
+    if (buffer_ == nullptr) {
+        Logger::error(TAG, "Failed to allocate %u byte trace buffer", (unsigned)TRACE_BUFFER_BYTES);
+        return false;
+    }
+    return true;
+}
+
+bool TraceRecorder::start(TraceSink sink) {
+    if (buffer_ == nullptr || sink == TraceSink::NONE || sink_ != TraceSink::NONE) {
+        return false;
+    }
+    
+    frames_ = 0;
+    droppedFrames_ = 0;
+    bytes_ = 0;
+    limitReached_ = false;
+    liveClosed_ = false;
+    headerPending_ = true;
+    sink_ = sink;
+    recording_ = true;
+    
+    Logger::info(TAG, "Trace started (%s)", sink == TraceSink::FILE ? TRACE_FILE_PATH : "live");
+    return true;
+}
+
+void TraceRecorder::stop() {
+    if (recording_) {
+        recording_ = false;
+        Logger::info(TAG, "Trace stopped: %lu frames, %lu dropped",
+                     (unsigned long)frames_, (unsigned long)droppedFrames_);
+    }
+}
+
+void TraceRecorder::record(const ZoneFrame& frame, uint32_t timestampUs,
+                           uint32_t frameCounter, uint64_t zoneMask) {
+    if (!recording_) {
+        return;
+    }
+    
+    if (headerPending_) {
+        encoder_.reset(MULTI_ZONE_TOTAL_ZONES, zoneMask);
+        size_t len = encoder_.encodeHeader(encoded_);
+        if (!enqueue(encoded_, len)) {
+            droppedFrames_ = droppedFrames_ + 1;
+            return;
+        }
+        headerPending_ = false;
+    }
+    
+    frame_.timestamp_us = timestampUs;
+    frame_.frame_counter = frameCounter;
+    memcpy(frame_.status, frame.target_status, sizeof(frame.target_status));
+    memcpy(frame_.distance_mm, frame.distance_mm, sizeof(frame.distance_mm));
+    
+    // Only an enqueued frame becomes the delta reference
+    size_t len = encoder_.encode(frame_, encoded_);
+    if (enqueue(encoded_, len)) {
+        encoder_.accept(frame_);
+        frames_ = frames_ + 1;
+    } else {
+        droppedFrames_ = droppedFrames_ + 1;
+    }
+}
+
+void TraceRecorder::update() {
+    if (sink_ == TraceSink::HTTP) {
+        if (liveClosed_) {
+            discardQueued();
+            sink_ = TraceSink::NONE;
+        }
+        return;
+    }
+    if (sink_ != TraceSink::FILE) {
+        return;
+    }
+    
+    if (!file_) {
+        file_ = SPIFFS.open(TRACE_FILE_PATH, FILE_WRITE);
+        if (!file_) {
+            Logger::error(TAG, "Cannot create %s", TRACE_FILE_PATH);
+            recording_ = false;
+            discardQueued();
+            sink_ = TraceSink::NONE;
+            return;
+        }
+    }
+    
+    uint8_t chunk[256];
+    size_t len;
+    while ((len = xStreamBufferReceive(buffer_, chunk, sizeof(chunk), 0)) > 0) {
+        if (bytes_ + len > TRACE_FILE_MAX_BYTES) {
+            // The last frame may be cut; replay reports it as truncated
+            len = TRACE_FILE_MAX_BYTES - bytes_;
+            limitReached_ = true;
+        }
+        size_t written = file_.write(chunk, len);
+        bytes_ = bytes_ + written;
+        if (limitReached_ || written != len) {
+            Logger::warn(TAG, "Trace file %s at %lu bytes",
+                         limitReached_ ? "limit reached" : "write failed", (unsigned long)bytes_);
+            stop();
+            discardQueued();
+            break;
+        }
+    }
+    
+    if (!recording_ && xStreamBufferIsEmpty(buffer_) == pdTRUE) {
+        finishFile();
+    }
+}
+
+size_t TraceRecorder::readLive(uint8_t* out, size_t maxLen, bool& finished) {
+    finished = false;
+    if (sink_ != TraceSink::HTTP || liveClosed_) {
+        finished = true;
+        return 0;
+    }
+    
+    size_t len = xStreamBufferReceive(buffer_, out, maxLen, 0);
+    if (len > 0) {
+        bytes_ = bytes_ + len;
+        return len;
+    }
+    if (!recording_) {
+        // Stopped and everything sent
+        sink_ = TraceSink::NONE;
+        finished = true;
+    }
+    return 0;
+}
+
+void TraceRecorder::closeLive() {
+    if (sink_ == TraceSink::HTTP) {
+        stop();
+        liveClosed_ = true;
+    }
+}
+
+bool TraceRecorder::isRecording() const {
+    return recording_;
+}
+
+TraceSink TraceRecorder::getSink() const {
+    return sink_;
+}
+
+String TraceRecorder::toJson() const {
+    const char* sinkStr;
+    switch (sink_) {
+        case TraceSink::FILE: sinkStr = "file"; break;
+        case TraceSink::HTTP: sinkStr = "live"; break;
+        default:              sinkStr = "none"; break;
+    }
+    
+    String json = "{";
+    json += "\"recording\":" + String(recording_ ? "true" : "false") + ",";
+    json += "\"sink\":\"" + String(sinkStr) + "\",";
+    json += "\"frames\":" + String(frames_) + ",";
+    json += "\"droppedFrames\":" + String(droppedFrames_) + ",";
+    json += "\"bytes\":" + String(bytes_) + ",";
+    json += "\"maxFileBytes\":" + String(TRACE_FILE_MAX_BYTES) + ",";
+    json += "\"limitReached\":" + String(limitReached_ ? "true" : "false") + ",";
+    json += "\"fileExists\":" + String(SPIFFS.exists(TRACE_FILE_PATH) ? "true" : "false");
+    json += "}";
+    return json;
+}
+
+bool TraceRecorder::enqueue(const uint8_t* data, size_t len) {
+    // Single writer: free space can only grow until the send below
+    if (xStreamBufferSpacesAvailable(buffer_) < len) {
+        return false;
+    }
+    return xStreamBufferSend(buffer_, data, len, 0) == len;
+}
+
+void TraceRecorder::discardQueued() {
+    uint8_t chunk[64];
+    while (xStreamBufferReceive(buffer_, chunk, sizeof(chunk), 0) > 0) {
+    }
+}
+
+void TraceRecorder::finishFile() {
+    file_.close();
+    sink_ = TraceSink::NONE;
+    Logger::info(TAG, "Trace saved: %lu bytes, %lu frames (%lu dropped)",
+                 (unsigned long)bytes_, (unsigned long)frames_, (unsigned long)droppedFrames_);
+}
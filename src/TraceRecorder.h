@@ -0,0 +1,151 @@
+/**
+ * @file TraceRecorder.h
+ * @brief Records raw sensor frames to SPIFFS or a live HTTP stream
+ *
+ * Frames are delta-encoded (utils/FrameTrace.h) on the acquisition path
+ * and queued in a FreeRTOS stream buffer; the main loop drains them to
+ * TRACE_FILE_PATH, or the web server streams them to a client. Recording
+ * never blocks the sensor: a frame that doesn't fit the buffer is dropped
+ * and shows up as a frame counter gap in the trace.
+ *
+ * Traces are replayed offline with utils/TraceReplay.h.
+ */
+
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/stream_buffer.h>
+#include "Config.h"
+#include "DistanceSensor.h"
+#include "utils/FrameTrace.h"
+
+/**
+ * @enum TraceSink
+ * @brief Where recorded frames go
+ */
+enum class TraceSink : uint8_t {
+    NONE,       ///< Not recording
+    FILE,       ///< TRACE_FILE_PATH on SPIFFS
+    HTTP        ///< GET /trace/live chunked response
+};
+
+/**
+ * @class TraceRecorder
+ * @brief Single-producer frame trace recorder
+ *
+ * Usage:
+ *   TraceRecorder recorder;
+ *   recorder.begin();
+ *   heightController.setTraceRecorder(&recorder);
+ *   recorder.start(TraceSink::FILE);
+ *   // In loop:
+ *   recorder.update();
+ */
+class TraceRecorder {
+public:
+    TraceRecorder();
+    
+    /**
+     * @brief Allocate the stream buffer
+     * @return true if successful
+     */
+    bool begin();
+    
+    /**
+     * @brief Start a new trace
+     *
+     * A FILE trace replaces the previous TRACE_FILE_PATH.
+     *
+     * @param sink FILE or HTTP
+     * @return false if a trace is still active or begin() failed
+     */
+    bool start(TraceSink sink);
+    
+    /**
+     * @brief Stop recording; queued frames are still written out
+     */
+    void stop();
+    
+    /**
+     * @brief Queue one frame (acquisition path, no-op when not recording)
+     * @param frame Frame just read from the sensor
+     * @param timestampUs Data-ready time
+     * @param frameCounter Reading sequence number of the frame
+     * @param zoneMask Zone mask in effect (stored in the trace header)
+     */
+    void record(const ZoneFrame& frame, uint32_t timestampUs,
+                uint32_t frameCounter, uint64_t zoneMask);
+    
+    /**
+     * @brief Write queued frames to SPIFFS and finish stopped traces
+     *
+     * Call from the main loop.
+     */
+    void update();
+    
+    /**
+     * @brief Take queued bytes for the live HTTP stream
+     * @param out Destination
+     * @param maxLen Capacity of out
+     * @param finished Set when the trace is stopped and fully sent
+     * @return size_t Bytes copied (0 = nothing queued yet, or finished)
+     */
+    size_t readLive(uint8_t* out, size_t maxLen, bool& finished);
+    
+    /**
+     * @brief The live client went away: stop and discard what is queued
+     */
+    void closeLive();
+    
+    /**
+     * @brief Check if frames are being recorded
+     */
+    bool isRecording() const;
+    
+    /**
+     * @brief Current (or draining) sink, NONE when idle
+     */
+    TraceSink getSink() const;
+    
+    /**
+     * @brief Recorder state as JSON (GET /trace/status)
+     */
+    String toJson() const;
+    
+private:
+    StreamBufferHandle_t buffer_;
+    FrameTraceEncoder encoder_;
+    TraceFrame frame_;                          ///< Scratch, acquisition path only
+    uint8_t encoded_[FRAME_TRACE_MAX_FRAME_BYTES];
+    
+    volatile TraceSink sink_;
+    volatile bool recording_;
+    volatile bool headerPending_;               ///< Next record() starts with the header
+    volatile bool liveClosed_;
+    fs::File file_;
+    
+    volatile uint32_t frames_;                  ///< Frames queued this trace
+    volatile uint32_t droppedFrames_;           ///< Frames lost to a full buffer
+    volatile uint32_t bytes_;                   ///< Bytes delivered to the sink
+    bool limitReached_;                         ///< FILE trace stopped at TRACE_FILE_MAX_BYTES
+    
+    /**
+     * @brief Queue a whole encoded block, or nothing
+     */
+    bool enqueue(const uint8_t* data, size_t len);
+    
+    /**
+     * @brief Discard queued bytes (no reader left)
+     */
+    void discardQueued();
+    
+    /**
+     * @brief Close the file and go idle
+     */
+    void finishFile();
+};
+
+#endif // TRACE_RECORDER_H
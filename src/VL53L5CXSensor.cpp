@@ -0,0 +1,154 @@
+/**
+ * @file VL53L5CXSensor.cpp
+ * @brief Implementation of the VL53L5CX distance sensor
+ */
+
+#include "VL53L5CXSensor.h"
+#include "utils/Logger.h"
+#include "utils/SensorReadout.h"
+
+static const char* TAG = "VL53L5CX";
+
+// Bytes per results read for this build's readout profile
+static constexpr uint16_t READOUT_FRAME_BYTES =
+    SensorReadout::frameBytes(SensorReadout::ENABLED_FIELDS, MULTI_ZONE_TOTAL_ZONES,
+                              VL53L5CX_NB_TARGET_PER_ZONE);
+
+static_assert(SensorReadout::ENABLED_FIELDS & SensorReadout::DISTANCE_MM,
+              "Consensus needs distance_mm");
+static_assert(SensorReadout::ENABLED_FIELDS & SensorReadout::TARGET_STATUS,
+              "Consensus needs target_status");
+
+static_assert(MULTI_ZONE_TOTAL_ZONES == VL53L5CX_RESOLUTION_4X4 ||
+              MULTI_ZONE_TOTAL_ZONES == VL53L5CX_RESOLUTION_8X8,
+              "MULTI_ZONE_TOTAL_ZONES must match a VL53L5CX resolution");
+
+VL53L5CXSensor::VL53L5CXSensor()
+    : wireStarted_(false)
+{
+}
+
+bool VL53L5CXSensor::begin(uint32_t& uploadUs, uint32_t& uploadHz) {
+    if (!wireStarted_) {
+        Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL);
+        wireStarted_ = true;
+    }
+    
+    // begin() resets the sensor and uploads the ~84 KB firmware, so try
+    // Fast-mode Plus first and fall back to the ranging clock
+    uint32_t uploadStartUs = micros();
+    uploadHz = I2C_FIRMWARE_UPLOAD_FREQUENCY;
+    Wire.setClock(uploadHz);
+    bool detected = sensor_.begin();
+    if (!detected && uploadHz != I2C_FREQUENCY) {
+        Logger::warn(TAG, "Sensor bring-up failed at %lu kHz, retrying at %lu kHz",
+                     (unsigned long)(uploadHz / 1000),
+                     (unsigned long)(I2C_FREQUENCY / 1000));
+        uploadHz = I2C_FREQUENCY;
+        Wire.setClock(uploadHz);
+        detected = sensor_.begin();
+    }
+    uploadUs = micros() - uploadStartUs;
+    Wire.setClock(I2C_FREQUENCY);
+    
+    if (!detected) {
+        return false;
+    }
+    Logger::info(TAG, "Sensor firmware loaded in %lu ms at %lu kHz",
+                 (unsigned long)(uploadUs / 1000), (unsigned long)(uploadHz / 1000));
+    
+    // Zone grid is fixed at compile time (4x4 default, 8x8 with SENSOR_ZONES_8X8)
+    sensor_.setResolution(MULTI_ZONE_TOTAL_ZONES);
+    Logger::info(TAG, "Resolution: %dx%d (%d zones)",
+                 MULTI_ZONE_GRID_SIZE, MULTI_ZONE_GRID_SIZE, MULTI_ZONE_TOTAL_ZONES);
+    return true;
+}
+
+bool VL53L5CXSensor::startRanging(uint8_t frequencyHz) {
+    // Frequency can only be changed while ranging is stopped
+    sensor_.stopRanging();
+    bool ok = sensor_.setRangingFrequency(frequencyHz);
+    return sensor_.startRanging() && ok;
+}
+
+bool VL53L5CXSensor::isDataReady() {
+    return sensor_.isDataReady();
+}
+
+bool VL53L5CXSensor::readFrame(ZoneFrame& frame) {
+    // Only the outputs enabled by the build's readout profile are
+    // transferred (see utils/SensorReadout.h)
+    if (!sensor_.getRangingData(&results_)) {
+        return false;
+    }
+    
+    for (uint8_t zone = 0; zone < MULTI_ZONE_TOTAL_ZONES; zone++) {
+        const uint16_t target = zone * VL53L5CX_NB_TARGET_PER_ZONE;
+        frame.target_status[zone] = results_.target_status[target];
+        frame.distance_mm[zone] = results_.distance_mm[target];
+#if SENSOR_READOUT_HAS_CONFIDENCE
+        frame.range_sigma_mm[zone] = results_.range_sigma_mm[target];
+        frame.signal_per_spad[zone] = results_.signal_per_spad[target];
+        frame.ambient_per_spad[zone] = results_.ambient_per_spad[zone];
+#endif
+    }
+    return true;
+}
+
+bool VL53L5CXSensor::clearBus() {
+    // Nothing holds the bus and no transfer is in flight (sensor mutex held)
+    if (digitalRead(PIN_I2C_SDA) == HIGH && digitalRead(PIN_I2C_SCL) == HIGH) {
+        return false;
+    }
+    
+    // Take the pins from the I2C peripheral and drive them by hand
+    Wire.end();
+    pinMode(PIN_I2C_SDA, INPUT_PULLUP);
+    pinMode(PIN_I2C_SCL, OUTPUT_OPEN_DRAIN);
+    digitalWrite(PIN_I2C_SCL, HIGH);
+    delayMicroseconds(5);
+    
+    // A slave interrupted mid-byte holds SDA low until it has shifted out
+    // the rest of the byte and the ACK bit
+    uint8_t pulses = 0;
+    while (digitalRead(PIN_I2C_SDA) == LOW && pulses < I2C_RECOVERY_CLOCK_PULSES) {
+        digitalWrite(PIN_I2C_SCL, LOW);
+        delayMicroseconds(5);
+        digitalWrite(PIN_I2C_SCL, HIGH);
+        delayMicroseconds(5);
+        pulses++;
+    }
+    bool released = digitalRead(PIN_I2C_SDA) == HIGH;
+    
+    // STOP condition (SDA rising while SCL is high) resets the slaves' bus logic
+    pinMode(PIN_I2C_SDA, OUTPUT_OPEN_DRAIN);
+    digitalWrite(PIN_I2C_SCL, LOW);
+    delayMicroseconds(5);
+    digitalWrite(PIN_I2C_SDA, LOW);
+    delayMicroseconds(5);
+    digitalWrite(PIN_I2C_SCL, HIGH);
+    delayMicroseconds(5);
+    digitalWrite(PIN_I2C_SDA, HIGH);
+    delayMicroseconds(5);
+    
+    Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL);
+    Wire.setClock(I2C_FREQUENCY);
+    
+    Logger::warn(TAG, "I2C bus clear: %d SCL pulses, SDA %s", pulses,
+                 released ? "released" : "still low");
+    return true;
+}
+
+void VL53L5CXSensor::resetBus() {
+    Wire.end();
+    Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL);
+    Wire.setClock(I2C_FREQUENCY);
+}
+
+uint16_t VL53L5CXSensor::getFrameBytes() const {
+    return READOUT_FRAME_BYTES;
+}
+
+uint32_t VL53L5CXSensor::getBusHz() const {
+    return I2C_FREQUENCY;
+}
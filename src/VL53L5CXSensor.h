@@ -0,0 +1,71 @@
+/**
+ * @file VL53L5CXSensor.h
+ * @brief DistanceSensor implementation for the VL53L5CX (SparkFun library)
+ *
+ * Owns the I2C bus: bring-up with the firmware upload clock fallback,
+ * ranging restarts, the lean results readout (see utils/SensorReadout.h)
+ * and the bus recovery steps used by the sensor supervisor.
+ */
+
+#ifndef VL53L5CX_SENSOR_H
+#define VL53L5CX_SENSOR_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <SparkFun_VL53L5CX_Library.h>
+#include "Config.h"
+#include "DistanceSensor.h"
+
+/**
+ * @class VL53L5CXSensor
+ * @brief VL53L5CX on Wire (PIN_I2C_SDA / PIN_I2C_SCL)
+ *
+ * Usage:
+ *   VL53L5CXSensor tofSensor;
+ *   HeightController heightController(tofSensor);
+ */
+class VL53L5CXSensor : public DistanceSensor {
+public:
+    VL53L5CXSensor();
+    
+    /**
+     * @brief Start Wire, upload the firmware and set the zone grid
+     *
+     * begin() resets the sensor and uploads ~84 KB of firmware, so it runs
+     * at I2C_FIRMWARE_UPLOAD_FREQUENCY with a fallback to I2C_FREQUENCY.
+     */
+    bool begin(uint32_t& uploadUs, uint32_t& uploadHz) override;
+    
+    bool startRanging(uint8_t frequencyHz) override;
+    bool isDataReady() override;
+    
+    /**
+     * @brief Read the results and copy the first target of each zone
+     */
+    bool readFrame(ZoneFrame& frame) override;
+    
+    /**
+     * @brief Clock out a slave holding SDA low, then send a STOP
+     *
+     * If SDA or SCL is low, the pins are taken from the I2C driver and SCL
+     * is clocked (up to I2C_RECOVERY_CLOCK_PULSES) until SDA is released.
+     */
+    bool clearBus() override;
+    
+    /**
+     * @brief Reset the ESP32 I2C controller (stuck FSM, timeout state)
+     */
+    void resetBus() override;
+    
+    uint16_t getFrameBytes() const override;
+    uint32_t getBusHz() const override;
+    
+private:
+    SparkFun_VL53L5CX sensor_;
+    bool wireStarted_;
+    
+    // Results buffer reused every frame (not on the task stack)
+    VL53L5CX_ResultsData results_;
+};
+
+#endif // VL53L5CX_SENSOR_H
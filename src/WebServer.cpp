@@ -6,6 +6,7 @@
 #include "WebServer.h"
 #include "SystemConfiguration.h"
 #include "utils/Logger.h"
+#include "utils/HeightUnits.h"
 #include <SPIFFS.h>
 
 static const char* TAG = "WebServer";
@@ -17,6 +18,10 @@ DeskWebServer::DeskWebServer(HeightController& heightController,
     , heightController_(heightController)
     , movementController_(movementController)
     , presetManager_(nullptr)
+    , bootTimeline_(nullptr)
+    , traceRecorder_(nullptr)
+    , controlTask_(nullptr)
+    , lastCalibrationSequence_(0)
 {
 }
 
@@ -34,6 +39,18 @@ void DeskWebServer::setPresetManager(PresetManager* presetManager) {
     presetManager_ = presetManager;
 }
 
+void DeskWebServer::setBootTimeline(const BootTimeline* bootTimeline) {
+    bootTimeline_ = bootTimeline;
+}
+
+void DeskWebServer::setTraceRecorder(TraceRecorder* traceRecorder) {
+    traceRecorder_ = traceRecorder;
+}
+
+void DeskWebServer::setControlTask(ControlTask* controlTask) {
+    controlTask_ = controlTask;
+}
+
 void DeskWebServer::setupSSE() {
     // Configure SSE event source
     events_.onConnect([](AsyncEventSourceClient* client) {
@@ -61,6 +78,16 @@ void DeskWebServer::setupRoutes() {
         handleGetStatus(request);
     });
     
+    // GET /diagnostics - Sensor pipeline diagnostics
+    server_.on("/diagnostics", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleGetDiagnostics(request);
+    });
+    
+    // GET /boot - Boot timeline and time to first valid height
+    server_.on("/boot", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleGetBoot(request);
+    });
+    
     // POST /target - Set target height
     server_.on("/target", HTTP_POST, 
         [](AsyncWebServerRequest* request) {},
@@ -112,7 +139,12 @@ void DeskWebServer::setupRoutes() {
         }
     );
     
-    // POST /calibrate - Run calibration
+    // GET /calibrate - Current/last calibration job
+    server_.on("/calibrate", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleGetCalibrate(request);
+    });
+    
+    // POST /calibrate - Start a calibration job
     server_.on("/calibrate", HTTP_POST,
         [](AsyncWebServerRequest* request) {},
         NULL,
@@ -121,6 +153,57 @@ void DeskWebServer::setupRoutes() {
         }
     );
     
+    // POST /zonemask - Learn or clear the static obstruction zone mask
+    server_.on("/zonemask", HTTP_POST,
+        [](AsyncWebServerRequest* request) {},
+        NULL,
+        [this](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+            handlePostZoneMask(request, data, len);
+        }
+    );
+    
+    // GET /trace/status - Frame trace recorder state (register before /trace)
+    server_.on("/trace/status", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        if (traceRecorder_ == nullptr) {
+            sendJsonError(request, 503, "Trace recorder not available");
+            return;
+        }
+        request->send(200, "application/json", traceRecorder_->toJson());
+    });
+    
+    // GET /trace/live - Record a trace straight into the response
+    server_.on("/trace/live", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleGetTraceLive(request);
+    });
+    
+    // GET /trace - Download the last recorded trace file
+    server_.on("/trace", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleGetTrace(request);
+    });
+    
+    // POST /trace - Start or stop recording a trace file
+    server_.on("/trace", HTTP_POST,
+        [](AsyncWebServerRequest* request) {},
+        NULL,
+        [this](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+            handlePostTrace(request, data, len);
+        }
+    );
+    
+    // GET /control - Control task schedule and period jitter
+    server_.on("/control", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleGetControl(request);
+    });
+    
+    // POST /control - Reset the jitter statistics
+    server_.on("/control", HTTP_POST,
+        [](AsyncWebServerRequest* request) {},
+        NULL,
+        [this](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+            handlePostControl(request, data, len);
+        }
+    );
+    
     // 404 handler
     server_.onNotFound([this](AsyncWebServerRequest* request) {
         sendJsonError(request, 404, "Not found");
@@ -132,17 +215,20 @@ void DeskWebServer::setupRoutes() {
 void DeskWebServer::sendHeightUpdate() {
     if (events_.count() == 0) return;
     
-    const HeightReading& reading = heightController_.getReading();
-    const TargetHeight& target = movementController_.getTarget();
+    const HeightReading reading = heightController_.getReading();
+    TargetHeight target = movementController_.getTarget();
     
     String json = "{";
-    json += "\"height\":" + String(reading.calculated_height_cm) + ",";
+    json += "\"height\":" + String(HeightUnits::mmToCm(reading.calculated_height_mm), 1) + ",";
+    json += "\"heightMm\":" + String(reading.calculated_height_mm) + ",";
     json += "\"rawDistance\":" + String(reading.raw_distance_mm) + ",";
     json += "\"filteredDistance\":" + String(reading.filtered_distance_mm) + ",";
     json += "\"valid\":" + String(reading.validity == ReadingValidity::VALID ? "true" : "false") + ",";
     json += "\"timestamp\":" + String(reading.timestamp_ms) + ",";
+    json += "\"latencyUs\":" + String(reading.latency_us) + ",";
+    json += "\"velocity\":" + String(reading.velocity_mm_s) + ",";
     // Include target height
-    json += "\"targetHeight\":" + String(target.active ? target.target_height_cm : 0) + ",";
+    json += "\"targetHeight\":" + String(HeightUnits::mmToCm(target.active ? target.target_height_mm : 0), 1) + ",";
     json += "\"targetActive\":" + String(target.active ? "true" : "false") + ",";
     // Include system diagnostics for live updates
     json += "\"uptime\":" + String(millis()) + ",";
@@ -198,6 +284,17 @@ void DeskWebServer::sendPresetUpdated(uint8_t slot) {
     events_.send(json.c_str(), "preset_updated", millis());
 }
 
+void DeskWebServer::sendCalibrationProgress() {
+    const CalibrationStatus status = heightController_.getCalibrationStatus();
+    if (status.sequence == lastCalibrationSequence_) return;
+    lastCalibrationSequence_ = status.sequence;
+    
+    if (events_.count() == 0) return;
+    
+    String json = calibrationToJson(status);
+    events_.send(json.c_str(), "calibration_progress", millis());
+}
+
 size_t DeskWebServer::getClientCount() const {
     return events_.count();
 }
@@ -217,18 +314,48 @@ void DeskWebServer::handleGetStatus(AsyncWebServerRequest* request) {
     request->send(200, "application/json", json);
 }
 
+void DeskWebServer::handleGetDiagnostics(AsyncWebServerRequest* request) {
+    request->send(200, "application/json", heightController_.getZoneDiagnostics());
+}
+
+void DeskWebServer::handleGetBoot(AsyncWebServerRequest* request) {
+    // All timestamps are micros() since the application started
+    String json = "{\"phases\":[";
+    if (bootTimeline_ != nullptr) {
+        for (uint8_t i = 0; i < bootTimeline_->getCount(); i++) {
+            if (i > 0) json += ",";
+            json += "{\"name\":\"" + String(bootTimeline_->getName(i)) + "\",";
+            json += "\"atUs\":" + String(bootTimeline_->getTimestampUs(i)) + ",";
+            json += "\"durationUs\":" + String(bootTimeline_->getDurationUs(i)) + "}";
+        }
+    }
+    json += "],";
+    json += "\"setupUs\":" + String(bootTimeline_ != nullptr ? bootTimeline_->getTotalUs() : 0) + ",";
+    json += "\"sensorFirmwareUploadUs\":" + String(heightController_.getFirmwareUploadUs()) + ",";
+    json += "\"sensorFirmwareUploadHz\":" + String(heightController_.getFirmwareUploadHz()) + ",";
+    // Warm reset: first valid height is the reading restored from RTC memory
+    json += "\"warmStart\":" + String(heightController_.isWarmStart() ? "true" : "false") + ",";
+    // 0 until the first VALID reading has been published
+    json += "\"firstValidHeightUs\":" + String(heightController_.getFirstValidReadingUs());
+    json += "}";
+    
+    request->send(200, "application/json", json);
+}
+
 void DeskWebServer::handlePostTarget(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
     String body = String((char*)data).substring(0, len);
     Logger::debug(TAG, "POST /target: %s", body.c_str());
     
-    int targetHeight;
-    if (!parseJsonField(body, "height", targetHeight)) {
+    // API takes cm (decimals allowed); everything downstream is mm
+    float targetHeightCm;
+    if (!parseJsonField(body, "height", targetHeightCm)) {
         sendJsonError(request, 400, "Missing 'height' field");
         return;
     }
+    uint16_t targetHeightMm = HeightUnits::cmToMm(targetHeightCm);
     
     // Validate height range
-    if (!SystemConfig.isValidHeight(targetHeight)) {
+    if (!SystemConfig.isValidHeightMm(targetHeightMm)) {
         String msg = "Height must be between " + String(SystemConfig.getMinHeight()) + 
                      " and " + String(SystemConfig.getMaxHeight()) + " cm";
         sendJsonError(request, 400, msg);
@@ -242,12 +369,12 @@ void DeskWebServer::handlePostTarget(AsyncWebServerRequest* request, uint8_t* da
     }
     
     // Set target
-    if (!movementController_.setTargetHeight(targetHeight)) {
+    if (!movementController_.setTargetHeight(targetHeightMm)) {
         sendJsonError(request, 500, "Failed to set target height");
         return;
     }
     
-    String json = "{\"success\":true,\"target\":" + String(targetHeight) + "}";
+    String json = "{\"success\":true,\"target\":" + String(HeightUnits::mmToCm(targetHeightMm), 1) + "}";
     request->send(200, "application/json", json);
 }
 
@@ -286,6 +413,93 @@ void DeskWebServer::handlePostConfig(AsyncWebServerRequest* request, uint8_t* da
     if (parseJsonField(body, "movementTimeout", value)) {
         if (SystemConfig.setMovementTimeout(value)) updated = true;
     }
+    if (parseJsonField(body, "calibrationOffsetMm", value)) {
+        // 0 means uncalibrated; use /calibrate or factory reset for that
+        if (value != 0 && value >= -32767 && value <= 32767 &&
+            SystemConfig.setCalibrationOffsetMm(value)) updated = true;
+    }
+    String method;
+    if (parseJsonField(body, "consensusMethod", method)) {
+        if (method == "weighted") {
+            if (SystemConfig.setConsensusMethod(ConsensusMethod::CONFIDENCE_WEIGHTED)) updated = true;
+        } else if (method == "plane") {
+            if (SystemConfig.setConsensusMethod(ConsensusMethod::PLANE_FIT)) updated = true;
+        } else if (method == "median") {
+            if (SystemConfig.setConsensusMethod(ConsensusMethod::MEDIAN_MEAN)) updated = true;
+        }
+    }
+    if (parseJsonField(body, "temporalFilter", method)) {
+        if (method == "kalman") {
+            if (SystemConfig.setTemporalFilter(TemporalFilterMethod::KALMAN)) updated = true;
+        } else if (method == "average") {
+            if (SystemConfig.setTemporalFilter(TemporalFilterMethod::MOVING_AVERAGE)) updated = true;
+        }
+    }
+    if (parseJsonField(body, "filterWindowMode", method)) {
+        if (method == "adaptive") {
+            if (SystemConfig.setFilterWindowMode(FilterWindowMode::ADAPTIVE)) updated = true;
+        } else if (method == "fixed") {
+            if (SystemConfig.setFilterWindowMode(FilterWindowMode::FIXED)) updated = true;
+        }
+    }
+    if (parseJsonField(body, "zoneFilter", method)) {
+        if (method == "exponential") {
+            if (SystemConfig.setZoneFilter(ZoneFilterMethod::EXPONENTIAL)) updated = true;
+        } else if (method == "none") {
+            if (SystemConfig.setZoneFilter(ZoneFilterMethod::NONE)) updated = true;
+        }
+    }
+    if (parseJsonField(body, "outlierThreshold", method)) {
+        if (method == "adaptive") {
+            if (SystemConfig.setOutlierThreshold(OutlierThresholdMethod::ADAPTIVE)) updated = true;
+        } else if (method == "fixed") {
+            if (SystemConfig.setOutlierThreshold(OutlierThresholdMethod::FIXED)) updated = true;
+        }
+    }
+    if (parseJsonField(body, "outlierMinMm", value)) {
+        if (value > 0 && SystemConfig.setOutlierMinMm(value)) updated = true;
+    }
+    if (parseJsonField(body, "outlierMaxMm", value)) {
+        if (value > 0 && SystemConfig.setOutlierMaxMm(value)) updated = true;
+    }
+    if (parseJsonField(body, "kalmanProcessNoise", value)) {
+        if (value > 0 && SystemConfig.setKalmanProcessNoise(value)) updated = true;
+    }
+    if (parseJsonField(body, "kalmanMeasurementNoise", value)) {
+        if (value > 0 && SystemConfig.setKalmanMeasurementNoise(value)) updated = true;
+    }
+    if (parseJsonField(body, "stopMode", method)) {
+        if (method == "predictive") {
+            if (SystemConfig.setStopMode(StopMode::PREDICTIVE)) updated = true;
+        } else if (method == "tolerance") {
+            if (SystemConfig.setStopMode(StopMode::TOLERANCE)) updated = true;
+        }
+    }
+    if (parseJsonField(body, "stopDistanceUpMm", value)) {
+        if (value >= 0 && SystemConfig.setStopDistanceUpMm(value)) updated = true;
+    }
+    if (parseJsonField(body, "stopDistanceDownMm", value)) {
+        if (value >= 0 && SystemConfig.setStopDistanceDownMm(value)) updated = true;
+    }
+    if (parseJsonField(body, "motionFaultFrames", value)) {
+        if (value > 0 && value <= 255 && SystemConfig.setMotionFaultFrames(value)) updated = true;
+    }
+    if (parseJsonField(body, "driveMode", method)) {
+        if (method == "pwm") {
+            if (SystemConfig.setDriveMode(DriveMode::PWM)) updated = true;
+        } else if (method == "switched") {
+            if (SystemConfig.setDriveMode(DriveMode::SWITCHED)) updated = true;
+        }
+    }
+    if (parseJsonField(body, "rampUpMs", value)) {
+        if (value >= 0 && SystemConfig.setRampUpMs(value)) updated = true;
+    }
+    if (parseJsonField(body, "rampDownMs", value)) {
+        if (value >= 0 && SystemConfig.setRampDownMs(value)) updated = true;
+    }
+    if (parseJsonField(body, "slowdownDistanceMm", value)) {
+        if (value >= 0 && SystemConfig.setSlowdownDistanceMm(value)) updated = true;
+    }
     
     if (updated) {
         request->send(200, "application/json", "{\"success\":true}");
@@ -303,7 +517,7 @@ void DeskWebServer::handleGetPresets(AsyncWebServerRequest* request) {
             if (i > 0) json += ",";
             json += "{\"slot\":" + String(presets[i].slot);
             json += ",\"name\":\"" + String(presets[i].name) + "\"";
-            json += ",\"height_cm\":" + String(presets[i].height_cm, 1);
+            json += ",\"height_cm\":" + String(HeightUnits::mmToCm(presets[i].height_mm), 1);
             json += ",\"enabled\":" + String(presets[i].isEnabled() ? "true" : "false");
             json += "}";
         }
@@ -352,16 +566,16 @@ void DeskWebServer::handlePostPreset(AsyncWebServerRequest* request, uint8_t* da
     }
     
     // Set target to preset height
-    if (!movementController_.setTargetHeight(preset->height_cm)) {
+    if (!movementController_.setTargetFromPreset(preset->height_mm, slot)) {
         sendJsonError(request, 500, "Failed to activate preset");
         return;
     }
     
-    Logger::info(TAG, "Activated preset %d: '%s' -> %.1f cm", 
-                 slot, preset->name, preset->height_cm);
+    Logger::info(TAG, "Activated preset %d: '%s' -> %d mm", 
+                 slot, preset->name, preset->height_mm);
     
     String json = "{\"success\":true,\"slot\":" + String(slot) + 
-                  ",\"target\":" + String(preset->height_cm, 1) + "}";
+                  ",\"target\":" + String(HeightUnits::mmToCm(preset->height_mm), 1) + "}";
     request->send(200, "application/json", json);
 }
 
@@ -383,13 +597,13 @@ void DeskWebServer::handlePostPresetSave(AsyncWebServerRequest* request, uint8_t
     String name;
     parseJsonField(body, "name", name);  // Optional
     
-    int height;
-    if (!parseJsonField(body, "height", height)) {
+    float heightCm;
+    if (!parseJsonField(body, "height", heightCm)) {
         sendJsonError(request, 400, "Missing 'height' field");
         return;
     }
     
-    if (!presetManager_->savePreset(slot, name.c_str(), (float)height)) {
+    if (!presetManager_->savePreset(slot, name.c_str(), HeightUnits::cmToMm(heightCm))) {
         sendJsonError(request, 400, "Failed to save preset (invalid slot or height)");
         return;
     }
@@ -405,25 +619,208 @@ void DeskWebServer::handlePostCalibrate(AsyncWebServerRequest* request, uint8_t*
     String body = String((char*)data).substring(0, len);
     Logger::debug(TAG, "POST /calibrate: %s", body.c_str());
     
-    int knownHeight;
-    if (!parseJsonField(body, "height", knownHeight)) {
+    float knownHeightCm;
+    if (!parseJsonField(body, "height", knownHeightCm)) {
         sendJsonError(request, 400, "Missing 'height' field");
         return;
     }
     
-    if (knownHeight < 30 || knownHeight > 200) {
+    if (knownHeightCm < 30.0f || knownHeightCm > 200.0f) {
         sendJsonError(request, 400, "Known height must be between 30 and 200 cm");
         return;
     }
     
-    if (!heightController_.calibrate(knownHeight)) {
-        sendJsonError(request, 500, "Calibration failed - check sensor");
+    // The sample mean is only meaningful for a parked desk
+    if (movementController_.isMoving()) {
+        sendJsonError(request, 409, "Desk is moving");
         return;
     }
     
-    String json = "{\"success\":true,\"calibrationConstant\":" + 
-                  String(SystemConfig.getCalibrationConstant()) + "}";
-    request->send(200, "application/json", json);
+    if (!heightController_.isSensorReady()) {
+        sendJsonError(request, 503, "Sensor not ready - check wiring");
+        return;
+    }
+    
+    // Sampling happens on the acquisition path; answer right away
+    uint32_t jobId = heightController_.startCalibration(HeightUnits::cmToMm(knownHeightCm));
+    if (jobId == 0) {
+        sendJsonError(request, 409, "Calibration already running");
+        return;
+    }
+    
+    String json = "{\"success\":true,\"jobId\":" + String(jobId) + "}";
+    request->send(202, "application/json", json);
+}
+
+void DeskWebServer::handleGetCalibrate(AsyncWebServerRequest* request) {
+    request->send(200, "application/json",
+                  calibrationToJson(heightController_.getCalibrationStatus()));
+}
+
+void DeskWebServer::handlePostZoneMask(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
+    String body = String((char*)data).substring(0, len);
+    Logger::debug(TAG, "POST /zonemask: %s", body.c_str());
+    
+    String action;
+    if (!parseJsonField(body, "action", action)) {
+        sendJsonError(request, 400, "Missing 'action' field");
+        return;
+    }
+    
+    if (action == "learn") {
+        // Learning needs a clear floor; don't learn while the desk is driven
+        if (movementController_.isMoving()) {
+            sendJsonError(request, 409, "Desk is moving");
+            return;
+        }
+        int frames = ZONE_MASK_LEARN_FRAMES;
+        parseJsonField(body, "frames", frames);  // Optional
+        if (frames < 1 || frames > ZONE_MASK_MAX_LEARN_FRAMES) {
+            sendJsonError(request, 400, "frames must be between 1 and " +
+                          String(ZONE_MASK_MAX_LEARN_FRAMES));
+            return;
+        }
+        heightController_.startZoneMaskLearning(frames);
+        request->send(200, "application/json",
+                      "{\"success\":true,\"learning\":true,\"frames\":" + String(frames) + "}");
+    } else if (action == "clear") {
+        heightController_.clearZoneMask();
+        request->send(200, "application/json", "{\"success\":true,\"learning\":false}");
+    } else {
+        sendJsonError(request, 400, "action must be 'learn' or 'clear'");
+    }
+}
+
+void DeskWebServer::handleGetTrace(AsyncWebServerRequest* request) {
+    if (traceRecorder_ == nullptr) {
+        sendJsonError(request, 503, "Trace recorder not available");
+        return;
+    }
+    if (traceRecorder_->getSink() == TraceSink::FILE) {
+        sendJsonError(request, 409, "Trace is still being recorded");
+        return;
+    }
+    if (!SPIFFS.exists(TRACE_FILE_PATH)) {
+        sendJsonError(request, 404, "No trace recorded");
+        return;
+    }
+    request->send(SPIFFS, TRACE_FILE_PATH, "application/octet-stream", true);
+}
+
+void DeskWebServer::handleGetTraceLive(AsyncWebServerRequest* request) {
+    if (traceRecorder_ == nullptr) {
+        sendJsonError(request, 503, "Trace recorder not available");
+        return;
+    }
+    if (!traceRecorder_->start(TraceSink::HTTP)) {
+        sendJsonError(request, 409, "A trace is already being recorded");
+        return;
+    }
+    
+    // Streams until POST /trace {"action":"stop"} or the client disconnects
+    TraceRecorder* recorder = traceRecorder_;
+    request->onDisconnect([recorder]() {
+        recorder->closeLive();
+    });
+    AsyncWebServerResponse* response = request->beginChunkedResponse("application/octet-stream",
+        [recorder](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            bool finished;
+            size_t len = recorder->readLive(buffer, maxLen, finished);
+            if (len == 0 && !finished) {
+                return RESPONSE_TRY_AGAIN;
+            }
+            return len;
+        });
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+}
+
+void DeskWebServer::handlePostTrace(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
+    String body = String((char*)data).substring(0, len);
+    Logger::debug(TAG, "POST /trace: %s", body.c_str());
+    
+    if (traceRecorder_ == nullptr) {
+        sendJsonError(request, 503, "Trace recorder not available");
+        return;
+    }
+    
+    String action;
+    if (!parseJsonField(body, "action", action)) {
+        sendJsonError(request, 400, "Missing 'action' field");
+        return;
+    }
+    
+    if (action == "start") {
+        if (!traceRecorder_->start(TraceSink::FILE)) {
+            sendJsonError(request, 409, "A trace is already being recorded");
+            return;
+        }
+    } else if (action == "stop") {
+        traceRecorder_->stop();
+    } else {
+        sendJsonError(request, 400, "action must be 'start' or 'stop'");
+        return;
+    }
+    request->send(200, "application/json", traceRecorder_->toJson());
+}
+
+void DeskWebServer::handleGetControl(AsyncWebServerRequest* request) {
+    if (controlTask_ == nullptr) {
+        sendJsonError(request, 503, "Control task not available");
+        return;
+    }
+    request->send(200, "application/json", controlTask_->toJson());
+}
+
+void DeskWebServer::handlePostControl(AsyncWebServerRequest* request, uint8_t* data, size_t len) {
+    String body = String((char*)data).substring(0, len);
+    Logger::debug(TAG, "POST /control: %s", body.c_str());
+    
+    if (controlTask_ == nullptr) {
+        sendJsonError(request, 503, "Control task not available");
+        return;
+    }
+    
+    String action;
+    if (!parseJsonField(body, "action", action)) {
+        sendJsonError(request, 400, "Missing 'action' field");
+        return;
+    }
+    if (action != "reset") {
+        sendJsonError(request, 400, "action must be 'reset'");
+        return;
+    }
+    
+    // Cleared by the control task at its next pass
+    controlTask_->resetStats();
+    request->send(200, "application/json", "{\"success\":true}");
+}
+
+String DeskWebServer::calibrationToJson(const CalibrationStatus& status) {
+    const char* stateStr;
+    switch (status.state) {
+        case CalibrationState::RUNNING:   stateStr = "running"; break;
+        case CalibrationState::SUCCEEDED: stateStr = "succeeded"; break;
+        case CalibrationState::FAILED:    stateStr = "failed"; break;
+        default:                          stateStr = "idle"; break;
+    }
+    
+    String json = "{";
+    json += "\"jobId\":" + String(status.job_id) + ",";
+    json += "\"state\":\"" + String(stateStr) + "\",";
+    json += "\"knownHeight\":" + String(HeightUnits::mmToCm(status.known_height_mm), 1) + ",";
+    json += "\"samples\":" + String(status.samples) + ",";
+    json += "\"maxSamples\":" + String(CALIBRATION_MAX_SAMPLES) + ",";
+    json += "\"meanDistance\":" + String(status.mean_distance_mm) + ",";
+    json += "\"stdErrorMm\":" + String(status.std_error_mm, 2) + ",";
+    json += "\"targetStdErrorMm\":" + String(CALIBRATION_TARGET_STDERR_MM, 2);
+    if (status.state == CalibrationState::SUCCEEDED) {
+        json += ",\"calibrationOffsetMm\":" + String(status.offset_mm);
+    } else if (status.state == CalibrationState::FAILED) {
+        json += ",\"message\":\"" + String(status.error) + "\"";
+    }
+    json += "}";
+    return json;
 }
 
 void DeskWebServer::sendJsonError(AsyncWebServerRequest* request, int code, const String& message) {
@@ -466,3 +863,10 @@ bool DeskWebServer::parseJsonField(const String& json, const String& field, int&
     value = strValue.toInt();
     return true;
 }
+
+bool DeskWebServer::parseJsonField(const String& json, const String& field, float& value) {
+    String strValue;
+    if (!parseJsonField(json, field, strValue)) return false;
+    value = strValue.toFloat();
+    return true;
+}
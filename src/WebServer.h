@@ -21,6 +21,9 @@
 #include "HeightController.h"
 #include "MovementController.h"
 #include "PresetManager.h"
+#include "TraceRecorder.h"
+#include "ControlTask.h"
+#include "utils/BootTimeline.h"
 
 // Forward declaration for PresetManager (for optional dependency)
 // class PresetManager;
@@ -56,6 +59,24 @@ public:
      */
     void setPresetManager(PresetManager* presetManager);
     
+    /**
+     * @brief Set boot timeline reference (served by GET /boot)
+     * @param bootTimeline Pointer to the timeline filled by setup()
+     */
+    void setBootTimeline(const BootTimeline* bootTimeline);
+    
+    /**
+     * @brief Set trace recorder reference (serves /trace)
+     * @param traceRecorder Pointer to TraceRecorder
+     */
+    void setTraceRecorder(TraceRecorder* traceRecorder);
+    
+    /**
+     * @brief Set control task reference (serves /control)
+     * @param controlTask Pointer to ControlTask
+     */
+    void setControlTask(ControlTask* controlTask);
+    
     /**
      * @brief Send height update SSE event to all connected clients
      * 
@@ -84,12 +105,20 @@ public:
      */
     void sendPresetUpdated(uint8_t slot);
     
+    /**
+     * @brief Send calibration progress SSE event if the job changed
+     * 
+     * Emits "calibration_progress" for every new sample and on completion.
+     * Call from the main loop alongside sendHeightUpdate().
+     */
+    void sendCalibrationProgress();
+    
     /**
      * @brief Get number of connected SSE clients
      * @return size_t Number of clients
      */
     size_t getClientCount() const;
-
+    
 private:
     AsyncWebServer server_;
     AsyncEventSource events_;
@@ -97,6 +126,10 @@ private:
     HeightController& heightController_;
     MovementController& movementController_;
     PresetManager* presetManager_;
+    const BootTimeline* bootTimeline_;
+    TraceRecorder* traceRecorder_;
+    ControlTask* controlTask_;
+    uint32_t lastCalibrationSequence_;   ///< Last calibration status pushed over SSE
     
     /**
      * @brief Setup all route handlers
@@ -111,6 +144,8 @@ private:
     // Route handlers
     void handleRoot(AsyncWebServerRequest* request);
     void handleGetStatus(AsyncWebServerRequest* request);
+    void handleGetDiagnostics(AsyncWebServerRequest* request);
+    void handleGetBoot(AsyncWebServerRequest* request);
     void handlePostTarget(AsyncWebServerRequest* request, uint8_t* data, size_t len);
     void handlePostStop(AsyncWebServerRequest* request);
     void handleGetConfig(AsyncWebServerRequest* request);
@@ -118,18 +153,31 @@ private:
     void handleGetPresets(AsyncWebServerRequest* request);
     void handlePostPreset(AsyncWebServerRequest* request, uint8_t* data, size_t len);
     void handlePostPresetSave(AsyncWebServerRequest* request, uint8_t* data, size_t len);
+    void handleGetCalibrate(AsyncWebServerRequest* request);
     void handlePostCalibrate(AsyncWebServerRequest* request, uint8_t* data, size_t len);
+    void handlePostZoneMask(AsyncWebServerRequest* request, uint8_t* data, size_t len);
+    void handleGetTrace(AsyncWebServerRequest* request);
+    void handleGetTraceLive(AsyncWebServerRequest* request);
+    void handlePostTrace(AsyncWebServerRequest* request, uint8_t* data, size_t len);
+    void handleGetControl(AsyncWebServerRequest* request);
+    void handlePostControl(AsyncWebServerRequest* request, uint8_t* data, size_t len);
     
     /**
      * @brief Send JSON error response
      */
     void sendJsonError(AsyncWebServerRequest* request, int code, const String& message);
     
+    /**
+     * @brief Calibration job status as JSON (GET /calibrate and SSE)
+     */
+    String calibrationToJson(const CalibrationStatus& status);
+    
     /**
      * @brief Parse JSON body and extract field
      */
     bool parseJsonField(const String& json, const String& field, String& value);
     bool parseJsonField(const String& json, const String& field, int& value);
+    bool parseJsonField(const String& json, const String& field, float& value);
 };
 
 #endif // WEB_SERVER_H
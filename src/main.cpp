@@ -12,8 +12,19 @@
  * 5. WiFi connection
  * 6. Sensor initialization
  * 7. Movement controller initialization
- * 8. Web server start
- * 9. Main loop (sensor sampling, state machine)
+ * 8. Preset manager initialization
+ * 9. Web server start
+ * 10. Control task start (height and movement updates, see ControlTask.h)
+ * 11. Main loop (WiFi, SSE publishing, trace writing)
+ * 
+ * The end of each setup() phase is recorded in bootTimeline (GET /boot).
+ * After a software, watchdog or panic reset (warm reset) the sensor and
+ * movement state retained in RTC memory are restored in steps 6 and 7.
+ * 
+ * With SENSOR_USE_DATA_READY_INTERRUPT, sensor sampling runs in its own
+ * FreeRTOS task. The control task, pinned next to it on the APP core,
+ * acts on each published reading within a control period; loop() runs on
+ * the PRO core and only publishes the results.
  */
 
 // Exclude from test builds (tests provide their own setup/loop)
@@ -21,15 +32,22 @@
 
 #include <Arduino.h>
 #include <SPIFFS.h>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 
 #include "Config.h"
 #include "SystemConfiguration.h"
 #include "WiFiManager.h"
+#include "VL53L5CXSensor.h"
 #include "HeightController.h"
 #include "MovementController.h"
+#include "ControlTask.h"
 #include "PresetManager.h"
+#include "TraceRecorder.h"
 #include "WebServer.h"
 #include "utils/Logger.h"
+#include "utils/BootTimeline.h"
 
 // Optional: Include secrets file if it exists (WiFi credentials)
 #if __has_include("secrets.h")
@@ -44,10 +62,28 @@
 // ============================================================================
 
 WiFiManager wifiManager;
-HeightController heightController;
+VL53L5CXSensor tofSensor;
+HeightController heightController(tofSensor);
 MovementController movementController(heightController);
+ControlTask controlTask(heightController, movementController);
 PresetManager presetManager;
+TraceRecorder traceRecorder;
 DeskWebServer webServer(heightController, movementController);
+BootTimeline bootTimeline;
+
+/**
+ * Movement status change waiting for loop() to publish it over SSE
+ * The callback runs in the control task, which must not block on the
+ * network.
+ */
+struct StatusEvent {
+    MovementState state;
+    const char* faultCode;                      ///< Static string, "" unless ERROR
+    char message[STATUS_EVENT_MESSAGE_MAX];
+};
+
+QueueHandle_t statusEvents = nullptr;
+volatile uint32_t droppedStatusEvents = 0;
 
 // ============================================================================
 // Forward Declarations
@@ -55,8 +91,10 @@ DeskWebServer webServer(heightController, movementController);
 
 void initSPIFFS();
 void initWiFi();
+bool isWarmReset();
 void onWiFiStatusChange(WiFiState state, const String& message);
-void onMovementStatusChange(MovementState state, const String& message);
+void onMovementStatusChange(MovementState state, const char* message);
+void publishStatusEvents();
 
 // ============================================================================
 // Arduino Setup
@@ -72,13 +110,16 @@ void setup() {
     Serial.println("  Desktop Height Controller");
     Serial.println("================================");
     Serial.println();
+    bootTimeline.mark("serial", micros());
     
     // 2. Logger setup
     Logger::init(LogLevel::INFO);
     Logger::info("Main", "Starting initialization...");
+    bootTimeline.mark("logger", micros());
     
     // 3. SPIFFS mount
     initSPIFFS();
+    bootTimeline.mark("spiffs", micros());
     
     // 4. SystemConfiguration init (NVS)
     if (!SystemConfig.init()) {
@@ -89,30 +130,59 @@ void setup() {
     if (!SystemConfig.isCalibrated()) {
         Logger::warn("Main", "System not calibrated! Please run calibration.");
     }
+    bootTimeline.mark("nvs", micros());
     
     // 5. WiFi initialization
     initWiFi();
+    bootTimeline.mark("wifi", micros());
     
     // 6. Sensor initialization
-    if (!heightController.init()) {
+    const bool warmReset = isWarmReset();
+    if (traceRecorder.begin()) {
+        heightController.setTraceRecorder(&traceRecorder);
+    }
+    if (!heightController.init(warmReset)) {
         Logger::error("Main", "Failed to initialize height sensor!");
+    } else if (SENSOR_USE_DATA_READY_INTERRUPT) {
+        if (!heightController.startAcquisitionTask()) {
+            Logger::warn("Main", "Falling back to polled sensor sampling");
+        }
     }
+    bootTimeline.mark("sensor", micros());
     
     // 7. Movement controller initialization
-    movementController.init();
+    statusEvents = xQueueCreate(STATUS_EVENT_QUEUE_LENGTH, sizeof(StatusEvent));
+    if (statusEvents == nullptr) {
+        Logger::error("Main", "Failed to create status event queue");
+    }
+    movementController.init(warmReset);
     movementController.setStatusCallback(onMovementStatusChange);
+    bootTimeline.mark("movement", micros());
     
     // 8. Preset manager initialization
     if (!presetManager.init()) {
         Logger::error("Main", "Failed to initialize PresetManager");
     }
+    bootTimeline.mark("presets", micros());
     
     // 9. Web server initialization
     webServer.setPresetManager(&presetManager);
+    webServer.setBootTimeline(&bootTimeline);
+    webServer.setTraceRecorder(&traceRecorder);
+    webServer.setControlTask(&controlTask);
     webServer.begin();
     Logger::info("Main", "Web server started on port 80");
+    bootTimeline.mark("webserver", micros());
+    
+    // 10. Control task (loop() runs the control pass if it can't start)
+    if (!controlTask.start()) {
+        Logger::warn("Main", "Falling back to control from the main loop");
+    }
+    bootTimeline.mark("control", micros());
     
-    Logger::info("Main", "Initialization complete!");
+    Logger::info("Main", "Initialization complete in %lu ms (sensor firmware %lu ms)",
+                 (unsigned long)(bootTimeline.getTotalUs() / 1000),
+                 (unsigned long)(heightController.getFirmwareUploadUs() / 1000));
     Serial.println();
     Serial.println("Ready.");
     Serial.println();
@@ -123,27 +193,45 @@ void setup() {
 // ============================================================================
 
 void loop() {
-    static unsigned long lastSensorUpdate = 0;
+    static unsigned long lastPublish = 0;
+    static uint32_t lastReadingSequence = 0;
     unsigned long now = millis();
     
     // WiFi state management
     wifiManager.update();
     
-    // Sensor sampling at 5Hz (200ms intervals) per PERF-002
-    if (now - lastSensorUpdate >= SENSOR_SAMPLE_INTERVAL_MS) {
-        lastSensorUpdate = now;
-        
-        // Update height reading
-        heightController.update();
-        
-        // Update movement state machine
-        movementController.update();
-        
-        // Push SSE height updates to connected clients
-        // Always send updates so clients can see raw sensor data even if invalid/uncalibrated
+    // Fallback when the control task couldn't be created
+    if (!controlTask.isRunning()) {
+        controlTask.tick();
+    }
+    
+    // Status changes raised by the control pass
+    publishStatusEvents();
+    
+    // Log lines from the control, acquisition and AsyncTCP tasks
+    Logger::flush();
+    
+    // Calibration offset and stop distances learned by the acquisition and
+    // control tasks (NVS writes kept out of them)
+    SystemConfig.persistLearnedValues();
+    
+    // Zone mask learned or cleared on the acquisition path
+    heightController.persistZoneMask();
+    
+    // Push SSE height updates for each new reading, or at least every
+    // sample interval so clients see raw sensor data even if invalid/uncalibrated
+    uint32_t sequence = heightController.getReadingSequence();
+    if (sequence != lastReadingSequence ||
+        now - lastPublish >= heightController.getSampleIntervalMs()) {
+        lastReadingSequence = sequence;
+        lastPublish = now;
         webServer.sendHeightUpdate();
+        webServer.sendCalibrationProgress();
     }
     
+    // Write recorded sensor frames to SPIFFS
+    traceRecorder.update();
+    
     // Web server update (handles async events)
     // Note: ESPAsyncWebServer handles requests asynchronously, minimal loop work needed
     
@@ -155,6 +243,29 @@ void loop() {
 // Initialization Functions
 // ============================================================================
 
+/**
+ * @brief Check if this boot follows a reset that kept RTC memory and sensor power
+ * 
+ * Power-on, brownout and deep-sleep wake are cold boots: RTC state is
+ * garbage (or the sensor was powered down) and is not restored.
+ * 
+ * @return true for esp_restart(), panic and watchdog resets
+ */
+bool isWarmReset() {
+    esp_reset_reason_t reason = esp_reset_reason();
+    switch (reason) {
+        case ESP_RST_SW:
+        case ESP_RST_PANIC:
+        case ESP_RST_INT_WDT:
+        case ESP_RST_TASK_WDT:
+        case ESP_RST_WDT:
+            Logger::info("Main", "Warm reset (reason %d)", (int)reason);
+            return true;
+        default:
+            return false;
+    }
+}
+
 /**
  * @brief Initialize SPIFFS filesystem
  * 
@@ -229,12 +340,47 @@ void onWiFiStatusChange(WiFiState state, const String& message) {
 
 /**
  * @brief Callback for movement status changes
+ * 
+ * Runs in the control task (or a web handler): switches the ranging
+ * profile at once and queues the SSE events for loop().
  */
-void onMovementStatusChange(MovementState state, const String& message) {
-    Logger::info("Movement", "%s - %s", movementController.getStateString(), message.c_str());
+void onMovementStatusChange(MovementState state, const char* message) {
+    // Range fast while the desk moves or settles, slow when it's parked
+    bool active = (state == MovementState::MOVING_UP ||
+                   state == MovementState::MOVING_DOWN ||
+                   state == MovementState::STABILIZING);
+    heightController.requestRangingProfile(active ? RangingProfile::ACTIVE : RangingProfile::IDLE);
     
-    // Send SSE status_change event via WebServer
-    webServer.sendStatusChange(state, message);
+    StatusEvent event;
+    event.state = state;
+    event.faultCode = (state == MovementState::ERROR) ? movementController.getFaultCode() : "";
+    strncpy(event.message, message, sizeof(event.message) - 1);
+    event.message[sizeof(event.message) - 1] = '\0';
+    if (statusEvents == nullptr || xQueueSend(statusEvents, &event, 0) != pdPASS) {
+        droppedStatusEvents++;
+    }
+}
+
+/**
+ * @brief Send queued movement status changes over SSE (loop() only)
+ */
+void publishStatusEvents() {
+    static uint32_t reportedDrops = 0;
+    if (droppedStatusEvents != reportedDrops) {
+        reportedDrops = droppedStatusEvents;
+        Logger::warn("Main", "%lu status events dropped (queue full)", (unsigned long)reportedDrops);
+    }
+    
+    StatusEvent event;
+    while (statusEvents != nullptr && xQueueReceive(statusEvents, &event, 0) == pdPASS) {
+        String message(event.message);
+        webServer.sendStatusChange(event.state, message);
+        
+        // Faults also go out as an SSE error event with their code
+        if (event.state == MovementState::ERROR) {
+            webServer.sendError(event.faultCode, message);
+        }
+    }
 }
 
 #endif // UNIT_TEST
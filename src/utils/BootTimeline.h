@@ -0,0 +1,97 @@
+/**
+ * @file BootTimeline.h
+ * @brief Timestamps of the setup() phases for boot time analysis
+ *
+ * setup() marks the end of each phase with micros(); GET /boot reports
+ * the list together with the sensor firmware upload time and the first
+ * valid height, so time-to-first-valid-height after a reboot can be
+ * compared across firmware builds.
+ *
+ * Header-only so native tests can include it directly.
+ */
+
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <stdint.h>
+#include "../Config.h"
+
+/**
+ * @class BootTimeline
+ * @brief Fixed-capacity list of (phase, timestamp) marks
+ *
+ * Usage:
+ *   BootTimeline timeline;
+ *   initSPIFFS();
+ *   timeline.mark("spiffs", micros());
+ *   for (uint8_t i = 0; i < timeline.getCount(); i++) {
+ *       timeline.getName(i); timeline.getDurationUs(i);
+ *   }
+ */
+class BootTimeline {
+public:
+    BootTimeline() : count_(0) {}
+
+    /**
+     * @brief Record the end of a phase
+     * @param phase Phase name (must be a string literal / static storage)
+     * @param timestampUs micros() at the end of the phase
+     * @return true if recorded, false if the timeline is full
+     */
+    bool mark(const char* phase, uint32_t timestampUs) {
+        if (count_ >= BOOT_TIMELINE_MAX_PHASES) {
+            return false;
+        }
+        names_[count_] = phase;
+        timestamps_[count_] = timestampUs;
+        count_++;
+        return true;
+    }
+
+    /**
+     * @brief Number of recorded phases
+     */
+    uint8_t getCount() const { return count_; }
+
+    /**
+     * @brief Phase name
+     * @param index 0..getCount()-1
+     * @return const char* Name, or "" if out of range
+     */
+    const char* getName(uint8_t index) const {
+        return (index < count_) ? names_[index] : "";
+    }
+
+    /**
+     * @brief micros() at the end of a phase
+     * @param index 0..getCount()-1
+     */
+    uint32_t getTimestampUs(uint8_t index) const {
+        return (index < count_) ? timestamps_[index] : 0;
+    }
+
+    /**
+     * @brief Time spent in a phase (since the previous mark, or since start)
+     * @param index 0..getCount()-1
+     */
+    uint32_t getDurationUs(uint8_t index) const {
+        if (index >= count_) {
+            return 0;
+        }
+        return (index == 0) ? timestamps_[0] : timestamps_[index] - timestamps_[index - 1];
+    }
+
+    /**
+     * @brief Timestamp of the last mark (end of setup() once it returned)
+     */
+    uint32_t getTotalUs() const {
+        return (count_ > 0) ? timestamps_[count_ - 1] : 0;
+    }
+
+private:
+    const char* names_[BOOT_TIMELINE_MAX_PHASES];
+    uint32_t timestamps_[BOOT_TIMELINE_MAX_PHASES];
+    uint8_t count_;
+};
+
+#endif // BOOT_TIMELINE_H
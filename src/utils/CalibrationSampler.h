@@ -0,0 +1,140 @@
+/**
+ * @file CalibrationSampler.h
+ * @brief Running mean with standard-error early stop for calibration jobs
+ *
+ * A calibration job feeds one consensus distance per sensor frame. The
+ * mean and variance are tracked with Welford's update, so the job can
+ * stop as soon as the mean is known well enough instead of after a fixed
+ * sample count: a quiet floor converges in under a second, a noisy one
+ * keeps sampling up to the cap.
+ *
+ * Header-only so native tests use this file directly.
+ */
+
+#ifndef CALIBRATION_SAMPLER_H
+#define CALIBRATION_SAMPLER_H
+
+#include <stdint.h>
+#include <math.h>
+
+/**
+ * @class CalibrationSampler
+ * @brief Accumulates distance samples for one calibration job
+ *
+ * Usage:
+ *   CalibrationSampler sampler;
+ *   sampler.start(10, 150, 0.5f);
+ *   // per reliable consensus frame:
+ *   if (sampler.addSample(distance_mm)) {
+ *       uint16_t avg = sampler.getMeanMm();  // isConverged() tells why it stopped
+ *   }
+ */
+class CalibrationSampler {
+public:
+    CalibrationSampler()
+        : minSamples_(0), maxSamples_(0), targetStdErrMm_(0.0f),
+          count_(0), mean_(0.0f), m2_(0.0f), active_(false), converged_(false) {}
+
+    /**
+     * @brief Begin a job, discarding previous samples
+     * @param minSamples Samples required before early stop (at least 2)
+     * @param maxSamples Hard cap on samples
+     * @param targetStdErrMm Stop once the standard error is at or below this
+     */
+    void start(uint16_t minSamples, uint16_t maxSamples, float targetStdErrMm) {
+        minSamples_ = (minSamples < 2) ? 2 : minSamples;
+        maxSamples_ = (maxSamples < minSamples_) ? minSamples_ : maxSamples;
+        targetStdErrMm_ = targetStdErrMm;
+        count_ = 0;
+        mean_ = 0.0f;
+        m2_ = 0.0f;
+        active_ = true;
+        converged_ = false;
+    }
+
+    /**
+     * @brief Abort the current job
+     */
+    void cancel() { active_ = false; }
+
+    /**
+     * @brief Add one distance sample
+     * @param distanceMm Consensus distance of a reliable frame
+     * @return true if this sample finished the job (converged or capped)
+     */
+    bool addSample(uint16_t distanceMm) {
+        if (!active_) {
+            return false;
+        }
+
+        count_++;
+        float delta = distanceMm - mean_;
+        mean_ += delta / count_;
+        m2_ += delta * (distanceMm - mean_);
+
+        if (count_ >= minSamples_ && getStdErrMm() <= targetStdErrMm_) {
+            converged_ = true;
+            active_ = false;
+            return true;
+        }
+        if (count_ >= maxSamples_) {
+            active_ = false;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Check if a job is collecting samples
+     */
+    bool isActive() const { return active_; }
+
+    /**
+     * @brief Check if the last job stopped on the standard error target
+     */
+    bool isConverged() const { return converged_; }
+
+    /**
+     * @brief Samples collected in the current/last job
+     */
+    uint16_t getCount() const { return count_; }
+
+    /**
+     * @brief Mean distance rounded to the nearest mm
+     */
+    uint16_t getMeanMm() const {
+        return static_cast<uint16_t>(mean_ + 0.5f);
+    }
+
+    /**
+     * @brief Sample standard deviation (0 with fewer than 2 samples)
+     */
+    float getStdDevMm() const {
+        if (count_ < 2) {
+            return 0.0f;
+        }
+        return sqrtf(m2_ / (count_ - 1));
+    }
+
+    /**
+     * @brief Standard error of the mean (infinite with fewer than 2 samples)
+     */
+    float getStdErrMm() const {
+        if (count_ < 2) {
+            return INFINITY;
+        }
+        return getStdDevMm() / sqrtf(static_cast<float>(count_));
+    }
+
+private:
+    uint16_t minSamples_;
+    uint16_t maxSamples_;
+    float targetStdErrMm_;
+    uint16_t count_;
+    float mean_;   ///< Running mean (mm)
+    float m2_;     ///< Sum of squared deviations from the running mean
+    bool active_;
+    bool converged_;
+};
+
+#endif // CALIBRATION_SAMPLER_H
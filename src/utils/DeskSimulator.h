@@ -0,0 +1,539 @@
+/**
+ * @file DeskSimulator.h
+ * @brief Desk physics and multi-zone sensor model for closed-loop runs
+ *
+ * Stands in for the desk and the ToF sensor so the real HeightController
+ * and MovementController can be run against each other on the host:
+ *
+ * - Motor: driven by writes to PIN_MOTOR_UP / PIN_MOTOR_DOWN, with a
+ *   response delay, separate up/down speeds, a soft-start ramp and a
+ *   coast-down after power is cut, between two end stops. PWM on the
+ *   pins (writeDuty()) scales the speed in proportion to the duty. A
+ *   jammed desk, a stuck-on driver or swapped motor wires can be injected.
+ * - Sensor: implements DistanceSensor. Frames arrive at the ranging
+ *   frequency on the simulated clock; every zone sees the floor with a
+ *   fixed per-zone bias, Gaussian noise and random dropouts, or the top
+ *   of an obstacle placed under it.
+ *
+ * The simulator owns the clock: the test routes millis()/micros() and
+ * digitalWrite() to it and calls advance(), so a run takes as long as
+ * the controllers' CPU time, not the desk's travel time.
+ *
+ * MoveMetrics turns a run into time-to-target, overshoot and settle time.
+ *
+ * Header-only so native tests use this file directly.
+ */
+
+#ifndef DESK_SIMULATOR_H
+#define DESK_SIMULATOR_H
+
+#include <stdint.h>
+#include <math.h>
+#include "../Config.h"
+#include "../DistanceSensor.h"
+
+/**
+ * @struct DeskModel
+ * @brief Physical parameters of the simulated desk and sensor
+ *
+ * Defaults are a typical two-leg office desk with the sensor under the
+ * desktop looking at the floor.
+ */
+struct DeskModel {
+    float up_speed_mm_s;        ///< Full speed rising (motor works against the load)
+    float down_speed_mm_s;      ///< Full speed lowering
+    float accel_mm_s2;          ///< Soft-start ramp
+    float decel_mm_s2;          ///< Coast-down once power is cut or reversed
+    uint16_t response_ms;       ///< Pin write to motor torque (MOSFET + desk controller)
+    uint16_t min_distance_mm;   ///< Lower end stop (sensor to floor)
+    uint16_t max_distance_mm;   ///< Upper end stop
+    float noise_mm;             ///< Per-zone range noise, 1 sigma
+    float zone_bias_mm;         ///< Fixed per-zone offset spread (floor tilt, optics)
+    uint8_t dropout_percent;    ///< Chance a zone reports no target in a frame
+
+    DeskModel()
+        : up_speed_mm_s(35.0f)
+        , down_speed_mm_s(40.0f)
+        , accel_mm_s2(200.0f)
+        , decel_mm_s2(300.0f)
+        , response_ms(50)
+        , min_distance_mm(600)
+        , max_distance_mm(1250)
+        , noise_mm(4.0f)
+        , zone_bias_mm(3.0f)
+        , dropout_percent(2)
+    {
+    }
+};
+
+/**
+ * @enum DeskMotorFault
+ * @brief Motor hardware fault injected into the simulated desk
+ */
+enum class DeskMotorFault : uint8_t {
+    NONE,       ///< Motor follows the pins
+    JAMMED,     ///< Desk does not move whatever the pins say
+    STUCK_ON,   ///< Driver keeps the last direction it was switched on in
+    REVERSED    ///< Motor wires swapped: up drives down and vice versa
+};
+
+/**
+ * @class DeskSimulator
+ * @brief Simulated desk, motor and distance sensor on a simulated clock
+ *
+ * Usage:
+ *   DeskSimulator desk(DeskModel(), 700);
+ *   HeightController height(desk);
+ *   // millis()/micros() -> desk.nowMs()/nowUs(), digitalWrite -> desk.writePin()
+ *   for (;;) {
+ *       desk.advance(1000);
+ *       ...controllers...
+ *   }
+ */
+class DeskSimulator : public DistanceSensor {
+public:
+    static constexpr uint32_t STEP_US = 1000;   ///< Physics integration step
+    static constexpr uint32_t PWM_PERIOD_US = 1000000UL / MOTOR_PWM_FREQUENCY_HZ;
+    static constexpr uint8_t MAX_OBSTACLES = 4;
+    static constexpr uint8_t STATUS_VALID = 5;
+    static constexpr uint8_t STATUS_NO_TARGET = 255;
+
+    /**
+     * @param model Physical parameters
+     * @param startDistanceMm Initial sensor-to-floor distance
+     * @param seed Noise and dropout seed (runs are reproducible)
+     */
+    explicit DeskSimulator(const DeskModel& model = DeskModel(), uint16_t startDistanceMm = 700,
+                           uint32_t seed = 1)
+        : model_(model)
+        , nowUs_(0)
+        , position_mm_(startDistanceMm)
+        , velocity_mm_s_(0.0f)
+        , upLevel_(0.0f)
+        , downLevel_(0.0f)
+        , upOnUntilUs_(0)
+        , downOnUntilUs_(0)
+        , drive_(0)
+        , driveLevel_(0.0f)
+        , pendingDrive_(0)
+        , pendingLevel_(0.0f)
+        , pendingAtUs_(0)
+        , pinConflicts_(0)
+        , motorFault_(DeskMotorFault::NONE)
+        , lastDrive_(0)
+        , ranging_(false)
+        , offline_(false)
+        , framePeriodUs_(1000000)
+        , nextFrameUs_(0)
+        , frames_(0)
+        , obstacleCount_(0)
+        , rng_(seed != 0 ? seed : 1)
+    {
+        for (uint8_t zone = 0; zone < MULTI_ZONE_TOTAL_ZONES; zone++) {
+            zoneBias_mm_[zone] = (uniform() * 2.0f - 1.0f) * model_.zone_bias_mm;
+        }
+    }
+
+    // ---------------------------------------------------------------------
+    // Clock
+    // ---------------------------------------------------------------------
+
+    uint32_t nowUs() const { return static_cast<uint32_t>(nowUs_); }
+    uint32_t nowMs() const { return static_cast<uint32_t>(nowUs_ / 1000); }
+
+    /**
+     * @brief Advance the clock and integrate the desk motion
+     * @param us Time to advance (integrated in STEP_US steps)
+     */
+    void advance(uint32_t us) {
+        while (us > 0) {
+            uint32_t dt = us;
+            if (dt > STEP_US) {
+                dt = STEP_US;
+            }
+            nowUs_ += dt;
+            us -= dt;
+            step(dt * 1e-6f);
+        }
+    }
+
+    // ---------------------------------------------------------------------
+    // Motor
+    // ---------------------------------------------------------------------
+
+    /**
+     * @brief Route a digitalWrite() to the motor inputs
+     *
+     * Other pins are ignored. Both inputs high counts as a conflict and
+     * cuts the drive, as an interlocked desk controller would.
+     */
+    void writePin(uint8_t pin, uint8_t level) {
+        writeLevel(pin, level != LOW ? 1.0f : 0.0f);
+    }
+
+    /**
+     * @brief Route an ledcWrite() to the motor inputs
+     *
+     * A duty change in the direction already driven applies at once;
+     * switching on, off or over takes the response delay as writePin().
+     *
+     * The LEDC takes a new duty at the end of the PWM period, so a lower
+     * duty may keep the old one on the pin for up to PWM_PERIOD_US. A
+     * conflict is counted when both inputs may be on at once, to the
+     * microsecond: writing one channel off and the other on back to back
+     * is one.
+     *
+     * @param pin Pin the LEDC channel is attached to
+     * @param duty Duty in counts
+     * @param resolutionBits Channel resolution (full duty = 2^bits - 1)
+     */
+    void writeDuty(uint8_t pin, uint32_t duty, uint8_t resolutionBits) {
+        float full = static_cast<float>((1UL << resolutionBits) - 1);
+        float level = duty / full;
+        if (level > 1.0f) {
+            level = 1.0f;
+        }
+        if (pin == PIN_MOTOR_UP && level < upLevel_) {
+            upOnUntilUs_ = nowUs_ + PWM_PERIOD_US;
+        } else if (pin == PIN_MOTOR_DOWN && level < downLevel_) {
+            downOnUntilUs_ = nowUs_ + PWM_PERIOD_US;
+        }
+        writeLevel(pin, level);
+    }
+
+    int8_t getDrive() const { return drive_; }                   ///< Motor drive in effect: +1 up, -1 down, 0 off
+    float getDriveLevel() const { return driveLevel_; }          ///< Duty in effect, 0-1 (1 when switched on)
+    uint32_t getPinConflictCount() const { return pinConflicts_; } ///< Both motor inputs (possibly) high at once
+
+    // ---------------------------------------------------------------------
+    // Ground truth
+    // ---------------------------------------------------------------------
+
+    float getDistanceMm() const { return position_mm_; }         ///< True sensor-to-floor distance
+    float getVelocityMmS() const { return velocity_mm_s_; }      ///< True velocity (positive = rising)
+    bool isMoving() const { return velocity_mm_s_ != 0.0f; }
+    uint32_t getFrameCount() const { return frames_; }           ///< Frames read so far
+    const DeskModel& getModel() const { return model_; }
+
+    // ---------------------------------------------------------------------
+    // Scenario
+    // ---------------------------------------------------------------------
+
+    /**
+     * @brief Place an object on the floor under some zones
+     * @param zones Bit n set = zone n sees the object
+     * @param heightMm Height of the object's top above the floor
+     * @return false if MAX_OBSTACLES are placed already
+     */
+    bool addObstacle(uint64_t zones, uint16_t heightMm) {
+        if (obstacleCount_ >= MAX_OBSTACLES) {
+            return false;
+        }
+        obstacles_[obstacleCount_].zones = zones;
+        obstacles_[obstacleCount_].height_mm = heightMm;
+        obstacleCount_++;
+        return true;
+    }
+
+    void clearObstacles() { obstacleCount_ = 0; }
+
+    /**
+     * @brief Move the desk by hand (someone leans on it), within the end stops
+     * @param mm Displacement, positive = up
+     */
+    void push(float mm) {
+        position_mm_ += mm;
+        if (position_mm_ < model_.min_distance_mm) position_mm_ = model_.min_distance_mm;
+        if (position_mm_ > model_.max_distance_mm) position_mm_ = model_.max_distance_mm;
+    }
+
+    /**
+     * @brief Inject a motor fault (takes effect on the next step)
+     */
+    void setMotorFault(DeskMotorFault fault) { motorFault_ = fault; }
+
+    /**
+     * @brief Simulate a dead sensor: no frames and begin() fails
+     */
+    void setOffline(bool offline) { offline_ = offline; }
+
+    // ---------------------------------------------------------------------
+    // DistanceSensor
+    // ---------------------------------------------------------------------
+
+    bool begin(uint32_t& uploadUs, uint32_t& uploadHz) override {
+        uploadUs = 0;
+        uploadHz = I2C_FREQUENCY;
+        ranging_ = false;
+        return !offline_;
+    }
+
+    bool startRanging(uint8_t frequencyHz) override {
+        if (offline_ || frequencyHz == 0) {
+            return false;
+        }
+        framePeriodUs_ = 1000000UL / frequencyHz;
+        nextFrameUs_ = nowUs_ + framePeriodUs_;
+        ranging_ = true;
+        return true;
+    }
+
+    bool isDataReady() override {
+        return ranging_ && !offline_ && nowUs_ >= nextFrameUs_;
+    }
+
+    bool readFrame(ZoneFrame& frame) override {
+        if (!ranging_ || offline_) {
+            return false;
+        }
+
+        for (uint8_t zone = 0; zone < MULTI_ZONE_TOTAL_ZONES; zone++) {
+            float distance = position_mm_ + zoneBias_mm_[zone];
+            for (uint8_t i = 0; i < obstacleCount_; i++) {
+                if (obstacles_[i].zones & (1ULL << zone)) {
+                    float top = position_mm_ - obstacles_[i].height_mm;
+                    if (top < distance) {
+                        distance = top;
+                    }
+                }
+            }
+            distance += gaussian() * model_.noise_mm;
+
+            bool dropout = uniform() * 100.0f < model_.dropout_percent;
+            uint8_t status = STATUS_VALID;
+            if (dropout) {
+                status = STATUS_NO_TARGET;
+            }
+            frame.target_status[zone] = status;
+            frame.distance_mm[zone] = dropout ? 0 : static_cast<int16_t>(lroundf(distance));
+#if SENSOR_READOUT_HAS_CONFIDENCE
+            frame.range_sigma_mm[zone] = static_cast<uint16_t>(model_.noise_mm + 1.0f);
+            frame.signal_per_spad[zone] = dropout ? 0 : 1500;
+            frame.ambient_per_spad[zone] = 5;
+#endif
+        }
+
+        // The next frame follows on the ranging grid; unread frames are lost
+        while (nextFrameUs_ <= nowUs_) {
+            nextFrameUs_ += framePeriodUs_;
+        }
+        frames_++;
+        return true;
+    }
+
+private:
+    struct Obstacle {
+        uint64_t zones;
+        uint16_t height_mm;
+    };
+
+    DeskModel model_;
+    uint64_t nowUs_;
+
+    float position_mm_;
+    float velocity_mm_s_;
+
+    float upLevel_;             ///< Duty on the up input, 0-1
+    float downLevel_;
+    uint64_t upOnUntilUs_;      ///< Old duty may still be on the pin until then (LEDC latch)
+    uint64_t downOnUntilUs_;
+    int8_t drive_;
+    float driveLevel_;
+    int8_t pendingDrive_;
+    float pendingLevel_;
+    uint64_t pendingAtUs_;
+    uint32_t pinConflicts_;
+    DeskMotorFault motorFault_;
+    int8_t lastDrive_;          ///< Last non-zero drive (kept by a stuck-on driver)
+
+    bool ranging_;
+    bool offline_;
+    uint32_t framePeriodUs_;
+    uint64_t nextFrameUs_;
+    uint32_t frames_;
+
+    float zoneBias_mm_[MULTI_ZONE_TOTAL_ZONES];
+    Obstacle obstacles_[MAX_OBSTACLES];
+    uint8_t obstacleCount_;
+
+    uint32_t rng_;
+
+    void writeLevel(uint8_t pin, float level) {
+        if (pin == PIN_MOTOR_UP) {
+            upLevel_ = level;
+        } else if (pin == PIN_MOTOR_DOWN) {
+            downLevel_ = level;
+        } else {
+            return;
+        }
+
+        bool up = upLevel_ > 0.0f;
+        bool down = downLevel_ > 0.0f;
+        // Driving one input while the other is (or may still be) on
+        bool otherOn = (pin == PIN_MOTOR_UP) ? (down || nowUs_ < downOnUntilUs_)
+                                             : (up || nowUs_ < upOnUntilUs_);
+        if (level > 0.0f && otherOn) {
+            pinConflicts_++;
+        }
+        int8_t command = (up == down) ? 0 : (up ? 1 : -1);
+        float commandLevel = (command > 0) ? upLevel_ : (command < 0) ? downLevel_ : 0.0f;
+        if (command != pendingDrive_) {
+            pendingDrive_ = command;
+            pendingAtUs_ = nowUs_ + static_cast<uint64_t>(model_.response_ms) * 1000;
+        } else if (drive_ == command) {
+            driveLevel_ = commandLevel;
+        }
+        pendingLevel_ = commandLevel;
+    }
+
+    void step(float dt) {
+        if (nowUs_ >= pendingAtUs_) {
+            drive_ = pendingDrive_;
+            driveLevel_ = pendingLevel_;
+        }
+        if (drive_ != 0) {
+            lastDrive_ = drive_;
+        }
+
+        int8_t motor = drive_;
+        float level = driveLevel_;
+        switch (motorFault_) {
+            case DeskMotorFault::JAMMED:   motor = 0; break;
+            case DeskMotorFault::STUCK_ON: motor = lastDrive_; level = 1.0f; break;
+            case DeskMotorFault::REVERSED: motor = -drive_; break;
+            default: break;
+        }
+
+        float target = (motor > 0) ? model_.up_speed_mm_s * level :
+                       (motor < 0) ? -model_.down_speed_mm_s * level : 0.0f;
+        float dv = target - velocity_mm_s_;
+        bool slowing = (velocity_mm_s_ > 0.0f && dv < 0.0f) || (velocity_mm_s_ < 0.0f && dv > 0.0f);
+        float maxDv = (slowing ? model_.decel_mm_s2 : model_.accel_mm_s2) * dt;
+        if (dv > maxDv) dv = maxDv;
+        if (dv < -maxDv) dv = -maxDv;
+        velocity_mm_s_ += dv;
+
+        position_mm_ += velocity_mm_s_ * dt;
+        if (position_mm_ <= model_.min_distance_mm) {
+            position_mm_ = model_.min_distance_mm;
+            if (velocity_mm_s_ < 0.0f) velocity_mm_s_ = 0.0f;
+        } else if (position_mm_ >= model_.max_distance_mm) {
+            position_mm_ = model_.max_distance_mm;
+            if (velocity_mm_s_ > 0.0f) velocity_mm_s_ = 0.0f;
+        }
+    }
+
+    /// xorshift32, uniform in [0, 1)
+    float uniform() {
+        rng_ ^= rng_ << 13;
+        rng_ ^= rng_ >> 17;
+        rng_ ^= rng_ << 5;
+        return (rng_ >> 8) * (1.0f / 16777216.0f);
+    }
+
+    /// Standard normal (Box-Muller)
+    float gaussian() {
+        float u1 = uniform();
+        float u2 = uniform();
+        if (u1 < 1e-7f) u1 = 1e-7f;
+        return sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+    }
+};
+
+/**
+ * @struct MoveReport
+ * @brief Outcome of one simulated move
+ */
+struct MoveReport {
+    bool reached;               ///< Entered the tolerance band
+    bool settled;               ///< In the band, motor off and desk still at the end
+    uint32_t time_to_target_ms; ///< Start to first entry into the band
+    uint32_t settle_time_ms;    ///< Start to the beginning of the final settled stretch
+    float overshoot_mm;         ///< Furthest travel past the target (0 = none)
+    float final_error_mm;       ///< Position - target at the end
+    uint16_t reversals;         ///< Motor direction changes (up <-> down)
+    uint32_t motor_on_ms;       ///< Time the motor was driven
+};
+
+/**
+ * @class MoveMetrics
+ * @brief Measures a move from the true desk position
+ *
+ * Positions can be in any unit/origin as long as start, target and
+ * samples agree (the tests use true desk height in mm).
+ *
+ * Usage:
+ *   metrics.begin(nowMs, startMm, targetMm, toleranceMm);
+ *   // every simulation step:
+ *   metrics.sample(nowMs, positionMm, desk.getDrive(), desk.isMoving());
+ *   MoveReport r = metrics.report();
+ */
+class MoveMetrics {
+public:
+    MoveMetrics() { begin(0, 0.0f, 0.0f, 0.0f); }
+
+    void begin(uint32_t nowMs, float startMm, float targetMm, float toleranceMm) {
+        startMs_ = nowMs;
+        lastMs_ = nowMs;
+        target_ = targetMm;
+        tolerance_ = toleranceMm;
+        direction_ = (targetMm >= startMm) ? 1.0f : -1.0f;
+        lastDrive_ = 0;
+        settledSinceMs_ = 0;
+        report_.reached = false;
+        report_.settled = false;
+        report_.time_to_target_ms = 0;
+        report_.settle_time_ms = 0;
+        report_.overshoot_mm = 0.0f;
+        report_.final_error_mm = startMm - targetMm;
+        report_.reversals = 0;
+        report_.motor_on_ms = 0;
+    }
+
+    void sample(uint32_t nowMs, float positionMm, int8_t drive, bool moving) {
+        float error = positionMm - target_;
+        bool inBand = fabsf(error) <= tolerance_;
+
+        float past = error * direction_;
+        if (past > report_.overshoot_mm) {
+            report_.overshoot_mm = past;
+        }
+
+        if (inBand && !report_.reached) {
+            report_.reached = true;
+            report_.time_to_target_ms = nowMs - startMs_;
+        }
+
+        bool settledNow = inBand && drive == 0 && !moving;
+        if (settledNow && !report_.settled) {
+            settledSinceMs_ = nowMs;
+        }
+        report_.settled = settledNow;
+        report_.settle_time_ms = settledNow ? settledSinceMs_ - startMs_ : 0;
+
+        if (drive != 0) {
+            if (lastDrive_ != 0 && drive != lastDrive_) {
+                report_.reversals++;
+            }
+            lastDrive_ = drive;
+            report_.motor_on_ms += nowMs - lastMs_;
+        }
+
+        report_.final_error_mm = error;
+        lastMs_ = nowMs;
+    }
+
+    const MoveReport& report() const { return report_; }
+
+private:
+    uint32_t startMs_;
+    uint32_t lastMs_;
+    float target_;
+    float tolerance_;
+    float direction_;
+    int8_t lastDrive_;
+    uint32_t settledSinceMs_;
+    MoveReport report_;
+};
+
+#endif // DESK_SIMULATOR_H
@@ -0,0 +1,245 @@
+/**
+ * @file FloorPlane.h
+ * @brief RANSAC floor-plane fit over the zone grid (alternative consensus)
+ *
+ * The median-mean consensus treats the zones as 16/64 samples of one
+ * distance. With the sensor tilted, the floor is a gradient across the
+ * grid instead: the mean then depends on which zones survived (an
+ * obstacle or dropout on one side shifts it), and on steep tilts the
+ * edge zones fall outside the outlier threshold of the median.
+ *
+ * This estimator uses where each zone looks. Zone (row, col) of an N x N
+ * grid points at angles ((col - (N-1)/2) * fov / N, (row - (N-1)/2) * fov / N),
+ * and reports its distance along the sensor axis (as the consensus and
+ * the desk simulator assume), so it sees the point z * (tx, ty, 1) with
+ * tx, ty the tangents of those angles. A floor plane n . P = h then gives
+ *
+ *   S / z = p + q * tx + r * ty     (S = frame median, keeps values ~1)
+ *
+ * which is linear in (p, q, r). The distance along the sensor axis is
+ * S / p; atan(q / p) and atan(r / p) are the tilts across columns and rows.
+ *
+ * Fit:
+ *   1. RANSAC: planes through 3 random valid zones, each scored by the
+ *      zones within the outlier threshold (in mm) of it; stops early
+ *      once a plane explains every zone
+ *   2. Least squares over the best plane's inliers (centered normal
+ *      equations, 2x2 solve)
+ *
+ * Everything is single precision (ESP32 FPU); sampling is a fixed-seed
+ * LCG, so a frame always gives the same result.
+ *
+ * Header-only (template) so native tests use this file directly.
+ */
+
+#ifndef FLOOR_PLANE_H
+#define FLOOR_PLANE_H
+
+#include <stdint.h>
+#include <math.h>
+#include "../Config.h"
+
+/**
+ * @struct PlaneFit
+ * @brief Floor plane of one frame
+ */
+struct PlaneFit {
+    bool ok;                     ///< A plane was fitted (false = use the mean)
+    uint16_t axis_distance_mm;   ///< Plane distance along the sensor axis
+    uint8_t inlier_count;        ///< Zones within the threshold of the plane
+    float tilt_x_deg;            ///< Floor tilt across columns
+    float tilt_y_deg;            ///< Floor tilt across rows
+    float residual_mm;           ///< RMS distance of the inliers from the plane
+};
+
+/**
+ * @class FixedFloorPlaneEstimator
+ * @brief RANSAC + least-squares plane fit over a GridSize x GridSize zone grid
+ *
+ * Usage:
+ *   FloorPlaneEstimator plane;
+ *   PlaneFit fit = plane.fit(zoneIndex, distance, count, thresholdMm, medianMm);
+ *   if (fit.ok) consensusMm = fit.axis_distance_mm;
+ *
+ * @tparam GridSize Zones per side (4 or 8)
+ */
+template <uint8_t GridSize>
+class FixedFloorPlaneEstimator {
+public:
+    /// Zones in the grid
+    static constexpr uint8_t ZONES = GridSize * GridSize;
+
+    /**
+     * @param fovDeg Field of view across the grid (square)
+     * @param iterations RANSAC hypotheses per frame
+     */
+    explicit FixedFloorPlaneEstimator(float fovDeg = SENSOR_FOV_DEG,
+                                      uint8_t iterations = PLANE_FIT_RANSAC_ITERATIONS)
+        : iterations_(iterations) {
+        const float pitch = fovDeg / GridSize * 3.14159265f / 180.0f;
+        const float center = (GridSize - 1) / 2.0f;
+        for (uint8_t zone = 0; zone < ZONES; zone++) {
+            tx_[zone] = tanf((zone % GridSize - center) * pitch);
+            ty_[zone] = tanf((zone / GridSize - center) * pitch);
+        }
+    }
+
+    /**
+     * @brief Fit the floor plane to the valid zones of one frame
+     *
+     * @param zones Zone index of each valid distance
+     * @param distances Valid zone distances in mm (non-zero)
+     * @param count Number of valid zones
+     * @param thresholdMm Largest distance of an inlier from the plane
+     * @param referenceMm Scale for the fit (the frame median)
+     * @return PlaneFit ok = false if fewer than 3 zones or no plane found
+     */
+    PlaneFit fit(const uint8_t* zones, const uint16_t* distances, uint8_t count,
+                 uint16_t thresholdMm, uint16_t referenceMm) const {
+        PlaneFit result = {false, 0, 0, 0.0f, 0.0f, 0.0f};
+        if (count < 3 || referenceMm == 0) {
+            return result;
+        }
+        if (count > ZONES) {
+            count = ZONES;
+        }
+
+        // Per zone: scaled inverse distance, ray tangents and the
+        // threshold in u (|du| = u * dz / z)
+        const float scale = static_cast<float>(referenceMm);
+        float u[ZONES];
+        float x[ZONES];
+        float y[ZONES];
+        float tol[ZONES];
+        for (uint8_t i = 0; i < count; i++) {
+            float z = static_cast<float>(distances[i]);
+            u[i] = scale / z;
+            x[i] = tx_[zones[i]];
+            y[i] = ty_[zones[i]];
+            tol[i] = u[i] * thresholdMm / z;
+        }
+
+        // Step 1: RANSAC over 3-zone planes
+        uint32_t seed = 1;
+        uint8_t bestCount = 0;
+        float bestP = 0.0f;
+        float bestQ = 0.0f;
+        float bestR = 0.0f;
+        for (uint8_t it = 0; it < iterations_ && bestCount < count; it++) {
+            uint8_t a = next(seed) % count;
+            uint8_t b = (a + 1 + next(seed) % (count - 1)) % count;
+            uint8_t c = next(seed) % count;
+            if (c == a || c == b) {
+                continue;
+            }
+
+            float dxb = x[b] - x[a], dyb = y[b] - y[a], dub = u[b] - u[a];
+            float dxc = x[c] - x[a], dyc = y[c] - y[a], duc = u[c] - u[a];
+            float det = dxb * dyc - dxc * dyb;
+            if (fabsf(det) < 1e-6f) {
+                continue;  // Collinear zones (same row, column or diagonal)
+            }
+            float q = (dub * dyc - duc * dyb) / det;
+            float r = (dxb * duc - dxc * dub) / det;
+            float p = u[a] - q * x[a] - r * y[a];
+
+            uint8_t inliers = 0;
+            for (uint8_t i = 0; i < count; i++) {
+                inliers += (fabsf(u[i] - (p + q * x[i] + r * y[i])) <= tol[i]) ? 1 : 0;
+            }
+            if (inliers > bestCount) {
+                bestCount = inliers;
+                bestP = p;
+                bestQ = q;
+                bestR = r;
+            }
+        }
+        if (bestCount < 3) {
+            return result;
+        }
+
+        // Step 2: least squares over the inliers, centered so the slopes
+        // come from a 2x2 system
+        float n = 0.0f, mx = 0.0f, my = 0.0f, mu = 0.0f;
+        bool inlier[ZONES];
+        for (uint8_t i = 0; i < count; i++) {
+            inlier[i] = fabsf(u[i] - (bestP + bestQ * x[i] + bestR * y[i])) <= tol[i];
+            if (inlier[i]) {
+                n += 1.0f;
+                mx += x[i];
+                my += y[i];
+                mu += u[i];
+            }
+        }
+        mx /= n;
+        my /= n;
+        mu /= n;
+        float cxx = 0.0f, cyy = 0.0f, cxy = 0.0f, cxu = 0.0f, cyu = 0.0f;
+        for (uint8_t i = 0; i < count; i++) {
+            if (!inlier[i]) {
+                continue;
+            }
+            float dx = x[i] - mx, dy = y[i] - my, du = u[i] - mu;
+            cxx += dx * dx;
+            cyy += dy * dy;
+            cxy += dx * dy;
+            cxu += dx * du;
+            cyu += dy * du;
+        }
+        float q = bestQ;
+        float r = bestR;
+        float det = cxx * cyy - cxy * cxy;
+        if (det > 1e-9f) {
+            q = (cxu * cyy - cyu * cxy) / det;
+            r = (cyu * cxx - cxu * cxy) / det;
+        }
+        float p = mu - q * mx - r * my;
+        if (p <= 0.0f) {
+            return result;
+        }
+
+        float sumSq = 0.0f;
+        for (uint8_t i = 0; i < count; i++) {
+            if (inlier[i]) {
+                float e = distances[i] - scale / (p + q * x[i] + r * y[i]);
+                sumSq += e * e;
+            }
+        }
+
+        float axis = scale / p + 0.5f;
+        result.ok = axis < 65535.0f;
+        result.axis_distance_mm = result.ok ? static_cast<uint16_t>(axis) : 0;
+        result.inlier_count = static_cast<uint8_t>(n);
+        result.tilt_x_deg = atan2f(q, p) * 180.0f / 3.14159265f;
+        result.tilt_y_deg = atan2f(r, p) * 180.0f / 3.14159265f;
+        result.residual_mm = sqrtf(sumSq / n);
+        return result;
+    }
+
+    /**
+     * @brief Tangent of a zone's ray across columns (tests, diagnostics)
+     */
+    float rayX(uint8_t zone) const { return zone < ZONES ? tx_[zone] : 0.0f; }
+
+    /**
+     * @brief Tangent of a zone's ray across rows (tests, diagnostics)
+     */
+    float rayY(uint8_t zone) const { return zone < ZONES ? ty_[zone] : 0.0f; }
+
+private:
+    static uint32_t next(uint32_t& seed) {
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 16;
+    }
+
+    float tx_[ZONES];
+    float ty_[ZONES];
+    uint8_t iterations_;
+};
+
+/**
+ * Estimator sized for the build's zone grid (see SENSOR_ZONES_8X8)
+ */
+typedef FixedFloorPlaneEstimator<MULTI_ZONE_GRID_SIZE> FloorPlaneEstimator;
+
+#endif // FLOOR_PLANE_H
@@ -0,0 +1,313 @@
+/**
+ * @file FrameTrace.h
+ * @brief Compact binary trace of raw per-zone sensor frames
+ *
+ * Keeps the input of the consensus stage (target status and distance of
+ * every zone, frame timestamp and frame counter) so field problems can be
+ * replayed offline against the real filter code.
+ *
+ * Layout (all multi-byte fields little-endian):
+ *
+ *   Header (FRAME_TRACE_HEADER_BYTES)
+ *     0  magic "DTRC"
+ *     4  version (FRAME_TRACE_VERSION)
+ *     5  zone count (16 or 64)
+ *     6  reserved (0, 0)
+ *     8  zone mask at recording start (uint64, bit n = zone n masked)
+ *
+ *   Frame, deltas against the previous frame in the trace (zeros before
+ *   the first one):
+ *     varint   timestamp delta in us (mod 2^32)
+ *     varint   frame counter delta (mod 2^32, > 1 = frames not traced)
+ *     bitmap   zones/8 bytes, bit n = status of zone n changed
+ *     bytes    new status of each changed zone, in zone order
+ *     varint   zigzag(distance - previous distance) for every zone
+ *
+ * A desk at rest costs about 1 byte per zone, so a 4x4 frame is ~22 bytes
+ * instead of 56 raw.
+ *
+ * Header-only so native tests and replay use this file directly.
+ */
+
+#ifndef FRAME_TRACE_H
+#define FRAME_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+constexpr uint8_t FRAME_TRACE_VERSION = 1;
+constexpr uint8_t FRAME_TRACE_MAX_ZONES = 64;
+constexpr size_t FRAME_TRACE_HEADER_BYTES = 16;
+
+/// Worst case: two 5-byte varints, bitmap, every status, 3-byte distance deltas
+constexpr size_t FRAME_TRACE_MAX_FRAME_BYTES =
+    5 + 5 + FRAME_TRACE_MAX_ZONES / 8 + FRAME_TRACE_MAX_ZONES + FRAME_TRACE_MAX_ZONES * 3;
+
+/**
+ * @struct TraceFrame
+ * @brief One sensor frame as recorded
+ */
+struct TraceFrame {
+    uint32_t timestamp_us;                      ///< Data-ready time (micros())
+    uint32_t frame_counter;                     ///< Reading sequence number
+    uint8_t status[FRAME_TRACE_MAX_ZONES];      ///< Target status per zone
+    int16_t distance_mm[FRAME_TRACE_MAX_ZONES]; ///< Distance per zone
+};
+
+namespace FrameTrace {
+
+/**
+ * @brief Append an unsigned LEB128 varint
+ * @return size_t Bytes written (1-5)
+ */
+inline size_t putVarint(uint32_t value, uint8_t* out) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = static_cast<uint8_t>(value);
+    return n;
+}
+
+/**
+ * @brief Read an unsigned LEB128 varint
+ * @param data Input
+ * @param size Bytes available
+ * @param value Decoded value
+ * @return size_t Bytes consumed, 0 if truncated or longer than 5 bytes
+ */
+inline size_t getVarint(const uint8_t* data, size_t size, uint32_t& value) {
+    value = 0;
+    for (size_t n = 0; n < size && n < 5; n++) {
+        value |= static_cast<uint32_t>(data[n] & 0x7F) << (7 * n);
+        if ((data[n] & 0x80) == 0) {
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+/// Map signed to unsigned so small magnitudes stay small (0, -1, 1, -2 -> 0, 1, 2, 3)
+inline uint32_t zigzag(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+inline int32_t unzigzag(uint32_t value) {
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+} // namespace FrameTrace
+
+/**
+ * @class FrameTraceEncoder
+ * @brief Delta-encodes frames against the last accepted one
+ *
+ * encode() does not advance the state; call accept() once the bytes are
+ * actually stored, so a frame dropped on a full buffer never breaks the
+ * delta chain (the frame counter shows the gap instead).
+ *
+ * Usage:
+ *   encoder.reset(16, mask);
+ *   size_t n = encoder.encodeHeader(buf);
+ *   // per frame:
+ *   n = encoder.encode(frame, buf);
+ *   if (store(buf, n)) encoder.accept(frame);
+ */
+class FrameTraceEncoder {
+public:
+    FrameTraceEncoder() { reset(16, 0); }
+
+    /**
+     * @brief Start a new trace
+     * @param zones Zones per frame (16 or 64)
+     * @param mask Zone mask recorded in the header
+     */
+    void reset(uint8_t zones, uint64_t mask) {
+        zones_ = (zones > FRAME_TRACE_MAX_ZONES) ? FRAME_TRACE_MAX_ZONES : zones;
+        mask_ = mask;
+        memset(&prev_, 0, sizeof(prev_));
+    }
+
+    uint8_t getZones() const { return zones_; }
+
+    /**
+     * @brief Write the file header
+     * @param out At least FRAME_TRACE_HEADER_BYTES
+     * @return size_t FRAME_TRACE_HEADER_BYTES
+     */
+    size_t encodeHeader(uint8_t* out) const {
+        out[0] = 'D';
+        out[1] = 'T';
+        out[2] = 'R';
+        out[3] = 'C';
+        out[4] = FRAME_TRACE_VERSION;
+        out[5] = zones_;
+        out[6] = 0;
+        out[7] = 0;
+        for (uint8_t i = 0; i < 8; i++) {
+            out[8 + i] = static_cast<uint8_t>(mask_ >> (8 * i));
+        }
+        return FRAME_TRACE_HEADER_BYTES;
+    }
+
+    /**
+     * @brief Encode one frame against the last accepted frame
+     * @param frame Frame to encode (first getZones() zones)
+     * @param out At least FRAME_TRACE_MAX_FRAME_BYTES
+     * @return size_t Bytes written
+     */
+    size_t encode(const TraceFrame& frame, uint8_t* out) const {
+        size_t n = 0;
+        n += FrameTrace::putVarint(frame.timestamp_us - prev_.timestamp_us, out + n);
+        n += FrameTrace::putVarint(frame.frame_counter - prev_.frame_counter, out + n);
+
+        uint8_t* bitmap = out + n;
+        const uint8_t bitmapBytes = zones_ / 8;
+        memset(bitmap, 0, bitmapBytes);
+        n += bitmapBytes;
+        for (uint8_t zone = 0; zone < zones_; zone++) {
+            if (frame.status[zone] != prev_.status[zone]) {
+                bitmap[zone / 8] |= static_cast<uint8_t>(1 << (zone % 8));
+                out[n++] = frame.status[zone];
+            }
+        }
+
+        for (uint8_t zone = 0; zone < zones_; zone++) {
+            int32_t delta = static_cast<int32_t>(frame.distance_mm[zone]) - prev_.distance_mm[zone];
+            n += FrameTrace::putVarint(FrameTrace::zigzag(delta), out + n);
+        }
+        return n;
+    }
+
+    /**
+     * @brief Make frame the reference for the next encode()
+     */
+    void accept(const TraceFrame& frame) {
+        prev_ = frame;
+    }
+
+private:
+    uint8_t zones_;
+    uint64_t mask_;
+    TraceFrame prev_;
+};
+
+/**
+ * @class FrameTraceReader
+ * @brief Decodes a trace held in memory
+ *
+ * Usage:
+ *   FrameTraceReader reader(data, size);
+ *   if (!reader.isValid()) ...;
+ *   TraceFrame frame;
+ *   while (reader.next(frame)) { ... }
+ *   if (reader.isTruncated()) ...;   // recording cut mid-frame
+ */
+class FrameTraceReader {
+public:
+    /**
+     * @brief Parse the header of a trace
+     * @param data Trace bytes (must outlive the reader)
+     * @param size Byte count
+     */
+    FrameTraceReader(const uint8_t* data, size_t size)
+        : data_(data)
+        , size_(size)
+        , pos_(0)
+        , zones_(0)
+        , mask_(0)
+        , truncated_(false)
+    {
+        memset(&prev_, 0, sizeof(prev_));
+        if (size < FRAME_TRACE_HEADER_BYTES || memcmp(data, "DTRC", 4) != 0 ||
+            data[4] != FRAME_TRACE_VERSION ||
+            (data[5] != 16 && data[5] != FRAME_TRACE_MAX_ZONES)) {
+            return;
+        }
+        zones_ = data[5];
+        for (uint8_t i = 0; i < 8; i++) {
+            mask_ |= static_cast<uint64_t>(data[8 + i]) << (8 * i);
+        }
+        pos_ = FRAME_TRACE_HEADER_BYTES;
+    }
+
+    /**
+     * @brief Check if the header was recognised
+     */
+    bool isValid() const { return zones_ != 0; }
+
+    uint8_t getZones() const { return zones_; }      ///< Zones per frame
+    uint64_t getZoneMask() const { return mask_; }   ///< Mask at recording start
+
+    /**
+     * @brief Check if decoding stopped on an incomplete frame
+     */
+    bool isTruncated() const { return truncated_; }
+
+    /**
+     * @brief Decode the next frame
+     * @param frame Receives the frame (first getZones() zones)
+     * @return false at end of trace or on an incomplete frame
+     */
+    bool next(TraceFrame& frame) {
+        if (!isValid() || pos_ >= size_) {
+            return false;
+        }
+
+        const uint8_t* p = data_ + pos_;
+        const size_t avail = size_ - pos_;
+        size_t n = 0;
+        uint32_t value;
+        size_t used;
+
+        if ((used = FrameTrace::getVarint(p + n, avail - n, value)) == 0) return fail();
+        frame.timestamp_us = prev_.timestamp_us + value;
+        n += used;
+        if ((used = FrameTrace::getVarint(p + n, avail - n, value)) == 0) return fail();
+        frame.frame_counter = prev_.frame_counter + value;
+        n += used;
+
+        const uint8_t bitmapBytes = zones_ / 8;
+        if (avail - n < bitmapBytes) return fail();
+        const uint8_t* bitmap = p + n;
+        n += bitmapBytes;
+        for (uint8_t zone = 0; zone < zones_; zone++) {
+            if (bitmap[zone / 8] & (1 << (zone % 8))) {
+                if (n >= avail) return fail();
+                frame.status[zone] = p[n++];
+            } else {
+                frame.status[zone] = prev_.status[zone];
+            }
+        }
+
+        for (uint8_t zone = 0; zone < zones_; zone++) {
+            if ((used = FrameTrace::getVarint(p + n, avail - n, value)) == 0) return fail();
+            frame.distance_mm[zone] =
+                static_cast<int16_t>(prev_.distance_mm[zone] + FrameTrace::unzigzag(value));
+            n += used;
+        }
+
+        pos_ += n;
+        prev_ = frame;
+        return true;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_;
+    uint8_t zones_;
+    uint64_t mask_;
+    bool truncated_;
+    TraceFrame prev_;
+
+    bool fail() {
+        truncated_ = true;
+        pos_ = size_;
+        return false;
+    }
+};
+
+#endif // FRAME_TRACE_H
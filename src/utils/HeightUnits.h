@@ -0,0 +1,126 @@
+/**
+ * @file HeightUnits.h
+ * @brief Millimeter height arithmetic and cm conversion at the API edge
+ *
+ * The height pipeline (readings, targets, calibration offset, presets)
+ * works in integer millimeters. Centimeters only appear where values
+ * enter or leave the device (HTTP/SSE JSON, log messages, the cm-based
+ * min/max limits), so tolerance checks are not quantized to 1 cm steps.
+ *
+ * Header-only so native tests can include it directly.
+ */
+
+#ifndef HEIGHT_UNITS_H
+#define HEIGHT_UNITS_H
+
+#include <stdint.h>
+
+namespace HeightUnits {
+
+/// Millimeters per centimeter
+constexpr uint16_t MM_PER_CM = 10;
+
+/// Upper clamp for a calculated height (2 m)
+constexpr int32_t MAX_HEIGHT_MM = 2000;
+
+/**
+ * @brief Convert an API centimeter value to millimeters
+ * @param cm Height in cm (fractional allowed, e.g. 72.5)
+ * @return uint16_t Height in mm, rounded to nearest; 0 for negative input
+ */
+inline uint16_t cmToMm(float cm) {
+    if (cm <= 0.0f) {
+        return 0;
+    }
+    float mm = cm * MM_PER_CM + 0.5f;
+    if (mm >= 65535.0f) {
+        return 65535;
+    }
+    return static_cast<uint16_t>(mm);
+}
+
+/**
+ * @brief Convert millimeters to centimeters for JSON output
+ * @param mm Height in mm
+ * @return float Height in cm (format with one decimal)
+ */
+inline float mmToCm(uint16_t mm) {
+    return static_cast<float>(mm) / MM_PER_CM;
+}
+
+/**
+ * @brief Desk height from the filtered floor distance
+ *
+ * Floor-pointing sensor under the desk: distance grows as the desk rises,
+ * so height_mm = calibration_offset_mm + distance_mm.
+ *
+ * @param calibrationOffsetMm Offset from calibrate() (0 = uncalibrated)
+ * @param distanceMm Filtered sensor distance
+ * @return uint16_t Height in mm clamped to 0..MAX_HEIGHT_MM, 0 if uncalibrated
+ */
+inline uint16_t heightFromDistance(int16_t calibrationOffsetMm, uint16_t distanceMm) {
+    if (calibrationOffsetMm == 0) {
+        return 0;
+    }
+    int32_t height = static_cast<int32_t>(calibrationOffsetMm) + distanceMm;
+    if (height < 0) {
+        height = 0;
+    }
+    if (height > MAX_HEIGHT_MM) {
+        height = MAX_HEIGHT_MM;
+    }
+    return static_cast<uint16_t>(height);
+}
+
+/**
+ * @brief Calibration offset for a known height and averaged distance
+ *
+ * An offset of exactly 0 would read as "uncalibrated", so it is nudged
+ * to 1 mm (well inside sensor noise).
+ *
+ * @param knownHeightMm Measured desk height
+ * @param distanceMm Averaged sensor distance at that height
+ * @return int16_t Offset in mm
+ */
+inline int16_t calibrationOffset(uint16_t knownHeightMm, uint16_t distanceMm) {
+    int32_t offset = static_cast<int32_t>(knownHeightMm) - distanceMm;
+    if (offset == 0) {
+        offset = 1;
+    }
+    if (offset < -32767) {
+        offset = -32767;
+    }
+    if (offset > 32767) {
+        offset = 32767;
+    }
+    return static_cast<int16_t>(offset);
+}
+
+/**
+ * @brief Signed distance still to travel
+ * @param targetMm Target height
+ * @param currentMm Current height
+ * @return int32_t Positive when the desk must rise
+ */
+inline int32_t errorMm(uint16_t targetMm, uint16_t currentMm) {
+    return static_cast<int32_t>(targetMm) - static_cast<int32_t>(currentMm);
+}
+
+/**
+ * @brief Check whether the current height is within tolerance of the target
+ * @param targetMm Target height
+ * @param currentMm Current height
+ * @param toleranceMm Allowed deviation (inclusive)
+ * @return true if |target - current| <= tolerance
+ */
+inline bool isWithinTolerance(uint16_t targetMm, uint16_t currentMm, uint16_t toleranceMm) {
+    int32_t diff = errorMm(targetMm, currentMm);
+    if (diff < 0) {
+        diff = -diff;
+    }
+    return diff <= static_cast<int32_t>(toleranceMm);
+}
+
+} // namespace HeightUnits
+
+#endif // HEIGHT_UNITS_H
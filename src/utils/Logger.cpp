@@ -6,16 +6,41 @@
 #include "Logger.h"
 #include <stdarg.h>
 
+// Native closed-loop tests (native_sim env) log to stdout
+#ifdef NATIVE_TEST
+#include <stdio.h>
+#define LOG_PRINTF printf
+#else
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#define LOG_PRINTF Serial.printf
+
+/**
+ * Line logged by another task, waiting for the loop task to print it
+ */
+struct QueuedLogLine {
+    unsigned long timestamp;
+    LogLevel level;
+    const char* tag;                            ///< Static string
+    char message[LOG_QUEUE_MESSAGE_MAX];
+};
+
+static QueueHandle_t logQueue = nullptr;
+static TaskHandle_t outputTask = nullptr;       ///< The only task writing to Serial
+static volatile uint32_t droppedLines = 0;
+#endif
+
 // Static member initialization
 LogLevel Logger::minLevel_ = LogLevel::INFO;
 bool Logger::serialEnabled_ = true;
 bool Logger::initialized_ = false;
-char Logger::buffer_[MAX_LOG_LENGTH];
 
 void Logger::init(LogLevel minLevel, bool serialOutput) {
     minLevel_ = minLevel;
     serialEnabled_ = serialOutput;
     
+#ifndef NATIVE_TEST
     if (serialOutput && !Serial) {
         Serial.begin(SERIAL_BAUD_RATE);
         // Wait for serial to initialize (with timeout)
@@ -25,6 +50,12 @@ void Logger::init(LogLevel minLevel, bool serialOutput) {
         }
     }
     
+    outputTask = xTaskGetCurrentTaskHandle();
+    if (logQueue == nullptr) {
+        logQueue = xQueueCreate(LOG_QUEUE_LENGTH, sizeof(QueuedLogLine));
+    }
+#endif
+    
     initialized_ = true;
     
     if (minLevel != LogLevel::NONE) {
@@ -68,6 +99,27 @@ void Logger::error(const char* tag, const char* format, ...) {
     va_end(args);
 }
 
+void Logger::flush() {
+#ifndef NATIVE_TEST
+    if (logQueue == nullptr || xTaskGetCurrentTaskHandle() != outputTask) {
+        return;
+    }
+    
+    QueuedLogLine line;
+    while (xQueueReceive(logQueue, &line, 0) == pdPASS) {
+        print(line.timestamp, line.level, line.tag, line.message);
+    }
+    
+    static uint32_t reportedDrops = 0;
+    if (droppedLines != reportedDrops) {
+        reportedDrops = droppedLines;
+        LOG_PRINTF("[%8lu] [%-5s] [%-16s] %lu log lines dropped (queue full)\n",
+                   getTimestamp(), levelToString(LogLevel::WARN), "Logger",
+                   (unsigned long)reportedDrops);
+    }
+#endif
+}
+
 void Logger::setLevel(LogLevel level) {
     minLevel_ = level;
 }
@@ -93,16 +145,37 @@ void Logger::log(LogLevel level, const char* tag, const char* format, va_list ar
     // Format: [timestamp] [LEVEL] [tag] message
     unsigned long timestamp = getTimestamp();
     
-    // Build the message
-    vsnprintf(buffer_, MAX_LOG_LENGTH - 1, format, args);
-    buffer_[MAX_LOG_LENGTH - 1] = '\0';  // Ensure null termination
+    // Build the message on the caller's stack: tasks log concurrently
+    char buffer[MAX_LOG_LENGTH];
+    vsnprintf(buffer, MAX_LOG_LENGTH - 1, format, args);
+    buffer[MAX_LOG_LENGTH - 1] = '\0';  // Ensure null termination
     
-    // Print to serial
-    Serial.printf("[%8lu] [%-5s] [%-16s] %s\n", 
-                  timestamp, 
-                  levelToString(level), 
-                  tag, 
-                  buffer_);
+#ifndef NATIVE_TEST
+    // Other tasks never touch Serial: queue for loop(), never wait
+    if (logQueue != nullptr && xTaskGetCurrentTaskHandle() != outputTask) {
+        QueuedLogLine line;
+        line.timestamp = timestamp;
+        line.level = level;
+        line.tag = tag;
+        strncpy(line.message, buffer, sizeof(line.message) - 1);
+        line.message[sizeof(line.message) - 1] = '\0';
+        if (xQueueSend(logQueue, &line, 0) != pdPASS) {
+            droppedLines++;
+        }
+        return;
+    }
+    flush();
+#endif
+    
+    print(timestamp, level, tag, buffer);
+}
+
+void Logger::print(unsigned long timestamp, LogLevel level, const char* tag, const char* message) {
+    LOG_PRINTF("[%8lu] [%-5s] [%-16s] %s\n", 
+               timestamp, 
+               levelToString(level), 
+               tag, 
+               message);
 }
 
 unsigned long Logger::getTimestamp() {
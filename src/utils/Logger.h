@@ -4,6 +4,12 @@
  * 
  * Provides structured logging with multiple severity levels.
  * Serial output enabled by default, optional SD card logging.
+ * 
+ * Only the task that called init() (the Arduino loop task) writes to
+ * Serial, which blocks once the UART FIFO is full. Other tasks - the
+ * control and acquisition tasks, AsyncTCP - format the line on their own
+ * stack and queue it; loop() prints the queue with flush(). A line from
+ * the loop task flushes the queue first, so lines keep their order.
  */
 
 #ifndef LOGGER_H
@@ -32,6 +38,10 @@ enum class LogLevel : uint8_t {
  *   Logger::init(LogLevel::INFO);
  *   Logger::info("HeightController", "Sensor initialized");
  *   Logger::error("WiFiManager", "Connection failed: %s", ssid);
+ *   // In loop:
+ *   Logger::flush();
+ * 
+ * Tags must be static strings: queued lines keep the pointer.
  */
 class Logger {
 public:
@@ -39,9 +49,16 @@ public:
      * @brief Initialize the logger
      * @param minLevel Minimum level to output (messages below this are ignored)
      * @param serialOutput Enable serial output (default: true)
+     * 
+     * Call from the task that will call flush().
      */
     static void init(LogLevel minLevel = LogLevel::INFO, bool serialOutput = true);
     
+    /**
+     * @brief Print the lines other tasks queued (loop() only)
+     */
+    static void flush();
+    
     /**
      * @brief Log a debug message
      * @param tag Module/component name
@@ -92,14 +109,13 @@ public:
      * @return const char* Level name ("DEBUG", "INFO", etc.)
      */
     static const char* levelToString(LogLevel level);
-
+    
 private:
     static LogLevel minLevel_;
     static bool serialEnabled_;
     static bool initialized_;
     
-    static const uint16_t MAX_LOG_LENGTH = 256;
-    static char buffer_[MAX_LOG_LENGTH];
+    static const uint16_t MAX_LOG_LENGTH = 256;    ///< Per-call stack buffer
     
     /**
      * @brief Internal log function
@@ -110,6 +126,11 @@ private:
      */
     static void log(LogLevel level, const char* tag, const char* format, va_list args);
     
+    /**
+     * @brief Write one formatted line to Serial
+     */
+    static void print(unsigned long timestamp, LogLevel level, const char* tag, const char* message);
+    
     /**
      * @brief Get current timestamp in milliseconds
      * @return unsigned long Timestamp
@@ -0,0 +1,202 @@
+/**
+ * @file MedianSelect.h
+ * @brief Median selection kernel for multi-zone consensus
+ *
+ * Replaces the per-frame insertion sort in HeightController::computeMedian.
+ * Two paths, both returning the lower middle element for even counts
+ * (index (count - 1) / 2 of the sorted values):
+ *
+ *   - count <= 16: pad to 16 with UINT16_MAX and run a fixed 60-comparator
+ *     sorting network (Green, 10 layers). Cost is constant and branch-light
+ *     regardless of input order. Padding sorts to the end, so the index of
+ *     the lower median is unchanged.
+ *   - count > 16 (8x8 mode): in-place quickselect with median-of-three
+ *     pivot, O(n) average. Only partially reorders the input.
+ *
+ * Header-only so native tests can include it directly.
+ */
+
+#ifndef MEDIAN_SELECT_H
+#define MEDIAN_SELECT_H
+
+#include <stdint.h>
+
+namespace MedianSelect {
+
+/// Largest count handled by the sorting network path
+constexpr uint8_t NETWORK_SIZE = 16;
+
+/**
+ * @brief Compare-exchange: after the call a <= b
+ */
+inline void compareExchange(uint16_t& a, uint16_t& b) {
+    const uint16_t lo = (a < b) ? a : b;
+    const uint16_t hi = (a < b) ? b : a;
+    a = lo;
+    b = hi;
+}
+
+/**
+ * @brief Sort exactly 16 values in place with a fixed sorting network
+ * @param v Array of NETWORK_SIZE values
+ */
+inline void sortNetwork16(uint16_t* v) {
+    // Unrolled so the compiler can keep values in registers (min/max, no branches)
+    // Layer 1
+    compareExchange(v[0], v[13]);
+    compareExchange(v[1], v[12]);
+    compareExchange(v[2], v[15]);
+    compareExchange(v[3], v[14]);
+    compareExchange(v[4], v[8]);
+    compareExchange(v[5], v[6]);
+    compareExchange(v[7], v[11]);
+    compareExchange(v[9], v[10]);
+    // Layer 2
+    compareExchange(v[0], v[5]);
+    compareExchange(v[1], v[7]);
+    compareExchange(v[2], v[9]);
+    compareExchange(v[3], v[4]);
+    compareExchange(v[6], v[13]);
+    compareExchange(v[8], v[14]);
+    compareExchange(v[10], v[15]);
+    compareExchange(v[11], v[12]);
+    // Layer 3
+    compareExchange(v[0], v[1]);
+    compareExchange(v[2], v[3]);
+    compareExchange(v[4], v[5]);
+    compareExchange(v[6], v[8]);
+    compareExchange(v[7], v[9]);
+    compareExchange(v[10], v[11]);
+    compareExchange(v[12], v[13]);
+    compareExchange(v[14], v[15]);
+    // Layer 4
+    compareExchange(v[0], v[2]);
+    compareExchange(v[1], v[3]);
+    compareExchange(v[4], v[10]);
+    compareExchange(v[5], v[11]);
+    compareExchange(v[6], v[7]);
+    compareExchange(v[8], v[9]);
+    compareExchange(v[12], v[14]);
+    compareExchange(v[13], v[15]);
+    // Layer 5
+    compareExchange(v[1], v[2]);
+    compareExchange(v[3], v[12]);
+    compareExchange(v[4], v[6]);
+    compareExchange(v[5], v[7]);
+    compareExchange(v[8], v[10]);
+    compareExchange(v[9], v[11]);
+    compareExchange(v[13], v[14]);
+    // Layer 6
+    compareExchange(v[1], v[4]);
+    compareExchange(v[2], v[6]);
+    compareExchange(v[5], v[8]);
+    compareExchange(v[7], v[10]);
+    compareExchange(v[9], v[13]);
+    compareExchange(v[11], v[14]);
+    // Layer 7
+    compareExchange(v[2], v[4]);
+    compareExchange(v[3], v[6]);
+    compareExchange(v[9], v[12]);
+    compareExchange(v[11], v[13]);
+    // Layer 8
+    compareExchange(v[3], v[5]);
+    compareExchange(v[6], v[8]);
+    compareExchange(v[7], v[9]);
+    compareExchange(v[10], v[12]);
+    // Layer 9
+    compareExchange(v[3], v[4]);
+    compareExchange(v[5], v[6]);
+    compareExchange(v[7], v[8]);
+    compareExchange(v[9], v[10]);
+    compareExchange(v[11], v[12]);
+    // Layer 10
+    compareExchange(v[6], v[7]);
+    compareExchange(v[8], v[9]);
+}
+
+/**
+ * @brief Select the k-th smallest value (0-based) by quickselect
+ *
+ * Partially reorders values in place.
+ *
+ * @param values Array of count values (modified)
+ * @param count Number of elements (>= 1)
+ * @param k Rank to select (< count)
+ * @return k-th smallest value
+ */
+inline uint16_t quickSelect(uint16_t* values, uint8_t count, uint8_t k) {
+    int16_t left = 0;
+    int16_t right = static_cast<int16_t>(count) - 1;
+
+    while (left < right) {
+        // Median-of-three pivot guards against sorted / reversed input
+        const int16_t mid = left + (right - left) / 2;
+        if (values[mid] < values[left]) {
+            compareExchange(values[mid], values[left]);
+        }
+        if (values[right] < values[left]) {
+            compareExchange(values[right], values[left]);
+        }
+        if (values[right] < values[mid]) {
+            compareExchange(values[right], values[mid]);
+        }
+        const uint16_t pivot = values[mid];
+
+        // Hoare partition
+        int16_t i = left;
+        int16_t j = right;
+        while (i <= j) {
+            while (values[i] < pivot) i++;
+            while (values[j] > pivot) j--;
+            if (i <= j) {
+                const uint16_t tmp = values[i];
+                values[i] = values[j];
+                values[j] = tmp;
+                i++;
+                j--;
+            }
+        }
+
+        if (k <= j) {
+            right = j;
+        } else if (k >= i) {
+            left = i;
+        } else {
+            return values[k];
+        }
+    }
+    return values[k];
+}
+
+/**
+ * @brief Lower median of an array (lower middle for even counts)
+ *
+ * @param values Array of distances (may be reordered when count > 16)
+ * @param count Number of elements
+ * @return Median value, or 0 for an empty array
+ */
+inline uint16_t lowerMedian(uint16_t* values, uint8_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    if (count == 1) {
+        return values[0];
+    }
+
+    const uint8_t k = (count - 1) / 2;
+
+    if (count <= NETWORK_SIZE) {
+        uint16_t padded[NETWORK_SIZE];
+        for (uint8_t i = 0; i < NETWORK_SIZE; i++) {
+            padded[i] = (i < count) ? values[i] : UINT16_MAX;
+        }
+        sortNetwork16(padded);
+        return padded[k];
+    }
+
+    return quickSelect(values, count, k);
+}
+
+} // namespace MedianSelect
+
+#endif // MEDIAN_SELECT_H
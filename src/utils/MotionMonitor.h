@@ -0,0 +1,174 @@
+/**
+ * @file MotionMonitor.h
+ * @brief Detects a stalled, runaway or reversed desk from its measured velocity
+ *
+ * The movement timeout only fires after 30 s, so a jammed desk or a dead
+ * motor driver would keep the motor powered that long. This compares the
+ * Kalman velocity estimate, frame by frame, with what the motor command
+ * says the desk should be doing:
+ *
+ *   STALL           - motor on, desk slower than MOTION_STALL_SPEED_MM_S
+ *                     in the driven direction (jam, end stop, dead driver)
+ *   WRONG_DIRECTION - motor on, desk moving the other way faster than
+ *                     MOTION_WRONG_DIRECTION_SPEED_MM_S (swapped wiring)
+ *                     before it made any progress the right way
+ *   RUNAWAY         - motor off, desk still moving in the last driven
+ *                     direction faster than MOTION_RUNAWAY_SPEED_MM_S
+ *                     (welded relay, shorted MOSFET)
+ *
+ * A condition must hold for the configured number of consecutive frames.
+ * Nothing is judged within MOTION_START_GRACE_MS of the motor switching
+ * on or reversing, or MOTION_STOP_GRACE_MS of it switching off, while the
+ * desk ramps and the velocity estimate catches up. The estimate rings the
+ * other way for about a second after a sudden stop, so once the desk has
+ * made progress under the current command a reversed velocity counts as
+ * a stall (a jam), not as a wrong direction.
+ *
+ * Pure policy (time is passed in), header-only so native tests use it
+ * directly.
+ */
+
+#ifndef MOTION_MONITOR_H
+#define MOTION_MONITOR_H
+
+#include <stdint.h>
+#include "../Config.h"
+
+/**
+ * @enum MotionFault
+ * @brief Motion that does not match the motor command
+ */
+enum class MotionFault : uint8_t {
+    NONE,               ///< Motion matches the command (or not judged yet)
+    STALL,              ///< Motor on, no progress
+    WRONG_DIRECTION,    ///< Motor on, desk moving the other way
+    RUNAWAY             ///< Motor off, desk still moving
+};
+
+/**
+ * @class MotionMonitor
+ * @brief Per-frame check of measured velocity against the motor command
+ *
+ * Usage:
+ *   monitor.onDrive(+1, millis());      // on every motor pin change
+ *   // per new frame:
+ *   MotionFault fault = monitor.update(reading.velocity_mm_s, millis());
+ *   if (fault != MotionFault::NONE) { stopMotor(); }
+ */
+class MotionMonitor {
+public:
+    /**
+     * @param faultFrames Consecutive frames a condition must hold
+     */
+    explicit MotionMonitor(uint8_t faultFrames = DEFAULT_MOTION_FAULT_FRAMES)
+        : faultFrames_(1)
+    {
+        setFaultFrames(faultFrames);
+        reset();
+    }
+
+    /**
+     * @brief Set the consecutive frames a condition must hold (at least 1)
+     */
+    void setFaultFrames(uint8_t frames) {
+        faultFrames_ = (frames == 0) ? 1 : frames;
+    }
+
+    uint8_t getFaultFrames() const { return faultFrames_; }
+
+    /**
+     * @brief Forget the drive history (motor off and at rest)
+     */
+    void reset() {
+        drive_ = 0;
+        lastDrive_ = 0;
+        driveChangeMs_ = 0;
+        progressed_ = false;
+        clearCounts();
+    }
+
+    /**
+     * @brief Record a motor command change
+     * @param drive +1 up, -1 down, 0 off
+     * @param nowMs Current time
+     */
+    void onDrive(int8_t drive, uint32_t nowMs) {
+        if (drive == drive_) {
+            return;
+        }
+        if (drive_ != 0) {
+            lastDrive_ = drive_;
+        }
+        drive_ = drive;
+        driveChangeMs_ = nowMs;
+        progressed_ = false;
+        clearCounts();
+    }
+
+    /**
+     * @brief Check one frame's velocity against the motor command
+     * @param velocityMmS Velocity estimate (positive = rising)
+     * @param nowMs Current time
+     * @return The fault once it held for the configured frames, else NONE
+     */
+    MotionFault update(int16_t velocityMmS, uint32_t nowMs) {
+        uint32_t sinceChange = nowMs - driveChangeMs_;
+        if (drive_ != 0) {
+            if (sinceChange < MOTION_START_GRACE_MS) {
+                return MotionFault::NONE;
+            }
+            int32_t along = (int32_t)velocityMmS * drive_;
+            if (along >= (int32_t)MOTION_STALL_SPEED_MM_S) {
+                progressed_ = true;
+            }
+            bool wrong = !progressed_ && along <= -(int32_t)MOTION_WRONG_DIRECTION_SPEED_MM_S;
+            count(wrong, wrongFrames_);
+            count(!wrong && along < (int32_t)MOTION_STALL_SPEED_MM_S, stallFrames_);
+            if (wrongFrames_ >= faultFrames_) {
+                return MotionFault::WRONG_DIRECTION;
+            }
+            if (stallFrames_ >= faultFrames_) {
+                return MotionFault::STALL;
+            }
+            return MotionFault::NONE;
+        }
+
+        if (lastDrive_ == 0 || sinceChange < MOTION_STOP_GRACE_MS) {
+            return MotionFault::NONE;
+        }
+        // Only the driven direction: the estimate rings back the other way
+        // for a second after a hard stop
+        int32_t along = (int32_t)velocityMmS * lastDrive_;
+        count(along >= (int32_t)MOTION_RUNAWAY_SPEED_MM_S, runawayFrames_);
+        return (runawayFrames_ >= faultFrames_) ? MotionFault::RUNAWAY : MotionFault::NONE;
+    }
+
+    int8_t getDrive() const { return drive_; }
+
+private:
+    /// Consecutive frames a condition held (saturating)
+    static void count(bool condition, uint8_t& frames) {
+        if (!condition) {
+            frames = 0;
+        } else if (frames < 255) {
+            frames++;
+        }
+    }
+
+    void clearCounts() {
+        stallFrames_ = 0;
+        wrongFrames_ = 0;
+        runawayFrames_ = 0;
+    }
+
+    uint8_t faultFrames_;
+    int8_t drive_;              ///< Current motor command
+    int8_t lastDrive_;          ///< Last non-zero command (direction a runaway would take)
+    uint32_t driveChangeMs_;
+    bool progressed_;           ///< Desk moved the right way since the command
+    uint8_t stallFrames_;
+    uint8_t wrongFrames_;
+    uint8_t runawayFrames_;
+};
+
+#endif // MOTION_MONITOR_H
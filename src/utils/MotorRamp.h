@@ -0,0 +1,230 @@
+/**
+ * @file MotorRamp.h
+ * @brief Soft-start, soft-stop and approach slow-down for the PWM motor drive
+ *
+ * Switching the motor MOSFETs fully on and off starts the desk with a jolt
+ * and stops it hard, and the coast after the cut depends on the full
+ * speed the desk happened to reach. In DriveMode::PWM the duty follows
+ * this ramp instead:
+ *
+ * - start: the duty jumps to the minimum the motor turns at, then rises
+ *   to full at rampUpMs per full scale
+ * - approach: within slowdownMm of the target the duty is scaled down in
+ *   proportion to the distance left, to the minimum at the target, so the
+ *   desk reaches the cut at the same low speed every time
+ * - stop: the duty falls at rampDownMs per full scale and drops to zero
+ *   once below the minimum
+ * - reverse: the old direction is cut, both stay at zero for the reverse
+ *   rest, then the new direction soft-starts from the minimum. LEDC
+ *   latches a duty at the end of the PWM period, so writing one channel
+ *   off and the other on back to back could drive both MOSFETs for up to
+ *   a period; the rest spans thousands of periods and lets the desk coast
+ *   to a stop
+ * - cut: zero at once (faults, emergency stop)
+ *
+ * Duty is in permille (0-1000); MovementController scales it to the LEDC
+ * resolution. The ramp is stepped by the control loop, so its steps are
+ * one control period apart.
+ *
+ * Pure policy (time is passed in), header-only so native tests use it
+ * directly.
+ */
+
+#ifndef MOTOR_RAMP_H
+#define MOTOR_RAMP_H
+
+#include <stdint.h>
+
+/**
+ * @class MotorRamp
+ * @brief Duty for one motor direction from ramp limits and distance to go
+ *
+ * Usage:
+ *   ramp.configure(400, 250, 50, 500, 200);
+ *   ramp.start(+1, millis());                       // motor on
+ *   // every control tick:
+ *   uint16_t duty = ramp.update(millis(), remainingMm);
+ *   ramp.stop(millis());                            // soft stop
+ */
+class MotorRamp {
+public:
+    static constexpr uint16_t FULL_DUTY = 1000;     ///< Permille
+
+    MotorRamp()
+        : rampUpMs_(0)
+        , rampDownMs_(0)
+        , slowdownMm_(0)
+        , minDuty_(0)
+        , reverseRestMs_(0)
+        , direction_(0)
+        , pending_(0)
+        , restSinceMs_(0)
+        , stopping_(false)
+        , duty_(0)
+        , lastMs_(0)
+        , carry_(0)
+    {
+    }
+
+    /**
+     * @param rampUpMs Time from zero to full duty (0 = no ramp)
+     * @param rampDownMs Time from full to zero duty (0 = no ramp)
+     * @param slowdownMm Distance to the target the slow-down starts at (0 = off)
+     * @param minDuty Lowest duty the motor turns at, permille
+     * @param reverseRestMs Time at zero duty between directions
+     */
+    void configure(uint16_t rampUpMs, uint16_t rampDownMs, uint16_t slowdownMm, uint16_t minDuty,
+                   uint16_t reverseRestMs) {
+        rampUpMs_ = rampUpMs;
+        rampDownMs_ = rampDownMs;
+        slowdownMm_ = slowdownMm;
+        minDuty_ = (minDuty > FULL_DUTY) ? FULL_DUTY : minDuty;
+        reverseRestMs_ = reverseRestMs;
+    }
+
+    /**
+     * @brief Drive in a direction with a soft start
+     *
+     * Already driving that way: carries on from the current duty. Driving
+     * (or soft stopping) the other way: the old direction is cut at once
+     * and the new one waits out the reverse rest in update().
+     *
+     * @param direction +1 up, -1 down
+     * @param nowMs Current time
+     */
+    void start(int8_t direction, uint32_t nowMs) {
+        if (pending_ != 0) {
+            pending_ = direction;   // Already resting: the rest runs on
+            return;
+        }
+        if (direction_ != 0 && direction != direction_) {
+            cut();
+            pending_ = direction;
+            restSinceMs_ = nowMs;
+            return;
+        }
+        direction_ = direction;
+        stopping_ = false;
+        if (duty_ < minDuty_) {
+            duty_ = minDuty_;
+        }
+        lastMs_ = nowMs;
+        carry_ = 0;
+    }
+
+    /**
+     * @brief Ramp down to zero (soft stop)
+     */
+    void stop(uint32_t nowMs) {
+        pending_ = 0;
+        if (direction_ == 0) {
+            return;
+        }
+        if (!stopping_) {
+            stopping_ = true;
+            lastMs_ = nowMs;
+            carry_ = 0;
+        }
+    }
+
+    /**
+     * @brief Zero at once
+     */
+    void cut() {
+        direction_ = 0;
+        pending_ = 0;
+        stopping_ = false;
+        duty_ = 0;
+    }
+
+    /**
+     * @brief Step the duty to now
+     * @param nowMs Current time
+     * @param remainingMm Distance left to the target in the direction of travel
+     * @return Duty in permille for getDirection()
+     */
+    uint16_t update(uint32_t nowMs, int32_t remainingMm) {
+        if (pending_ != 0) {
+            // Strictly more: at least reverseRestMs has really passed,
+            // whatever the phase of the millisecond clock at the cut
+            if (nowMs - restSinceMs_ <= reverseRestMs_) {
+                return 0;
+            }
+            int8_t direction = pending_;
+            pending_ = 0;
+            start(direction, nowMs);
+            return duty_;
+        }
+        if (direction_ == 0) {
+            return 0;
+        }
+        uint32_t elapsed = nowMs - lastMs_;
+        lastMs_ = nowMs;
+
+        uint16_t target = stopping_ ? 0 : approachDuty(remainingMm);
+        if (duty_ < target) {
+            duty_ = step(duty_, target, elapsed, rampUpMs_, true);
+        } else if (duty_ > target) {
+            duty_ = step(duty_, target, elapsed, rampDownMs_, false);
+        } else {
+            carry_ = 0;
+        }
+
+        // The motor does not turn below the minimum: stop there
+        if (stopping_ && duty_ < minDuty_) {
+            cut();
+        }
+        return duty_;
+    }
+
+    /**
+     * @brief Duty the approach allows at a distance from the target
+     * @return Full beyond slowdownMm, falling linearly to the minimum at the target
+     */
+    uint16_t approachDuty(int32_t remainingMm) const {
+        if (slowdownMm_ == 0 || remainingMm >= (int32_t)slowdownMm_) {
+            return FULL_DUTY;
+        }
+        if (remainingMm <= 0) {
+            return minDuty_;
+        }
+        return (uint16_t)(minDuty_ + (uint32_t)(FULL_DUTY - minDuty_) * (uint32_t)remainingMm / slowdownMm_);
+    }
+
+    int8_t getDirection() const { return direction_; }     ///< Direction driven (0 once at zero)
+    bool isReversing() const { return pending_ != 0; }      ///< Resting before the other direction
+    uint16_t getDuty() const { return duty_; }              ///< Current duty, permille
+    bool isStopping() const { return stopping_; }           ///< Soft stop in progress
+
+private:
+    /// Move toward target by at most elapsed / rampMs of full scale; the
+    /// fraction of a permille left over carries to the next step, so short
+    /// control periods do not slow the ramp
+    uint16_t step(uint16_t duty, uint16_t target, uint32_t elapsedMs, uint16_t rampMs, bool rising) {
+        uint32_t change = FULL_DUTY;
+        if (rampMs != 0) {
+            carry_ += (uint32_t)FULL_DUTY * elapsedMs;
+            change = carry_ / rampMs;
+            carry_ %= rampMs;
+        }
+        if (rising) {
+            return (duty + change >= target) ? target : (uint16_t)(duty + change);
+        }
+        return (duty <= target + change) ? target : (uint16_t)(duty - change);
+    }
+
+    uint16_t rampUpMs_;
+    uint16_t rampDownMs_;
+    uint16_t slowdownMm_;
+    uint16_t minDuty_;
+    uint16_t reverseRestMs_;
+    int8_t direction_;          ///< +1 up, -1 down, 0 off
+    int8_t pending_;            ///< Direction to start after the reverse rest, 0 if none
+    uint32_t restSinceMs_;      ///< Cut of the old direction
+    bool stopping_;
+    uint16_t duty_;             ///< Permille
+    uint32_t lastMs_;
+    uint32_t carry_;            ///< Ramp progress below one permille, permille x ms
+};
+
+#endif // MOTOR_RAMP_H
@@ -1,12 +1,16 @@
 /**
  * @file MovingAverageFilter.h
- * @brief Circular buffer implementation of moving average filter for sensor smoothing
- * 
- * Implements a configurable-size moving average filter using a circular buffer.
+ * @brief Fixed-capacity moving average filter for sensor smoothing
+ *
+ * Circular buffer with a running sum: addSample() and getAverage() are O(1)
+ * and storage is part of the object (no heap), so the filter can be copied,
+ * assigned, or re-configured in place safely.
  * Designed for smoothing VL53L5CX distance sensor readings.
- * 
+ *
  * Per spec (FR-001a): "Moving average filter applied to smooth sensor noise"
  * Per data-model.md: Filter window size configurable (default 5, range 3-10)
+ *
+ * Header-only (template) so native tests use this file directly.
  */
 
 #ifndef MOVING_AVERAGE_FILTER_H
@@ -16,96 +20,215 @@
 #include "../Config.h"
 
 /**
- * @class MovingAverageFilter
- * @brief Implements a moving average filter using a circular buffer
- * 
+ * @class FixedMovingAverageFilter
+ * @brief Moving average over a runtime window of up to Capacity samples
+ *
  * Usage:
  *   MovingAverageFilter filter(5);  // 5-sample window
  *   filter.addSample(rawReading);
  *   uint16_t smoothed = filter.getAverage();
+ *
+ * @tparam Capacity Compile-time storage size (largest window after resize())
  */
-class MovingAverageFilter {
+template <uint8_t Capacity>
+class FixedMovingAverageFilter {
+    static_assert(Capacity >= MAX_FILTER_WINDOW_SIZE,
+                  "Capacity must hold the largest configurable window");
+    // uint8_t indices; 255 * 65535 still fits the uint32_t running sum
+    static_assert(Capacity > 0, "Capacity must be non-zero");
+
 public:
     /**
      * @brief Construct a new Moving Average Filter
      * @param windowSize Number of samples to average (clamped to MIN_FILTER_WINDOW_SIZE..MAX_FILTER_WINDOW_SIZE)
      */
-    explicit MovingAverageFilter(uint8_t windowSize = DEFAULT_FILTER_WINDOW_SIZE);
-    
-    /**
-     * @brief Destroy the Moving Average Filter
-     */
-    ~MovingAverageFilter();
-    
+    explicit FixedMovingAverageFilter(uint8_t windowSize = DEFAULT_FILTER_WINDOW_SIZE)
+        : windowSize_(clampWindowSize(windowSize))
+    {
+        reset();
+    }
+
     /**
      * @brief Add a new sample to the filter
-     * 
+     *
      * If buffer is full, oldest sample is overwritten (circular buffer behavior).
-     * 
+     *
      * @param sample Raw sensor reading (0-4000mm for VL53L5CX)
      */
-    void addSample(uint16_t sample);
-    
+    void addSample(uint16_t sample) {
+        if (sampleCount_ < windowSize_) {
+            sampleCount_++;
+        } else {
+            sum_ -= buffer_[head_];
+        }
+        buffer_[head_] = sample;
+        sum_ += sample;
+        head_ = (head_ + 1 == windowSize_) ? 0 : head_ + 1;
+    }
+
     /**
      * @brief Get the current moving average
-     * 
+     *
      * - If no samples: returns 0
      * - If partial window: returns average of available samples
      * - If full window: returns average of windowSize samples
-     * 
+     *
      * @return uint16_t Averaged value (same unit as input samples)
      */
-    uint16_t getAverage() const;
-    
+    uint16_t getAverage() const {
+        if (sampleCount_ == 0) {
+            return 0;
+        }
+        return static_cast<uint16_t>(sum_ / sampleCount_);
+    }
+
     /**
      * @brief Get the most recently added sample
      * @return uint16_t Last sample value, or 0 if empty
      */
-    uint16_t getLastSample() const;
-    
+    uint16_t getLastSample() const {
+        if (sampleCount_ == 0) {
+            return 0;
+        }
+        // head_ points to next write position; handle wrap-around
+        uint8_t lastIndex = (head_ == 0) ? (windowSize_ - 1) : (head_ - 1);
+        return buffer_[lastIndex];
+    }
+
     /**
      * @brief Get the current number of samples in buffer
      * @return uint8_t Sample count (0 to windowSize)
      */
-    uint8_t getSampleCount() const;
-    
+    uint8_t getSampleCount() const { return sampleCount_; }
+
     /**
-     * @brief Get the configured window size
-     * @return uint8_t Window size (3-10)
+     * @brief Get the current window size
+     * @return uint8_t Window size (3-10 as configured, up to Capacity after resize())
      */
-    uint8_t getWindowSize() const;
-    
+    uint8_t getWindowSize() const { return windowSize_; }
+
+    /**
+     * @brief Get the compile-time storage capacity
+     * @return uint8_t Largest window resize() accepts
+     */
+    static constexpr uint8_t capacity() { return Capacity; }
+
     /**
      * @brief Check if filter has no samples
      * @return true if no samples have been added or reset was called
      */
-    bool isEmpty() const;
-    
+    bool isEmpty() const { return sampleCount_ == 0; }
+
     /**
      * @brief Check if filter has a full window of samples
      * @return true if sampleCount >= windowSize
      */
-    bool isFull() const;
-    
+    bool isFull() const { return sampleCount_ >= windowSize_; }
+
+    /**
+     * @brief Change the window size, keeping the most recent samples
+     *
+     * Used when the sample rate changes so the filter time constant can
+     * be preserved. Unlike the constructor this is not limited to the
+     * user-configurable range.
+     *
+     * @param windowSize New window (clamped to 1..Capacity)
+     */
+    void resize(uint8_t windowSize) {
+        if (windowSize < 1) {
+            windowSize = 1;
+        }
+        if (windowSize > Capacity) {
+            windowSize = Capacity;
+        }
+        if (windowSize == windowSize_) {
+            return;
+        }
+
+        // Gather the newest samples oldest-first, then lay them out from
+        // index 0 exactly as if they had been added to the new window
+        uint16_t kept[Capacity];
+        uint8_t keep = getSamples(kept, windowSize);
+
+        windowSize_ = windowSize;
+        reset();
+        for (uint8_t i = 0; i < keep; i++) {
+            addSample(kept[i]);
+        }
+    }
+
+    /**
+     * @brief Copy the newest samples, oldest first
+     *
+     * Feeding the result to addSample() in order rebuilds the same window
+     * (used by resize() and to retain the filter across a warm restart).
+     *
+     * @param out Receives up to maxCount samples
+     * @param maxCount Capacity of out
+     * @return uint8_t Number of samples copied
+     */
+    uint8_t getSamples(uint16_t* out, uint8_t maxCount) const {
+        uint8_t count = (sampleCount_ < maxCount) ? sampleCount_ : maxCount;
+        for (uint8_t i = 0; i < count; i++) {
+            uint8_t age = count - i;  // 1 = most recent
+            out[i] = buffer_[(head_ + windowSize_ - age) % windowSize_];
+        }
+        return count;
+    }
+
+    /**
+     * @brief Set the user-configured window size and clear samples
+     *
+     * Replaces re-constructing the filter when the configuration changes.
+     *
+     * @param windowSize Window (clamped to MIN_FILTER_WINDOW_SIZE..MAX_FILTER_WINDOW_SIZE)
+     */
+    void configure(uint8_t windowSize) {
+        windowSize_ = clampWindowSize(windowSize);
+        reset();
+    }
+
     /**
      * @brief Clear all samples from the filter
-     * 
+     *
      * Called when sensor is recalibrated or on error recovery.
      */
-    void reset();
+    void reset() {
+        head_ = 0;
+        sampleCount_ = 0;
+        sum_ = 0;
+        for (uint8_t i = 0; i < Capacity; i++) {
+            buffer_[i] = 0;
+        }
+    }
 
 private:
-    uint16_t* buffer_;       ///< Circular buffer for samples
-    uint8_t windowSize_;     ///< Configured window size (3-10)
-    uint8_t head_;           ///< Index of next write position
-    uint8_t sampleCount_;    ///< Number of valid samples in buffer (0 to windowSize)
-    
+    uint16_t buffer_[Capacity];  ///< Circular buffer; first windowSize_ entries in use
+    uint32_t sum_;               ///< Running sum of the samples in the window
+    uint8_t windowSize_;         ///< Active window size (1..Capacity)
+    uint8_t head_;               ///< Index of next write position
+    uint8_t sampleCount_;        ///< Number of valid samples in buffer (0 to windowSize)
+
     /**
      * @brief Clamp window size to valid range
      * @param size Requested window size
      * @return uint8_t Clamped to MIN_FILTER_WINDOW_SIZE..MAX_FILTER_WINDOW_SIZE
      */
-    static uint8_t clampWindowSize(uint8_t size);
+    static uint8_t clampWindowSize(uint8_t size) {
+        if (size < MIN_FILTER_WINDOW_SIZE) {
+            return MIN_FILTER_WINDOW_SIZE;
+        }
+        if (size > MAX_FILTER_WINDOW_SIZE) {
+            return MAX_FILTER_WINDOW_SIZE;
+        }
+        return size;
+    }
 };
 
+/**
+ * Filter used by HeightController. Capacity covers the window after
+ * rescaling to the active ranging frequency (see applyRangingProfile()).
+ */
+typedef FixedMovingAverageFilter<MAX_SCALED_FILTER_WINDOW_SIZE> MovingAverageFilter;
+
 #endif // MOVING_AVERAGE_FILTER_H
@@ -0,0 +1,208 @@
+/**
+ * @file NoiseAdaptiveWindow.h
+ * @brief Moving average window sized from the measured consensus noise
+ *
+ * Averaging N samples of noise sigma leaves sigma / sqrt(N), at the cost
+ * of (N-1)/2 frames of lag. A fixed window pays the same lag on every
+ * floor; this picks the smallest window that brings the measured noise
+ * down to ADAPTIVE_WINDOW_TARGET_NOISE_MM:
+ *
+ *   window = ceil((sigma / target)^2), clamped to minWindow..maxWindow
+ *
+ * sigma comes from second differences of the consensus distance,
+ * e = x[n] - 2 x[n-1] + x[n-2]. For white noise E[e^2] = 6 sigma^2, and a
+ * desk moving at constant speed contributes nothing, so travel is not
+ * mistaken for noise. The mean of e^2 is exponential over
+ * ADAPTIVE_WINDOW_NOISE_FRAMES; once warmed up each e^2 is capped at 16x
+ * the mean (4 sigma), so the single-frame kick of a start or stop barely
+ * moves it.
+ *
+ * Window N is right for sigma^2 in ((N-1) target^2, N target^2]. The
+ * window only moves once sigma leaves that band widened by h either side
+ * (h = ADAPTIVE_WINDOW_HYSTERESIS_PERCENT), and then goes straight to the
+ * window for the new sigma, so noise sitting on a boundary does not
+ * toggle the window every frame.
+ *
+ * Windows are in samples at RANGING_FREQUENCY_REFERENCE_HZ, like the
+ * configured filter window; the caller scales them to the ranging rate.
+ *
+ * Header-only so native tests can include it directly.
+ */
+
+#ifndef NOISE_ADAPTIVE_WINDOW_H
+#define NOISE_ADAPTIVE_WINDOW_H
+
+#include <stdint.h>
+#include <math.h>
+#include "../Config.h"
+
+/**
+ * @class NoiseAdaptiveWindow
+ * @brief Consensus noise estimator with a hysteretic window choice
+ *
+ * Usage:
+ *   NoiseAdaptiveWindow adaptive;
+ *   adaptive.reset(configuredWindow);
+ *   // per reliable consensus:
+ *   if (adaptive.update(consensusMm)) {
+ *       filter.resize(scale(adaptive.getWindow()));
+ *   }
+ */
+class NoiseAdaptiveWindow {
+public:
+    /**
+     * @param targetNoiseMm Residual noise the window aims for (1-sigma, mm)
+     * @param minWindow Smallest window
+     * @param maxWindow Largest window
+     */
+    explicit NoiseAdaptiveWindow(float targetNoiseMm = ADAPTIVE_WINDOW_TARGET_NOISE_MM,
+                                 uint8_t minWindow = MIN_FILTER_WINDOW_SIZE,
+                                 uint8_t maxWindow = MAX_FILTER_WINDOW_SIZE)
+        : targetVariance_(targetNoiseMm * targetNoiseMm)
+        , minWindow_(minWindow)
+        , maxWindow_(maxWindow < minWindow ? minWindow : maxWindow)
+        , last_(0.0f)
+        , prev1_(0.0f)
+        , prev2_(0.0f)
+        , switchCount_(0)
+    {
+        reset(minWindow_);
+    }
+
+    /**
+     * @brief Forget the noise estimate and start from a window
+     * @param window Window until the estimate has warmed up
+     */
+    void reset(uint8_t window) {
+        window_ = clampWindow(window);
+        meanSq_ = 0.0f;
+        estimates_ = 0;
+        restart();
+    }
+
+    /**
+     * @brief Break the sample history, keeping the noise estimate
+     *
+     * Call on a gap in the consensus (unreliable frame, filter reset,
+     * sensor recovery); the second difference across it would be
+     * meaningless.
+     */
+    void restart() {
+        history_ = 0;
+    }
+
+    /**
+     * @brief Feed one consensus distance and re-evaluate the window
+     * @param distanceMm Reliable consensus distance
+     * @return true if the window changed
+     */
+    bool update(uint16_t distanceMm) {
+        prev2_ = prev1_;
+        prev1_ = last_;
+        last_ = static_cast<float>(distanceMm);
+        if (history_ < 2) {
+            history_++;
+            return false;
+        }
+
+        float e = last_ - 2.0f * prev1_ + prev2_;
+        float sq = e * e;
+        if (estimates_ < ADAPTIVE_WINDOW_NOISE_FRAMES) {
+            // Warm-up: plain mean, no cap (there is nothing to cap against)
+            estimates_++;
+            meanSq_ += (sq - meanSq_) / static_cast<float>(estimates_);
+        } else {
+            float cap = 16.0f * meanSq_;
+            if (sq > cap) {
+                sq = cap;
+            }
+            meanSq_ += (sq - meanSq_) / static_cast<float>(ADAPTIVE_WINDOW_NOISE_FRAMES);
+        }
+
+        if (estimates_ < WARMUP_ESTIMATES) {
+            return false;
+        }
+
+        // Band of the current window, widened by the hysteresis
+        float variance = getNoiseVariance();
+        const float h = ADAPTIVE_WINDOW_HYSTERESIS_PERCENT / 100.0f;
+        float upper = window_ * targetVariance_ * (1.0f + h) * (1.0f + h);
+        float lower = (window_ - 1) * targetVariance_ * (1.0f - h) * (1.0f - h);
+        if (variance >= lower && variance <= upper) {
+            return false;
+        }
+        uint8_t window = windowForVariance(variance);
+        if (window == window_) {
+            return false;
+        }
+        window_ = window;
+        switchCount_++;
+        return true;
+    }
+
+    /**
+     * @brief Window for the current noise (samples at the reference rate)
+     */
+    uint8_t getWindow() const { return window_; }
+
+    /**
+     * @brief Estimated consensus noise, 1-sigma in mm (0 until measured)
+     */
+    float getNoiseMm() const { return sqrtf(getNoiseVariance()); }
+
+    /**
+     * @brief True once enough frames were seen to size the window
+     */
+    bool isWarmedUp() const { return estimates_ >= WARMUP_ESTIMATES; }
+
+    /**
+     * @brief Number of window changes since construction (diagnostics)
+     */
+    uint32_t getSwitchCount() const { return switchCount_; }
+
+    /**
+     * @brief Window that brings a noise variance down to the target
+     * @param variance Noise variance in mm^2
+     * @return uint8_t ceil(variance / target^2), clamped to min..max
+     */
+    uint8_t windowForVariance(float variance) const {
+        float samples = ceilf(variance / targetVariance_);
+        if (samples <= static_cast<float>(minWindow_)) {
+            return minWindow_;
+        }
+        if (samples >= static_cast<float>(maxWindow_)) {
+            return maxWindow_;
+        }
+        return static_cast<uint8_t>(samples);
+    }
+
+private:
+    /// Second differences needed before the window follows the estimate
+    static constexpr uint8_t WARMUP_ESTIMATES = ADAPTIVE_WINDOW_NOISE_FRAMES / 4;
+
+    float getNoiseVariance() const { return meanSq_ / 6.0f; }
+
+    uint8_t clampWindow(uint8_t window) const {
+        if (window < minWindow_) {
+            return minWindow_;
+        }
+        if (window > maxWindow_) {
+            return maxWindow_;
+        }
+        return window;
+    }
+
+    float targetVariance_;
+    uint8_t minWindow_;
+    uint8_t maxWindow_;
+    uint8_t window_;
+    float meanSq_;           ///< Mean squared second difference (mm^2)
+    uint8_t estimates_;      ///< Second differences averaged (saturates at NOISE_FRAMES)
+    uint8_t history_;        ///< Samples since the last gap (0-2)
+    float last_;             ///< Newest three consensus samples
+    float prev1_;
+    float prev2_;
+    uint32_t switchCount_;
+};
+
+#endif // NOISE_ADAPTIVE_WINDOW_H
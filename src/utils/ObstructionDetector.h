@@ -0,0 +1,200 @@
+/**
+ * @file ObstructionDetector.h
+ * @brief Detects an object pushed under the desk while it is lowering
+ *
+ * The consensus rejects zones that read much shorter than the floor as
+ * outliers, which is right for chair legs but means a box, a chair arm or
+ * a knee that ends up under a lowering desk goes unnoticed until the desk
+ * lands on it. This watches the raw zone frame instead.
+ *
+ * A zone is "near" when it reads more than OBSTRUCTION_MARGIN_MM shorter
+ * than the floor. The first frame after arm() is the reference: whatever
+ * is near then (a chair leg, a cable tray) belongs to the scene. After
+ * that the near zones are grouped into 4-connected clusters, and the
+ * detector trips on the first frame in which one cluster holds at least
+ * OBSTRUCTION_MIN_ZONES zones that were not near in the reference. That
+ * covers an object appearing (a new cluster) and an object the desk is
+ * closing in on (its cluster growing as it fills more of the field of
+ * view). Requiring adjacent zones instead of consecutive frames keeps a
+ * single noisy zone from tripping it without adding a frame of delay.
+ *
+ * Once tripped the detector stays tripped until re-armed.
+ *
+ * Header-only (template) so native tests use this file directly.
+ */
+
+#ifndef OBSTRUCTION_DETECTOR_H
+#define OBSTRUCTION_DETECTOR_H
+
+#include <stdint.h>
+#include "../Config.h"
+
+/**
+ * @class FixedObstructionDetector
+ * @brief Growing near-zone cluster detection on a GridSize x GridSize grid
+ *
+ * Usage:
+ *   ObstructionDetector detector;
+ *   detector.arm();                 // desk starts lowering
+ *   // per frame, bit n set = zone n much shorter than the floor:
+ *   if (detector.update(nearZones)) {
+ *       stopMotor();
+ *   }
+ *
+ * @tparam GridSize Zones per side (4 or 8)
+ */
+template <uint8_t GridSize>
+class FixedObstructionDetector {
+    static_assert(GridSize > 1 && GridSize <= 8, "Zones are a 64-bit mask");
+
+public:
+    /// Zones in the grid
+    static constexpr uint8_t ZONES = GridSize * GridSize;
+
+    /**
+     * @param minZones New near zones in one cluster that count as an obstruction
+     */
+    explicit FixedObstructionDetector(uint8_t minZones = OBSTRUCTION_MIN_ZONES)
+        : minZones_(minZones == 0 ? 1 : minZones)
+    {
+        disarm();
+    }
+
+    /**
+     * @brief Start watching; the next frame becomes the reference
+     */
+    void arm() {
+        armed_ = true;
+        haveReference_ = false;
+        reference_ = 0;
+        tripped_ = false;
+        zones_ = 0;
+        newZoneCount_ = 0;
+    }
+
+    /**
+     * @brief Stop watching and clear a detection
+     */
+    void disarm() {
+        armed_ = false;
+        haveReference_ = false;
+        reference_ = 0;
+        tripped_ = false;
+        zones_ = 0;
+        newZoneCount_ = 0;
+    }
+
+    /**
+     * @brief Check one frame
+     * @param nearZones Bit n set = zone n reads much shorter than the floor
+     * @return true if the detector tripped on this frame
+     */
+    bool update(uint64_t nearZones) {
+        if (!armed_ || tripped_) {
+            return false;
+        }
+        nearZones &= gridMask();
+        if (!haveReference_) {
+            reference_ = nearZones;
+            haveReference_ = true;
+            return false;
+        }
+
+        uint64_t fresh = nearZones & ~reference_;
+        uint64_t remaining = nearZones;
+        while (fresh & remaining) {
+            // Grow the cluster of the lowest new zone left
+            uint64_t seed = fresh & remaining;
+            uint64_t cluster = seed & (~seed + 1);
+            for (;;) {
+                uint64_t grown = (cluster | dilate(cluster)) & nearZones;
+                if (grown == cluster) {
+                    break;
+                }
+                cluster = grown;
+            }
+            remaining &= ~cluster;
+
+            uint8_t added = countZones(cluster & fresh);
+            if (added >= minZones_) {
+                tripped_ = true;
+                zones_ = cluster;
+                newZoneCount_ = added;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief True between arm() and disarm()
+     */
+    bool isArmed() const { return armed_; }
+
+    /**
+     * @brief True once an obstruction was detected since arm()
+     */
+    bool isTripped() const { return tripped_; }
+
+    /**
+     * @brief Zones of the cluster that tripped the detector (0 if not tripped)
+     */
+    uint64_t getZones() const { return zones_; }
+
+    /**
+     * @brief Zones of that cluster that were not near in the reference
+     */
+    uint8_t getNewZoneCount() const { return newZoneCount_; }
+
+    /**
+     * @brief Number of bits set in a zone mask
+     */
+    static uint8_t countZones(uint64_t zones) {
+        uint8_t count = 0;
+        while (zones) {
+            zones &= zones - 1;
+            count++;
+        }
+        return count;
+    }
+
+private:
+    static uint64_t gridMask() {
+        return (ZONES >= 64) ? ~0ULL : ((1ULL << ZONES) - 1);
+    }
+
+    /// Zones in column 0 (zone n is row n / GridSize, column n % GridSize)
+    static uint64_t firstColumn() {
+        uint64_t column = 0;
+        for (uint8_t row = 0; row < GridSize; row++) {
+            column |= 1ULL << (row * GridSize);
+        }
+        return column;
+    }
+
+    /// 4-neighbours of a set of zones
+    static uint64_t dilate(uint64_t zones) {
+        const uint64_t first = firstColumn();
+        const uint64_t last = first << (GridSize - 1);
+        uint64_t neighbours = ((zones & ~last) << 1) |
+                              ((zones & ~first) >> 1) |
+                              (zones << GridSize) |
+                              (zones >> GridSize);
+        return neighbours & gridMask();
+    }
+
+    uint8_t minZones_;
+    bool armed_;
+    bool haveReference_;
+    uint64_t reference_;     ///< Near zones in the first frame after arm()
+    bool tripped_;
+    uint64_t zones_;
+    uint8_t newZoneCount_;
+};
+
+/**
+ * Detector sized for the build's zone grid (see SENSOR_ZONES_8X8)
+ */
+typedef FixedObstructionDetector<MULTI_ZONE_GRID_SIZE> ObstructionDetector;
+
+#endif // OBSTRUCTION_DETECTOR_H
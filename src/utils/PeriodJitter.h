@@ -0,0 +1,147 @@
+/**
+ * @file PeriodJitter.h
+ * @brief Period and jitter statistics for a fixed-rate task
+ *
+ * The control task records the time of every wake-up. Each period between
+ * two wake-ups is compared with the nominal one. Min/avg/max are kept for
+ * the period and avg/max for the jitter |period - nominal|. A histogram
+ * of the jitter gives its 99th percentile without storing samples.
+ * GET /control reports them, so the control period can be checked under
+ * web load.
+ *
+ * Pure policy (time is passed in), header-only so native tests use it
+ * directly.
+ */
+
+#ifndef PERIOD_JITTER_H
+#define PERIOD_JITTER_H
+
+#include <stdint.h>
+#include "../Config.h"
+
+/**
+ * @class PeriodJitter
+ * @brief Running period statistics and jitter histogram
+ *
+ * Usage:
+ *   PeriodJitter jitter(CONTROL_PERIOD_MS * 1000);
+ *   // every wake-up:
+ *   jitter.record(micros());
+ *   jitter.getP99JitterUs();
+ */
+class PeriodJitter {
+public:
+    static constexpr uint8_t BINS = CONTROL_JITTER_BINS;
+    static constexpr uint16_t BIN_US = CONTROL_JITTER_BIN_US;
+
+    /**
+     * @param nominalUs Period the task is scheduled at
+     */
+    explicit PeriodJitter(uint32_t nominalUs)
+        : nominalUs_(nominalUs)
+    {
+        reset();
+    }
+
+    /**
+     * @brief Record a wake-up
+     *
+     * The first wake-up after construction or reset() only starts the
+     * first period.
+     *
+     * @param wakeUs micros() at the wake-up
+     */
+    void record(uint32_t wakeUs) {
+        if (!started_) {
+            started_ = true;
+            lastWakeUs_ = wakeUs;
+            return;
+        }
+        uint32_t period = wakeUs - lastWakeUs_;
+        lastWakeUs_ = wakeUs;
+        uint32_t jitter = (period > nominalUs_) ? period - nominalUs_ : nominalUs_ - period;
+
+        if (count_ == 0 || period < minPeriodUs_) {
+            minPeriodUs_ = period;
+        }
+        if (period > maxPeriodUs_) {
+            maxPeriodUs_ = period;
+        }
+        if (jitter > maxJitterUs_) {
+            maxJitterUs_ = jitter;
+        }
+        periodSumUs_ += period;
+        jitterSumUs_ += jitter;
+        count_++;
+
+        uint32_t bin = jitter / BIN_US;
+        histogram_[(bin < BINS - 1) ? bin : BINS - 1]++;
+    }
+
+    /**
+     * @brief Drop all samples; the next wake-up starts a new period
+     */
+    void reset() {
+        started_ = false;
+        lastWakeUs_ = 0;
+        count_ = 0;
+        minPeriodUs_ = 0;
+        maxPeriodUs_ = 0;
+        maxJitterUs_ = 0;
+        periodSumUs_ = 0;
+        jitterSumUs_ = 0;
+        for (uint8_t i = 0; i < BINS; i++) {
+            histogram_[i] = 0;
+        }
+    }
+
+    uint32_t getNominalUs() const { return nominalUs_; }        ///< Scheduled period
+    uint32_t getCount() const { return count_; }                ///< Periods recorded
+    uint32_t getMinPeriodUs() const { return minPeriodUs_; }    ///< 0 until a period is recorded
+    uint32_t getMaxPeriodUs() const { return maxPeriodUs_; }
+    uint32_t getMaxJitterUs() const { return maxJitterUs_; }
+
+    uint32_t getAvgPeriodUs() const {
+        return (count_ > 0) ? (uint32_t)(periodSumUs_ / count_) : 0;
+    }
+
+    uint32_t getAvgJitterUs() const {
+        return (count_ > 0) ? (uint32_t)(jitterSumUs_ / count_) : 0;
+    }
+
+    /**
+     * @brief Jitter 99% of the periods stayed within
+     * @return Upper bound of the histogram bin holding the 99th percentile,
+     *         or the maximum when that is the open-ended last bin
+     */
+    uint32_t getP99JitterUs() const {
+        if (count_ == 0) {
+            return 0;
+        }
+        // Smallest bin count reaching 99% of the samples (rounded up)
+        uint32_t needed = count_ - count_ / 100;
+        uint32_t seen = 0;
+        for (uint8_t bin = 0; bin < BINS - 1; bin++) {
+            seen += histogram_[bin];
+            if (seen >= needed) {
+                uint32_t bound = (uint32_t)(bin + 1) * BIN_US;
+                return (bound < maxJitterUs_) ? bound : maxJitterUs_;
+            }
+        }
+        return maxJitterUs_;
+    }
+
+private:
+    uint32_t nominalUs_;
+    bool started_;
+    uint32_t lastWakeUs_;
+    uint32_t count_;
+    uint32_t minPeriodUs_;
+    uint32_t maxPeriodUs_;
+    uint32_t maxJitterUs_;
+    uint64_t periodSumUs_;
+    uint64_t jitterSumUs_;
+    uint32_t histogram_[BINS];      ///< Jitter in BIN_US bins, last one open-ended
+};
+
+#endif // PERIOD_JITTER_H
@@ -0,0 +1,100 @@
+/**
+ * @file RetainedState.h
+ * @brief Checksummed state block that survives a software reset
+ *
+ * Instances are placed in RTC memory with RTC_NOINIT_ATTR, which the
+ * bootloader neither loads nor clears: after a watchdog, panic or
+ * esp_restart() reset the last saved value is still there, after a
+ * power-on it is garbage. load() only accepts a block whose magic and
+ * checksum match, so garbage (and a layout from another firmware version,
+ * via RETAINED_STATE_VERSION and sizeof(T)) is rejected.
+ *
+ * The class has no constructor on purpose: a non-trivial constructor
+ * would run at startup and wipe the retained value.
+ *
+ * Header-only so native tests use this file directly.
+ */
+
+#ifndef RETAINED_STATE_H
+#define RETAINED_STATE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include "../Config.h"
+
+/**
+ * @class RetainedState
+ * @brief Holds one T with a validity check
+ *
+ * Usage:
+ *   RTC_NOINIT_ATTR static RetainedState<Snapshot> retained;
+ *   if (warmReset && retained.load(snapshot)) { ... } else { retained.invalidate(); }
+ *   retained.save(snapshot);  // whenever the state changes
+ *
+ * @tparam T Trivially copyable snapshot struct
+ */
+template <typename T>
+class RetainedState {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Retained state is copied byte-wise");
+
+public:
+    /**
+     * @brief Store a snapshot (a few dozen bytes; cheap enough per frame)
+     * @param data Snapshot to retain
+     */
+    void save(const T& data) {
+        memcpy(&data_, &data, sizeof(T));
+        magic_ = MAGIC;
+        checksum_ = checksum();
+    }
+
+    /**
+     * @brief Retrieve the snapshot if the block is intact
+     * @param out Receives the snapshot (untouched on failure)
+     * @return true if a snapshot saved by this firmware layout was found
+     */
+    bool load(T& out) const {
+        if (magic_ != MAGIC || checksum_ != checksum()) {
+            return false;
+        }
+        memcpy(&out, &data_, sizeof(T));
+        return true;
+    }
+
+    /**
+     * @brief Discard the snapshot (cold boot, or state no longer meaningful)
+     */
+    void invalidate() {
+        magic_ = 0;
+        checksum_ = 0;
+    }
+
+private:
+    static constexpr uint32_t MAGIC = 0x57524D53;  // "WRMS"
+
+    uint32_t magic_;
+    uint32_t checksum_;
+    T data_;
+
+    /**
+     * @brief FNV-1a over version, size and payload
+     */
+    uint32_t checksum() const {
+        uint32_t hash = 2166136261u;
+        const uint32_t header[2] = {RETAINED_STATE_VERSION, static_cast<uint32_t>(sizeof(T))};
+        hash = fnv1a(hash, reinterpret_cast<const uint8_t*>(header), sizeof(header));
+        return fnv1a(hash, reinterpret_cast<const uint8_t*>(&data_), sizeof(T));
+    }
+
+    static uint32_t fnv1a(uint32_t hash, const uint8_t* bytes, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            hash ^= bytes[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+};
+
+#endif // RETAINED_STATE_H
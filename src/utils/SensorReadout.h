@@ -0,0 +1,142 @@
+/**
+ * @file SensorReadout.h
+ * @brief Per-frame I2C payload of the VL53L5CX for the build's readout profile
+ *
+ * The ULD driver reads one results block per frame whose size depends on
+ * which outputs are compiled in. Outputs are removed with the driver's
+ * VL53L5CX_DISABLE_* macros, set as global build flags in platformio.ini
+ * so the library and this firmware see the same VL53L5CX_ResultsData
+ * layout:
+ *
+ *   - lean (default): distance, target status, sigma, signal and ambient.
+ *     Everything the median and confidence-weighted consensus read.
+ *   - minimal (esp32dev_minimal_readout): distance and target status
+ *     only. Confidence-weighted consensus falls back to median-mean.
+ *
+ * frameBytes() mirrors data_read_size from vl53l5cx_start_ranging(): each
+ * enabled output block is a 4-byte header plus its per-zone payload, on
+ * top of the mandatory start/metadata/common blocks and a 24-byte footer.
+ *
+ * Header-only so native tests can include it directly.
+ */
+
+#ifndef SENSOR_READOUT_H
+#define SENSOR_READOUT_H
+
+#include <stdint.h>
+
+namespace SensorReadout {
+
+/**
+ * @brief Optional ULD output blocks
+ */
+enum Field : uint16_t {
+    AMBIENT_PER_SPAD    = 1 << 0,   ///< 4 bytes/zone
+    NB_SPADS_ENABLED    = 1 << 1,   ///< 4 bytes/zone
+    NB_TARGET_DETECTED  = 1 << 2,   ///< 1 byte/zone
+    SIGNAL_PER_SPAD     = 1 << 3,   ///< 4 bytes/target
+    RANGE_SIGMA_MM      = 1 << 4,   ///< 2 bytes/target
+    DISTANCE_MM         = 1 << 5,   ///< 2 bytes/target
+    REFLECTANCE_PERCENT = 1 << 6,   ///< 1 byte/target
+    TARGET_STATUS       = 1 << 7,   ///< 1 byte/target
+    MOTION_INDICATOR    = 1 << 8    ///< 140 bytes, fixed
+};
+
+/// Every optional output (driver default)
+constexpr uint16_t ALL_FIELDS = 0x1FF;
+
+/// Block header preceding each output in the results buffer
+constexpr uint16_t BLOCK_HEADER_BYTES = 4;
+
+/// Start (0) + metadata (12) + common data (4) blocks, their headers and the footer
+constexpr uint16_t FIXED_BYTES = (0 + BLOCK_HEADER_BYTES) + (12 + BLOCK_HEADER_BYTES) +
+                                 (4 + BLOCK_HEADER_BYTES) + 24;
+
+/// Motion indicator block payload (independent of resolution)
+constexpr uint16_t MOTION_INDICATOR_BYTES = 140;
+
+/**
+ * @brief Outputs compiled into this build (from VL53L5CX_DISABLE_* flags)
+ */
+constexpr uint16_t ENABLED_FIELDS = ALL_FIELDS
+#ifdef VL53L5CX_DISABLE_AMBIENT_PER_SPAD
+    & ~AMBIENT_PER_SPAD
+#endif
+#ifdef VL53L5CX_DISABLE_NB_SPADS_ENABLED
+    & ~NB_SPADS_ENABLED
+#endif
+#ifdef VL53L5CX_DISABLE_NB_TARGET_DETECTED
+    & ~NB_TARGET_DETECTED
+#endif
+#ifdef VL53L5CX_DISABLE_SIGNAL_PER_SPAD
+    & ~SIGNAL_PER_SPAD
+#endif
+#ifdef VL53L5CX_DISABLE_RANGE_SIGMA_MM
+    & ~RANGE_SIGMA_MM
+#endif
+#ifdef VL53L5CX_DISABLE_DISTANCE_MM
+    & ~DISTANCE_MM
+#endif
+#ifdef VL53L5CX_DISABLE_REFLECTANCE_PERCENT
+    & ~REFLECTANCE_PERCENT
+#endif
+#ifdef VL53L5CX_DISABLE_TARGET_STATUS
+    & ~TARGET_STATUS
+#endif
+#ifdef VL53L5CX_DISABLE_MOTION_INDICATOR
+    & ~MOTION_INDICATOR
+#endif
+    ;
+
+/**
+ * @brief Bytes of one output block including its header (0 if disabled)
+ */
+constexpr uint16_t blockBytes(uint16_t fields, uint16_t field, uint16_t payload) {
+    return (fields & field) ? static_cast<uint16_t>(payload + BLOCK_HEADER_BYTES) : 0;
+}
+
+/**
+ * @brief Size of one results read over I2C
+ * @param fields Enabled outputs (Field bits)
+ * @param zones 16 or 64
+ * @param targetsPerZone VL53L5CX_NB_TARGET_PER_ZONE
+ * @return uint16_t Bytes per frame
+ */
+constexpr uint16_t frameBytes(uint16_t fields, uint8_t zones, uint8_t targetsPerZone = 1) {
+    return FIXED_BYTES +
+           blockBytes(fields, AMBIENT_PER_SPAD, 4 * zones) +
+           blockBytes(fields, NB_SPADS_ENABLED, 4 * zones) +
+           blockBytes(fields, NB_TARGET_DETECTED, zones) +
+           blockBytes(fields, SIGNAL_PER_SPAD, 4 * zones * targetsPerZone) +
+           blockBytes(fields, RANGE_SIGMA_MM, 2 * zones * targetsPerZone) +
+           blockBytes(fields, DISTANCE_MM, 2 * zones * targetsPerZone) +
+           blockBytes(fields, REFLECTANCE_PERCENT, zones * targetsPerZone) +
+           blockBytes(fields, TARGET_STATUS, zones * targetsPerZone) +
+           blockBytes(fields, MOTION_INDICATOR, MOTION_INDICATOR_BYTES);
+}
+
+/**
+ * @brief Ideal bus time for a read of this size
+ *
+ * 9 clocks per byte (8 data + ACK); ignores start/address overhead and
+ * clock stretching, so the measured time is always somewhat higher.
+ *
+ * @param bytes Bytes read
+ * @param i2cHz Bus clock
+ * @return uint32_t Microseconds
+ */
+constexpr uint32_t busTimeUs(uint32_t bytes, uint32_t i2cHz) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(bytes) * 9u * 1000000u) / i2cHz);
+}
+
+/**
+ * @brief True if the build reads sigma, signal and ambient (weighted consensus)
+ */
+constexpr bool hasConfidenceFields(uint16_t fields) {
+    return (fields & (AMBIENT_PER_SPAD | SIGNAL_PER_SPAD | RANGE_SIGMA_MM)) ==
+           (AMBIENT_PER_SPAD | SIGNAL_PER_SPAD | RANGE_SIGMA_MM);
+}
+
+} // namespace SensorReadout
+
+#endif // SENSOR_READOUT_H
@@ -0,0 +1,256 @@
+/**
+ * @file SensorSupervisor.h
+ * @brief Fault detection and escalating recovery policy for the ToF sensor
+ *
+ * HeightController reports every frame read and every failed read; the
+ * supervisor declares a fault when frames stop arriving (starvation) or
+ * reads keep failing, and hands back the recovery step to run:
+ *
+ *   BUS_CLEAR    - clock SCL until a slave stuck mid-byte releases SDA,
+ *                  then restart ranging
+ *   WIRE_REINIT  - tear down and re-create the I2C driver, restart ranging
+ *   SENSOR_RESET - reset the sensor and re-upload its firmware
+ *
+ * Each step gets a wait window to produce a frame before the next one is
+ * tried; SENSOR_RESET is repeated with exponential backoff. The time from
+ * fault detection to the first good frame is recorded in a histogram.
+ *
+ * Pure policy (time is passed in), header-only so native tests use it
+ * directly.
+ */
+
+#ifndef SENSOR_SUPERVISOR_H
+#define SENSOR_SUPERVISOR_H
+
+#include <stdint.h>
+#include "../Config.h"
+
+/**
+ * @enum SensorRecoveryAction
+ * @brief Recovery step, in escalation order
+ */
+enum class SensorRecoveryAction : uint8_t {
+    NONE,           ///< Healthy, or current step still waiting for a frame
+    BUS_CLEAR,      ///< SCL clock-out bus recovery + ranging restart
+    WIRE_REINIT,    ///< I2C driver re-init + ranging restart
+    SENSOR_RESET    ///< Sensor reset and firmware re-upload
+};
+
+/**
+ * @class SensorSupervisor
+ * @brief Tracks sensor health and decides recovery steps
+ *
+ * Usage:
+ *   supervisor.reset(millis());
+ *   // per frame:  readOk ? supervisor.onFrame(millis()) : supervisor.onReadError();
+ *   // after a ranging (re)start:  supervisor.onRangingStart(millis());
+ *   switch (supervisor.poll(millis(), framePeriodMs)) { ... }
+ */
+class SensorSupervisor {
+public:
+    static constexpr uint8_t ACTION_COUNT = 4;
+    static constexpr uint8_t HISTOGRAM_BINS = 8;
+
+    SensorSupervisor() { reset(0); }
+
+    /**
+     * @brief Start supervising from a healthy state; clears statistics
+     * @param nowMs Current time (ranging just started)
+     */
+    void reset(uint32_t nowMs) {
+        lastFrameMs_ = nowMs;
+        consecutiveErrors_ = 0;
+        recovering_ = false;
+        step_ = SensorRecoveryAction::NONE;
+        faultMs_ = 0;
+        stepMs_ = 0;
+        resetBackoffMs_ = SENSOR_RECOVERY_RESET_WAIT_MS;
+        starvations_ = 0;
+        errorFaults_ = 0;
+        readErrors_ = 0;
+        recoveries_ = 0;
+        lastRecoveryMs_ = 0;
+        maxRecoveryMs_ = 0;
+        for (uint8_t i = 0; i < ACTION_COUNT; i++) {
+            actions_[i] = 0;
+        }
+        for (uint8_t i = 0; i < HISTOGRAM_BINS; i++) {
+            histogram_[i] = 0;
+        }
+    }
+
+    /**
+     * @brief A frame was read successfully (its consensus may still be unreliable)
+     * @param nowMs Current time
+     */
+    void onFrame(uint32_t nowMs) {
+        lastFrameMs_ = nowMs;
+        consecutiveErrors_ = 0;
+        if (recovering_) {
+            lastRecoveryMs_ = nowMs - faultMs_;
+            if (lastRecoveryMs_ > maxRecoveryMs_) {
+                maxRecoveryMs_ = lastRecoveryMs_;
+            }
+            histogram_[histogramBin(lastRecoveryMs_)]++;
+            recoveries_++;
+            recovering_ = false;
+            step_ = SensorRecoveryAction::NONE;
+            resetBackoffMs_ = SENSOR_RECOVERY_RESET_WAIT_MS;
+        }
+    }
+
+    /**
+     * @brief A data-ready frame could not be read
+     */
+    void onReadError() {
+        readErrors_++;
+        if (consecutiveErrors_ < 255) {
+            consecutiveErrors_++;
+        }
+    }
+
+    /**
+     * @brief Ranging was (re)started: the next frame is one period away
+     * @param nowMs Current time
+     */
+    void onRangingStart(uint32_t nowMs) {
+        lastFrameMs_ = nowMs;
+    }
+
+    /**
+     * @brief Check health and pick the next recovery step
+     * @param nowMs Current time
+     * @param framePeriodMs Current ranging period (a frame is overdue after
+     *                      this plus SENSOR_STARVATION_MARGIN_MS)
+     * @return SensorRecoveryAction Step to run now, or NONE
+     */
+    SensorRecoveryAction poll(uint32_t nowMs, uint32_t framePeriodMs) {
+        if (!recovering_) {
+            bool starved = nowMs - lastFrameMs_ > framePeriodMs + SENSOR_STARVATION_MARGIN_MS;
+            bool failing = consecutiveErrors_ >= SENSOR_MAX_CONSECUTIVE_ERRORS;
+            if (!starved && !failing) {
+                return SensorRecoveryAction::NONE;
+            }
+            if (failing) {
+                errorFaults_++;
+            } else {
+                starvations_++;
+            }
+            recovering_ = true;
+            faultMs_ = nowMs;
+            return beginStep(SensorRecoveryAction::BUS_CLEAR, nowMs);
+        }
+
+        if (nowMs - stepMs_ < stepWaitMs()) {
+            return SensorRecoveryAction::NONE;
+        }
+        switch (step_) {
+            case SensorRecoveryAction::BUS_CLEAR:
+                return beginStep(SensorRecoveryAction::WIRE_REINIT, nowMs);
+            case SensorRecoveryAction::WIRE_REINIT:
+                return beginStep(SensorRecoveryAction::SENSOR_RESET, nowMs);
+            default:
+                // Sensor still silent after a reset: try again, less often
+                resetBackoffMs_ = (resetBackoffMs_ * 2 > SENSOR_RECOVERY_MAX_BACKOFF_MS)
+                                  ? SENSOR_RECOVERY_MAX_BACKOFF_MS : resetBackoffMs_ * 2;
+                return beginStep(SensorRecoveryAction::SENSOR_RESET, nowMs);
+        }
+    }
+
+    /**
+     * @brief Check if a fault is being recovered
+     * @return true from fault detection until the next good frame
+     */
+    bool isRecovering() const { return recovering_; }
+
+    /**
+     * @brief Step currently running (NONE when healthy)
+     */
+    SensorRecoveryAction getStep() const { return step_; }
+
+    uint32_t getStarvationCount() const { return starvations_; }   ///< Faults from missing frames
+    uint32_t getErrorFaultCount() const { return errorFaults_; }   ///< Faults from repeated read errors
+    uint32_t getReadErrorCount() const { return readErrors_; }     ///< Failed reads since reset()
+    uint32_t getRecoveryCount() const { return recoveries_; }      ///< Faults that ended in a good frame
+    uint32_t getLastRecoveryMs() const { return lastRecoveryMs_; } ///< Detection to first good frame
+    uint32_t getMaxRecoveryMs() const { return maxRecoveryMs_; }
+
+    /**
+     * @brief Number of times a step was run
+     * @param action BUS_CLEAR, WIRE_REINIT or SENSOR_RESET
+     */
+    uint32_t getActionCount(SensorRecoveryAction action) const {
+        return actions_[static_cast<uint8_t>(action)];
+    }
+
+    /**
+     * @brief Recoveries per time bin
+     * @param bin 0..HISTOGRAM_BINS-1 (see getHistogramBoundMs())
+     */
+    uint32_t getHistogramCount(uint8_t bin) const {
+        return (bin < HISTOGRAM_BINS) ? histogram_[bin] : 0;
+    }
+
+    /**
+     * @brief Exclusive upper bound of a histogram bin
+     * @param bin 0..HISTOGRAM_BINS-1
+     * @return uint32_t Bound in ms; 0 for the last (open-ended) bin
+     */
+    static uint32_t getHistogramBoundMs(uint8_t bin) {
+        static const uint32_t bounds[HISTOGRAM_BINS - 1] = {50, 100, 250, 500, 1000, 2000, 5000};
+        return (bin < HISTOGRAM_BINS - 1) ? bounds[bin] : 0;
+    }
+
+    /**
+     * @brief Step name for logs and JSON
+     */
+    static const char* actionName(SensorRecoveryAction action) {
+        switch (action) {
+            case SensorRecoveryAction::BUS_CLEAR:    return "bus_clear";
+            case SensorRecoveryAction::WIRE_REINIT:  return "wire_reinit";
+            case SensorRecoveryAction::SENSOR_RESET: return "sensor_reset";
+            default:                                 return "none";
+        }
+    }
+
+private:
+    uint32_t lastFrameMs_;
+    uint8_t consecutiveErrors_;
+    bool recovering_;
+    SensorRecoveryAction step_;
+    uint32_t faultMs_;          ///< Fault detected
+    uint32_t stepMs_;           ///< Current step started
+    uint32_t resetBackoffMs_;   ///< Wait after SENSOR_RESET (doubles while it fails)
+
+    uint32_t starvations_;
+    uint32_t errorFaults_;
+    uint32_t readErrors_;
+    uint32_t recoveries_;
+    uint32_t lastRecoveryMs_;
+    uint32_t maxRecoveryMs_;
+    uint32_t actions_[ACTION_COUNT];
+    uint32_t histogram_[HISTOGRAM_BINS];
+
+    SensorRecoveryAction beginStep(SensorRecoveryAction step, uint32_t nowMs) {
+        step_ = step;
+        stepMs_ = nowMs;
+        consecutiveErrors_ = 0;
+        actions_[static_cast<uint8_t>(step)]++;
+        return step;
+    }
+
+    uint32_t stepWaitMs() const {
+        return (step_ == SensorRecoveryAction::SENSOR_RESET) ? resetBackoffMs_
+                                                              : SENSOR_RECOVERY_STEP_WAIT_MS;
+    }
+
+    static uint8_t histogramBin(uint32_t ms) {
+        uint8_t bin = 0;
+        while (bin < HISTOGRAM_BINS - 1 && ms >= getHistogramBoundMs(bin)) {
+            bin++;
+        }
+        return bin;
+    }
+};
+
+#endif // SENSOR_SUPERVISOR_H
@@ -0,0 +1,133 @@
+/**
+ * @file TraceReplay.h
+ * @brief Runs recorded frames through the spatial and temporal filters
+ *
+ * Feeds each frame of a FrameTrace to ZoneConsensus::fromZones() with the
+ * zone mask from the trace header, then reliable consensus values to a
+ * MovingAverageFilter and a VelocityKalmanFilter using the frame
+ * timestamps, as HeightController::processFrame() does. Traces hold no
+ * sigma/signal/ambient, so the consensus is the median-mean path.
+ *
+ * Header-only so native tests replay real traces against the filter code.
+ */
+
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+#include <stdint.h>
+#include "FrameTrace.h"
+#include "ZoneConsensus.h"
+#include "MovingAverageFilter.h"
+#include "VelocityKalmanFilter.h"
+
+/**
+ * @struct ReplayStep
+ * @brief Pipeline output for one replayed frame
+ */
+struct ReplayStep {
+    TraceFrame frame;                 ///< Decoded input
+    ConsensusResult consensus;        ///< Spatial stage
+    uint16_t average_mm;              ///< Moving average (0 before the first reliable frame)
+    uint16_t kalman_mm;               ///< Kalman distance
+    int16_t velocity_mm_s;            ///< Kalman velocity
+    uint32_t missed_frames;           ///< Frames between this one and the previous (counter gap)
+};
+
+/**
+ * @class TraceReplay
+ * @brief Frame source over a recorded trace
+ *
+ * Usage:
+ *   TraceReplay replay(data, size);
+ *   ReplayStep step;
+ *   while (replay.next(step)) { ... }
+ */
+class TraceReplay {
+public:
+    /**
+     * @brief Start replaying a trace
+     * @param data Trace bytes (must outlive the replay)
+     * @param size Byte count
+     * @param windowSize Moving average window
+     * @param processNoise Kalman acceleration noise (mm/s^2)
+     * @param measurementNoise Kalman measurement noise (mm)
+     */
+    TraceReplay(const uint8_t* data, size_t size,
+                uint8_t windowSize = DEFAULT_FILTER_WINDOW_SIZE,
+                float processNoise = DEFAULT_KALMAN_PROCESS_NOISE,
+                float measurementNoise = DEFAULT_KALMAN_MEASUREMENT_NOISE)
+        : reader_(data, size)
+        , filter_(windowSize)
+        , kalman_(processNoise, measurementNoise)
+        , frames_(0)
+        , reliableFrames_(0)
+        , missedFrames_(0)
+        , lastCounter_(0)
+        , rule_(ZoneConsensus::fixedOutlierRule())
+    {
+    }
+
+    /**
+     * @brief Replay with another outlier threshold rule (default: fixed)
+     */
+    void setOutlierRule(const ZoneConsensus::OutlierRule& rule) { rule_ = rule; }
+
+    /**
+     * @brief Check if the trace header was recognised
+     */
+    bool isValid() const { return reader_.isValid(); }
+
+    /**
+     * @brief Check if the trace ended mid-frame
+     */
+    bool isTruncated() const { return reader_.isTruncated(); }
+
+    /**
+     * @brief Decode and filter the next frame
+     * @param step Receives the frame and the filter outputs
+     * @return false at end of trace
+     */
+    bool next(ReplayStep& step) {
+        if (!reader_.next(step.frame)) {
+            return false;
+        }
+
+        step.missed_frames = (frames_ > 0) ? step.frame.frame_counter - lastCounter_ - 1 : 0;
+        missedFrames_ += step.missed_frames;
+        lastCounter_ = step.frame.frame_counter;
+        frames_++;
+
+        const uint8_t zones = reader_.getZones();
+        step.consensus = ZoneConsensus::fromZones(step.frame.status, step.frame.distance_mm, zones,
+                                                  reader_.getZoneMask(),
+                                                  static_cast<uint8_t>(zones / 4), rule_);
+        if (step.consensus.is_reliable) {
+            reliableFrames_++;
+            filter_.addSample(step.consensus.consensus_distance_mm);
+            kalman_.update(step.consensus.consensus_distance_mm, step.frame.timestamp_us);
+        }
+
+        step.average_mm = filter_.getAverage();
+        step.kalman_mm = kalman_.getDistance();
+        step.velocity_mm_s = kalman_.getVelocity();
+        return true;
+    }
+
+    uint32_t getFrameCount() const { return frames_; }            ///< Frames replayed so far
+    uint32_t getReliableCount() const { return reliableFrames_; } ///< Frames with a reliable consensus
+    uint32_t getMissedCount() const { return missedFrames_; }     ///< Counter gaps summed
+
+    uint8_t getZones() const { return reader_.getZones(); }
+
+private:
+    FrameTraceReader reader_;
+    MovingAverageFilter filter_;
+    VelocityKalmanFilter kalman_;
+    uint32_t frames_;
+    uint32_t reliableFrames_;
+    uint32_t missedFrames_;
+    uint32_t lastCounter_;
+    ZoneConsensus::OutlierRule rule_;
+};
+
+#endif // TRACE_REPLAY_H
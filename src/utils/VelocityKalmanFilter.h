@@ -0,0 +1,189 @@
+/**
+ * @file VelocityKalmanFilter.h
+ * @brief Constant-velocity Kalman filter for the temporal filtering stage
+ *
+ * Alternative to MovingAverageFilter. State is [distance, velocity]; the
+ * process model assumes constant velocity disturbed by white acceleration
+ * noise, so a desk moving at steady speed is tracked without the
+ * (N-1)/2-frame lag of a moving average, while a stationary desk still
+ * gets heavy smoothing once the velocity estimate settles at zero.
+ *
+ * Time step comes from frame timestamps, so ranging profile changes
+ * (1 Hz idle / 15 Hz active) need no retuning.
+ *
+ * Header-only so native tests can include it directly.
+ */
+
+#ifndef VELOCITY_KALMAN_FILTER_H
+#define VELOCITY_KALMAN_FILTER_H
+
+#include <stdint.h>
+
+/**
+ * @class VelocityKalmanFilter
+ * @brief 2-state (position, velocity) Kalman filter in single precision
+ *
+ * Usage:
+ *   VelocityKalmanFilter kf(300.0f, 3.0f);
+ *   kf.update(consensusMm, frameTimeUs);
+ *   uint16_t smoothed = kf.getDistance();
+ *   int16_t rate = kf.getVelocity();
+ */
+class VelocityKalmanFilter {
+public:
+    /**
+     * @brief Construct the filter
+     * @param processNoise Acceleration noise (1-sigma, mm/s^2)
+     * @param measurementNoise Measurement noise (1-sigma, mm)
+     */
+    VelocityKalmanFilter(float processNoise, float measurementNoise)
+        : accelVariance_(processNoise * processNoise)
+        , measVariance_(measurementNoise * measurementNoise)
+    {
+        reset();
+    }
+
+    /**
+     * @brief Change noise parameters (state is kept)
+     * @param processNoise Acceleration noise (1-sigma, mm/s^2)
+     * @param measurementNoise Measurement noise (1-sigma, mm)
+     */
+    void setNoise(float processNoise, float measurementNoise) {
+        accelVariance_ = processNoise * processNoise;
+        measVariance_ = measurementNoise * measurementNoise;
+    }
+
+    /**
+     * @brief Forget state; next update() re-initializes from the measurement
+     */
+    void reset() {
+        x_ = 0.0f;
+        v_ = 0.0f;
+        p00_ = p01_ = p11_ = 0.0f;
+        lastUs_ = 0;
+        nis_ = 1.0f;
+        maneuvering_ = false;
+        initialized_ = false;
+    }
+
+    /**
+     * @brief Predict to timeUs and fuse one distance measurement
+     * @param measurementMm Consensus distance in mm
+     * @param timeUs Frame timestamp (micros(), wraps)
+     */
+    void update(uint16_t measurementMm, uint32_t timeUs) {
+        const float z = static_cast<float>(measurementMm);
+
+        if (!initialized_) {
+            x_ = z;
+            v_ = 0.0f;
+            p00_ = measVariance_;
+            p01_ = 0.0f;
+            p11_ = INITIAL_VELOCITY_VARIANCE;
+            lastUs_ = timeUs;
+            initialized_ = true;
+            return;
+        }
+
+        float dt = static_cast<float>(timeUs - lastUs_) * 1e-6f;
+        lastUs_ = timeUs;
+        if (dt <= 0.0f) {
+            dt = MIN_DT_S;
+        }
+        if (dt > MAX_DT_S) {
+            dt = MAX_DT_S;
+        }
+
+        // Predict: x' = F x, P' = F P F^T + Q (discrete white acceleration)
+        x_ += v_ * dt;
+        const float dt2 = dt * dt;
+        const float qa = maneuvering_ ? accelVariance_ : accelVariance_ * QUIET_VARIANCE_RATIO;
+        const float q00 = qa * dt2 * dt2 * 0.25f;
+        const float q01 = qa * dt2 * dt * 0.5f;
+        const float q11 = qa * dt2;
+        const float p00 = p00_ + dt * (2.0f * p01_ + dt * p11_) + q00;
+        const float p01 = p01_ + dt * p11_ + q01;
+        const float p11 = p11_ + q11;
+
+        // Update with H = [1 0]
+        const float s = p00 + measVariance_;
+        const float k0 = p00 / s;
+        const float k1 = p01 / s;
+        const float innovation = z - x_;
+        nis_ += NIS_ALPHA * (innovation * innovation / s - nis_);
+        maneuvering_ = (nis_ > NIS_MANEUVER_THRESHOLD);
+        x_ += k0 * innovation;
+        v_ += k1 * innovation;
+
+        p00_ = (1.0f - k0) * p00;
+        p01_ = (1.0f - k0) * p01;
+        p11_ = p11 - k1 * p01;
+    }
+
+    /**
+     * @brief Filtered distance
+     * @return uint16_t Distance in mm (rounded, clamped at 0)
+     */
+    uint16_t getDistance() const {
+        if (x_ <= 0.0f) {
+            return 0;
+        }
+        if (x_ >= 65535.0f) {
+            return 65535;
+        }
+        return static_cast<uint16_t>(x_ + 0.5f);
+    }
+
+    /**
+     * @brief Estimated rate of change of distance
+     * @return int16_t Velocity in mm/s (positive = distance increasing)
+     */
+    int16_t getVelocity() const {
+        if (v_ >= 32767.0f) {
+            return 32767;
+        }
+        if (v_ <= -32767.0f) {
+            return -32767;
+        }
+        return static_cast<int16_t>(v_ >= 0.0f ? v_ + 0.5f : v_ - 0.5f);
+    }
+
+    /**
+     * @brief Check if at least one measurement has been fused
+     * @return true if the state is valid
+     */
+    bool isInitialized() const {
+        return initialized_;
+    }
+
+private:
+    /// Velocity uncertainty on first sample: desk speed unknown (~100 mm/s)
+    static constexpr float INITIAL_VELOCITY_VARIANCE = 100.0f * 100.0f;
+    /// Guards against duplicate timestamps
+    static constexpr float MIN_DT_S = 0.001f;
+    /// Caps prediction across long gaps (stale sensor, idle at 1 Hz)
+    static constexpr float MAX_DT_S = 2.0f;
+    /// Process noise scale when innovations are consistent with the model
+    static constexpr float QUIET_VARIANCE_RATIO = 1.0f / 2000.0f;
+    /// EMA weight for the innovation statistic
+    static constexpr float NIS_ALPHA = 0.3f;
+    /// Smoothed NIS above which full process noise is used (expected 1.0)
+    static constexpr float NIS_MANEUVER_THRESHOLD = 3.0f;
+
+    float accelVariance_;  ///< sigma_a^2 (mm^2/s^4)
+    float measVariance_;   ///< sigma_z^2 (mm^2)
+
+    float x_;              ///< Distance estimate (mm)
+    float v_;              ///< Velocity estimate (mm/s)
+    float p00_;            ///< Covariance [0][0]
+    float p01_;            ///< Covariance [0][1] == [1][0]
+    float p11_;            ///< Covariance [1][1]
+
+    float nis_;            ///< Smoothed normalized innovation squared
+    bool maneuvering_;     ///< Full process noise while innovations are large
+
+    uint32_t lastUs_;      ///< Timestamp of last update
+    bool initialized_;
+};
+
+#endif // VELOCITY_KALMAN_FILTER_H
@@ -0,0 +1,356 @@
+/**
+ * @file ZoneConsensus.h
+ * @brief Multi-zone consensus arithmetic (validation, median, outliers, mean)
+ *
+ * HeightController::computeMultiZoneConsensus() extracts the zones of a
+ * VL53L5CX frame (mask, sigma, confidence weights, logging) and hands the
+ * valid ones to combine(). fromZones() runs the whole median-mean path on
+ * plain status/distance arrays, which is what trace replay and native
+ * tests feed.
+ *
+ * Per 002-multi-zone-filtering:
+ *   1. Validate each zone (status 5/6/9, SENSOR_MIN_VALID_MM..SENSOR_MAX_RANGE_MM)
+ *   2. Require min_valid zones (FR-007)
+ *   3. Median of the valid zones
+ *   4. Drop zones further from the median than the outlier threshold
+ *      (fixed MULTI_ZONE_OUTLIER_THRESHOLD_MM, or scaled from the frame's
+ *      median absolute deviation)
+ *   5. Mean (or confidence-weighted mean) of the rest
+ *
+ * Header-only so native tests use this file directly.
+ */
+
+#ifndef ZONE_CONSENSUS_H
+#define ZONE_CONSENSUS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "../Config.h"
+#include "MedianSelect.h"
+
+/**
+ * @struct ConsensusResult
+ * @brief Multi-zone consensus result per data-model.md Section 2
+ *
+ * Aggregated distance estimate from multiple valid zones after outlier filtering.
+ * Used for spatial filtering stage before temporal moving average.
+ */
+struct ConsensusResult {
+    uint16_t consensus_distance_mm;   ///< Median-filtered mean of valid zones
+    uint8_t valid_zone_count;         ///< Number of zones that passed validation (0-MULTI_ZONE_TOTAL_ZONES)
+    uint8_t outlier_count;            ///< Number of zones excluded as outliers
+    bool is_reliable;                 ///< true if >= MULTI_ZONE_MIN_VALID_ZONES valid (per FR-007)
+    float estimated_sigma_mm;         ///< Predicted 1-sigma of consensus_distance_mm from zone sigmas
+    uint16_t outlier_threshold_mm;    ///< Threshold applied to this frame (0 if too few zones)
+};
+
+namespace ZoneConsensus {
+
+/// Largest zone grid of the VL53L5CX (8x8)
+constexpr uint8_t MAX_ZONES = 64;
+
+/**
+ * @struct OutlierRule
+ * @brief How the outlier threshold of a frame is chosen
+ */
+struct OutlierRule {
+    bool adaptive;      ///< MAD-scaled (true) or MULTI_ZONE_OUTLIER_THRESHOLD_MM
+    uint16_t min_mm;    ///< Adaptive lower bound
+    uint16_t max_mm;    ///< Adaptive upper bound
+};
+
+/**
+ * @brief The original fixed threshold
+ */
+inline OutlierRule fixedOutlierRule() {
+    OutlierRule rule = {false, MULTI_ZONE_OUTLIER_THRESHOLD_MM, MULTI_ZONE_OUTLIER_THRESHOLD_MM};
+    return rule;
+}
+
+/**
+ * @brief Check if a single zone measurement is valid
+ *
+ * Validates status codes (5, 6, 9 valid; 0, 255 invalid) and range.
+ *
+ * @param status Target status code from sensor
+ * @param distance Distance reading in mm
+ * @return true if zone passes validation
+ */
+inline bool isZoneValid(uint8_t status, uint16_t distance) {
+    // Accept only high-confidence status codes: 5, 6, 9
+    // Per spec clarification: reject undefined codes (1-4, 7-8, 10+) conservatively
+    if (status != 5 && status != 6 && status != 9) {
+        return false;
+    }
+
+    // Range validation
+    return distance >= SENSOR_MIN_VALID_MM && distance <= SENSOR_MAX_RANGE_MM;
+}
+
+/**
+ * @brief Calculate arithmetic mean of an array
+ *
+ * Uses uint32_t accumulator for overflow safety
+ * (64 zones x 65535 = 4,194,240).
+ *
+ * @param values Array of distances
+ * @param count Number of elements
+ * @return Mean value in mm (truncated), 0 if count is 0
+ */
+inline uint16_t mean(const uint16_t* values, uint8_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        sum += values[i];
+    }
+    return static_cast<uint16_t>(sum / count);
+}
+
+/**
+ * @brief Confidence weight of a single zone
+ *
+ * Inverse variance (1/sigma^2, sigma floored at WEIGHTED_CONSENSUS_MIN_SIGMA_MM)
+ * scaled by snr / (snr + WEIGHTED_CONSENSUS_SNR_KNEE), snr = signal / ambient.
+ *
+ * @param sigma_mm Range sigma reported by the sensor
+ * @param signal_per_spad Return signal rate (kcps/SPAD)
+ * @param ambient_per_spad Ambient rate (kcps/SPAD)
+ * @return Relative weight (> 0)
+ */
+inline float zoneWeight(uint16_t sigma_mm, uint32_t signal_per_spad, uint32_t ambient_per_spad) {
+    float sigma = (sigma_mm < WEIGHTED_CONSENSUS_MIN_SIGMA_MM)
+        ? static_cast<float>(WEIGHTED_CONSENSUS_MIN_SIGMA_MM)
+        : static_cast<float>(sigma_mm);
+
+    // Ambient of 0 (dark room) means the sigma term alone decides
+    float snrFactor = 1.0f;
+    if (ambient_per_spad > 0) {
+        float snr = static_cast<float>(signal_per_spad) / static_cast<float>(ambient_per_spad);
+        snrFactor = snr / (snr + WEIGHTED_CONSENSUS_SNR_KNEE);
+    }
+
+    return snrFactor / (sigma * sigma);
+}
+
+/**
+ * @brief Calculate weighted mean of an array
+ *
+ * @param values Array of distances
+ * @param weights Per-value weights (> 0)
+ * @param count Number of elements
+ * @return Weighted mean in mm (rounded); plain mean if all weights are 0
+ */
+inline uint16_t weightedMean(const uint16_t* values, const float* weights, uint8_t count) {
+    if (count == 0) {
+        return 0;
+    }
+
+    float weightedSum = 0.0f;
+    float weightTotal = 0.0f;
+    for (uint8_t i = 0; i < count; i++) {
+        weightedSum += weights[i] * values[i];
+        weightTotal += weights[i];
+    }
+
+    if (weightTotal <= 0.0f) {
+        return mean(values, count);
+    }
+
+    return static_cast<uint16_t>(weightedSum / weightTotal + 0.5f);
+}
+
+/**
+ * @brief Median absolute deviation from a given median
+ *
+ * @param values Array of distances
+ * @param count Number of elements (up to MAX_ZONES)
+ * @param median Pre-computed median of values
+ * @return Lower median of |value - median| in mm, 0 if count is 0
+ */
+inline uint16_t medianAbsDeviation(const uint16_t* values, uint8_t count, uint16_t median) {
+    if (count == 0) {
+        return 0;
+    }
+    uint16_t deviations[MAX_ZONES];
+    for (uint8_t i = 0; i < count; i++) {
+        deviations[i] = (values[i] >= median) ? values[i] - median : median - values[i];
+    }
+    return MedianSelect::lowerMedian(deviations, count);
+}
+
+/**
+ * @brief Outlier threshold for one frame
+ *
+ * Adaptive: MULTI_ZONE_MAD_SCALE * 1.4826 * MAD (a robust sigma that
+ * ignores up to half the zones being obstructed), clamped to
+ * [min_mm, max_mm]. Quiet short-range frames get a tight threshold that
+ * catches small obstructions; noisy long-range or sunlit frames get a
+ * wider one so genuine floor zones are not thrown away.
+ *
+ * @param values Array of distances
+ * @param count Number of elements
+ * @param median Pre-computed median of values
+ * @param rule Fixed or adaptive, with bounds
+ * @return Threshold in mm
+ */
+inline uint16_t outlierThreshold(const uint16_t* values, uint8_t count, uint16_t median,
+                                 const OutlierRule& rule) {
+    if (!rule.adaptive) {
+        return MULTI_ZONE_OUTLIER_THRESHOLD_MM;
+    }
+    uint16_t maxMm = (rule.max_mm < rule.min_mm) ? rule.min_mm : rule.max_mm;
+    float threshold = MULTI_ZONE_MAD_SCALE * 1.4826f *
+                      static_cast<float>(medianAbsDeviation(values, count, median));
+    if (threshold < rule.min_mm) {
+        return rule.min_mm;
+    }
+    if (threshold > maxMm) {
+        return maxMm;
+    }
+    return static_cast<uint16_t>(threshold + 0.5f);
+}
+
+/**
+ * @brief Flag values within threshold of the median (inclusive)
+ *
+ * @param values Array of distances
+ * @param count Number of elements
+ * @param median Pre-computed median value
+ * @param threshold Largest deviation kept, in mm
+ * @param keep_flags Output array of bools (true = keep, false = outlier)
+ * @return uint8_t Number of values kept
+ */
+inline uint8_t filterOutliers(const uint16_t* values, uint8_t count, uint16_t median,
+                              uint16_t threshold, bool* keep_flags) {
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t deviation = (values[i] >= median) ? values[i] - median : median - values[i];
+        keep_flags[i] = deviation <= threshold;
+        if (keep_flags[i]) {
+            kept++;
+        }
+    }
+    return kept;
+}
+
+/**
+ * @brief Steps 2-5 on the validated zones of one frame
+ *
+ * @param distances Valid zone distances
+ * @param sigmas Their range sigmas, or nullptr (estimated_sigma_mm stays 0)
+ * @param weights Confidence weights for a weighted mean, or nullptr for the plain mean
+ * @param count Number of valid zones (up to MAX_ZONES)
+ * @param minValidZones Zones required for a reliable result
+ * @param medianOut Receives the median of the valid zones (0 if too few)
+ * @param rule Outlier threshold rule (default: fixed)
+ * @return ConsensusResult Unreliable if too few zones or all are outliers
+ */
+inline ConsensusResult combine(const uint16_t* distances, const uint16_t* sigmas,
+                               const float* weights, uint8_t count,
+                               uint8_t minValidZones = MULTI_ZONE_MIN_VALID_ZONES,
+                               uint16_t* medianOut = nullptr,
+                               const OutlierRule& rule = fixedOutlierRule()) {
+    ConsensusResult consensus = {0, count, 0, false, 0.0f, 0};
+    if (medianOut != nullptr) {
+        *medianOut = 0;
+    }
+    if (count < minValidZones || count == 0) {
+        return consensus;
+    }
+
+    // Median selection reorders its input
+    uint16_t medianInput[MAX_ZONES];
+    memcpy(medianInput, distances, count * sizeof(uint16_t));
+    uint16_t median = MedianSelect::lowerMedian(medianInput, count);
+    if (medianOut != nullptr) {
+        *medianOut = median;
+    }
+
+    consensus.outlier_threshold_mm = outlierThreshold(distances, count, median, rule);
+    bool keep[MAX_ZONES];
+    uint8_t keptCount = filterOutliers(distances, count, median,
+                                       consensus.outlier_threshold_mm, keep);
+    consensus.outlier_count = count - keptCount;
+    if (keptCount == 0) {
+        return consensus;
+    }
+
+    uint16_t keptValues[MAX_ZONES];
+    float keptWeights[MAX_ZONES];
+    float sigmaSqSum = 0.0f;     // Σσ² (equal weights)
+    float invSigmaSqSum = 0.0f;  // Σ1/σ² (inverse-variance weights)
+    uint8_t k = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (!keep[i]) {
+            continue;
+        }
+        if (sigmas != nullptr) {
+            float sigma = (sigmas[i] < WEIGHTED_CONSENSUS_MIN_SIGMA_MM)
+                ? static_cast<float>(WEIGHTED_CONSENSUS_MIN_SIGMA_MM)
+                : static_cast<float>(sigmas[i]);
+            sigmaSqSum += sigma * sigma;
+            invSigmaSqSum += 1.0f / (sigma * sigma);
+        }
+        if (weights != nullptr) {
+            keptWeights[k] = weights[i];
+        }
+        keptValues[k++] = distances[i];
+    }
+
+    if (weights != nullptr) {
+        consensus.consensus_distance_mm = weightedMean(keptValues, keptWeights, keptCount);
+        if (sigmas != nullptr) {
+            consensus.estimated_sigma_mm = 1.0f / sqrtf(invSigmaSqSum);
+        }
+    } else {
+        consensus.consensus_distance_mm = mean(keptValues, keptCount);
+        if (sigmas != nullptr) {
+            consensus.estimated_sigma_mm = sqrtf(sigmaSqSum) / keptCount;
+        }
+    }
+    consensus.is_reliable = true;
+    return consensus;
+}
+
+/**
+ * @brief Median-mean consensus over raw zone data
+ *
+ * Same validation and combination as HeightController without the
+ * confidence fields (used by trace replay).
+ *
+ * @param status Target status per zone
+ * @param distance Distance per zone (negative = invalid)
+ * @param zones Zone count (16 or 64)
+ * @param mask Bit n set = zone n skipped (learned obstruction)
+ * @param minValidZones Zones required for a reliable result (default: zones / 4)
+ * @param rule Outlier threshold rule (default: fixed)
+ * @return ConsensusResult
+ */
+inline ConsensusResult fromZones(const uint8_t* status, const int16_t* distance, uint8_t zones,
+                                 uint64_t mask = 0, uint8_t minValidZones = 0,
+                                 const OutlierRule& rule = fixedOutlierRule()) {
+    if (zones > MAX_ZONES) {
+        zones = MAX_ZONES;
+    }
+    uint16_t valid[MAX_ZONES];
+    uint8_t count = 0;
+    for (uint8_t zone = 0; zone < zones; zone++) {
+        if (mask & (1ULL << zone)) {
+            continue;
+        }
+        uint16_t d = (distance[zone] > 0) ? static_cast<uint16_t>(distance[zone]) : 0;
+        if (isZoneValid(status[zone], d)) {
+            valid[count++] = d;
+        }
+    }
+    return combine(valid, nullptr, nullptr, count,
+                   minValidZones > 0 ? minValidZones : static_cast<uint8_t>(zones / 4),
+                   nullptr, rule);
+}
+
+} // namespace ZoneConsensus
+
+#endif // ZONE_CONSENSUS_H
@@ -0,0 +1,191 @@
+/**
+ * @file ZoneMaskLearner.h
+ * @brief Learns which sensor zones are permanently blocked by fixed objects
+ *
+ * Cable trays, desk legs and PC towers sit in the same zones every frame.
+ * During a learning run each zone is compared with the frame's floor
+ * estimate (median of the usable zones); zones that are invalid or off the
+ * floor in nearly every frame are marked in a bitmask. The consensus then
+ * skips masked zones before validation instead of re-rejecting them as
+ * outliers on every frame.
+ *
+ * Header-only (template) so native tests use this file directly.
+ */
+
+#ifndef ZONE_MASK_LEARNER_H
+#define ZONE_MASK_LEARNER_H
+
+#include <stdint.h>
+#include "../Config.h"
+
+/**
+ * @class FixedZoneMaskLearner
+ * @brief Per-zone consistency counters for one learning run
+ *
+ * Usage:
+ *   ZoneMaskLearner learner;
+ *   learner.start(150);
+ *   // per frame with a reliable floor estimate:
+ *   for (zone...) learner.observe(zone, consistentWithFloor);
+ *   learner.endFrame();
+ *   if (learner.isComplete()) {
+ *       mask = learner.computeMask(ZONE_MASK_INCONSISTENT_PERCENT, ZONE_MASK_MIN_UNMASKED_ZONES);
+ *   }
+ *
+ * @tparam ZoneCount Number of sensor zones (16 or 64)
+ */
+template <uint8_t ZoneCount>
+class FixedZoneMaskLearner {
+    static_assert(ZoneCount > 0 && ZoneCount <= 64, "Mask is a 64-bit field");
+
+public:
+    FixedZoneMaskLearner() : targetFrames_(0), frames_(0), active_(false) {
+        for (uint8_t i = 0; i < ZoneCount; i++) {
+            inconsistent_[i] = 0;
+        }
+    }
+
+    /**
+     * @brief Begin a learning run, discarding previous counters
+     * @param frames Number of frames to observe
+     */
+    void start(uint16_t frames) {
+        for (uint8_t i = 0; i < ZoneCount; i++) {
+            inconsistent_[i] = 0;
+        }
+        frames_ = 0;
+        targetFrames_ = (frames == 0) ? 1 : frames;
+        active_ = true;
+    }
+
+    /**
+     * @brief Abort the current run
+     */
+    void cancel() { active_ = false; }
+
+    /**
+     * @brief Record one zone of the current frame
+     * @param zone Zone index (0..ZoneCount-1)
+     * @param consistent true if the zone was valid and agreed with the floor
+     */
+    void observe(uint8_t zone, bool consistent) {
+        if (!active_ || zone >= ZoneCount || consistent) {
+            return;
+        }
+        inconsistent_[zone]++;
+    }
+
+    /**
+     * @brief Close the current frame
+     * @return true if this frame completed the run
+     */
+    bool endFrame() {
+        if (!active_) {
+            return false;
+        }
+        frames_++;
+        if (frames_ >= targetFrames_) {
+            active_ = false;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Build the mask from the counters
+     *
+     * A zone is masked when it was inconsistent in at least
+     * inconsistentPercent of the observed frames. If more zones qualify
+     * than the floor estimate can spare, only the worst are masked.
+     *
+     * @param inconsistentPercent Threshold (1-100)
+     * @param minUnmaskedZones Zones that must stay unmasked
+     * @return uint64_t Bit n set = zone n masked
+     */
+    uint64_t computeMask(uint8_t inconsistentPercent, uint8_t minUnmaskedZones) const {
+        if (frames_ == 0) {
+            return 0;
+        }
+        uint8_t maxMasked = (minUnmaskedZones >= ZoneCount) ? 0 : ZoneCount - minUnmaskedZones;
+
+        // Integer compare: inconsistent / frames >= percent / 100
+        uint64_t mask = 0;
+        uint8_t masked = 0;
+        for (uint8_t i = 0; i < ZoneCount; i++) {
+            if (static_cast<uint32_t>(inconsistent_[i]) * 100u >=
+                static_cast<uint32_t>(frames_) * inconsistentPercent) {
+                mask |= (1ULL << i);
+                masked++;
+            }
+        }
+
+        // Over the cap: release the least-inconsistent zones first
+        while (masked > maxMasked) {
+            uint8_t best = 0;
+            uint16_t bestCount = 0xFFFF;
+            for (uint8_t i = 0; i < ZoneCount; i++) {
+                if ((mask & (1ULL << i)) && inconsistent_[i] < bestCount) {
+                    best = i;
+                    bestCount = inconsistent_[i];
+                }
+            }
+            mask &= ~(1ULL << best);
+            masked--;
+        }
+        return mask;
+    }
+
+    /**
+     * @brief Check if a run is in progress
+     */
+    bool isActive() const { return active_; }
+
+    /**
+     * @brief Check if the last run finished (not cancelled, not running)
+     */
+    bool isComplete() const { return !active_ && targetFrames_ > 0 && frames_ >= targetFrames_; }
+
+    /**
+     * @brief Frames observed in the current/last run
+     */
+    uint16_t getFramesObserved() const { return frames_; }
+
+    /**
+     * @brief Frames requested for the current/last run
+     */
+    uint16_t getTargetFrames() const { return targetFrames_; }
+
+    /**
+     * @brief Inconsistent frame count of one zone
+     * @param zone Zone index
+     */
+    uint16_t getInconsistentCount(uint8_t zone) const {
+        return (zone < ZoneCount) ? inconsistent_[zone] : 0;
+    }
+
+    /**
+     * @brief Number of bits set in a mask
+     * @param mask Zone mask
+     */
+    static uint8_t countMasked(uint64_t mask) {
+        uint8_t count = 0;
+        while (mask) {
+            mask &= mask - 1;
+            count++;
+        }
+        return count;
+    }
+
+private:
+    uint16_t inconsistent_[ZoneCount];  ///< Frames in which each zone disagreed with the floor
+    uint16_t targetFrames_;
+    uint16_t frames_;
+    bool active_;
+};
+
+/**
+ * Learner sized for the build's zone grid (see SENSOR_ZONES_8X8)
+ */
+typedef FixedZoneMaskLearner<MULTI_ZONE_TOTAL_ZONES> ZoneMaskLearner;
+
+#endif // ZONE_MASK_LEARNER_H
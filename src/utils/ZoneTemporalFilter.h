@@ -0,0 +1,179 @@
+/**
+ * @file ZoneTemporalFilter.h
+ * @brief Per-zone exponential smoothing ahead of the spatial consensus
+ *
+ * With consensus first, a zone that flickers between valid and invalid
+ * changes the set of zones behind the mean from one frame to the next,
+ * and every change is a small step in the consensus. This stage smooths
+ * each zone over time before the consensus and bridges short dropouts
+ * with the zone's last estimate, so the zone set stays stable.
+ *
+ * Per zone and frame:
+ *   - valid:   est += (d - est) / 2^shift, or est = d if the zone had no
+ *              estimate or jumped by more than MULTI_ZONE_OUTLIER_THRESHOLD_MM
+ *              (an obstacle appearing is a step, not a ramp)
+ *   - invalid: output est with a valid status for up to holdFrames frames,
+ *              then the zone passes through as invalid
+ *
+ * State is structure-of-arrays (Q4 fixed-point estimates, age counters),
+ * and the update is a branch-free pass over contiguous arrays, so it
+ * vectorizes on hosts and stays a tight loop on the ESP32.
+ *
+ * Header-only (template) so native tests use this file directly.
+ */
+
+#ifndef ZONE_TEMPORAL_FILTER_H
+#define ZONE_TEMPORAL_FILTER_H
+
+#include <stdint.h>
+#include "../Config.h"
+#include "ZoneConsensus.h"
+
+/**
+ * @class FixedZoneTemporalFilter
+ * @brief Exponential filter with dropout bridging over every zone
+ *
+ * Usage:
+ *   ZoneTemporalFilter zoneFilter;
+ *   // per frame, before the consensus:
+ *   zoneFilter.apply(frame.target_status, frame.distance_mm, frame.range_sigma_mm);
+ *
+ * @tparam ZoneCount Number of sensor zones (16 or 64)
+ */
+template <uint8_t ZoneCount>
+class FixedZoneTemporalFilter {
+    static_assert(ZoneCount > 0 && ZoneCount <= 64, "Bridged mask is a 64-bit field");
+
+public:
+    /// Fractional bits of the estimates
+    static constexpr uint8_t FRAC_BITS = 4;
+
+    /// Status written to bridged zones (VL53L5CX "range valid")
+    static constexpr uint8_t BRIDGED_STATUS = 5;
+
+    /**
+     * @param shift Smoothing factor alpha = 1 / 2^shift (0 = pass-through)
+     * @param holdFrames Frames a dropped zone is bridged with its estimate
+     */
+    explicit FixedZoneTemporalFilter(uint8_t shift = ZONE_FILTER_SHIFT,
+                                     uint8_t holdFrames = ZONE_FILTER_HOLD_FRAMES)
+        : shift_(shift), holdFrames_(holdFrames), bridgedMask_(0), bridgedCount_(0) {
+        reset();
+    }
+
+    /**
+     * @brief Forget all zone estimates (next valid reading is taken as is)
+     */
+    void reset() {
+        for (uint8_t i = 0; i < ZoneCount; i++) {
+            estimate_[i] = 0;
+            sigma_[i] = 0;
+            age_[i] = NO_ESTIMATE;
+        }
+        bridgedMask_ = 0;
+        bridgedCount_ = 0;
+    }
+
+    /**
+     * @brief Filter one frame in place
+     *
+     * Valid zones get their smoothed distance; zones that dropped out
+     * within the last holdFrames frames get their estimate and
+     * BRIDGED_STATUS; other zones are left as read.
+     *
+     * @param status Target status per zone (updated for bridged zones)
+     * @param distance Distance per zone in mm (smoothed or bridged)
+     * @param sigma Range sigma per zone, or nullptr; bridged zones get
+     *              their last valid sigma instead of the dropout's
+     */
+    void apply(uint8_t* status, int16_t* distance, uint16_t* sigma = nullptr) {
+        // Pass 1: validity, kept apart so pass 2 has no data-dependent branches
+        uint8_t valid[ZoneCount];
+        for (uint8_t i = 0; i < ZoneCount; i++) {
+            uint16_t d = (distance[i] > 0) ? static_cast<uint16_t>(distance[i]) : 0;
+            valid[i] = ZoneConsensus::isZoneValid(status[i], d) ? 1 : 0;
+        }
+
+        // Pass 2: estimate and age update over the SoA state
+        const int32_t jump = static_cast<int32_t>(MULTI_ZONE_OUTLIER_THRESHOLD_MM) << FRAC_BITS;
+        const int32_t half = 1 << (FRAC_BITS - 1);
+        const uint8_t bridgedStatus = BRIDGED_STATUS;
+        const uint8_t noEstimate = NO_ESTIMATE;
+        uint8_t bridged[ZoneCount];
+        for (uint8_t i = 0; i < ZoneCount; i++) {
+            int32_t in = static_cast<int32_t>(distance[i]) << FRAC_BITS;
+            int32_t est = estimate_[i];
+            int32_t delta = in - est;
+            int32_t absDelta = (delta < 0) ? -delta : delta;
+            bool restart = (age_[i] > holdFrames_) | (absDelta > jump);
+            int32_t smoothed = restart ? in : est + (delta >> shift_);
+            estimate_[i] = valid[i] ? smoothed : est;
+
+            uint8_t age = age_[i] + ((age_[i] < noEstimate) ? 1 : 0);
+            age_[i] = valid[i] ? 0 : age;
+            bridged[i] = (!valid[i] & (age_[i] <= holdFrames_)) ? 1 : 0;
+
+            int16_t out = static_cast<int16_t>((estimate_[i] + half) >> FRAC_BITS);
+            distance[i] = (valid[i] | bridged[i]) ? out : distance[i];
+            status[i] = bridged[i] ? bridgedStatus : status[i];
+        }
+
+        // Sigmas and the bridged mask (diagnostics) in a separate pass
+        uint64_t mask = 0;
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < ZoneCount; i++) {
+            if (sigma != nullptr) {
+                sigma_[i] = valid[i] ? sigma[i] : sigma_[i];
+                sigma[i] = bridged[i] ? sigma_[i] : sigma[i];
+            }
+            mask |= static_cast<uint64_t>(bridged[i]) << i;
+            count += bridged[i];
+        }
+        bridgedMask_ = mask;
+        bridgedCount_ = count;
+    }
+
+    /**
+     * @brief Zones bridged in the last frame
+     * @return uint64_t Bit n set = zone n was output from its estimate
+     */
+    uint64_t getBridgedMask() const { return bridgedMask_; }
+
+    /**
+     * @brief Number of zones bridged in the last frame
+     */
+    uint8_t getBridgedCount() const { return bridgedCount_; }
+
+    /**
+     * @brief Current estimate of one zone in mm (0 if it never was valid)
+     * @param zone Zone index
+     */
+    uint16_t getEstimate(uint8_t zone) const {
+        if (zone >= ZoneCount || age_[zone] == NO_ESTIMATE) {
+            return 0;
+        }
+        return static_cast<uint16_t>((estimate_[zone] + (1 << (FRAC_BITS - 1))) >> FRAC_BITS);
+    }
+
+    uint8_t getShift() const { return shift_; }            ///< Smoothing shift
+    uint8_t getHoldFrames() const { return holdFrames_; }  ///< Dropout bridge length
+
+private:
+    /// Age of a zone that has never been valid (saturates here)
+    static constexpr uint8_t NO_ESTIMATE = 0xFF;
+
+    int32_t estimate_[ZoneCount];  ///< Q4 distance estimates (mm * 16)
+    uint16_t sigma_[ZoneCount];    ///< Last valid range sigma per zone
+    uint8_t age_[ZoneCount];       ///< Frames since each zone was last valid
+    uint8_t shift_;
+    uint8_t holdFrames_;
+    uint64_t bridgedMask_;
+    uint8_t bridgedCount_;
+};
+
+/**
+ * Filter sized for the build's zone grid (see SENSOR_ZONES_8X8)
+ */
+typedef FixedZoneTemporalFilter<MULTI_ZONE_TOTAL_ZONES> ZoneTemporalFilter;
+
+#endif // ZONE_TEMPORAL_FILTER_H
@@ -0,0 +1,56 @@
+/**
+ * @file FS.h
+ * @brief Host stand-in for the ESP32 filesystem API (native_sim env)
+ *
+ * Files accept writes and discard them; nothing is ever found on disk.
+ */
+
+#ifndef NATIVE_FS_H
+#define NATIVE_FS_H
+
+#include <Arduino.h>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+
+namespace fs {
+
+class File {
+public:
+    File() : open_(false) {}
+    explicit File(bool open) : open_(open) {}
+
+    size_t write(const uint8_t* data, size_t len) {
+        (void)data;
+        return open_ ? len : 0;
+    }
+
+    void close() { open_ = false; }
+
+    explicit operator bool() const { return open_; }
+
+private:
+    bool open_;
+};
+
+class FS {
+public:
+    File open(const char* path, const char* mode = FILE_READ) {
+        (void)path;
+        return File(mode[0] == 'w');
+    }
+
+    bool exists(const char* path) {
+        (void)path;
+        return false;
+    }
+
+    bool remove(const char* path) {
+        (void)path;
+        return false;
+    }
+};
+
+} // namespace fs
+
+#endif // NATIVE_FS_H
@@ -0,0 +1,96 @@
+/**
+ * @file Preferences.h
+ * @brief In-memory stand-in for the ESP32 NVS Preferences API (native_sim env)
+ *
+ * Values live for the life of the process, per namespace, so
+ * SystemConfiguration and PresetManager behave as on a fresh device.
+ */
+
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+
+class Preferences {
+public:
+    Preferences() : store_(nullptr) {}
+
+    bool begin(const char* name, bool readOnly = false) {
+        (void)readOnly;
+        store_ = &storage()[name];
+        return true;
+    }
+
+    void end() { store_ = nullptr; }
+
+    bool clear() {
+        if (store_ == nullptr) return false;
+        store_->clear();
+        return true;
+    }
+
+    bool remove(const char* key) {
+        return store_ != nullptr && store_->erase(key) > 0;
+    }
+
+    bool isKey(const char* key) {
+        return store_ != nullptr && store_->count(key) > 0;
+    }
+
+    size_t putUChar(const char* key, uint8_t value) { return putNumber(key, value, 1); }
+    size_t putUShort(const char* key, uint16_t value) { return putNumber(key, value, 2); }
+    size_t putULong64(const char* key, uint64_t value) { return putNumber(key, value, 8); }
+
+    size_t putFloat(const char* key, float value) {
+        return putString(key, String(value, 6));
+    }
+
+    size_t putString(const char* key, const String& value) {
+        if (store_ == nullptr) return 0;
+        (*store_)[key] = value.c_str();
+        return value.length() + 1;
+    }
+
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0) {
+        return static_cast<uint8_t>(getNumber(key, defaultValue));
+    }
+
+    uint16_t getUShort(const char* key, uint16_t defaultValue = 0) {
+        return static_cast<uint16_t>(getNumber(key, defaultValue));
+    }
+
+    uint64_t getULong64(const char* key, uint64_t defaultValue = 0) {
+        return getNumber(key, defaultValue);
+    }
+
+    float getFloat(const char* key, float defaultValue = 0.0f) {
+        return isKey(key) ? strtof((*store_)[key].c_str(), nullptr) : defaultValue;
+    }
+
+    String getString(const char* key, const String& defaultValue = String()) {
+        return isKey(key) ? String((*store_)[key].c_str()) : defaultValue;
+    }
+
+private:
+    typedef std::map<std::string, std::string> Namespace;
+    Namespace* store_;
+
+    static std::map<std::string, Namespace>& storage() {
+        static std::map<std::string, Namespace> namespaces;
+        return namespaces;
+    }
+
+    size_t putNumber(const char* key, uint64_t value, size_t bytes) {
+        if (store_ == nullptr) return 0;
+        (*store_)[key] = std::to_string(static_cast<unsigned long long>(value));
+        return bytes;
+    }
+
+    uint64_t getNumber(const char* key, uint64_t defaultValue) {
+        return isKey(key) ? strtoull((*store_)[key].c_str(), nullptr, 10) : defaultValue;
+    }
+};
+
+#endif // NATIVE_PREFERENCES_H
@@ -0,0 +1,13 @@
+/**
+ * @file SPIFFS.h
+ * @brief Host stand-in for SPIFFS (native_sim env), see FS.h
+ */
+
+#ifndef NATIVE_SPIFFS_H
+#define NATIVE_SPIFFS_H
+
+#include "FS.h"
+
+static fs::FS SPIFFS;
+
+#endif // NATIVE_SPIFFS_H
@@ -0,0 +1,78 @@
+/**
+ * @file esp32-hal-ledc.h
+ * @brief Host stand-in for the ESP32 Arduino LEDC (PWM) API (native_sim env)
+ *
+ * Records each channel's setup, attached pin and duty, and passes every
+ * ledcWrite() on to FakeLedc::onWrite, which the closed-loop tests route
+ * to the simulated desk as they do digitalWrite().
+ */
+
+#ifndef NATIVE_ESP32_HAL_LEDC_H
+#define NATIVE_ESP32_HAL_LEDC_H
+
+#include <stdint.h>
+
+/**
+ * @struct FakeLedc
+ * @brief State of the fake LEDC peripheral
+ */
+struct FakeLedc {
+    static constexpr uint8_t CHANNELS = 16;
+    static constexpr uint8_t NO_PIN = 0xFF;
+
+    uint32_t frequencyHz[CHANNELS];
+    uint8_t resolutionBits[CHANNELS];
+    uint8_t pin[CHANNELS];              ///< Attached pin, NO_PIN if none
+    uint32_t duty[CHANNELS];
+    uint32_t writes;                    ///< ledcWrite() calls since reset()
+
+    /// Called on every ledcWrite() to an attached channel
+    void (*onWrite)(uint8_t pin, uint32_t duty, uint8_t resolutionBits);
+
+    void reset() {
+        for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+            frequencyHz[channel] = 0;
+            resolutionBits[channel] = 0;
+            pin[channel] = NO_PIN;
+            duty[channel] = 0;
+        }
+        writes = 0;
+        onWrite = nullptr;
+    }
+
+    static FakeLedc& instance() {
+        static FakeLedc ledc = [] { FakeLedc fresh; fresh.reset(); return fresh; }();
+        return ledc;
+    }
+};
+
+inline uint32_t ledcSetup(uint8_t channel, uint32_t freq, uint8_t resolution_bits) {
+    FakeLedc& ledc = FakeLedc::instance();
+    if (channel >= FakeLedc::CHANNELS) return 0;
+    ledc.frequencyHz[channel] = freq;
+    ledc.resolutionBits[channel] = resolution_bits;
+    return freq;
+}
+
+inline void ledcAttachPin(uint8_t pin, uint8_t channel) {
+    if (channel < FakeLedc::CHANNELS) FakeLedc::instance().pin[channel] = pin;
+}
+
+inline void ledcDetachPin(uint8_t pin) {
+    FakeLedc& ledc = FakeLedc::instance();
+    for (uint8_t channel = 0; channel < FakeLedc::CHANNELS; channel++) {
+        if (ledc.pin[channel] == pin) ledc.pin[channel] = FakeLedc::NO_PIN;
+    }
+}
+
+inline void ledcWrite(uint8_t channel, uint32_t duty) {
+    FakeLedc& ledc = FakeLedc::instance();
+    if (channel >= FakeLedc::CHANNELS) return;
+    ledc.duty[channel] = duty;
+    ledc.writes++;
+    if (ledc.pin[channel] != FakeLedc::NO_PIN && ledc.onWrite != nullptr) {
+        ledc.onWrite(ledc.pin[channel], duty, ledc.resolutionBits[channel]);
+    }
+}
+
+#endif // NATIVE_ESP32_HAL_LEDC_H
@@ -0,0 +1,47 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the ESP32 FreeRTOS port (native_sim env)
+ *
+ * Native closed-loop tests run the controllers single-threaded through
+ * their polled paths, so critical sections and mutexes are no-ops and
+ * task creation fails. Also provides the ESP32 attributes the sources
+ * use (esp_attr.h), which ArduinoFake doesn't.
+ */
+
+#ifndef NATIVE_FREERTOS_H
+#define NATIVE_FREERTOS_H
+
+#include <stdint.h>
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+#ifndef RTC_NOINIT_ATTR
+#define RTC_NOINIT_ATTR
+#endif
+#ifndef digitalPinToInterrupt
+#define digitalPinToInterrupt(pin) (pin)
+#endif
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL 0
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+typedef struct {
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0, 0}
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
+
+#endif // NATIVE_FREERTOS_H
@@ -0,0 +1,29 @@
+/**
+ * @file semphr.h
+ * @brief Host stand-in for FreeRTOS mutexes (native_sim env, single thread)
+ */
+
+#ifndef NATIVE_FREERTOS_SEMPHR_H
+#define NATIVE_FREERTOS_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+typedef void* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+    static int mutex;
+    return &mutex;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
+
+inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+    static int mutex;
+    return &mutex;
+}
+
+inline BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+inline BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t) { return pdTRUE; }
+
+#endif // NATIVE_FREERTOS_SEMPHR_H
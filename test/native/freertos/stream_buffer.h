@@ -0,0 +1,66 @@
+/**
+ * @file stream_buffer.h
+ * @brief Host stand-in for FreeRTOS stream buffers (native_sim env)
+ *
+ * A plain byte ring with the same non-blocking semantics, so
+ * TraceRecorder works in closed-loop runs.
+ */
+
+#ifndef NATIVE_FREERTOS_STREAM_BUFFER_H
+#define NATIVE_FREERTOS_STREAM_BUFFER_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include "FreeRTOS.h"
+
+struct NativeStreamBuffer {
+    uint8_t* data;
+    size_t capacity;
+    size_t head;
+    size_t count;
+};
+
+typedef NativeStreamBuffer* StreamBufferHandle_t;
+
+inline StreamBufferHandle_t xStreamBufferCreate(size_t size, size_t) {
+    NativeStreamBuffer* buffer = static_cast<NativeStreamBuffer*>(malloc(sizeof(NativeStreamBuffer)));
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+    buffer->data = static_cast<uint8_t*>(malloc(size));
+    buffer->capacity = size;
+    buffer->head = 0;
+    buffer->count = 0;
+    return buffer;
+}
+
+inline size_t xStreamBufferSpacesAvailable(StreamBufferHandle_t buffer) {
+    return buffer->capacity - buffer->count;
+}
+
+inline BaseType_t xStreamBufferIsEmpty(StreamBufferHandle_t buffer) {
+    return buffer->count == 0 ? pdTRUE : pdFALSE;
+}
+
+inline size_t xStreamBufferSend(StreamBufferHandle_t buffer, const void* data, size_t len, TickType_t) {
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    size_t n = 0;
+    while (n < len && buffer->count < buffer->capacity) {
+        buffer->data[(buffer->head + buffer->count) % buffer->capacity] = in[n++];
+        buffer->count++;
+    }
+    return n;
+}
+
+inline size_t xStreamBufferReceive(StreamBufferHandle_t buffer, void* data, size_t len, TickType_t) {
+    uint8_t* out = static_cast<uint8_t*>(data);
+    size_t n = 0;
+    while (n < len && buffer->count > 0) {
+        out[n++] = buffer->data[buffer->head];
+        buffer->head = (buffer->head + 1) % buffer->capacity;
+        buffer->count--;
+    }
+    return n;
+}
+
+#endif // NATIVE_FREERTOS_STREAM_BUFFER_H
@@ -0,0 +1,30 @@
+/**
+ * @file task.h
+ * @brief Host stand-in for FreeRTOS tasks (native_sim env)
+ *
+ * There is no scheduler on the host: creating a task fails, so the
+ * controllers stay on their polled paths.
+ */
+
+#ifndef NATIVE_FREERTOS_TASK_H
+#define NATIVE_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*,
+                                          UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+    if (handle != nullptr) {
+        *handle = nullptr;
+    }
+    return pdFAIL;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+inline BaseType_t xTaskNotifyGive(TaskHandle_t) { return pdPASS; }
+inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t*) {}
+inline void vTaskDelay(TickType_t) {}
+
+#endif // NATIVE_FREERTOS_TASK_H
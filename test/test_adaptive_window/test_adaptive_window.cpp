@@ -0,0 +1,352 @@
+/**
+ * @file test_adaptive_window.cpp
+ * @brief Unit tests and lag benchmark for the noise-adaptive filter window
+ *
+ * Uses NoiseAdaptiveWindow.h and MovingAverageFilter.h directly, the way
+ * HeightController::updateFilterWindow() runs them with
+ * {"filterWindowMode":"adaptive"}. Signals are at the reference rate
+ * (RANGING_FREQUENCY_REFERENCE_HZ), where windows need no scaling.
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include "utils/NoiseAdaptiveWindow.h"
+#include "utils/MovingAverageFilter.h"
+
+static const uint16_t FLOOR_MM = 700;
+
+// ============================================
+// Helpers
+// ============================================
+
+/// Deterministic Gaussian noise (Box-Muller over an LCG)
+struct GaussianNoise {
+    uint32_t seed;
+
+    explicit GaussianNoise(uint32_t s) : seed(s) {}
+
+    float uniform() {
+        seed = seed * 1103515245u + 12345u;
+        return ((seed >> 8) + 1) / 16777217.0f;
+    }
+
+    float next(float sigma) {
+        float u1 = uniform();
+        float u2 = uniform();
+        return sigma * sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+    }
+};
+
+static uint16_t sample(float mm, GaussianNoise& noise, float sigma) {
+    return static_cast<uint16_t>(lroundf(mm + noise.next(sigma)));
+}
+
+/// Feed frames of a stationary floor; returns the window afterwards
+static uint8_t feedStationary(NoiseAdaptiveWindow& adaptive, GaussianNoise& noise,
+                              float sigma, uint16_t frames) {
+    for (uint16_t i = 0; i < frames; i++) {
+        adaptive.update(sample(FLOOR_MM, noise, sigma));
+    }
+    return adaptive.getWindow();
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================
+// Window sizing
+// ============================================
+
+/**
+ * window = ceil(variance / target^2), clamped to MIN..MAX_FILTER_WINDOW_SIZE
+ */
+void test_window_for_variance(void) {
+    NoiseAdaptiveWindow adaptive(1.0f);
+
+    TEST_ASSERT_EQUAL_UINT8(MIN_FILTER_WINDOW_SIZE, adaptive.windowForVariance(0.0f));
+    TEST_ASSERT_EQUAL_UINT8(3, adaptive.windowForVariance(2.25f));   // 1.5 mm
+    TEST_ASSERT_EQUAL_UINT8(4, adaptive.windowForVariance(3.5f));
+    TEST_ASSERT_EQUAL_UINT8(9, adaptive.windowForVariance(9.0f));    // 3 mm
+    TEST_ASSERT_EQUAL_UINT8(MAX_FILTER_WINDOW_SIZE, adaptive.windowForVariance(100.0f));
+}
+
+/**
+ * Until warmed up the window stays where reset() put it
+ */
+void test_starts_from_reset_window(void) {
+    NoiseAdaptiveWindow adaptive;
+    adaptive.reset(DEFAULT_FILTER_WINDOW_SIZE);
+    GaussianNoise noise(1);
+
+    for (uint8_t i = 0; i < 5; i++) {
+        TEST_ASSERT_FALSE(adaptive.update(sample(FLOOR_MM, noise, 0.5f)));
+    }
+    TEST_ASSERT_FALSE(adaptive.isWarmedUp());
+    TEST_ASSERT_EQUAL_UINT8(DEFAULT_FILTER_WINDOW_SIZE, adaptive.getWindow());
+}
+
+/**
+ * Clean floor: noise estimate close to the truth, shortest window
+ */
+void test_clean_floor_gets_short_window(void) {
+    NoiseAdaptiveWindow adaptive;
+    adaptive.reset(DEFAULT_FILTER_WINDOW_SIZE);
+    GaussianNoise noise(2);
+
+    uint8_t window = feedStationary(adaptive, noise, 1.2f, 300);
+
+    TEST_ASSERT_EQUAL_UINT8(MIN_FILTER_WINDOW_SIZE, window);
+    TEST_ASSERT_FLOAT_WITHIN(0.35f, 1.2f, adaptive.getNoiseMm());
+}
+
+/**
+ * Noisy floor: window grows to bring 3 mm of noise down to ~1 mm
+ */
+void test_noisy_floor_gets_long_window(void) {
+    NoiseAdaptiveWindow adaptive;
+    adaptive.reset(DEFAULT_FILTER_WINDOW_SIZE);
+    GaussianNoise noise(3);
+
+    uint8_t window = feedStationary(adaptive, noise, 3.0f, 300);
+
+    TEST_ASSERT_TRUE(window >= 8);
+    TEST_ASSERT_FLOAT_WITHIN(0.8f, 3.0f, adaptive.getNoiseMm());
+}
+
+/**
+ * Noise changing at runtime: window follows up, then back down
+ */
+void test_window_follows_noise_changes(void) {
+    NoiseAdaptiveWindow adaptive;
+    adaptive.reset(DEFAULT_FILTER_WINDOW_SIZE);
+    GaussianNoise noise(4);
+
+    TEST_ASSERT_EQUAL_UINT8(MIN_FILTER_WINDOW_SIZE, feedStationary(adaptive, noise, 1.0f, 200));
+    TEST_ASSERT_TRUE(feedStationary(adaptive, noise, 3.0f, 200) >= 8);
+    TEST_ASSERT_EQUAL_UINT8(MIN_FILTER_WINDOW_SIZE, feedStationary(adaptive, noise, 1.0f, 300));
+}
+
+/**
+ * Noise sitting on a window boundary: the raw estimate crosses it over
+ * and over, the hysteretic window barely moves
+ */
+void test_hysteresis_on_boundary(void) {
+    NoiseAdaptiveWindow adaptive;
+    adaptive.reset(DEFAULT_FILTER_WINDOW_SIZE);
+    GaussianNoise noise(5);
+
+    // sigma^2 = 5: boundary between windows 5 and 6
+    const float sigma = sqrtf(5.0f);
+    feedStationary(adaptive, noise, sigma, 100);
+    uint32_t switchesBefore = adaptive.getSwitchCount();
+
+    uint8_t lastRaw = 0;
+    uint32_t rawChanges = 0;
+    for (uint16_t i = 0; i < 3000; i++) {
+        adaptive.update(sample(FLOOR_MM, noise, sigma));
+        float noiseMm = adaptive.getNoiseMm();
+        uint8_t raw = adaptive.windowForVariance(noiseMm * noiseMm);
+        if (i > 0 && raw != lastRaw) {
+            rawChanges++;
+        }
+        lastRaw = raw;
+    }
+    uint32_t switches = adaptive.getSwitchCount() - switchesBefore;
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "Boundary noise over 3000 frames: raw window changes %lu, switches %lu",
+             (unsigned long)rawChanges, (unsigned long)switches);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(rawChanges >= 20);
+    TEST_ASSERT_TRUE(switches <= 2);
+}
+
+/**
+ * A desk moving at constant speed is not noise; the short start and
+ * stop kicks are capped
+ */
+void test_travel_is_not_noise(void) {
+    NoiseAdaptiveWindow adaptive;
+    adaptive.reset(DEFAULT_FILTER_WINDOW_SIZE);
+    GaussianNoise noise(6);
+    feedStationary(adaptive, noise, 1.0f, 100);
+
+    // Three moves of 300 mm at 8 mm/frame (40 mm/s at 5 Hz), with rests
+    float mm = FLOOR_MM;
+    for (uint8_t move = 0; move < 3; move++) {
+        float step = (move % 2 == 0) ? 8.0f : -8.0f;
+        for (uint8_t i = 0; i < 38; i++) {
+            mm += step;
+            adaptive.update(sample(mm, noise, 1.0f));
+        }
+        for (uint8_t i = 0; i < 20; i++) {
+            adaptive.update(sample(mm, noise, 1.0f));
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(MIN_FILTER_WINDOW_SIZE, adaptive.getWindow());
+    TEST_ASSERT_TRUE(adaptive.getNoiseMm() < 1.6f);
+}
+
+/**
+ * restart() drops the history, so a jump across a gap is not noise
+ */
+void test_restart_across_gap(void) {
+    NoiseAdaptiveWindow adaptive;
+    adaptive.reset(DEFAULT_FILTER_WINDOW_SIZE);
+    GaussianNoise noise(7);
+    feedStationary(adaptive, noise, 1.0f, 100);
+    float before = adaptive.getNoiseMm();
+
+    adaptive.restart();
+    for (uint8_t i = 0; i < 5; i++) {
+        adaptive.update(sample(FLOOR_MM + 150, noise, 1.0f));
+    }
+
+    TEST_ASSERT_FLOAT_WITHIN(0.3f, before, adaptive.getNoiseMm());
+    TEST_ASSERT_EQUAL_UINT8(MIN_FILTER_WINDOW_SIZE, adaptive.getWindow());
+}
+
+// ============================================
+// Benchmark: lag and residual noise, fixed vs adaptive
+// ============================================
+
+struct WindowResult {
+    uint8_t window;
+    float residualMm;      ///< 1-sigma of the filter output while stationary
+    uint8_t settleFrames;  ///< Frames until a 50 mm step is within 2 mm
+};
+
+/**
+ * Stationary floor, then a 50 mm step, through a moving average whose
+ * window is fixed (adaptive = false) or follows NoiseAdaptiveWindow
+ */
+static WindowResult runWindow(float sigma, bool adaptive, uint32_t seed) {
+    GaussianNoise noise(seed);
+    MovingAverageFilter filter(DEFAULT_FILTER_WINDOW_SIZE);
+    NoiseAdaptiveWindow adaptiveWindow;
+    adaptiveWindow.reset(DEFAULT_FILTER_WINDOW_SIZE);
+
+    const uint16_t frames = 400;
+    float sum = 0.0f;
+    float sumSq = 0.0f;
+    uint16_t counted = 0;
+    for (uint16_t i = 0; i < frames; i++) {
+        uint16_t mm = sample(FLOOR_MM, noise, sigma);
+        if (adaptiveWindow.update(mm) && adaptive) {
+            filter.resize(adaptiveWindow.getWindow());
+        }
+        filter.addSample(mm);
+        if (i >= frames / 2) {
+            float out = static_cast<float>(filter.getAverage()) - FLOOR_MM;
+            sum += out;
+            sumSq += out * out;
+            counted++;
+        }
+    }
+    float mean = sum / counted;
+
+    WindowResult result;
+    result.window = filter.getWindowSize();
+    result.residualMm = sqrtf(sumSq / counted - mean * mean);
+    result.settleFrames = 0;
+
+    // Noise-free step so settling is the window alone
+    const uint16_t target = FLOOR_MM + 50;
+    for (uint8_t i = 1; i <= 2 * MAX_FILTER_WINDOW_SIZE; i++) {
+        filter.addSample(target);
+        if (filter.getAverage() + 2 >= target) {
+            result.settleFrames = i;
+            break;
+        }
+    }
+    return result;
+}
+
+static void reportWindow(const char* floor, const char* rule, const WindowResult& r) {
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%-6s %-8s window %2u  residual %.2f mm  step settles in %u frames (%u ms)",
+             floor, rule, r.window, r.residualMm, r.settleFrames,
+             r.settleFrames * 1000u / RANGING_FREQUENCY_REFERENCE_HZ);
+    TEST_MESSAGE(msg);
+}
+
+/**
+ * Clean floor: adaptive settles faster at a residual still near 1 mm
+ */
+void test_benchmark_clean_floor(void) {
+    WindowResult fixed = runWindow(1.2f, false, 11);
+    WindowResult adaptive = runWindow(1.2f, true, 11);
+    reportWindow("clean", "fixed", fixed);
+    reportWindow("clean", "adaptive", adaptive);
+
+    TEST_ASSERT_EQUAL_UINT8(DEFAULT_FILTER_WINDOW_SIZE, fixed.window);
+    TEST_ASSERT_EQUAL_UINT8(MIN_FILTER_WINDOW_SIZE, adaptive.window);
+    TEST_ASSERT_TRUE(adaptive.settleFrames < fixed.settleFrames);
+    TEST_ASSERT_TRUE(adaptive.residualMm < 1.0f);
+}
+
+/**
+ * Noisy floor: adaptive pays more lag for a much quieter output
+ */
+void test_benchmark_noisy_floor(void) {
+    WindowResult fixed = runWindow(3.0f, false, 12);
+    WindowResult adaptive = runWindow(3.0f, true, 12);
+    reportWindow("noisy", "fixed", fixed);
+    reportWindow("noisy", "adaptive", adaptive);
+
+    TEST_ASSERT_TRUE(adaptive.window > fixed.window);
+    TEST_ASSERT_TRUE(adaptive.residualMm < 0.85f * fixed.residualMm);
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_window_for_variance);
+    RUN_TEST(test_starts_from_reset_window);
+    RUN_TEST(test_clean_floor_gets_short_window);
+    RUN_TEST(test_noisy_floor_gets_long_window);
+    RUN_TEST(test_window_follows_noise_changes);
+    RUN_TEST(test_hysteresis_on_boundary);
+    RUN_TEST(test_travel_is_not_noise);
+    RUN_TEST(test_restart_across_gap);
+    RUN_TEST(test_benchmark_clean_floor);
+    RUN_TEST(test_benchmark_noisy_floor);
+
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    UNITY_BEGIN();
+
+    RUN_TEST(test_window_for_variance);
+    RUN_TEST(test_starts_from_reset_window);
+    RUN_TEST(test_clean_floor_gets_short_window);
+    RUN_TEST(test_noisy_floor_gets_long_window);
+    RUN_TEST(test_window_follows_noise_changes);
+    RUN_TEST(test_hysteresis_on_boundary);
+    RUN_TEST(test_travel_is_not_noise);
+    RUN_TEST(test_restart_across_gap);
+    RUN_TEST(test_benchmark_clean_floor);
+    RUN_TEST(test_benchmark_noisy_floor);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
+#endif
@@ -0,0 +1,101 @@
+/**
+ * @file test_boot_timeline.cpp
+ * @brief Unit tests for the setup() phase timeline served by GET /boot
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cstring>
+#include "utils/BootTimeline.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================
+// Tests
+// ============================================
+
+/**
+ * @test Empty timeline reports nothing
+ */
+void test_empty_timeline(void) {
+    BootTimeline timeline;
+    TEST_ASSERT_EQUAL_UINT8(0, timeline.getCount());
+    TEST_ASSERT_EQUAL_UINT32(0, timeline.getTotalUs());
+    TEST_ASSERT_EQUAL_STRING("", timeline.getName(0));
+    TEST_ASSERT_EQUAL_UINT32(0, timeline.getDurationUs(0));
+}
+
+/**
+ * @test Durations are the gaps between consecutive marks
+ */
+void test_phase_durations(void) {
+    BootTimeline timeline;
+    timeline.mark("serial", 120000);
+    timeline.mark("nvs", 150000);
+    timeline.mark("sensor", 1050000);
+
+    TEST_ASSERT_EQUAL_UINT8(3, timeline.getCount());
+    TEST_ASSERT_EQUAL_STRING("sensor", timeline.getName(2));
+    TEST_ASSERT_EQUAL_UINT32(120000, timeline.getDurationUs(0));
+    TEST_ASSERT_EQUAL_UINT32(30000, timeline.getDurationUs(1));
+    TEST_ASSERT_EQUAL_UINT32(900000, timeline.getDurationUs(2));
+    TEST_ASSERT_EQUAL_UINT32(1050000, timeline.getTimestampUs(2));
+    TEST_ASSERT_EQUAL_UINT32(1050000, timeline.getTotalUs());
+}
+
+/**
+ * @test Marks beyond capacity are dropped, earlier ones kept
+ */
+void test_capacity(void) {
+    BootTimeline timeline;
+    for (uint8_t i = 0; i < BOOT_TIMELINE_MAX_PHASES; i++) {
+        TEST_ASSERT_TRUE(timeline.mark("phase", (i + 1) * 1000));
+    }
+    TEST_ASSERT_FALSE(timeline.mark("overflow", 999999));
+    TEST_ASSERT_EQUAL_UINT8(BOOT_TIMELINE_MAX_PHASES, timeline.getCount());
+    TEST_ASSERT_EQUAL_UINT32(BOOT_TIMELINE_MAX_PHASES * 1000, timeline.getTotalUs());
+}
+
+/**
+ * @test Duration stays correct across a micros() wrap
+ */
+void test_duration_across_wrap(void) {
+    BootTimeline timeline;
+    timeline.mark("a", 0xFFFFFF00u);
+    timeline.mark("b", 0x00000100u);
+    TEST_ASSERT_EQUAL_UINT32(0x200, timeline.getDurationUs(1));
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_timeline);
+    RUN_TEST(test_phase_durations);
+    RUN_TEST(test_capacity);
+    RUN_TEST(test_duration_across_wrap);
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_timeline);
+    RUN_TEST(test_phase_durations);
+    RUN_TEST(test_capacity);
+    RUN_TEST(test_duration_across_wrap);
+    UNITY_END();
+}
+
+void loop() {}
+#endif
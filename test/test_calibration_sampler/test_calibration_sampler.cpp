@@ -0,0 +1,206 @@
+/**
+ * @file test_calibration_sampler.cpp
+ * @brief Unit tests for the calibration job sampler
+ *
+ * Uses CalibrationSampler.h directly with the job limits from Config.h.
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include "Config.h"
+#include "utils/CalibrationSampler.h"
+
+static uint32_t lcgState = 1;
+
+static double uniform01() {
+    lcgState = lcgState * 1103515245u + 12345u;
+    return ((lcgState >> 8) & 0xFFFFFF) / 16777216.0 + 1e-9;
+}
+
+static double gaussian() {
+    return std::sqrt(-2.0 * std::log(uniform01())) * std::cos(2.0 * M_PI * uniform01());
+}
+
+/**
+ * @brief Feed consensus-like samples until the job ends
+ * @return Samples used
+ */
+static uint16_t runJob(CalibrationSampler& sampler, double trueMm, double sigmaMm) {
+    sampler.start(CALIBRATION_MIN_SAMPLES, CALIBRATION_MAX_SAMPLES, CALIBRATION_TARGET_STDERR_MM);
+    while (sampler.isActive()) {
+        double d = trueMm + gaussian() * sigmaMm;
+        sampler.addSample(static_cast<uint16_t>(d + 0.5));
+    }
+    return sampler.getCount();
+}
+
+void setUp(void) {
+    lcgState = 1;
+}
+
+void tearDown(void) {}
+
+// ============================================
+// Tests
+// ============================================
+
+/**
+ * @test Mean and standard error match the textbook formulas
+ */
+void test_statistics_match_direct_computation(void) {
+    const uint16_t samples[] = {700, 702, 698, 705, 699, 701, 697, 703};
+    const uint8_t n = sizeof(samples) / sizeof(samples[0]);
+    CalibrationSampler sampler;
+    sampler.start(100, 100, 0.0f);
+    double sum = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        sampler.addSample(samples[i]);
+        sum += samples[i];
+    }
+    double mean = sum / n;
+    double ss = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        ss += (samples[i] - mean) * (samples[i] - mean);
+    }
+    double sd = std::sqrt(ss / (n - 1));
+
+    TEST_ASSERT_EQUAL_UINT16(n, sampler.getCount());
+    TEST_ASSERT_EQUAL_UINT16(static_cast<uint16_t>(mean + 0.5), sampler.getMeanMm());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, (float)sd, sampler.getStdDevMm());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, (float)(sd / std::sqrt((double)n)), sampler.getStdErrMm());
+}
+
+/**
+ * @test No early stop before two samples, and not before the minimum
+ */
+void test_minimum_samples_enforced(void) {
+    CalibrationSampler sampler;
+    sampler.start(5, 50, 0.5f);
+    TEST_ASSERT_TRUE(std::isinf(sampler.getStdErrMm()));
+
+    // Identical samples: standard error 0 from the second sample on
+    for (uint8_t i = 0; i < 4; i++) {
+        TEST_ASSERT_FALSE(sampler.addSample(700));
+    }
+    TEST_ASSERT_TRUE(sampler.addSample(700));
+    TEST_ASSERT_TRUE(sampler.isConverged());
+    TEST_ASSERT_FALSE(sampler.isActive());
+    TEST_ASSERT_EQUAL_UINT16(5, sampler.getCount());
+
+    // A minimum below 2 is raised to 2
+    sampler.start(0, 50, 0.5f);
+    TEST_ASSERT_FALSE(sampler.addSample(700));
+    TEST_ASSERT_TRUE(sampler.addSample(700));
+}
+
+/**
+ * @test Job ends at the cap without converging when readings are too noisy
+ */
+void test_cap_without_convergence(void) {
+    CalibrationSampler sampler;
+    uint16_t used = runJob(sampler, 700.0, 40.0);
+    TEST_ASSERT_EQUAL_UINT16(CALIBRATION_MAX_SAMPLES, used);
+    TEST_ASSERT_FALSE(sampler.isConverged());
+    TEST_ASSERT_TRUE(sampler.getStdErrMm() > CALIBRATION_TARGET_STDERR_MM);
+    // Further samples are ignored
+    TEST_ASSERT_FALSE(sampler.addSample(700));
+    TEST_ASSERT_EQUAL_UINT16(CALIBRATION_MAX_SAMPLES, sampler.getCount());
+}
+
+/**
+ * @test Quiet floor stops early; noisier floor samples longer but stays accurate
+ */
+void test_early_stop_scales_with_noise(void) {
+    CalibrationSampler sampler;
+    char msg[96];
+    uint16_t previous = 0;
+    const double sigmas[] = {1.0, 2.0, 4.0};
+    for (uint8_t i = 0; i < 3; i++) {
+        uint16_t used = runJob(sampler, 731.3, sigmas[i]);
+        snprintf(msg, sizeof(msg), "sigma %.1f mm: %u samples, mean %u mm, std error %.2f mm",
+                 sigmas[i], used, sampler.getMeanMm(), sampler.getStdErrMm());
+        TEST_MESSAGE(msg);
+
+        TEST_ASSERT_TRUE(sampler.isConverged());
+        TEST_ASSERT_TRUE(used >= previous);
+        TEST_ASSERT_UINT16_WITHIN(2, 731, sampler.getMeanMm());
+        previous = used;
+    }
+    // 1 mm consensus noise needs far fewer than the cap
+    lcgState = 1;
+    TEST_ASSERT_TRUE(runJob(sampler, 731.3, 1.0) < CALIBRATION_MAX_SAMPLES / 4);
+}
+
+/**
+ * @test Mean error across jobs is within the target bound
+ */
+void test_converged_mean_accuracy(void) {
+    CalibrationSampler sampler;
+    double sqErr = 0;
+    const uint16_t jobs = 200;
+    for (uint16_t j = 0; j < jobs; j++) {
+        runJob(sampler, 650.0, 2.0);
+        double err = sampler.getMeanMm() - 650.0;
+        sqErr += err * err;
+    }
+    // RMS error of a converged job: target std error plus 0.5 mm rounding
+    TEST_ASSERT_TRUE(std::sqrt(sqErr / jobs) < 1.0);
+}
+
+/**
+ * @test cancel() stops a job; start() discards old samples
+ */
+void test_cancel_and_restart(void) {
+    CalibrationSampler sampler;
+    sampler.start(10, 100, 0.5f);
+    sampler.addSample(900);
+    sampler.addSample(950);
+    sampler.cancel();
+    TEST_ASSERT_FALSE(sampler.isActive());
+    TEST_ASSERT_FALSE(sampler.isConverged());
+    TEST_ASSERT_FALSE(sampler.addSample(900));
+
+    sampler.start(10, 100, 0.5f);
+    TEST_ASSERT_TRUE(sampler.isActive());
+    TEST_ASSERT_EQUAL_UINT16(0, sampler.getCount());
+    sampler.addSample(700);
+    TEST_ASSERT_EQUAL_UINT16(700, sampler.getMeanMm());
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_statistics_match_direct_computation);
+    RUN_TEST(test_minimum_samples_enforced);
+    RUN_TEST(test_cap_without_convergence);
+    RUN_TEST(test_early_stop_scales_with_noise);
+    RUN_TEST(test_converged_mean_accuracy);
+    RUN_TEST(test_cancel_and_restart);
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);
+    UNITY_BEGIN();
+    RUN_TEST(test_statistics_match_direct_computation);
+    RUN_TEST(test_minimum_samples_enforced);
+    RUN_TEST(test_cap_without_convergence);
+    RUN_TEST(test_early_stop_scales_with_noise);
+    RUN_TEST(test_converged_mean_accuracy);
+    RUN_TEST(test_cancel_and_restart);
+    UNITY_END();
+}
+
+void loop() {}
+#endif
@@ -0,0 +1,929 @@
+/**
+ * @file test_desk_sim.cpp
+ * @brief Desk simulator model tests and closed-loop movement runs
+ *
+ * The first tests check the simulated motor, sensor and MoveMetrics on
+ * their own. The closed-loop tests (native_sim env only) run the real
+ * HeightController and MovementController against DeskSimulator:
+ * millis()/micros() come from the simulated clock and the motor pin
+ * writes drive the simulated desk. Each run prints time-to-target,
+ * overshoot and settle time.
+ *
+ * Control is ticked as in main.cpp's loop() in interrupt mode: on every
+ * frame, on a pending ranging profile switch, or once per sample interval.
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#include <chrono>
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cstdio>
+#include "utils/DeskSimulator.h"
+#ifdef NATIVE_TEST
+#include <esp32-hal-ledc.h>
+#include "HeightController.h"
+#include "MovementController.h"
+#include "utils/Logger.h"
+#endif
+
+static const int16_t CAL_OFFSET_MM = 30;     // Desktop surface above the sensor
+static const uint16_t START_DISTANCE_MM = 700;
+
+// ============================================
+// Helpers
+// ============================================
+
+static uint8_t readyFramesIn(DeskSimulator& desk, uint32_t ms) {
+    ZoneFrame frame;
+    uint8_t frames = 0;
+    for (uint32_t t = 0; t < ms; t++) {
+        desk.advance(1000);
+        if (desk.isDataReady() && desk.readFrame(frame)) {
+            frames++;
+        }
+    }
+    return frames;
+}
+
+// ============================================
+// Model Tests
+// ============================================
+
+/**
+ * @test Drive starts after the response delay and ramps to full speed
+ */
+void test_motor_response_and_ramp(void) {
+    DeskModel model;
+    DeskSimulator desk(model, START_DISTANCE_MM);
+
+    desk.writePin(PIN_MOTOR_UP, HIGH);
+    desk.advance((model.response_ms - 10) * 1000UL);
+    TEST_ASSERT_EQUAL_INT8(0, desk.getDrive());
+    TEST_ASSERT_FALSE(desk.isMoving());
+
+    desk.advance(20 * 1000UL);
+    TEST_ASSERT_EQUAL_INT8(1, desk.getDrive());
+    TEST_ASSERT_TRUE(desk.getVelocityMmS() > 0.0f);
+
+    // Ramp: full speed after up_speed / accel seconds
+    desk.advance(static_cast<uint32_t>(model.up_speed_mm_s / model.accel_mm_s2 * 1e6f) + 1000);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, model.up_speed_mm_s, desk.getVelocityMmS());
+
+    // Steady state: one more second is up_speed millimetres
+    float before = desk.getDistanceMm();
+    desk.advance(1000000);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, model.up_speed_mm_s, desk.getDistanceMm() - before);
+}
+
+/**
+ * @test After power is cut the desk coasts v^2 / (2 * decel) and stops
+ */
+void test_motor_coast_down(void) {
+    DeskModel model;
+    DeskSimulator desk(model, START_DISTANCE_MM);
+
+    desk.writePin(PIN_MOTOR_DOWN, HIGH);
+    desk.advance(2000000);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -model.down_speed_mm_s, desk.getVelocityMmS());
+
+    desk.writePin(PIN_MOTOR_DOWN, LOW);
+    desk.advance(model.response_ms * 1000UL);
+    float cutAt = desk.getDistanceMm();
+    desk.advance(1000000);
+    TEST_ASSERT_FALSE(desk.isMoving());
+
+    float expected = model.down_speed_mm_s * model.down_speed_mm_s / (2.0f * model.decel_mm_s2);
+    TEST_ASSERT_FLOAT_WITHIN(0.3f, expected, cutAt - desk.getDistanceMm());
+}
+
+/**
+ * @test Both motor inputs high is counted and cuts the drive; end stops hold
+ */
+void test_pin_conflict_and_end_stop(void) {
+    DeskModel model;
+    DeskSimulator desk(model, model.max_distance_mm - 20);
+
+    desk.writePin(PIN_MOTOR_UP, HIGH);
+    desk.writePin(PIN_MOTOR_DOWN, HIGH);
+    desk.advance(500000);
+    TEST_ASSERT_EQUAL_UINT32(1, desk.getPinConflictCount());
+    TEST_ASSERT_EQUAL_INT8(0, desk.getDrive());
+
+    desk.writePin(PIN_MOTOR_DOWN, LOW);
+    desk.advance(3000000);
+    TEST_ASSERT_EQUAL_FLOAT(model.max_distance_mm, desk.getDistanceMm());
+    TEST_ASSERT_FALSE(desk.isMoving());
+}
+
+/**
+ * @test Frames arrive at the ranging frequency; offline sensor gives none
+ */
+void test_frames_follow_ranging_rate(void) {
+    DeskSimulator desk;
+    uint32_t uploadUs, uploadHz;
+    TEST_ASSERT_TRUE(desk.begin(uploadUs, uploadHz));
+    TEST_ASSERT_FALSE(desk.isDataReady());
+
+    TEST_ASSERT_TRUE(desk.startRanging(15));
+    TEST_ASSERT_EQUAL_UINT8(15, readyFramesIn(desk, 1000));
+    TEST_ASSERT_TRUE(desk.startRanging(1));
+    TEST_ASSERT_EQUAL_UINT8(2, readyFramesIn(desk, 2000));
+
+    desk.setOffline(true);
+    TEST_ASSERT_EQUAL_UINT8(0, readyFramesIn(desk, 2000));
+    TEST_ASSERT_FALSE(desk.begin(uploadUs, uploadHz));
+}
+
+/**
+ * @test Zones read the floor with noise and bias; obstacle zones read its top
+ */
+void test_zones_floor_noise_and_obstacle(void) {
+    DeskModel model;
+    model.dropout_percent = 0;
+    DeskSimulator desk(model, 900, 7);
+    const uint64_t chairZones = (1ULL << 0) | (1ULL << 1);
+    desk.addObstacle(chairZones, 450);
+
+    uint32_t uploadUs, uploadHz;
+    desk.begin(uploadUs, uploadHz);
+    desk.startRanging(15);
+
+    ZoneFrame frame;
+    float sum = 0.0f, sumSq = 0.0f;
+    uint32_t count = 0;
+    for (uint16_t i = 0; i < 200; i++) {
+        desk.advance(1000000 / 15);
+        TEST_ASSERT_TRUE(desk.isDataReady());
+        TEST_ASSERT_TRUE(desk.readFrame(frame));
+        for (uint8_t zone = 0; zone < MULTI_ZONE_TOTAL_ZONES; zone++) {
+            TEST_ASSERT_EQUAL_UINT8(DeskSimulator::STATUS_VALID, frame.target_status[zone]);
+            if (chairZones & (1ULL << zone)) {
+                TEST_ASSERT_INT_WITHIN(30, 450, frame.distance_mm[zone]);
+                continue;
+            }
+            float error = frame.distance_mm[zone] - 900.0f;
+            sum += error;
+            sumSq += error * error;
+            count++;
+        }
+    }
+
+    float mean = sum / count;
+    float sigma = sqrtf(sumSq / count - mean * mean);
+    TEST_ASSERT_FLOAT_WITHIN(model.zone_bias_mm, 0.0f, mean);
+    TEST_ASSERT_FLOAT_WITHIN(1.5f, sqrtf(model.noise_mm * model.noise_mm +
+                                         model.zone_bias_mm * model.zone_bias_mm / 3.0f), sigma);
+}
+
+/**
+ * @test Injected motor faults: jammed desk, stuck-on driver, swapped wires
+ */
+void test_motor_faults(void) {
+    DeskModel model;
+    DeskSimulator desk(model, 900);
+
+    desk.setMotorFault(DeskMotorFault::JAMMED);
+    desk.writePin(PIN_MOTOR_UP, HIGH);
+    desk.advance(1000000);
+    TEST_ASSERT_EQUAL_INT8(1, desk.getDrive());
+    TEST_ASSERT_FALSE(desk.isMoving());
+
+    desk.setMotorFault(DeskMotorFault::REVERSED);
+    desk.advance(1000000);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -model.down_speed_mm_s, desk.getVelocityMmS());
+
+    // Switched off in the reversed direction: the driver stays on downwards
+    desk.setMotorFault(DeskMotorFault::NONE);
+    desk.writePin(PIN_MOTOR_UP, LOW);
+    desk.writePin(PIN_MOTOR_DOWN, HIGH);
+    desk.advance(1000000);
+    desk.setMotorFault(DeskMotorFault::STUCK_ON);
+    desk.writePin(PIN_MOTOR_DOWN, LOW);
+    desk.advance(1000000);
+    TEST_ASSERT_EQUAL_INT8(0, desk.getDrive());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -model.down_speed_mm_s, desk.getVelocityMmS());
+}
+
+/**
+ * @test PWM duty scales the speed; both inputs with duty is a conflict
+ */
+void test_pwm_duty_scales_speed(void) {
+    DeskModel model;
+    DeskSimulator desk(model, START_DISTANCE_MM);
+
+    desk.writeDuty(PIN_MOTOR_UP, 511, 10);
+    desk.advance(2000000);
+    TEST_ASSERT_EQUAL_INT8(1, desk.getDrive());
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, model.up_speed_mm_s * 0.5f, desk.getVelocityMmS());
+
+    // Same direction: a duty change applies without the response delay
+    desk.writeDuty(PIN_MOTOR_UP, 1023, 10);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, desk.getDriveLevel());
+
+    desk.writeDuty(PIN_MOTOR_DOWN, 100, 10);
+    TEST_ASSERT_EQUAL_UINT32(1, desk.getPinConflictCount());
+    desk.writeDuty(PIN_MOTOR_DOWN, 0, 10);
+    desk.writeDuty(PIN_MOTOR_UP, 0, 10);
+    desk.advance(1000000);
+    TEST_ASSERT_EQUAL_INT8(0, desk.getDrive());
+    TEST_ASSERT_FALSE(desk.isMoving());
+}
+
+/**
+ * @test MoveMetrics: time to target, overshoot, reversals and settle time
+ */
+void test_move_metrics(void) {
+    MoveMetrics metrics;
+    metrics.begin(1000, 700.0f, 800.0f, 10.0f);
+
+    // Rise at 0.1 mm/ms, overshoot to 815, reverse, settle at 803
+    float position = 700.0f;
+    uint32_t t = 1000;
+    for (; position < 815.0f; t++, position += 0.1f) metrics.sample(t, position, 1, true);
+    for (; position > 803.0f; t++, position -= 0.1f) metrics.sample(t, position, -1, true);
+    uint32_t stoppedAt = t;
+    for (; t < stoppedAt + 500; t++) metrics.sample(t, position, 0, false);
+
+    const MoveReport& report = metrics.report();
+    TEST_ASSERT_TRUE(report.reached);
+    TEST_ASSERT_TRUE(report.settled);
+    TEST_ASSERT_UINT32_WITHIN(2, 900, report.time_to_target_ms);
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, 15.0f, report.overshoot_mm);
+    TEST_ASSERT_EQUAL_UINT16(1, report.reversals);
+    TEST_ASSERT_EQUAL_UINT32(stoppedAt - 1000, report.settle_time_ms);
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, 3.0f, report.final_error_mm);
+
+    // Leaving the band again clears the settled state
+    metrics.sample(t, 820.0f, 0, false);
+    TEST_ASSERT_FALSE(metrics.report().settled);
+}
+
+// ============================================
+// Closed-Loop Tests (native_sim env)
+// ============================================
+
+#ifdef NATIVE_TEST
+
+static DeskSimulator* desk = nullptr;
+static HeightController* height = nullptr;
+static MovementController* movement = nullptr;
+static uint32_t lastSensorMs = 0;
+static uint32_t lastControlMs = 0;
+
+static float trueHeightMm() {
+    return CAL_OFFSET_MM + desk->getDistanceMm();
+}
+
+static void onMovementStatus(MovementState state, const char* message) {
+    (void)message;
+    // As main.cpp: range fast while the desk moves or settles
+    bool active = (state == MovementState::MOVING_UP ||
+                   state == MovementState::MOVING_DOWN ||
+                   state == MovementState::STABILIZING);
+    height->requestRangingProfile(active ? RangingProfile::ACTIVE : RangingProfile::IDLE);
+}
+
+/**
+ * @brief One millisecond of the firmware's tasks (interrupt mode timing)
+ *
+ * The height update stands in for the acquisition task woken by the
+ * data-ready edge, the movement update for the control task's pass.
+ */
+static void controlTick() {
+    uint32_t now = desk->nowMs();
+    bool frameReady = desk->isDataReady();   // Stands in for the data-ready edge
+    if (frameReady || height->isRangingProfilePending() ||
+        now - lastSensorMs >= height->getSampleIntervalMs()) {
+        lastSensorMs = now;
+        height->update();
+    }
+    if (now - lastControlMs >= CONTROL_PERIOD_MS) {
+        lastControlMs = now;
+        movement->update();
+    }
+}
+
+static void runFor(uint32_t ms) {
+    for (uint32_t t = 0; t < ms; t++) {
+        desk->advance(DeskSimulator::STEP_US);
+        controlTick();
+    }
+}
+
+/**
+ * @brief Build the desk and controllers, boot them and let the reading settle
+ */
+static void startDesk(const DeskModel& model, uint16_t startDistanceMm, uint32_t seed) {
+    desk = new DeskSimulator(model, startDistanceMm, seed);
+    height = new HeightController(*desk);
+    movement = new MovementController(*height);
+    lastSensorMs = 0;
+    lastControlMs = 0;
+
+    TEST_ASSERT_TRUE(height->init());
+    movement->init();
+    movement->setStatusCallback(onMovementStatus);
+    runFor(3000);
+    TEST_ASSERT_TRUE(height->isValid());
+}
+
+/**
+ * @brief Check a move ended at the target with the controller idle
+ *
+ * The controller judges the target by the measured height, so the true
+ * height may be off by the sensor's fixed bias on top of the tolerance.
+ */
+static void assertArrived(const MoveReport& report) {
+    TEST_ASSERT_TRUE(report.reached);
+    TEST_ASSERT_FALSE(movement->hasError());
+    TEST_ASSERT_EQUAL(MovementState::IDLE, movement->getState());
+    TEST_ASSERT_TRUE(fabsf(report.final_error_mm) <=
+                     SystemConfig.getTolerance() + desk->getModel().zone_bias_mm);
+    TEST_ASSERT_EQUAL_UINT32(0, desk->getPinConflictCount());
+}
+
+/**
+ * @brief Move to a target and measure the move from the true desk height
+ *
+ * Runs until the movement controller is done (IDLE or ERROR) and the desk
+ * has stopped, or maxMs.
+ */
+static MoveReport runMove(const char* name, uint16_t targetHeightMm, uint32_t maxMs = 60000) {
+    MoveMetrics metrics;
+    float start = trueHeightMm();
+    metrics.begin(desk->nowMs(), start, targetHeightMm, SystemConfig.getTolerance());
+    TEST_ASSERT_TRUE(movement->setTargetHeight(targetHeightMm));
+
+    uint32_t startMs = desk->nowMs();
+    while (desk->nowMs() - startMs < maxMs) {
+        desk->advance(DeskSimulator::STEP_US);
+        controlTick();
+        metrics.sample(desk->nowMs(), trueHeightMm(), desk->getDrive(), desk->isMoving());
+
+        bool done = !movement->getTarget().active || movement->hasError();
+        if (done && desk->getDrive() == 0 && !desk->isMoving()) {
+            break;
+        }
+    }
+
+    const MoveReport& report = metrics.report();
+    printf("  %-22s %4.0f -> %4u mm: to target %5lu ms, overshoot %4.1f mm, "
+           "settled %s %5lu ms, error %+5.1f mm, %u reversals, %s\n",
+           name, start, targetHeightMm, (unsigned long)report.time_to_target_ms,
+           report.overshoot_mm, report.settled ? "in" : "NOT",
+           (unsigned long)report.settle_time_ms, report.final_error_mm, report.reversals,
+           movement->getStateString());
+    return report;
+}
+
+/**
+ * @test Rising move reaches the target and settles within tolerance
+ */
+void test_closed_loop_move_up(void) {
+    startDesk(DeskModel(), START_DISTANCE_MM, 1);
+    MoveReport report = runMove("up", 1000);
+
+    assertArrived(report);
+    // 270 mm at 35 mm/s plus ramp and sensor lag
+    TEST_ASSERT_UINT32_WITHIN(1500, 7700, report.time_to_target_ms);
+}
+
+/**
+ * @test Lowering move reaches the target and settles within tolerance
+ */
+void test_closed_loop_move_down(void) {
+    startDesk(DeskModel(), 1100, 2);
+    MoveReport report = runMove("down", 800);
+
+    assertArrived(report);
+    // 330 mm at 40 mm/s plus ramp and sensor lag
+    TEST_ASSERT_UINT32_WITHIN(1500, 8250, report.time_to_target_ms);
+}
+
+/**
+ * @test An obstacle under two zones is rejected as outliers; the move is unaffected
+ */
+void test_closed_loop_obstacle_ignored(void) {
+    startDesk(DeskModel(), START_DISTANCE_MM, 3);
+    desk->addObstacle((1ULL << 0) | (1ULL << 1), 450);
+    MoveReport report = runMove("up, chair under 2", 950);
+
+    assertArrived(report);
+    TEST_ASSERT_TRUE(height->getOutlierCount() >= 1);
+}
+
+/**
+ * @test A chair already under the desk when it starts lowering is not an obstruction
+ */
+void test_closed_loop_lowering_past_chair(void) {
+    startDesk(DeskModel(), 1100, 12);
+    desk->addObstacle((1ULL << 0) | (1ULL << 1), 450);
+    MoveReport report = runMove("down, chair under 2", 800);
+
+    assertArrived(report);
+}
+
+/**
+ * @test A box pushed under the lowering desk stops it within one frame
+ */
+void test_closed_loop_obstruction_stops(void) {
+    startDesk(DeskModel(), 1100, 13);
+    TEST_ASSERT_TRUE(movement->setTargetHeight(750));
+    runFor(2000);
+    TEST_ASSERT_EQUAL(MovementState::MOVING_DOWN, movement->getState());
+
+    // Worst case: the box appears just after a frame, so the next frame
+    // (one period later) is the first to show it
+    uint32_t sequence = height->getReadingSequence();
+    while (height->getReadingSequence() == sequence) {
+        runFor(1);
+    }
+
+    // Box under the middle quarter of the field of view
+    const uint8_t n = MULTI_ZONE_GRID_SIZE;
+    uint64_t box = 0;
+    for (uint8_t row = n / 4; row < n - n / 4; row++) {
+        for (uint8_t col = n / 4; col < n - n / 4; col++) {
+            box |= 1ULL << (row * n + col);
+        }
+    }
+    desk->addObstacle(box, 300);
+    uint32_t placedAt = desk->nowMs();
+    while (!movement->hasError() && desk->nowMs() - placedAt < 1000) {
+        runFor(1);
+    }
+    uint32_t stopMs = desk->nowMs() - placedAt;
+    float stoppedAt = desk->getDistanceMm();
+
+    TEST_ASSERT_TRUE(movement->hasError());
+    TEST_ASSERT_EQUAL(MovementFault::OBSTRUCTION, movement->getFault());
+    TEST_ASSERT_EQUAL_STRING("OBSTRUCTION", movement->getFaultCode());
+    // The next frame shows the box; the motor is cut on it
+    const uint32_t framePeriodMs = 1000 / RANGING_FREQUENCY_ACTIVE_HZ;
+    TEST_ASSERT_TRUE(stopMs <= framePeriodMs + 1);
+    TEST_ASSERT_TRUE(movement->getObstructionStopLatencyUs() < 1000);
+    TEST_ASSERT_TRUE(movement->toJson().indexOf("\"errorCode\":\"OBSTRUCTION\"") >= 0);
+
+    runFor(1000);
+    TEST_ASSERT_EQUAL_INT8(0, desk->getDrive());
+    TEST_ASSERT_FALSE(desk->isMoving());
+    TEST_ASSERT_EQUAL_UINT32(0, desk->getPinConflictCount());
+    printf("  obstruction: motor off %lu ms after the box appeared (frame to pins %lu us), "
+           "desk coasted %.1f mm\n",
+           (unsigned long)stopMs, (unsigned long)movement->getObstructionStopLatencyUs(),
+           stoppedAt - desk->getDistanceMm());
+
+    // Cleared and lowered again with the box still there: part of the scene now
+    movement->clearError();
+    MoveReport report = runMove("down, box in view", 1000);
+    assertArrived(report);
+}
+
+/**
+ * @test Sensor loss mid-move stops the motor and raises an error
+ */
+void test_closed_loop_sensor_loss_stops(void) {
+    startDesk(DeskModel(), START_DISTANCE_MM, 4);
+    TEST_ASSERT_TRUE(movement->setTargetHeight(1100));
+    runFor(2000);
+    TEST_ASSERT_TRUE(movement->isMoving());
+
+    desk->setOffline(true);
+    uint32_t lostAt = desk->nowMs();
+    while (!movement->hasError() && desk->nowMs() - lostAt < 5000) {
+        runFor(1);
+    }
+    TEST_ASSERT_TRUE(movement->hasError());
+    runFor(500);
+    TEST_ASSERT_EQUAL_INT8(0, desk->getDrive());
+    TEST_ASSERT_FALSE(desk->isMoving());
+    printf("  sensor loss: motor stopped %lu ms after the last frame\n",
+           (unsigned long)(desk->nowMs() - lostAt - 500));
+}
+
+/**
+ * @test Zones dropping out in 20% of frames, per-zone filter on
+ */
+void test_closed_loop_zone_filter_dropouts(void) {
+    DeskModel model;
+    model.dropout_percent = 20;
+    startDesk(model, START_DISTANCE_MM, 9);
+    SystemConfig.setZoneFilter(ZoneFilterMethod::EXPONENTIAL);
+    MoveReport report = runMove("up, zone filter", 1000);
+    SystemConfig.setZoneFilter(ZoneFilterMethod::NONE);
+
+    assertArrived(report);
+}
+
+/**
+ * @test Adaptive filter window: sized down on the quiet simulated floor
+ * while idle, then a move with the adaptive window
+ */
+void test_closed_loop_adaptive_window(void) {
+    startDesk(DeskModel(), START_DISTANCE_MM, 10);
+    SystemConfig.setFilterWindowMode(FilterWindowMode::ADAPTIVE);
+    runFor(30000);   // ~30 idle frames warm up the noise estimate
+
+    String diagnostics = height->getZoneDiagnostics();
+    TEST_ASSERT_TRUE(diagnostics.indexOf("\"filterWindowMode\":\"adaptive\"") >= 0);
+    TEST_ASSERT_TRUE(diagnostics.indexOf("\"adaptiveWindow\":3,") >= 0);
+
+    MoveReport report = runMove("up, adaptive window", 1000);
+    SystemConfig.setFilterWindowMode(FilterWindowMode::FIXED);
+
+    assertArrived(report);
+}
+
+/**
+ * @test Floor-plane consensus on the simulated floor, chair legs under two zones
+ */
+void test_closed_loop_plane_consensus(void) {
+    startDesk(DeskModel(), START_DISTANCE_MM, 11);
+    desk->addObstacle((1ULL << 0) | (1ULL << 1), 450);
+    SystemConfig.setConsensusMethod(ConsensusMethod::PLANE_FIT);
+    MoveReport report = runMove("up, plane consensus", 1000);
+    String diagnostics = height->getZoneDiagnostics();
+    SystemConfig.setConsensusMethod(ConsensusMethod::MEDIAN_MEAN);
+
+    assertArrived(report);
+    TEST_ASSERT_TRUE(diagnostics.indexOf("\"fallbacks\":0}") >= 0);
+}
+
+/**
+ * @brief Run the same series of moves and total up how they went
+ */
+struct SeriesResult {
+    uint32_t doneMs;        ///< Sum of the times from target set to controller idle
+    uint16_t reversals;     ///< Sum of the moves' reversals
+    float worstErrorMm;     ///< Largest true final error
+    float minErrorMm;       ///< Final error range: max - min is the stop's repeatability
+    float maxErrorMm;
+};
+
+static SeriesResult runSeries(const char* name, const uint16_t* targets, uint8_t count) {
+    SeriesResult result = {0, 0, 0.0f, 1e6f, -1e6f};
+    for (uint8_t i = 0; i < count; i++) {
+        char label[24];
+        snprintf(label, sizeof(label), "%s #%u", name, i + 1);
+        uint32_t startMs = desk->nowMs();
+        MoveReport report = runMove(label, targets[i]);
+        assertArrived(report);
+        result.doneMs += desk->nowMs() - startMs;
+        result.reversals += report.reversals;
+        if (fabsf(report.final_error_mm) > result.worstErrorMm) {
+            result.worstErrorMm = fabsf(report.final_error_mm);
+        }
+        result.minErrorMm = fminf(result.minErrorMm, report.final_error_mm);
+        result.maxErrorMm = fmaxf(result.maxErrorMm, report.final_error_mm);
+    }
+    return result;
+}
+
+/**
+ * @test Predictive stop learns its stop distances from zero and then
+ * beats the tolerance cut on time-to-stable and reversals
+ */
+void test_closed_loop_predictive_stop(void) {
+    const uint16_t targets[] = {1000, 760, 1200, 650, 900, 780};
+    const uint8_t count = sizeof(targets) / sizeof(targets[0]);
+
+    startDesk(DeskModel(), START_DISTANCE_MM, 14);
+    SystemConfig.setStopMode(StopMode::TOLERANCE);
+    SeriesResult tolerance = runSeries("tolerance", targets, count);
+
+    // Learning from nothing: the first moves stop late, then converge
+    SystemConfig.setStopMode(StopMode::PREDICTIVE);
+    SystemConfig.setStopDistanceUpMm(0);
+    SystemConfig.setStopDistanceDownMm(0);
+    runSeries("learning", targets, count);
+    uint16_t learnedUp = SystemConfig.getStopDistanceUpMm();
+    uint16_t learnedDown = SystemConfig.getStopDistanceDownMm();
+
+    SeriesResult predictive = runSeries("predictive", targets, count);
+    printf("  stop distance up %u mm, down %u mm\n"
+           "  tolerance cut:  %lu ms to idle, %u reversals, worst error %.1f mm\n"
+           "  predictive cut: %lu ms to idle, %u reversals, worst error %.1f mm\n",
+           SystemConfig.getStopDistanceUpMm(), SystemConfig.getStopDistanceDownMm(),
+           (unsigned long)tolerance.doneMs, tolerance.reversals, tolerance.worstErrorMm,
+           (unsigned long)predictive.doneMs, predictive.reversals, predictive.worstErrorMm);
+    SystemConfig.setStopDistanceUpMm(DEFAULT_STOP_DISTANCE_UP_MM);
+    SystemConfig.setStopDistanceDownMm(DEFAULT_STOP_DISTANCE_DOWN_MM);
+    SystemConfig.setStopMode(static_cast<StopMode>(DEFAULT_STOP_MODE));
+
+    // Filter lag plus coast at 35-40 mm/s, learned per direction
+    TEST_ASSERT_UINT16_WITHIN(8, 22, learnedUp);
+    TEST_ASSERT_UINT16_WITHIN(8, 22, learnedDown);
+    TEST_ASSERT_TRUE(tolerance.reversals >= count / 2);
+    TEST_ASSERT_EQUAL_UINT16(0, predictive.reversals);
+    TEST_ASSERT_TRUE(predictive.worstErrorMm < tolerance.worstErrorMm);
+    // At least half a second faster per move on average
+    TEST_ASSERT_TRUE(predictive.doneMs + count * 500 < tolerance.doneMs);
+    TEST_ASSERT_TRUE(movement->toJson().indexOf("\"lastStopOvershootMm\":") > 0);
+}
+
+/**
+ * @brief Move to a target and return the desk speed when the motor was cut
+ */
+static float runMoveCutSpeed(const char* name, uint16_t targetHeightMm) {
+    TEST_ASSERT_TRUE(movement->setTargetHeight(targetHeightMm));
+    float cutSpeed = 0.0f;
+    while (movement->isMoving()) {
+        cutSpeed = fabsf(desk->getVelocityMmS());
+        runFor(1);
+    }
+    runFor(2000);
+    TEST_ASSERT_FALSE(movement->hasError());
+    printf("  %-22s motor cut at %4.1f mm/s\n", name, cutSpeed);
+    return cutSpeed;
+}
+
+/**
+ * @test PWM drive (soft start, slow-down, soft stop) through the fake LEDC:
+ * arrives without reversals and cuts the motor well below full speed
+ */
+void test_closed_loop_pwm_drive(void) {
+    const uint16_t targets[] = {1000, 760, 1200, 650, 900, 780};
+    const uint8_t count = sizeof(targets) / sizeof(targets[0]);
+
+    startDesk(DeskModel(), START_DISTANCE_MM, 17);
+    SeriesResult switched = runSeries("switched", targets, count);
+    float switchedCut = runMoveCutSpeed("switched", 1100);
+
+    // The stop distances relearn for the lower cut speed: the first moves
+    // may stop short and are not judged
+    SystemConfig.setDriveMode(DriveMode::PWM);
+    for (uint8_t i = 0; i < count; i++) {
+        runMove("pwm, learning", targets[i]);
+    }
+    SeriesResult pwm = runSeries("pwm", targets, count);
+    float pwmCut = runMoveCutSpeed("pwm", 1100);
+    printf("  switched: %lu ms to idle, error %+.1f..%+.1f mm\n"
+           "  pwm:      %lu ms to idle, error %+.1f..%+.1f mm\n",
+           (unsigned long)switched.doneMs, switched.minErrorMm, switched.maxErrorMm,
+           (unsigned long)pwm.doneMs, pwm.minErrorMm, pwm.maxErrorMm);
+
+    // LEDC set up on both motor pins, both channels off at rest
+    FakeLedc& ledc = FakeLedc::instance();
+    TEST_ASSERT_EQUAL_UINT32(MOTOR_PWM_FREQUENCY_HZ, ledc.frequencyHz[MOTOR_PWM_CHANNEL_UP]);
+    TEST_ASSERT_EQUAL_UINT8(MOTOR_PWM_RESOLUTION_BITS, ledc.resolutionBits[MOTOR_PWM_CHANNEL_DOWN]);
+    TEST_ASSERT_EQUAL_UINT8(PIN_MOTOR_UP, ledc.pin[MOTOR_PWM_CHANNEL_UP]);
+    TEST_ASSERT_EQUAL_UINT8(PIN_MOTOR_DOWN, ledc.pin[MOTOR_PWM_CHANNEL_DOWN]);
+    TEST_ASSERT_EQUAL_UINT32(0, ledc.duty[MOTOR_PWM_CHANNEL_UP]);
+    TEST_ASSERT_EQUAL_UINT32(0, ledc.duty[MOTOR_PWM_CHANNEL_DOWN]);
+    TEST_ASSERT_EQUAL_UINT16(0, movement->getMotorDuty());
+    TEST_ASSERT_TRUE(movement->toJson().indexOf("\"driveMode\":\"pwm\"") > 0);
+
+    // An emergency stop skips the soft stop
+    TEST_ASSERT_TRUE(movement->setTargetHeight(700));
+    runFor(2000);
+    TEST_ASSERT_TRUE(movement->getMotorDuty() > 0);
+    TEST_ASSERT_TRUE(ledc.duty[MOTOR_PWM_CHANNEL_DOWN] > 0);
+    movement->emergencyStop();
+    TEST_ASSERT_EQUAL_UINT32(0, ledc.duty[MOTOR_PWM_CHANNEL_DOWN]);
+    TEST_ASSERT_EQUAL_UINT16(0, movement->getMotorDuty());
+    runFor(2000);
+
+    // Back to switched: the pins are plain GPIO again
+    SystemConfig.setDriveMode(static_cast<DriveMode>(DEFAULT_DRIVE_MODE));
+    SystemConfig.setStopDistanceUpMm(DEFAULT_STOP_DISTANCE_UP_MM);
+    SystemConfig.setStopDistanceDownMm(DEFAULT_STOP_DISTANCE_DOWN_MM);
+    assertArrived(runMove("switched again", 900));
+    TEST_ASSERT_EQUAL(DriveMode::SWITCHED, movement->getDriveMode());
+    TEST_ASSERT_EQUAL_UINT8(FakeLedc::NO_PIN, ledc.pin[MOTOR_PWM_CHANNEL_UP]);
+
+    TEST_ASSERT_EQUAL_UINT16(0, pwm.reversals);
+    TEST_ASSERT_TRUE(pwmCut < switchedCut * 0.75f);
+}
+
+/**
+ * @test A PWM reversal rests at zero duty before the other direction:
+ * the LEDC latch never leaves both channels on, not even for a PWM period
+ */
+void test_closed_loop_pwm_reversal(void) {
+    startDesk(DeskModel(), START_DISTANCE_MM, 18);
+    SystemConfig.setDriveMode(DriveMode::PWM);
+    TEST_ASSERT_TRUE(movement->setTargetHeight(1100));
+    runFor(3000);
+    TEST_ASSERT_EQUAL_INT8(1, desk->getDrive());
+    TEST_ASSERT_EQUAL_UINT16(MotorRamp::FULL_DUTY, movement->getMotorDuty());
+
+    // Retargeted below the desk mid-move, at full duty
+    FakeLedc& ledc = FakeLedc::instance();
+    TEST_ASSERT_TRUE(movement->setTargetHeight(800));
+    TEST_ASSERT_EQUAL(MovementState::MOVING_DOWN, movement->getState());
+    TEST_ASSERT_EQUAL_UINT32(0, ledc.duty[MOTOR_PWM_CHANNEL_UP]);
+    TEST_ASSERT_EQUAL_UINT32(0, ledc.duty[MOTOR_PWM_CHANNEL_DOWN]);
+
+    uint32_t reversedAt = desk->nowMs();
+    while (movement->getMotorDuty() == 0 && desk->nowMs() - reversedAt < 1000) {
+        TEST_ASSERT_EQUAL_UINT32(0, ledc.duty[MOTOR_PWM_CHANNEL_UP]);
+        TEST_ASSERT_EQUAL_UINT32(0, ledc.duty[MOTOR_PWM_CHANNEL_DOWN]);
+        runFor(1);
+    }
+    uint32_t restMs = desk->nowMs() - reversedAt;
+    printf("  pwm reversal: %lu ms at zero duty, desk at %.1f mm/s when driven down\n",
+           (unsigned long)restMs, desk->getVelocityMmS());
+    TEST_ASSERT_TRUE(restMs > MOTOR_REVERSE_REST_MS);
+    TEST_ASSERT_TRUE(ledc.duty[MOTOR_PWM_CHANNEL_DOWN] > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, ledc.duty[MOTOR_PWM_CHANNEL_UP]);
+    // Coasted to a stop, and restarts from the minimum duty
+    TEST_ASSERT_FALSE(desk->getVelocityMmS() > 0.0f);
+    TEST_ASSERT_EQUAL_UINT16(MOTOR_MIN_DUTY_PERCENT * MotorRamp::FULL_DUTY / 100,
+                             movement->getMotorDuty());
+
+    MoveReport report = runMove("pwm, after reversal", 800);
+    SystemConfig.setDriveMode(static_cast<DriveMode>(DEFAULT_DRIVE_MODE));
+    assertArrived(report);
+    TEST_ASSERT_EQUAL_UINT32(0, desk->getPinConflictCount());
+}
+
+/// Motion faults must stop the desk well inside the movement timeout
+static const uint32_t MOTION_FAULT_LIMIT_MS = 1500;
+
+/**
+ * @brief Run until the controller raises an error, or maxMs
+ * @return Milliseconds from the call to the error
+ */
+static uint32_t runUntilError(uint32_t maxMs) {
+    uint32_t startMs = desk->nowMs();
+    while (!movement->hasError() && desk->nowMs() - startMs < maxMs) {
+        runFor(1);
+    }
+    return desk->nowMs() - startMs;
+}
+
+/**
+ * @test A desk jamming mid-move is stopped as a stall long before the timeout
+ */
+void test_closed_loop_stall_stops(void) {
+    startDesk(DeskModel(), START_DISTANCE_MM, 14);
+    TEST_ASSERT_TRUE(movement->setTargetHeight(1100));
+    runFor(3000);
+    TEST_ASSERT_EQUAL(MovementState::MOVING_UP, movement->getState());
+
+    desk->setMotorFault(DeskMotorFault::JAMMED);
+    uint32_t stopMs = runUntilError(DEFAULT_MOVEMENT_TIMEOUT_MS);
+    TEST_ASSERT_EQUAL(MovementFault::STALL, movement->getFault());
+    TEST_ASSERT_EQUAL_STRING("MOTOR_STALL", movement->getFaultCode());
+    TEST_ASSERT_TRUE(stopMs < MOTION_FAULT_LIMIT_MS);
+    runFor(100);
+    TEST_ASSERT_EQUAL_INT8(0, desk->getDrive());
+    printf("  stall: motor off %lu ms after the jam (%u frames)\n",
+           (unsigned long)stopMs, SystemConfig.getMotionFaultFrames());
+}
+
+/**
+ * @test Swapped motor wires are stopped as wrong direction soon after motor on
+ */
+void test_closed_loop_wrong_direction_stops(void) {
+    startDesk(DeskModel(), 1000, 15);
+    desk->setMotorFault(DeskMotorFault::REVERSED);
+    float start = desk->getDistanceMm();
+    TEST_ASSERT_TRUE(movement->setTargetHeight(1200));
+
+    uint32_t stopMs = runUntilError(DEFAULT_MOVEMENT_TIMEOUT_MS);
+    TEST_ASSERT_EQUAL(MovementFault::WRONG_DIRECTION, movement->getFault());
+    TEST_ASSERT_EQUAL_STRING("WRONG_DIRECTION", movement->getFaultCode());
+    TEST_ASSERT_TRUE(stopMs < MOTION_FAULT_LIMIT_MS);
+    runFor(500);
+    TEST_ASSERT_EQUAL_INT8(0, desk->getDrive());
+    TEST_ASSERT_FALSE(desk->isMoving());
+    printf("  wrong direction: motor off %lu ms after motor on, desk went %.1f mm down\n",
+           (unsigned long)stopMs, start - desk->getDistanceMm());
+}
+
+/**
+ * @test A stuck-on driver is reported as a runaway after the motor is cut
+ */
+void test_closed_loop_runaway_detected(void) {
+    startDesk(DeskModel(), START_DISTANCE_MM, 16);
+    desk->setMotorFault(DeskMotorFault::STUCK_ON);
+    TEST_ASSERT_TRUE(movement->setTargetHeight(1000));
+    while (movement->isMoving()) {
+        runFor(1);
+    }
+
+    uint32_t detectMs = runUntilError(DEFAULT_MOVEMENT_TIMEOUT_MS);
+    TEST_ASSERT_EQUAL(MovementFault::RUNAWAY, movement->getFault());
+    TEST_ASSERT_EQUAL_STRING("MOTOR_RUNAWAY", movement->getFaultCode());
+    TEST_ASSERT_TRUE(detectMs < MOTION_FAULT_LIMIT_MS);
+    TEST_ASSERT_TRUE(desk->isMoving());
+    TEST_ASSERT_TRUE(movement->toJson().indexOf("\"errorCode\":\"MOTOR_RUNAWAY\"") >= 0);
+    printf("  runaway: reported %lu ms after motor off\n", (unsigned long)detectMs);
+}
+
+/**
+ * @test A series of moves runs much faster than real time
+ */
+void test_closed_loop_faster_than_real_time(void) {
+    startDesk(DeskModel(), START_DISTANCE_MM, 5);
+    const uint16_t targets[] = {1000, 760, 1200, 650, 900};
+
+    uint32_t simStartMs = desk->nowMs();
+    auto wallStart = std::chrono::steady_clock::now();
+    for (uint8_t i = 0; i < sizeof(targets) / sizeof(targets[0]); i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "series #%u", i + 1);
+        assertArrived(runMove(name, targets[i]));
+    }
+    double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    double simS = (desk->nowMs() - simStartMs) / 1000.0;
+
+    printf("  %.0f s of desk time in %.3f s (%.0fx real time)\n", simS, wallS, simS / wallS);
+    TEST_ASSERT_TRUE(simS / wallS > 10.0);
+}
+
+#endif
+
+void setUp(void) {
+#ifdef NATIVE_TEST
+    When(Method(ArduinoFake(), millis)).AlwaysDo([]() -> unsigned long {
+        return desk != nullptr ? desk->nowMs() : 0;
+    });
+    When(Method(ArduinoFake(), micros)).AlwaysDo([]() -> unsigned long {
+        return desk != nullptr ? desk->nowUs() : 0;
+    });
+    When(Method(ArduinoFake(), digitalWrite)).AlwaysDo([](uint8_t pin, uint8_t level) {
+        if (desk != nullptr) desk->writePin(pin, level);
+    });
+    When(Method(ArduinoFake(), pinMode)).AlwaysReturn();
+    FakeLedc::instance().onWrite = [](uint8_t pin, uint32_t duty, uint8_t bits) {
+        if (desk != nullptr) desk->writeDuty(pin, duty, bits);
+    };
+    When(Method(ArduinoFake(), delayMicroseconds)).AlwaysReturn();
+
+    static bool configured = false;
+    if (!configured) {
+        Logger::setLevel(LogLevel::NONE);
+        SystemConfig.init();
+        SystemConfig.setCalibrationOffsetMm(CAL_OFFSET_MM);
+        configured = true;
+    }
+#endif
+}
+
+void tearDown(void) {
+#ifdef NATIVE_TEST
+    delete movement;
+    delete height;
+    delete desk;
+    movement = nullptr;
+    height = nullptr;
+    desk = nullptr;
+#endif
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_motor_response_and_ramp);
+    RUN_TEST(test_motor_coast_down);
+    RUN_TEST(test_pin_conflict_and_end_stop);
+    RUN_TEST(test_frames_follow_ranging_rate);
+    RUN_TEST(test_zones_floor_noise_and_obstacle);
+    RUN_TEST(test_motor_faults);
+    RUN_TEST(test_pwm_duty_scales_speed);
+    RUN_TEST(test_move_metrics);
+    RUN_TEST(test_closed_loop_move_up);
+    RUN_TEST(test_closed_loop_move_down);
+    RUN_TEST(test_closed_loop_obstacle_ignored);
+    RUN_TEST(test_closed_loop_lowering_past_chair);
+    RUN_TEST(test_closed_loop_obstruction_stops);
+    RUN_TEST(test_closed_loop_sensor_loss_stops);
+    RUN_TEST(test_closed_loop_zone_filter_dropouts);
+    RUN_TEST(test_closed_loop_adaptive_window);
+    RUN_TEST(test_closed_loop_plane_consensus);
+    RUN_TEST(test_closed_loop_predictive_stop);
+    RUN_TEST(test_closed_loop_pwm_drive);
+    RUN_TEST(test_closed_loop_pwm_reversal);
+    RUN_TEST(test_closed_loop_stall_stops);
+    RUN_TEST(test_closed_loop_wrong_direction_stops);
+    RUN_TEST(test_closed_loop_runaway_detected);
+    RUN_TEST(test_closed_loop_faster_than_real_time);
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);
+    UNITY_BEGIN();
+    RUN_TEST(test_motor_response_and_ramp);
+    RUN_TEST(test_motor_coast_down);
+    RUN_TEST(test_pin_conflict_and_end_stop);
+    RUN_TEST(test_frames_follow_ranging_rate);
+    RUN_TEST(test_zones_floor_noise_and_obstacle);
+    RUN_TEST(test_motor_faults);
+    RUN_TEST(test_pwm_duty_scales_speed);
+    RUN_TEST(test_move_metrics);
+    UNITY_END();
+}
+
+void loop() {}
+#endif
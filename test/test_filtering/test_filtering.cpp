@@ -12,11 +12,10 @@
 #ifdef NATIVE_TEST
 #include <ArduinoFake.h>
 using namespace fakeit;
-#include "MovingAverageFilter.h"  // Local header-only version for native
 #else
 #include <Arduino.h>
-#include "utils/MovingAverageFilter.h"
 #endif
+#include "utils/MovingAverageFilter.h"
 #include <unity.h>
 
 void setUp() {}
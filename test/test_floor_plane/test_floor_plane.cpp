@@ -0,0 +1,439 @@
+/**
+ * @file test_floor_plane.cpp
+ * @brief Unit tests, accuracy and cycle benchmark for the floor-plane consensus
+ *
+ * Uses FloorPlane.h and ZoneConsensus::combine() directly, the way
+ * HeightController::computeMultiZoneConsensus() runs them with
+ * {"consensusMethod":"plane"}. Synthetic floors are exact planes seen
+ * through the zone rays: 1 / z = (1 + gx * tx + gy * ty) / D, with D the
+ * distance along the sensor axis and gx, gy the tangents of the tilt.
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#include <chrono>
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include "utils/FloorPlane.h"
+#include "utils/ZoneConsensus.h"
+
+typedef FixedFloorPlaneEstimator<4> Plane4x4;
+typedef FixedFloorPlaneEstimator<8> Plane8x8;
+
+static const float AXIS_MM = 720.0f;
+static const uint16_t THRESHOLD_MM = MULTI_ZONE_OUTLIER_THRESHOLD_MM;
+
+// ============================================
+// Helpers
+// ============================================
+
+/// Deterministic Gaussian noise (Box-Muller over an LCG)
+struct GaussianNoise {
+    uint32_t seed;
+
+    explicit GaussianNoise(uint32_t s) : seed(s) {}
+
+    float uniform() {
+        seed = seed * 1103515245u + 12345u;
+        return ((seed >> 8) + 1) / 16777217.0f;
+    }
+
+    float next(float sigma) {
+        float u1 = uniform();
+        float u2 = uniform();
+        return sigma * sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+    }
+};
+
+/**
+ * @brief One frame over a tilted floor
+ *
+ * Zones in obstacleMask read obstacleMm instead; dropouts (percent) are
+ * left out. Returns the valid zone count.
+ */
+template <uint8_t GridSize>
+static uint8_t makeFrame(const FixedFloorPlaneEstimator<GridSize>& plane, float tiltXDeg, float tiltYDeg,
+                         uint64_t obstacleMask, uint16_t obstacleMm, float noiseMm,
+                         uint8_t dropoutPercent, GaussianNoise& noise,
+                         uint8_t* zones, uint16_t* distances) {
+    const float gx = tanf(tiltXDeg * 3.14159265f / 180.0f);
+    const float gy = tanf(tiltYDeg * 3.14159265f / 180.0f);
+    uint8_t count = 0;
+    for (uint8_t zone = 0; zone < GridSize * GridSize; zone++) {
+        if (dropoutPercent > 0 && noise.uniform() * 100.0f < dropoutPercent) {
+            continue;
+        }
+        float z = AXIS_MM / (1.0f + gx * plane.rayX(zone) + gy * plane.rayY(zone));
+        if (obstacleMask & (1ULL << zone)) {
+            z = obstacleMm;
+        }
+        zones[count] = zone;
+        distances[count] = static_cast<uint16_t>(lroundf(z + noise.next(noiseMm)));
+        count++;
+    }
+    return count;
+}
+
+static uint16_t medianOf(const uint16_t* distances, uint8_t count) {
+    uint16_t scratch[ZoneConsensus::MAX_ZONES];
+    for (uint8_t i = 0; i < count; i++) {
+        scratch[i] = distances[i];
+    }
+    return MedianSelect::lowerMedian(scratch, count);
+}
+
+template <uint8_t GridSize>
+static PlaneFit fitFrame(const FixedFloorPlaneEstimator<GridSize>& plane, const uint8_t* zones,
+                         const uint16_t* distances, uint8_t count) {
+    return plane.fit(zones, distances, count, THRESHOLD_MM, medianOf(distances, count));
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================
+// Geometry
+// ============================================
+
+/**
+ * Zone rays: FoV / grid apart, symmetric about the sensor axis
+ */
+void test_zone_rays(void) {
+    Plane4x4 plane(45.0f);
+    const float edge = tanf(1.5f * 11.25f * 3.14159265f / 180.0f);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, -edge, plane.rayX(0));
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, -edge, plane.rayY(0));
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, edge, plane.rayX(15));
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, edge, plane.rayY(15));
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, -plane.rayX(1), plane.rayX(2));
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, plane.rayY(4), plane.rayY(7));
+}
+
+// ============================================
+// Fit
+// ============================================
+
+/**
+ * Level floor without noise: axis distance exact, no tilt
+ */
+void test_level_floor(void) {
+    Plane4x4 plane;
+    GaussianNoise noise(1);
+    uint8_t zones[16];
+    uint16_t distances[16];
+    uint8_t count = makeFrame(plane, 0.0f, 0.0f, 0, 0, 0.0f, 0, noise, zones, distances);
+
+    PlaneFit fit = fitFrame(plane, zones, distances, count);
+
+    TEST_ASSERT_TRUE(fit.ok);
+    TEST_ASSERT_EQUAL_UINT16(720, fit.axis_distance_mm);
+    TEST_ASSERT_EQUAL_UINT8(16, fit.inlier_count);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f, fit.tilt_x_deg);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f, fit.tilt_y_deg);
+}
+
+/**
+ * Tilted floor: axis distance and both tilts recovered
+ */
+void test_tilted_floor(void) {
+    Plane4x4 plane;
+    GaussianNoise noise(2);
+    uint8_t zones[16];
+    uint16_t distances[16];
+    uint8_t count = makeFrame(plane, 8.0f, -3.0f, 0, 0, 0.0f, 0, noise, zones, distances);
+
+    PlaneFit fit = fitFrame(plane, zones, distances, count);
+
+    TEST_ASSERT_TRUE(fit.ok);
+    TEST_ASSERT_UINT16_WITHIN(1, 720, fit.axis_distance_mm);
+    TEST_ASSERT_EQUAL_UINT8(16, fit.inlier_count);
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, 8.0f, fit.tilt_x_deg);
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, -3.0f, fit.tilt_y_deg);
+    TEST_ASSERT_TRUE(fit.residual_mm < 1.0f);
+}
+
+/**
+ * Chair legs under three zones are left out of the plane
+ */
+void test_chair_legs_rejected(void) {
+    Plane4x4 plane;
+    GaussianNoise noise(3);
+    uint8_t zones[16];
+    uint16_t distances[16];
+    uint64_t legs = (1ULL << 0) | (1ULL << 4) | (1ULL << 13);
+    uint8_t count = makeFrame(plane, 5.0f, 0.0f, legs, 450, 2.0f, 0, noise, zones, distances);
+
+    PlaneFit fit = fitFrame(plane, zones, distances, count);
+
+    TEST_ASSERT_TRUE(fit.ok);
+    TEST_ASSERT_EQUAL_UINT8(13, fit.inlier_count);
+    TEST_ASSERT_UINT16_WITHIN(3, 720, fit.axis_distance_mm);
+}
+
+/**
+ * 8x8 grid with an obstacle under a quarter of the zones
+ */
+void test_8x8_grid(void) {
+    Plane8x8 plane;
+    GaussianNoise noise(4);
+    uint8_t zones[64];
+    uint16_t distances[64];
+    uint64_t box = 0;
+    for (uint8_t row = 0; row < 4; row++) {
+        box |= 0xFULL << (row * 8);
+    }
+    uint8_t count = makeFrame(plane, -6.0f, 4.0f, box, 380, 3.0f, 0, noise, zones, distances);
+
+    PlaneFit fit = fitFrame(plane, zones, distances, count);
+
+    TEST_ASSERT_TRUE(fit.ok);
+    TEST_ASSERT_EQUAL_UINT8(48, fit.inlier_count);
+    TEST_ASSERT_UINT16_WITHIN(3, 720, fit.axis_distance_mm);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, -6.0f, fit.tilt_x_deg);
+}
+
+/**
+ * Too few zones, or zones that cannot span a plane: no fit
+ */
+void test_degenerate_input(void) {
+    Plane4x4 plane;
+    uint8_t zones[] = {4, 5, 6, 7};
+    uint16_t distances[] = {720, 721, 719, 720};
+
+    TEST_ASSERT_FALSE(plane.fit(zones, distances, 2, THRESHOLD_MM, 720).ok);
+    TEST_ASSERT_FALSE(plane.fit(zones, distances, 4, THRESHOLD_MM, 720).ok);  // One row
+    TEST_ASSERT_FALSE(plane.fit(zones, distances, 4, THRESHOLD_MM, 0).ok);
+}
+
+// ============================================
+// Benchmark: accuracy against the median-mean consensus
+// ============================================
+
+struct Accuracy {
+    float meanErrorMm;   ///< Mean |consensus - axis distance|
+    float jitterMm;      ///< 1-sigma of the consensus
+};
+
+/**
+ * Noisy frames over a tilted floor with chair legs and dropouts,
+ * combined by median-mean and by the plane fit
+ */
+static void runAccuracy(float tiltXDeg, uint64_t legs, uint8_t dropoutPercent, uint32_t seed,
+                        Accuracy& mean, Accuracy& plane) {
+    Plane4x4 estimator;
+    GaussianNoise noise(seed);
+    const uint16_t frames = 500;
+    float sum[2] = {0.0f, 0.0f};
+    float sumAbs[2] = {0.0f, 0.0f};
+    float sumSq[2] = {0.0f, 0.0f};
+    for (uint16_t f = 0; f < frames; f++) {
+        uint8_t zones[16];
+        uint16_t distances[16];
+        uint8_t count = makeFrame(estimator, tiltXDeg, 0.0f, legs, 450, 4.0f, dropoutPercent,
+                                  noise, zones, distances);
+
+        uint16_t median = 0;
+        ConsensusResult consensus = ZoneConsensus::combine(distances, nullptr, nullptr, count,
+                                                           MULTI_ZONE_MIN_VALID_ZONES, &median);
+        PlaneFit fit = estimator.fit(zones, distances, count, consensus.outlier_threshold_mm, median);
+        float result[2] = {
+            static_cast<float>(consensus.consensus_distance_mm),
+            static_cast<float>(fit.ok ? fit.axis_distance_mm : consensus.consensus_distance_mm)
+        };
+        for (uint8_t k = 0; k < 2; k++) {
+            float error = result[k] - AXIS_MM;
+            sum[k] += error;
+            sumAbs[k] += fabsf(error);
+            sumSq[k] += error * error;
+        }
+    }
+    Accuracy* out[2] = {&mean, &plane};
+    for (uint8_t k = 0; k < 2; k++) {
+        float avg = sum[k] / frames;
+        out[k]->meanErrorMm = sumAbs[k] / frames;
+        out[k]->jitterMm = sqrtf(sumSq[k] / frames - avg * avg);
+    }
+}
+
+static void reportAccuracy(const char* scenario, const Accuracy& mean, const Accuracy& plane) {
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%-26s median-mean |error| %5.1f mm jitter %4.2f mm | plane %4.1f mm %4.2f mm",
+             scenario, mean.meanErrorMm, mean.jitterMm, plane.meanErrorMm, plane.jitterMm);
+    TEST_MESSAGE(msg);
+}
+
+/**
+ * Level floor: the plane costs nothing in accuracy or jitter
+ */
+void test_benchmark_level_floor(void) {
+    Accuracy mean, plane;
+    runAccuracy(0.0f, 0, 0, 21, mean, plane);
+    reportAccuracy("level", mean, plane);
+
+    TEST_ASSERT_TRUE(plane.meanErrorMm < 2.0f);
+    TEST_ASSERT_TRUE(plane.jitterMm < 1.3f * mean.jitterMm);
+}
+
+/**
+ * 6 degree tilt, legs under two zones on one side: the mean is pulled
+ * towards the other side, the plane is not
+ */
+void test_benchmark_tilt_with_legs(void) {
+    Accuracy mean, plane;
+    runAccuracy(6.0f, (1ULL << 0) | (1ULL << 4), 0, 22, mean, plane);
+    reportAccuracy("6 deg tilt, legs", mean, plane);
+
+    TEST_ASSERT_TRUE(plane.meanErrorMm < 2.0f);
+    TEST_ASSERT_TRUE(plane.meanErrorMm < mean.meanErrorMm / 2.0f);
+}
+
+/**
+ * 6 degree tilt, 20% dropouts: the zone set changes every frame, which
+ * moves the mean but not the plane
+ */
+void test_benchmark_tilt_with_dropouts(void) {
+    Accuracy mean, plane;
+    runAccuracy(6.0f, 0, 20, 23, mean, plane);
+    reportAccuracy("6 deg tilt, 20% dropouts", mean, plane);
+
+    TEST_ASSERT_TRUE(plane.jitterMm < mean.jitterMm);
+}
+
+/**
+ * 12 degree tilt: the corner zones are more than the outlier threshold
+ * from the median, so the median-mean drops genuine floor
+ */
+void test_benchmark_steep_tilt(void) {
+    Accuracy mean, plane;
+    runAccuracy(12.0f, 0, 0, 24, mean, plane);
+    reportAccuracy("12 deg tilt", mean, plane);
+
+    TEST_ASSERT_TRUE(plane.meanErrorMm < 2.0f);
+}
+
+// ============================================
+// Benchmark: cost per frame
+// ============================================
+
+#ifdef NATIVE_TEST
+typedef uint64_t Ticks;
+static Ticks nowTicks() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+static const char* TICK_UNIT = "ns";
+#else
+typedef uint32_t Ticks;  // CCOUNT wraps every ~18 s; unsigned differences stay right
+static Ticks nowTicks() {
+    return ESP.getCycleCount();
+}
+static const char* TICK_UNIT = "cycles";
+#endif
+
+/**
+ * Time fit() per frame on obstructed frames (RANSAC runs all its
+ * iterations) and report it against the 15 Hz frame budget
+ */
+template <uint8_t GridSize>
+static uint64_t timeFit(uint64_t obstacleMask) {
+    FixedFloorPlaneEstimator<GridSize> plane;
+    GaussianNoise noise(31);
+    const uint8_t frames = 32;
+    uint8_t zones[frames][GridSize * GridSize];
+    uint16_t distances[frames][GridSize * GridSize];
+    uint8_t counts[frames];
+    uint16_t medians[frames];
+    for (uint8_t f = 0; f < frames; f++) {
+        counts[f] = makeFrame(plane, 6.0f, -2.0f, obstacleMask, 450, 4.0f, 5, noise,
+                              zones[f], distances[f]);
+        medians[f] = medianOf(distances[f], counts[f]);
+    }
+
+    const uint16_t rounds = 50;
+    uint32_t checksum = 0;
+    Ticks start = nowTicks();
+    for (uint16_t r = 0; r < rounds; r++) {
+        for (uint8_t f = 0; f < frames; f++) {
+            checksum += plane.fit(zones[f], distances[f], counts[f], THRESHOLD_MM, medians[f])
+                            .axis_distance_mm;
+        }
+    }
+    Ticks elapsed = nowTicks() - start;
+    uint64_t perFrame = elapsed / (static_cast<uint32_t>(rounds) * frames);
+
+    char msg[112];
+    snprintf(msg, sizeof(msg), "Plane fit %ux%u: %lu %s per frame (checksum %lu)",
+             GridSize, GridSize, (unsigned long)perFrame, TICK_UNIT, (unsigned long)checksum);
+    TEST_MESSAGE(msg);
+    return perFrame;
+}
+
+/**
+ * Well inside the 66 ms frame at 15 Hz: under 1 ms per frame
+ * (240000 cycles at 240 MHz on the ESP32, 1000000 ns native)
+ */
+void test_benchmark_cycles(void) {
+#ifdef NATIVE_TEST
+    const uint64_t budget = 1000000;
+#else
+    const uint64_t budget = 240000;
+#endif
+    uint64_t t16 = timeFit<4>((1ULL << 0) | (1ULL << 4));
+    uint64_t t64 = timeFit<8>(0x0F0F0F0FULL);
+
+    TEST_ASSERT_TRUE(t16 < budget);
+    TEST_ASSERT_TRUE(t64 < budget);
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_zone_rays);
+    RUN_TEST(test_level_floor);
+    RUN_TEST(test_tilted_floor);
+    RUN_TEST(test_chair_legs_rejected);
+    RUN_TEST(test_8x8_grid);
+    RUN_TEST(test_degenerate_input);
+    RUN_TEST(test_benchmark_level_floor);
+    RUN_TEST(test_benchmark_tilt_with_legs);
+    RUN_TEST(test_benchmark_tilt_with_dropouts);
+    RUN_TEST(test_benchmark_steep_tilt);
+    RUN_TEST(test_benchmark_cycles);
+
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    UNITY_BEGIN();
+
+    RUN_TEST(test_zone_rays);
+    RUN_TEST(test_level_floor);
+    RUN_TEST(test_tilted_floor);
+    RUN_TEST(test_chair_legs_rejected);
+    RUN_TEST(test_8x8_grid);
+    RUN_TEST(test_degenerate_input);
+    RUN_TEST(test_benchmark_level_floor);
+    RUN_TEST(test_benchmark_tilt_with_legs);
+    RUN_TEST(test_benchmark_tilt_with_dropouts);
+    RUN_TEST(test_benchmark_steep_tilt);
+    RUN_TEST(test_benchmark_cycles);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
+#endif
@@ -16,6 +16,7 @@ using namespace fakeit;
 #include <Arduino.h>
 #endif
 #include <unity.h>
+#include "utils/HeightUnits.h"
 
 // Forward declare HeightController - tests should fail until implementation exists
 class HeightController;
@@ -81,24 +82,72 @@ void test_height_calculation_maximum() {
 }
 
 /**
- * Test: Height calculation with decimal truncation
+ * Test: Height keeps millimeter resolution
  * 
- * Sensor reading 1255mm should give same result as 1250mm
- * (integer division truncates, not rounds)
+ * The pipeline no longer divides by 10: 1250mm and 1259mm give
+ * different heights (HeightUnits::heightFromDistance)
  */
-void test_height_calculation_truncation() {
-    uint16_t calibration_constant_cm = 200;
+void test_height_calculation_mm_resolution() {
+    // Floor-pointing sensor: height_mm = offset_mm + distance_mm
+    int16_t calibration_offset_mm = -500;
     
-    // 1255mm / 10 = 125 (integer division)
-    uint16_t sensor_reading_mm = 1255;
-    uint16_t expected_height_cm = calibration_constant_cm - (sensor_reading_mm / 10);
+    TEST_ASSERT_EQUAL_UINT16(750, HeightUnits::heightFromDistance(calibration_offset_mm, 1250));
+    TEST_ASSERT_EQUAL_UINT16(755, HeightUnits::heightFromDistance(calibration_offset_mm, 1255));
+    TEST_ASSERT_EQUAL_UINT16(759, HeightUnits::heightFromDistance(calibration_offset_mm, 1259));
+}
+
+/**
+ * Test: Calibration offset round-trips at the known height
+ */
+void test_calibration_offset_mm() {
+    // Desk measured at 72.5cm, sensor averages 683mm
+    uint16_t known_mm = HeightUnits::cmToMm(72.5f);
+    int16_t offset = HeightUnits::calibrationOffset(known_mm, 683);
     
-    TEST_ASSERT_EQUAL(75, expected_height_cm);
+    TEST_ASSERT_EQUAL_INT16(42, offset);
+    TEST_ASSERT_EQUAL_UINT16(725, HeightUnits::heightFromDistance(offset, 683));
     
-    // 1259mm / 10 = 125 (still truncates to 125)
-    sensor_reading_mm = 1259;
-    expected_height_cm = calibration_constant_cm - (sensor_reading_mm / 10);
-    TEST_ASSERT_EQUAL(75, expected_height_cm);
+    // Offset of exactly 0 would mean "uncalibrated"; nudged to 1mm
+    TEST_ASSERT_EQUAL_INT16(1, HeightUnits::calibrationOffset(700, 700));
+    // Negative offsets are valid (sensor mounted below the desk surface)
+    TEST_ASSERT_EQUAL_INT16(-300, HeightUnits::calibrationOffset(700, 1000));
+}
+
+/**
+ * Test: Legacy cm calibration constant converts to the same heights
+ * 
+ * SystemConfiguration migrates "cal_const" (cm) to "cal_mm" as cm * 10
+ */
+void test_calibration_legacy_cm_migration() {
+    int16_t legacy_cm = 4;
+    int16_t offset_mm = legacy_cm * HeightUnits::MM_PER_CM;
+    
+    // Old: 4 + 710/10 = 75cm; new: 40 + 710 = 750mm
+    TEST_ASSERT_EQUAL_UINT16(750, HeightUnits::heightFromDistance(offset_mm, 710));
+    // Old truncated 719mm to 75cm too; new keeps the extra 9mm
+    TEST_ASSERT_EQUAL_UINT16(759, HeightUnits::heightFromDistance(offset_mm, 719));
+}
+
+/**
+ * Test: Implementation clamps and handles uncalibrated state
+ */
+void test_height_from_distance_limits() {
+    // Uncalibrated
+    TEST_ASSERT_EQUAL_UINT16(0, HeightUnits::heightFromDistance(0, 1000));
+    // Would go negative
+    TEST_ASSERT_EQUAL_UINT16(0, HeightUnits::heightFromDistance(-2000, 500));
+    // Above 2m
+    TEST_ASSERT_EQUAL_UINT16(2000, HeightUnits::heightFromDistance(500, 4000));
+}
+
+/**
+ * Test: cm <-> mm conversion at the API edge
+ */
+void test_cm_mm_conversion() {
+    TEST_ASSERT_EQUAL_UINT16(750, HeightUnits::cmToMm(75.0f));
+    TEST_ASSERT_EQUAL_UINT16(726, HeightUnits::cmToMm(72.55f));
+    TEST_ASSERT_EQUAL_UINT16(0, HeightUnits::cmToMm(-5.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 72.5f, HeightUnits::mmToCm(725));
 }
 
 /**
@@ -199,7 +248,11 @@ int main(int argc, char **argv) {
     RUN_TEST(test_height_calculation_basic);
     RUN_TEST(test_height_calculation_minimum);
     RUN_TEST(test_height_calculation_maximum);
-    RUN_TEST(test_height_calculation_truncation);
+    RUN_TEST(test_height_calculation_mm_resolution);
+    RUN_TEST(test_calibration_offset_mm);
+    RUN_TEST(test_calibration_legacy_cm_migration);
+    RUN_TEST(test_height_from_distance_limits);
+    RUN_TEST(test_cm_mm_conversion);
     RUN_TEST(test_height_calculation_different_calibration);
     RUN_TEST(test_height_calculation_clamping);
     RUN_TEST(test_height_calculation_zero_reading);
@@ -216,7 +269,11 @@ void setup() {
     RUN_TEST(test_height_calculation_basic);
     RUN_TEST(test_height_calculation_minimum);
     RUN_TEST(test_height_calculation_maximum);
-    RUN_TEST(test_height_calculation_truncation);
+    RUN_TEST(test_height_calculation_mm_resolution);
+    RUN_TEST(test_calibration_offset_mm);
+    RUN_TEST(test_calibration_legacy_cm_migration);
+    RUN_TEST(test_height_from_distance_limits);
+    RUN_TEST(test_cm_mm_conversion);
     RUN_TEST(test_height_calculation_different_calibration);
     RUN_TEST(test_height_calculation_clamping);
     RUN_TEST(test_height_calculation_zero_reading);
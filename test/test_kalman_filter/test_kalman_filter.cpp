@@ -0,0 +1,254 @@
+/**
+ * @file test_kalman_filter.cpp
+ * @brief Unit tests for VelocityKalmanFilter (constant-velocity temporal stage)
+ *
+ * Covers initialization, velocity tracking, timestamp handling, and a
+ * closed comparison against the moving average on a simulated desk move:
+ * lag while moving must drop well below the moving average's, with idle
+ * jitter no worse.
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include "utils/VelocityKalmanFilter.h"
+
+// Defaults (match Config.h)
+constexpr float PROCESS_NOISE = 100.0f;
+constexpr float MEASUREMENT_NOISE = 2.0f;
+
+// ============================================
+// Helpers
+// ============================================
+
+static uint32_t lcgState = 1;
+
+static double uniform01() {
+    lcgState = lcgState * 1103515245u + 12345u;
+    return ((lcgState >> 8) & 0xFFFFFF) / 16777216.0 + 1e-9;
+}
+
+static double gaussian() {
+    return std::sqrt(-2.0 * std::log(uniform01())) * std::cos(2.0 * M_PI * uniform01());
+}
+
+/**
+ * @brief Integer moving average, same truncation as MovingAverageFilter
+ */
+struct SimpleMovingAverage {
+    uint16_t buffer[32];
+    uint8_t size;
+    uint8_t count;
+    uint8_t head;
+
+    explicit SimpleMovingAverage(uint8_t n) : size(n), count(0), head(0) {}
+
+    uint16_t add(uint16_t sample) {
+        buffer[head] = sample;
+        head = (head + 1) % size;
+        if (count < size) count++;
+        uint32_t sum = 0;
+        for (uint8_t i = 0; i < count; i++) sum += buffer[i];
+        return static_cast<uint16_t>(sum / count);
+    }
+};
+
+struct TrackingStats {
+    double movingMeanAbsError;
+    double idleRms;
+};
+
+/**
+ * @brief Simulate idle -> 35 mm/s move -> idle at a fixed frame rate
+ */
+static void simulateMove(uint8_t rateHz, TrackingStats& kalmanStats, TrackingStats& averageStats) {
+    lcgState = 1;
+    VelocityKalmanFilter kf(PROCESS_NOISE, MEASUREMENT_NOISE);
+    // Window scaled like HeightController::applyRangingProfile (5 @ 5 Hz)
+    SimpleMovingAverage ma(5 * rateHz / 5);
+
+    const double dt = 1.0 / rateHz;
+    double truth = 700.0;
+    double movingErrK = 0, movingErrM = 0, idleSqK = 0, idleSqM = 0;
+    uint32_t nMoving = 0, nIdle = 0;
+
+    for (uint32_t i = 0; i < rateHz * 25u; i++) {
+        double t = i * dt;
+        if (t > 4.0 && t < 12.0) {
+            truth += 35.0 * dt;
+        }
+        uint16_t z = static_cast<uint16_t>(std::lround(truth + gaussian() * 2.0));
+        kf.update(z, static_cast<uint32_t>(t * 1e6));
+        uint16_t avg = ma.add(z);
+
+        if (t > 4.5 && t < 12.0) {
+            movingErrK += std::fabs(truth - kf.getDistance());
+            movingErrM += std::fabs(truth - avg);
+            nMoving++;
+        }
+        if (t > 18.0) {
+            idleSqK += (kf.getDistance() - truth) * (kf.getDistance() - truth);
+            idleSqM += (avg - truth) * (avg - truth);
+            nIdle++;
+        }
+    }
+
+    kalmanStats.movingMeanAbsError = movingErrK / nMoving;
+    kalmanStats.idleRms = std::sqrt(idleSqK / nIdle);
+    averageStats.movingMeanAbsError = movingErrM / nMoving;
+    averageStats.idleRms = std::sqrt(idleSqM / nIdle);
+}
+
+void setUp(void) {
+    lcgState = 1;
+}
+
+void tearDown(void) {}
+
+// ============================================
+// Tests
+// ============================================
+
+/**
+ * @test First update initializes state from the measurement
+ */
+void test_kalman_first_sample_initializes(void) {
+    VelocityKalmanFilter kf(PROCESS_NOISE, MEASUREMENT_NOISE);
+    TEST_ASSERT_FALSE(kf.isInitialized());
+
+    kf.update(850, 1000);
+
+    TEST_ASSERT_TRUE(kf.isInitialized());
+    TEST_ASSERT_EQUAL_UINT16(850, kf.getDistance());
+    TEST_ASSERT_EQUAL_INT16(0, kf.getVelocity());
+}
+
+/**
+ * @test Constant input stays put with zero velocity
+ */
+void test_kalman_stationary_input(void) {
+    VelocityKalmanFilter kf(PROCESS_NOISE, MEASUREMENT_NOISE);
+    for (uint32_t i = 0; i < 50; i++) {
+        kf.update(850, i * 66667);
+    }
+    TEST_ASSERT_EQUAL_UINT16(850, kf.getDistance());
+    TEST_ASSERT_EQUAL_INT16(0, kf.getVelocity());
+}
+
+/**
+ * @test Noise-free ramp: velocity converges to the true rate, no lag
+ */
+void test_kalman_tracks_constant_velocity(void) {
+    VelocityKalmanFilter kf(PROCESS_NOISE, MEASUREMENT_NOISE);
+    // 30 mm/s rising at 15 Hz for 4 seconds
+    for (uint32_t i = 0; i < 60; i++) {
+        uint16_t z = static_cast<uint16_t>(700 + i * 2);
+        kf.update(z, i * 66667);
+    }
+    TEST_ASSERT_INT16_WITHIN(2, 30, kf.getVelocity());
+    TEST_ASSERT_UINT16_WITHIN(1, 700 + 59 * 2, kf.getDistance());
+}
+
+/**
+ * @test Descending desk gives negative velocity
+ */
+void test_kalman_negative_velocity(void) {
+    VelocityKalmanFilter kf(PROCESS_NOISE, MEASUREMENT_NOISE);
+    for (uint32_t i = 0; i < 60; i++) {
+        uint16_t z = static_cast<uint16_t>(1100 - i * 2);
+        kf.update(z, i * 66667);
+    }
+    TEST_ASSERT_INT16_WITHIN(2, -30, kf.getVelocity());
+}
+
+/**
+ * @test micros() wraparound does not produce a huge time step
+ */
+void test_kalman_timestamp_wraparound(void) {
+    VelocityKalmanFilter kf(PROCESS_NOISE, MEASUREMENT_NOISE);
+    uint32_t t = 0xFFFFFFFFu - 500000u;
+    for (uint32_t i = 0; i < 30; i++) {
+        kf.update(850, t);
+        t += 66667;  // wraps mid-sequence
+    }
+    TEST_ASSERT_EQUAL_UINT16(850, kf.getDistance());
+    TEST_ASSERT_EQUAL_INT16(0, kf.getVelocity());
+}
+
+/**
+ * @test reset() forgets state
+ */
+void test_kalman_reset(void) {
+    VelocityKalmanFilter kf(PROCESS_NOISE, MEASUREMENT_NOISE);
+    for (uint32_t i = 0; i < 20; i++) {
+        kf.update(static_cast<uint16_t>(700 + i * 5), i * 66667);
+    }
+    kf.reset();
+    TEST_ASSERT_FALSE(kf.isInitialized());
+
+    kf.update(1200, 0);
+    TEST_ASSERT_EQUAL_UINT16(1200, kf.getDistance());
+    TEST_ASSERT_EQUAL_INT16(0, kf.getVelocity());
+}
+
+/**
+ * @test Moving lag well below the moving average, idle jitter no worse
+ *
+ * Checked at the reference (5 Hz) and active (15 Hz) ranging rates with
+ * the moving-average window scaled as in applyRangingProfile().
+ */
+void test_kalman_lag_and_idle_vs_moving_average(void) {
+    const uint8_t rates[] = {5, 15};
+    for (uint8_t rate : rates) {
+        TrackingStats k, m;
+        simulateMove(rate, k, m);
+
+        char msg[128];
+        snprintf(msg, sizeof(msg),
+                 "%2u Hz: moving error kalman %.2f mm vs average %.2f mm; idle rms %.2f vs %.2f mm",
+                 rate, k.movingMeanAbsError, m.movingMeanAbsError, k.idleRms, m.idleRms);
+        TEST_MESSAGE(msg);
+
+        TEST_ASSERT_TRUE(k.movingMeanAbsError < m.movingMeanAbsError * 0.25);
+        TEST_ASSERT_TRUE(k.idleRms <= m.idleRms);
+    }
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_kalman_first_sample_initializes);
+    RUN_TEST(test_kalman_stationary_input);
+    RUN_TEST(test_kalman_tracks_constant_velocity);
+    RUN_TEST(test_kalman_negative_velocity);
+    RUN_TEST(test_kalman_timestamp_wraparound);
+    RUN_TEST(test_kalman_reset);
+    RUN_TEST(test_kalman_lag_and_idle_vs_moving_average);
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);
+    UNITY_BEGIN();
+    RUN_TEST(test_kalman_first_sample_initializes);
+    RUN_TEST(test_kalman_stationary_input);
+    RUN_TEST(test_kalman_tracks_constant_velocity);
+    RUN_TEST(test_kalman_negative_velocity);
+    RUN_TEST(test_kalman_timestamp_wraparound);
+    RUN_TEST(test_kalman_reset);
+    RUN_TEST(test_kalman_lag_and_idle_vs_moving_average);
+    UNITY_END();
+}
+
+void loop() {}
+#endif
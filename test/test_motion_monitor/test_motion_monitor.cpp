@@ -0,0 +1,226 @@
+/**
+ * @file test_motion_monitor.cpp
+ * @brief Unit tests for stall, wrong-direction and runaway detection
+ *
+ * Feeds velocity estimates at the active frame rate, with the motor
+ * command changes MovementController::setMotorPins() reports.
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include "utils/MotionMonitor.h"
+
+static const uint32_t FRAME_MS = 1000 / RANGING_FREQUENCY_ACTIVE_HZ;
+
+// ============================================
+// Helpers
+// ============================================
+
+/**
+ * @brief Feed one velocity for a number of frames
+ * @return The first fault reported, or NONE; nowMs is advanced per frame
+ */
+static MotionFault feed(MotionMonitor& monitor, int16_t velocity, uint8_t frames, uint32_t& nowMs) {
+    for (uint8_t i = 0; i < frames; i++) {
+        nowMs += FRAME_MS;
+        MotionFault fault = monitor.update(velocity, nowMs);
+        if (fault != MotionFault::NONE) {
+            return fault;
+        }
+    }
+    return MotionFault::NONE;
+}
+
+/// Frames until a condition is judged after a drive change
+static uint8_t graceFrames(uint32_t graceMs) {
+    return (uint8_t)(graceMs / FRAME_MS);
+}
+
+// ============================================
+// Tests
+// ============================================
+
+/**
+ * @test Nothing is judged while the motor has never run
+ */
+void test_idle_never_faults(void) {
+    MotionMonitor monitor(3);
+    uint32_t now = 0;
+    TEST_ASSERT_EQUAL(MotionFault::NONE, feed(monitor, 0, 50, now));
+    TEST_ASSERT_EQUAL(MotionFault::NONE, feed(monitor, 40, 50, now));
+    TEST_ASSERT_EQUAL_INT8(0, monitor.getDrive());
+}
+
+/**
+ * @test No stall while the desk ramps and the estimate catches up
+ */
+void test_start_grace(void) {
+    MotionMonitor monitor(3);
+    uint32_t now = 1000;
+    monitor.onDrive(1, now);
+    TEST_ASSERT_EQUAL(MotionFault::NONE, feed(monitor, 0, graceFrames(MOTION_START_GRACE_MS), now));
+    TEST_ASSERT_EQUAL(MotionFault::NONE, feed(monitor, 35, 50, now));
+}
+
+/**
+ * @test No progress after the grace period is a stall after N frames
+ */
+void test_stall_after_fault_frames(void) {
+    MotionMonitor monitor(4);
+    uint32_t now = 0;
+    monitor.onDrive(-1, now);
+    now += MOTION_START_GRACE_MS;
+    TEST_ASSERT_EQUAL(MotionFault::NONE, feed(monitor, -3, 3, now));
+    TEST_ASSERT_EQUAL(MotionFault::STALL, feed(monitor, -3, 1, now));
+}
+
+/**
+ * @test One good frame restarts the count
+ */
+void test_count_resets_on_good_frame(void) {
+    MotionMonitor monitor(3);
+    uint32_t now = 0;
+    monitor.onDrive(1, now);
+    now += MOTION_START_GRACE_MS;
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(MotionFault::NONE, feed(monitor, 0, 2, now));
+        TEST_ASSERT_EQUAL(MotionFault::NONE, feed(monitor, 30, 1, now));
+    }
+}
+
+/**
+ * @test Moving the other way from the start is a wrong direction
+ */
+void test_wrong_direction(void) {
+    MotionMonitor monitor(3);
+    uint32_t now = 0;
+    monitor.onDrive(1, now);
+    now += MOTION_START_GRACE_MS;
+    TEST_ASSERT_EQUAL(MotionFault::NONE, feed(monitor, -40, 2, now));
+    TEST_ASSERT_EQUAL(MotionFault::WRONG_DIRECTION, feed(monitor, -40, 1, now));
+}
+
+/**
+ * @test After progress, the estimate ringing backwards on a jam is a stall
+ */
+void test_jam_after_progress_is_stall(void) {
+    MotionMonitor monitor(3);
+    uint32_t now = 0;
+    monitor.onDrive(1, now);
+    now += MOTION_START_GRACE_MS;
+    TEST_ASSERT_EQUAL(MotionFault::NONE, feed(monitor, 35, 10, now));
+    TEST_ASSERT_EQUAL(MotionFault::STALL, feed(monitor, -25, 3, now));
+
+    // A new command forgets the progress
+    monitor.onDrive(0, now);
+    monitor.onDrive(1, now);
+    now += MOTION_START_GRACE_MS;
+    TEST_ASSERT_EQUAL(MotionFault::WRONG_DIRECTION, feed(monitor, -25, 3, now));
+}
+
+/**
+ * @test Still moving the driven way after the stop grace is a runaway
+ */
+void test_runaway_after_motor_off(void) {
+    MotionMonitor monitor(3);
+    uint32_t now = 0;
+    monitor.onDrive(-1, now);
+    now += MOTION_START_GRACE_MS;
+    feed(monitor, -40, 20, now);
+    monitor.onDrive(0, now);
+
+    // Coasting and estimate lag inside the grace period are fine
+    TEST_ASSERT_EQUAL(MotionFault::NONE, feed(monitor, -40, graceFrames(MOTION_STOP_GRACE_MS), now));
+    TEST_ASSERT_EQUAL(MotionFault::NONE, feed(monitor, -40, 2, now));
+    TEST_ASSERT_EQUAL(MotionFault::RUNAWAY, feed(monitor, -40, 1, now));
+}
+
+/**
+ * @test Ringing the other way or slow drift after a stop is not a runaway
+ */
+void test_no_runaway_on_ringing(void) {
+    MotionMonitor monitor(3);
+    uint32_t now = 0;
+    monitor.onDrive(1, now);
+    now += MOTION_START_GRACE_MS;
+    feed(monitor, 35, 20, now);
+    monitor.onDrive(0, now);
+    now += MOTION_STOP_GRACE_MS;
+
+    TEST_ASSERT_EQUAL(MotionFault::NONE, feed(monitor, -29, 30, now));
+    TEST_ASSERT_EQUAL(MotionFault::NONE, feed(monitor, MOTION_RUNAWAY_SPEED_MM_S - 1, 30, now));
+    TEST_ASSERT_EQUAL(MotionFault::NONE, feed(monitor, 0, 30, now));
+}
+
+/**
+ * @test Frame count is configurable and never below one
+ */
+void test_fault_frames_setting(void) {
+    MotionMonitor monitor;
+    TEST_ASSERT_EQUAL_UINT8(DEFAULT_MOTION_FAULT_FRAMES, monitor.getFaultFrames());
+    monitor.setFaultFrames(0);
+    TEST_ASSERT_EQUAL_UINT8(1, monitor.getFaultFrames());
+
+    uint32_t now = 0;
+    monitor.onDrive(1, now);
+    now += MOTION_START_GRACE_MS;
+    TEST_ASSERT_EQUAL(MotionFault::STALL, feed(monitor, 0, 1, now));
+
+    monitor.setFaultFrames(10);
+    monitor.reset();
+    monitor.onDrive(1, now);
+    now += MOTION_START_GRACE_MS;
+    TEST_ASSERT_EQUAL(MotionFault::NONE, feed(monitor, 0, 9, now));
+    TEST_ASSERT_EQUAL(MotionFault::STALL, feed(monitor, 0, 1, now));
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_idle_never_faults);
+    RUN_TEST(test_start_grace);
+    RUN_TEST(test_stall_after_fault_frames);
+    RUN_TEST(test_count_resets_on_good_frame);
+    RUN_TEST(test_wrong_direction);
+    RUN_TEST(test_jam_after_progress_is_stall);
+    RUN_TEST(test_runaway_after_motor_off);
+    RUN_TEST(test_no_runaway_on_ringing);
+    RUN_TEST(test_fault_frames_setting);
+
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    UNITY_BEGIN();
+
+    RUN_TEST(test_idle_never_faults);
+    RUN_TEST(test_start_grace);
+    RUN_TEST(test_stall_after_fault_frames);
+    RUN_TEST(test_count_resets_on_good_frame);
+    RUN_TEST(test_wrong_direction);
+    RUN_TEST(test_jam_after_progress_is_stall);
+    RUN_TEST(test_runaway_after_motor_off);
+    RUN_TEST(test_no_runaway_on_ringing);
+    RUN_TEST(test_fault_frames_setting);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
+#endif
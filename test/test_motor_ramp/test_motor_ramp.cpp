@@ -0,0 +1,262 @@
+/**
+ * @file test_motor_ramp.cpp
+ * @brief Unit tests for the PWM drive's soft start, slow-down and soft stop
+ *
+ * Steps the ramp at 1 ms, as the desk simulator's control loop does, with
+ * the remaining distance MovementController::rampMotor() passes in.
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include "utils/MotorRamp.h"
+
+static const uint16_t RAMP_UP_MS = 400;
+static const uint16_t RAMP_DOWN_MS = 250;
+static const uint16_t SLOWDOWN_MM = 50;
+static const uint16_t MIN_DUTY = 600;
+static const uint16_t REVERSE_REST_MS = 200;
+static const int32_t FAR_MM = 1000;
+
+// ============================================
+// Helpers
+// ============================================
+
+static void configure(MotorRamp& ramp) {
+    ramp.configure(RAMP_UP_MS, RAMP_DOWN_MS, SLOWDOWN_MM, MIN_DUTY, REVERSE_REST_MS);
+}
+
+/**
+ * @brief Step the ramp for a number of milliseconds
+ * @return The last duty; nowMs is advanced
+ */
+static uint16_t stepFor(MotorRamp& ramp, uint32_t ms, int32_t remainingMm, uint32_t& nowMs) {
+    uint16_t duty = ramp.getDuty();
+    for (uint32_t i = 0; i < ms; i++) {
+        nowMs++;
+        duty = ramp.update(nowMs, remainingMm);
+    }
+    return duty;
+}
+
+// ============================================
+// Tests
+// ============================================
+
+/**
+ * @test Off until started
+ */
+void test_idle_is_zero(void) {
+    MotorRamp ramp;
+    configure(ramp);
+    uint32_t now = 0;
+    TEST_ASSERT_EQUAL_UINT16(0, stepFor(ramp, 100, FAR_MM, now));
+    TEST_ASSERT_EQUAL_INT8(0, ramp.getDirection());
+}
+
+/**
+ * @test Start jumps to the minimum, then rises to full over the rest of the ramp
+ */
+void test_soft_start(void) {
+    MotorRamp ramp;
+    configure(ramp);
+    uint32_t now = 0;
+    ramp.start(1, now);
+    TEST_ASSERT_EQUAL_UINT16(MIN_DUTY, ramp.getDuty());
+
+    // 40% of full scale to go at 400 ms per full scale
+    uint16_t duty = stepFor(ramp, 80, FAR_MM, now);
+    TEST_ASSERT_UINT16_WITHIN(2, MIN_DUTY + 200, duty);
+    TEST_ASSERT_EQUAL_UINT16(MotorRamp::FULL_DUTY, stepFor(ramp, 100, FAR_MM, now));
+    TEST_ASSERT_EQUAL_INT8(1, ramp.getDirection());
+}
+
+/**
+ * @test Inside the slow-down distance the duty follows the distance left
+ */
+void test_approach_slowdown(void) {
+    MotorRamp ramp;
+    configure(ramp);
+    TEST_ASSERT_EQUAL_UINT16(MotorRamp::FULL_DUTY, ramp.approachDuty(FAR_MM));
+    TEST_ASSERT_EQUAL_UINT16(MotorRamp::FULL_DUTY, ramp.approachDuty(SLOWDOWN_MM));
+    TEST_ASSERT_EQUAL_UINT16(800, ramp.approachDuty(SLOWDOWN_MM / 2));
+    TEST_ASSERT_EQUAL_UINT16(MIN_DUTY, ramp.approachDuty(0));
+    TEST_ASSERT_EQUAL_UINT16(MIN_DUTY, ramp.approachDuty(-20));
+
+    // Falls at the ramp-down rate, not in one step
+    uint32_t now = 0;
+    ramp.start(-1, now);
+    stepFor(ramp, 500, FAR_MM, now);
+    uint16_t duty = stepFor(ramp, 25, 0, now);
+    TEST_ASSERT_UINT16_WITHIN(2, 900, duty);
+    TEST_ASSERT_EQUAL_UINT16(MIN_DUTY, stepFor(ramp, 200, 0, now));
+    TEST_ASSERT_EQUAL_INT8(-1, ramp.getDirection());
+}
+
+/**
+ * @test No slow-down when the distance is 0
+ */
+void test_slowdown_off(void) {
+    MotorRamp ramp;
+    ramp.configure(RAMP_UP_MS, RAMP_DOWN_MS, 0, MIN_DUTY, REVERSE_REST_MS);
+    TEST_ASSERT_EQUAL_UINT16(MotorRamp::FULL_DUTY, ramp.approachDuty(0));
+}
+
+/**
+ * @test Soft stop ramps down and drops to zero below the minimum
+ */
+void test_soft_stop(void) {
+    MotorRamp ramp;
+    configure(ramp);
+    uint32_t now = 0;
+    ramp.start(1, now);
+    stepFor(ramp, 500, FAR_MM, now);
+
+    ramp.stop(now);
+    TEST_ASSERT_TRUE(ramp.isStopping());
+    uint16_t duty = stepFor(ramp, 50, FAR_MM, now);
+    TEST_ASSERT_UINT16_WITHIN(2, 800, duty);
+    TEST_ASSERT_EQUAL_UINT16(0, stepFor(ramp, 100, FAR_MM, now));
+    TEST_ASSERT_EQUAL_INT8(0, ramp.getDirection());
+    TEST_ASSERT_FALSE(ramp.isStopping());
+}
+
+/**
+ * @test Cut is immediate
+ */
+void test_cut(void) {
+    MotorRamp ramp;
+    configure(ramp);
+    uint32_t now = 0;
+    ramp.start(1, now);
+    stepFor(ramp, 500, FAR_MM, now);
+    ramp.cut();
+    TEST_ASSERT_EQUAL_UINT16(0, ramp.getDuty());
+    TEST_ASSERT_EQUAL_UINT16(0, stepFor(ramp, 10, FAR_MM, now));
+}
+
+/**
+ * @test Reversing cuts the old direction, rests at zero, then restarts
+ * from the minimum; never ramps through the old direction
+ */
+void test_reversal_restarts_from_minimum(void) {
+    MotorRamp ramp;
+    configure(ramp);
+    uint32_t now = 0;
+    ramp.start(1, now);
+    stepFor(ramp, 500, FAR_MM, now);
+
+    ramp.start(-1, now);
+    TEST_ASSERT_TRUE(ramp.isReversing());
+    TEST_ASSERT_EQUAL_INT8(0, ramp.getDirection());
+    TEST_ASSERT_EQUAL_UINT16(0, ramp.getDuty());
+    TEST_ASSERT_EQUAL_UINT16(0, stepFor(ramp, REVERSE_REST_MS, FAR_MM, now));
+    TEST_ASSERT_EQUAL_INT8(0, ramp.getDirection());
+
+    TEST_ASSERT_EQUAL_UINT16(MIN_DUTY, stepFor(ramp, 1, FAR_MM, now));
+    TEST_ASSERT_EQUAL_INT8(-1, ramp.getDirection());
+    TEST_ASSERT_FALSE(ramp.isReversing());
+
+    // Restarting the same way carries on from the current duty
+    stepFor(ramp, 500, FAR_MM, now);
+    ramp.stop(now);
+    stepFor(ramp, 20, FAR_MM, now);
+    uint16_t duty = ramp.getDuty();
+    ramp.start(-1, now);
+    TEST_ASSERT_EQUAL_UINT16(duty, ramp.getDuty());
+    TEST_ASSERT_FALSE(ramp.isStopping());
+}
+
+/**
+ * @test Reversing out of a soft stop also rests; a new start during the
+ * rest only changes the direction; stop and cut cancel it
+ */
+void test_reverse_rest(void) {
+    MotorRamp ramp;
+    configure(ramp);
+    uint32_t now = 0;
+    ramp.start(1, now);
+    stepFor(ramp, 500, FAR_MM, now);
+    ramp.stop(now);
+    stepFor(ramp, 20, FAR_MM, now);
+
+    ramp.start(-1, now);
+    TEST_ASSERT_TRUE(ramp.isReversing());
+    TEST_ASSERT_FALSE(ramp.isStopping());
+    TEST_ASSERT_EQUAL_UINT16(0, stepFor(ramp, 100, FAR_MM, now));
+    ramp.start(1, now);
+    TEST_ASSERT_EQUAL_UINT16(0, stepFor(ramp, REVERSE_REST_MS - 100, FAR_MM, now));
+    TEST_ASSERT_EQUAL_UINT16(MIN_DUTY, stepFor(ramp, 1, FAR_MM, now));
+    TEST_ASSERT_EQUAL_INT8(1, ramp.getDirection());
+
+    ramp.start(-1, now);
+    ramp.stop(now);
+    TEST_ASSERT_FALSE(ramp.isReversing());
+    TEST_ASSERT_EQUAL_UINT16(0, stepFor(ramp, 500, FAR_MM, now));
+    TEST_ASSERT_EQUAL_INT8(0, ramp.getDirection());
+
+    ramp.start(1, now);
+    ramp.start(-1, now);
+    ramp.cut();
+    TEST_ASSERT_FALSE(ramp.isReversing());
+    TEST_ASSERT_EQUAL_UINT16(0, stepFor(ramp, 500, FAR_MM, now));
+}
+
+/**
+ * @test Zero ramp times switch in one step
+ */
+void test_no_ramp(void) {
+    MotorRamp ramp;
+    ramp.configure(0, 0, 0, MIN_DUTY, REVERSE_REST_MS);
+    uint32_t now = 0;
+    ramp.start(1, now);
+    TEST_ASSERT_EQUAL_UINT16(MotorRamp::FULL_DUTY, stepFor(ramp, 1, FAR_MM, now));
+    ramp.stop(now);
+    TEST_ASSERT_EQUAL_UINT16(0, stepFor(ramp, 1, FAR_MM, now));
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_idle_is_zero);
+    RUN_TEST(test_soft_start);
+    RUN_TEST(test_approach_slowdown);
+    RUN_TEST(test_slowdown_off);
+    RUN_TEST(test_soft_stop);
+    RUN_TEST(test_cut);
+    RUN_TEST(test_reversal_restarts_from_minimum);
+    RUN_TEST(test_reverse_rest);
+    RUN_TEST(test_no_ramp);
+
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    UNITY_BEGIN();
+
+    RUN_TEST(test_idle_is_zero);
+    RUN_TEST(test_soft_start);
+    RUN_TEST(test_approach_slowdown);
+    RUN_TEST(test_slowdown_off);
+    RUN_TEST(test_soft_stop);
+    RUN_TEST(test_cut);
+    RUN_TEST(test_reversal_restarts_from_minimum);
+    RUN_TEST(test_reverse_rest);
+    RUN_TEST(test_no_ramp);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
+#endif
@@ -9,11 +9,10 @@
 #ifdef NATIVE_TEST
 #include <ArduinoFake.h>
 using namespace fakeit;
-#include "MovingAverageFilter.h"  // Local header-only version for native
 #else
 #include <Arduino.h>
-#include "utils/MovingAverageFilter.h"
 #endif
+#include "utils/MovingAverageFilter.h"
 #include <unity.h>
 
 // Forward declarations
@@ -203,6 +202,167 @@ void test_filter_get_last_sample() {
     TEST_ASSERT_EQUAL(300, filter.getLastSample());
 }
 
+/**
+ * Test: Growing the window keeps existing samples and fills from there
+ * (ranging rate switched from idle to active)
+ */
+void test_filter_resize_grow_keeps_samples() {
+    MovingAverageFilter filter(3);
+    filter.addSample(100);
+    filter.addSample(200);
+    filter.addSample(300);
+    filter.addSample(400);  // Window now holds 200, 300, 400
+    
+    filter.resize(15);
+    
+    TEST_ASSERT_EQUAL(15, filter.getWindowSize());
+    TEST_ASSERT_EQUAL(3, filter.getSampleCount());
+    TEST_ASSERT_EQUAL(300, filter.getAverage());
+    TEST_ASSERT_EQUAL(400, filter.getLastSample());
+    
+    filter.addSample(500);
+    TEST_ASSERT_EQUAL(4, filter.getSampleCount());
+    TEST_ASSERT_EQUAL(350, filter.getAverage());  // (200+300+400+500)/4
+}
+
+/**
+ * Test: Shrinking the window keeps only the newest samples
+ * (ranging rate switched from active to idle)
+ */
+void test_filter_resize_shrink_keeps_newest() {
+    MovingAverageFilter filter(5);
+    for (uint16_t v = 100; v <= 700; v += 100) {
+        filter.addSample(v);  // Window holds 300..700
+    }
+    
+    filter.resize(2);
+    
+    TEST_ASSERT_EQUAL(2, filter.getWindowSize());
+    TEST_ASSERT_TRUE(filter.isFull());
+    TEST_ASSERT_EQUAL(650, filter.getAverage());  // (600+700)/2
+    
+    filter.addSample(900);
+    TEST_ASSERT_EQUAL(800, filter.getAverage());  // (700+900)/2
+}
+
+/**
+ * Test: Resize allows windows outside the user-configurable 3-10 range
+ */
+void test_filter_resize_bounds() {
+    MovingAverageFilter filter(5);
+    
+    filter.resize(1);
+    TEST_ASSERT_EQUAL(1, filter.getWindowSize());
+    filter.addSample(100);
+    filter.addSample(200);
+    TEST_ASSERT_EQUAL(200, filter.getAverage());
+    
+    filter.resize(0);
+    TEST_ASSERT_EQUAL(1, filter.getWindowSize());
+    
+    filter.resize(255);
+    TEST_ASSERT_EQUAL(MAX_SCALED_FILTER_WINDOW_SIZE, filter.getWindowSize());
+}
+
+/**
+ * Test: getSamples() replayed into an empty filter rebuilds the window
+ * (warm restart restores the filter from RTC memory this way)
+ */
+void test_filter_get_samples_round_trip() {
+    MovingAverageFilter filter(5);
+    for (uint16_t v = 100; v <= 700; v += 100) {
+        filter.addSample(v);  // Window holds 300..700, head wrapped
+    }
+    
+    uint16_t samples[MovingAverageFilter::capacity()];
+    uint8_t count = filter.getSamples(samples, MovingAverageFilter::capacity());
+    TEST_ASSERT_EQUAL(5, count);
+    TEST_ASSERT_EQUAL(300, samples[0]);
+    TEST_ASSERT_EQUAL(700, samples[4]);
+    
+    MovingAverageFilter restored(5);
+    for (uint8_t i = 0; i < count; i++) {
+        restored.addSample(samples[i]);
+    }
+    TEST_ASSERT_EQUAL(filter.getAverage(), restored.getAverage());
+    TEST_ASSERT_EQUAL(filter.getLastSample(), restored.getLastSample());
+    
+    // Limited copy keeps the newest
+    TEST_ASSERT_EQUAL(2, filter.getSamples(samples, 2));
+    TEST_ASSERT_EQUAL(600, samples[0]);
+    TEST_ASSERT_EQUAL(700, samples[1]);
+    
+    MovingAverageFilter empty(5);
+    TEST_ASSERT_EQUAL(0, empty.getSamples(samples, 5));
+}
+
+/**
+ * Test: Copies are independent (no shared heap buffer)
+ */
+void test_filter_copy_is_independent() {
+    MovingAverageFilter original(3);
+    original.addSample(100);
+    original.addSample(200);
+    
+    MovingAverageFilter copy = original;
+    copy.addSample(900);
+    
+    TEST_ASSERT_EQUAL(150, original.getAverage());
+    TEST_ASSERT_EQUAL(400, copy.getAverage());  // (100+200+900)/3
+    
+    // Assignment replaces state entirely (used to alias the buffer)
+    original = copy;
+    copy.reset();
+    TEST_ASSERT_EQUAL(400, original.getAverage());
+    TEST_ASSERT_TRUE(copy.isEmpty());
+}
+
+/**
+ * Test: configure() applies the user range and clears samples
+ */
+void test_filter_configure() {
+    MovingAverageFilter filter(5);
+    filter.addSample(500);
+    filter.resize(20);
+    
+    filter.configure(7);
+    TEST_ASSERT_EQUAL(7, filter.getWindowSize());
+    TEST_ASSERT_TRUE(filter.isEmpty());
+    
+    filter.configure(50);
+    TEST_ASSERT_EQUAL(MAX_FILTER_WINDOW_SIZE, filter.getWindowSize());
+    filter.configure(1);
+    TEST_ASSERT_EQUAL(MIN_FILTER_WINDOW_SIZE, filter.getWindowSize());
+}
+
+/**
+ * Test: Running sum matches a full re-sum over a long stream with resizes
+ */
+void test_filter_running_sum_matches_resum() {
+    MovingAverageFilter filter(5);
+    uint16_t history[1000];
+    uint32_t seed = 12345;
+    const uint8_t windows[] = {5, 15, 1, 30, 3, 10};
+    
+    for (uint16_t i = 0; i < 1000; i++) {
+        if (i % 150 == 0) {
+            filter.resize(windows[(i / 150) % 6]);
+        }
+        seed = seed * 1103515245u + 12345u;
+        history[i] = 500 + (seed >> 16) % 3500;
+        filter.addSample(history[i]);
+        
+        // Resize keeps the newest min(count, window) samples, so the
+        // expected window is simply the last getSampleCount() samples
+        uint8_t n = filter.getSampleCount();
+        uint32_t sum = 0;
+        for (uint8_t k = 0; k < n; k++) {
+            sum += history[i - k];
+        }
+        TEST_ASSERT_EQUAL(sum / n, filter.getAverage());
+    }
+}
+
 // Arduino framework entry points
 #ifdef NATIVE_TEST
 int main(int argc, char **argv) {
@@ -221,6 +381,13 @@ int main(int argc, char **argv) {
     RUN_TEST(test_filter_overflow_protection);
     RUN_TEST(test_filter_is_full);
     RUN_TEST(test_filter_get_last_sample);
+    RUN_TEST(test_filter_resize_grow_keeps_samples);
+    RUN_TEST(test_filter_resize_shrink_keeps_newest);
+    RUN_TEST(test_filter_resize_bounds);
+    RUN_TEST(test_filter_get_samples_round_trip);
+    RUN_TEST(test_filter_copy_is_independent);
+    RUN_TEST(test_filter_configure);
+    RUN_TEST(test_filter_running_sum_matches_resum);
     
     return UNITY_END();
 }
@@ -244,6 +411,13 @@ void setup() {
     RUN_TEST(test_filter_overflow_protection);
     RUN_TEST(test_filter_is_full);
     RUN_TEST(test_filter_get_last_sample);
+    RUN_TEST(test_filter_resize_grow_keeps_samples);
+    RUN_TEST(test_filter_resize_shrink_keeps_newest);
+    RUN_TEST(test_filter_resize_bounds);
+    RUN_TEST(test_filter_get_samples_round_trip);
+    RUN_TEST(test_filter_copy_is_independent);
+    RUN_TEST(test_filter_configure);
+    RUN_TEST(test_filter_running_sum_matches_resum);
     
     UNITY_END();
 }
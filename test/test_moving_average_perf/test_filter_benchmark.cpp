@@ -0,0 +1,184 @@
+/**
+ * @file test_filter_benchmark.cpp
+ * @brief Benchmark: fixed-capacity running-sum filter vs previous heap filter
+ *
+ * LegacyMovingAverageFilter is the previous implementation (new[] buffer,
+ * full re-sum in getAverage()), kept here only as the baseline. Each
+ * iteration is one frame: addSample() followed by getAverage().
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#include <chrono>
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cstdio>
+#include "utils/MovingAverageFilter.h"
+
+// ============================================
+// Baseline (previous MovingAverageFilter)
+// ============================================
+
+class LegacyMovingAverageFilter {
+public:
+    explicit LegacyMovingAverageFilter(uint8_t windowSize)
+        : windowSize_(windowSize), head_(0), sampleCount_(0) {
+        buffer_ = new uint16_t[windowSize_];
+        for (uint8_t i = 0; i < windowSize_; i++) {
+            buffer_[i] = 0;
+        }
+    }
+
+    ~LegacyMovingAverageFilter() {
+        delete[] buffer_;
+    }
+
+    void addSample(uint16_t sample) {
+        buffer_[head_] = sample;
+        head_ = (head_ + 1) % windowSize_;
+        if (sampleCount_ < windowSize_) {
+            sampleCount_++;
+        }
+    }
+
+    uint16_t getAverage() const {
+        if (sampleCount_ == 0) return 0;
+        uint32_t sum = 0;
+        for (uint8_t i = 0; i < sampleCount_; i++) {
+            sum += buffer_[i];
+        }
+        return static_cast<uint16_t>(sum / sampleCount_);
+    }
+
+private:
+    LegacyMovingAverageFilter(const LegacyMovingAverageFilter&);
+    LegacyMovingAverageFilter& operator=(const LegacyMovingAverageFilter&);
+
+    uint16_t* buffer_;
+    uint8_t windowSize_;
+    uint8_t head_;
+    uint8_t sampleCount_;
+};
+
+// ============================================
+// Helpers
+// ============================================
+
+static unsigned long nowMicros() {
+#ifdef NATIVE_TEST
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#else
+    return micros();
+#endif
+}
+
+template <typename Filter>
+static double timePerFrameNs(Filter& filter, uint32_t frames, uint32_t& checksum) {
+    uint32_t seed = 1;
+    volatile uint32_t sink = 0;
+    unsigned long start = nowMicros();
+    for (uint32_t i = 0; i < frames; i++) {
+        seed = seed * 1103515245u + 12345u;
+        filter.addSample(800 + (seed >> 16) % 100);
+        sink += filter.getAverage();
+    }
+    unsigned long elapsed = nowMicros() - start;
+    checksum = sink;
+    return elapsed * 1000.0 / frames;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================
+// Tests
+// ============================================
+
+/**
+ * @test Both filters produce identical output (same truncating average)
+ */
+void test_benchmark_outputs_match(void) {
+    const uint8_t windows[] = {3, 5, 10, 15, 30};
+    for (uint8_t w : windows) {
+        LegacyMovingAverageFilter legacy(w);
+        MovingAverageFilter fixed(5);
+        fixed.resize(w);
+        uint32_t legacySum = 0;
+        uint32_t fixedSum = 0;
+        timePerFrameNs(legacy, 1000, legacySum);
+        timePerFrameNs(fixed, 1000, fixedSum);
+        TEST_ASSERT_EQUAL_UINT32(legacySum, fixedSum);
+    }
+}
+
+/**
+ * @test Storage is inline: sizeof covers the whole buffer, no heap
+ */
+void test_benchmark_no_heap(void) {
+    TEST_ASSERT_TRUE(sizeof(MovingAverageFilter) >=
+                     MAX_SCALED_FILTER_WINDOW_SIZE * sizeof(uint16_t));
+    TEST_ASSERT_EQUAL(MAX_SCALED_FILTER_WINDOW_SIZE, MovingAverageFilter::capacity());
+}
+
+/**
+ * @test Print per-frame cost for the configured, reference and active windows
+ *
+ * The running sum makes the cost independent of the window; the legacy
+ * re-sum grows linearly. Asserts only at the 30-sample active window.
+ */
+void test_benchmark_per_frame_cost(void) {
+    const uint8_t windows[] = {5, 10, 30};
+    const uint32_t frames = 200000;
+    double legacy30 = 0;
+    double fixed30 = 0;
+
+    for (uint8_t w : windows) {
+        LegacyMovingAverageFilter legacy(w);
+        MovingAverageFilter fixed(5);
+        fixed.resize(w);
+        uint32_t checksum = 0;
+        double legacyNs = timePerFrameNs(legacy, frames, checksum);
+        double fixedNs = timePerFrameNs(fixed, frames, checksum);
+
+        char msg[96];
+        snprintf(msg, sizeof(msg), "window %2u: legacy %6.2f ns/frame, fixed %6.2f ns/frame",
+                 w, legacyNs, fixedNs);
+        TEST_MESSAGE(msg);
+
+        if (w == 30) {
+            legacy30 = legacyNs;
+            fixed30 = fixedNs;
+        }
+    }
+
+    TEST_ASSERT_TRUE(fixed30 < legacy30);
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_benchmark_outputs_match);
+    RUN_TEST(test_benchmark_no_heap);
+    RUN_TEST(test_benchmark_per_frame_cost);
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);
+    UNITY_BEGIN();
+    RUN_TEST(test_benchmark_outputs_match);
+    RUN_TEST(test_benchmark_no_heap);
+    RUN_TEST(test_benchmark_per_frame_cost);
+    UNITY_END();
+}
+
+void loop() {}
+#endif
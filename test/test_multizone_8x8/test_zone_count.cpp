@@ -0,0 +1,293 @@
+/**
+ * @file test_zone_count.cpp
+ * @brief Unit tests for zone-count-generic multi-zone consensus (4x4 and 8x8)
+ *
+ * The firmware sizes all consensus buffers from MULTI_ZONE_TOTAL_ZONES,
+ * selected at compile time (-DSENSOR_ZONES_8X8). These tests mirror the
+ * pipeline as a template on zone count so both modes are checked in one
+ * build, and report a per-frame timing figure for each.
+ *
+ * Minimum valid zones scales with the grid (25%): 4 of 16, 16 of 64.
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#include <chrono>
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cstdio>
+#include <cstring>
+
+// ============================================
+// Constants (match Config.h)
+// ============================================
+constexpr uint16_t SENSOR_MIN_VALID_MM = 10;
+constexpr uint16_t SENSOR_MAX_RANGE_MM = 4000;
+constexpr uint16_t OUTLIER_THRESHOLD_MM = 30;
+
+// ============================================
+// Data Structures (match HeightController.h)
+// ============================================
+
+template <uint8_t ZoneCount>
+struct MockSensorFrame {
+    int16_t distance_mm[ZoneCount];
+    uint8_t target_status[ZoneCount];
+};
+
+struct ConsensusResult {
+    uint16_t consensus_distance_mm;
+    uint8_t valid_zone_count;
+    uint8_t outlier_count;
+    bool is_reliable;
+};
+
+// ============================================
+// Pipeline (mirrors HeightController.cpp)
+// ============================================
+
+bool isZoneValid(uint8_t status, uint16_t distance) {
+    if (status != 5 && status != 6 && status != 9) return false;
+    if (distance < SENSOR_MIN_VALID_MM) return false;
+    if (distance > SENSOR_MAX_RANGE_MM) return false;
+    return true;
+}
+
+uint16_t computeMedian(uint16_t* values, uint8_t count) {
+    if (count == 0) return 0;
+    for (uint8_t i = 1; i < count; i++) {
+        uint16_t key = values[i];
+        int8_t j = i - 1;
+        while (j >= 0 && values[j] > key) {
+            values[j + 1] = values[j];
+            j--;
+        }
+        values[j + 1] = key;
+    }
+    return values[(count - 1) / 2];
+}
+
+template <uint8_t ZoneCount>
+ConsensusResult computeConsensus(const MockSensorFrame<ZoneCount>& frame) {
+    constexpr uint8_t MIN_VALID_ZONES = ZoneCount / 4;
+    ConsensusResult result = {0, 0, 0, false};
+
+    uint16_t valid[ZoneCount];
+    uint8_t valid_count = 0;
+    for (uint8_t zone = 0; zone < ZoneCount; zone++) {
+        int16_t d = frame.distance_mm[zone];
+        uint16_t distance = (d > 0) ? static_cast<uint16_t>(d) : 0;
+        if (isZoneValid(frame.target_status[zone], distance)) {
+            valid[valid_count++] = distance;
+        }
+    }
+    result.valid_zone_count = valid_count;
+    if (valid_count < MIN_VALID_ZONES) return result;
+
+    uint16_t median_input[ZoneCount];
+    memcpy(median_input, valid, valid_count * sizeof(uint16_t));
+    uint16_t median = computeMedian(median_input, valid_count);
+
+    uint32_t sum = 0;
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < valid_count; i++) {
+        uint16_t dev = (valid[i] > median) ? valid[i] - median : median - valid[i];
+        if (dev <= OUTLIER_THRESHOLD_MM) {
+            sum += valid[i];
+            kept++;
+        }
+    }
+    result.outlier_count = valid_count - kept;
+    if (kept == 0) return result;
+
+    result.consensus_distance_mm = static_cast<uint16_t>(sum / kept);
+    result.is_reliable = true;
+    return result;
+}
+
+// ============================================
+// Helpers
+// ============================================
+
+template <uint8_t ZoneCount>
+void fillFrame(MockSensorFrame<ZoneCount>& frame, int16_t distance, uint8_t status = 5) {
+    for (uint8_t i = 0; i < ZoneCount; i++) {
+        frame.distance_mm[i] = distance;
+        frame.target_status[i] = status;
+    }
+}
+
+/**
+ * @brief Deterministic floor with ±noise and a block of near obstacles
+ */
+template <uint8_t ZoneCount>
+void fillClutteredFrame(MockSensorFrame<ZoneCount>& frame, uint32_t seed) {
+    for (uint8_t i = 0; i < ZoneCount; i++) {
+        seed = seed * 1103515245u + 12345u;
+        frame.distance_mm[i] = 850 + static_cast<int16_t>((seed >> 16) % 11) - 5;
+        frame.target_status[i] = 5;
+    }
+    // Chair leg / cable tray in the first 20% of zones
+    for (uint8_t i = 0; i < ZoneCount / 5; i++) {
+        frame.distance_mm[i] = 420;
+    }
+}
+
+static unsigned long nowMicros() {
+#ifdef NATIVE_TEST
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#else
+    return micros();
+#endif
+}
+
+template <uint8_t ZoneCount>
+double timeConsensusPerFrameUs(uint32_t frames) {
+    MockSensorFrame<ZoneCount> frame;
+    volatile uint32_t sink = 0;
+    unsigned long start = nowMicros();
+    for (uint32_t f = 0; f < frames; f++) {
+        fillClutteredFrame(frame, f);
+        sink += computeConsensus(frame).consensus_distance_mm;
+    }
+    unsigned long elapsed = nowMicros() - start;
+    (void)sink;
+    return static_cast<double>(elapsed) / frames;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================
+// Tests
+// ============================================
+
+/**
+ * @test 4x4 baseline still behaves as before (16 zones, 4 minimum)
+ */
+void test_4x4_all_zones_valid(void) {
+    MockSensorFrame<16> frame;
+    fillFrame(frame, 850);
+
+    ConsensusResult r = computeConsensus(frame);
+
+    TEST_ASSERT_TRUE(r.is_reliable);
+    TEST_ASSERT_EQUAL_UINT8(16, r.valid_zone_count);
+    TEST_ASSERT_EQUAL_UINT16(850, r.consensus_distance_mm);
+}
+
+/**
+ * @test 8x8 uses all 64 zones
+ */
+void test_8x8_all_zones_valid(void) {
+    MockSensorFrame<64> frame;
+    fillFrame(frame, 1200);
+
+    ConsensusResult r = computeConsensus(frame);
+
+    TEST_ASSERT_TRUE(r.is_reliable);
+    TEST_ASSERT_EQUAL_UINT8(64, r.valid_zone_count);
+    TEST_ASSERT_EQUAL_UINT8(0, r.outlier_count);
+    TEST_ASSERT_EQUAL_UINT16(1200, r.consensus_distance_mm);
+}
+
+/**
+ * @test 8x8 rejects a cluster of near obstacles covering 20% of zones
+ */
+void test_8x8_rejects_obstacle_cluster(void) {
+    MockSensorFrame<64> frame;
+    fillClutteredFrame(frame, 42);
+
+    ConsensusResult r = computeConsensus(frame);
+
+    TEST_ASSERT_TRUE(r.is_reliable);
+    TEST_ASSERT_EQUAL_UINT8(64 / 5, r.outlier_count);
+    TEST_ASSERT_UINT16_WITHIN(5, 850, r.consensus_distance_mm);
+}
+
+/**
+ * @test 8x8 minimum valid zones is 16 (25%)
+ */
+void test_8x8_min_valid_zones(void) {
+    MockSensorFrame<64> frame;
+    fillFrame(frame, 900, 255);
+    for (uint8_t i = 0; i < 15; i++) {
+        frame.target_status[i] = 5;
+    }
+    TEST_ASSERT_FALSE(computeConsensus(frame).is_reliable);
+
+    frame.target_status[15] = 5;
+    ConsensusResult r = computeConsensus(frame);
+    TEST_ASSERT_TRUE(r.is_reliable);
+    TEST_ASSERT_EQUAL_UINT8(16, r.valid_zone_count);
+}
+
+/**
+ * @test Last zone of the 8x8 grid is included (no 16-zone truncation)
+ */
+void test_8x8_last_zone_used(void) {
+    MockSensorFrame<64> frame;
+    fillFrame(frame, 900, 0);
+    for (uint8_t i = 48; i < 64; i++) {
+        frame.target_status[i] = 5;
+    }
+
+    ConsensusResult r = computeConsensus(frame);
+
+    TEST_ASSERT_TRUE(r.is_reliable);
+    TEST_ASSERT_EQUAL_UINT8(16, r.valid_zone_count);
+}
+
+/**
+ * @test Per-frame consensus timing for both modes
+ *
+ * Prints the figure; asserts only a generous bound so the test is
+ * stable across hosts. On device, see maxConsensusTimeUs in /diagnostics.
+ */
+void test_consensus_timing_per_frame(void) {
+    const uint32_t frames = 20000;
+    double us16 = timeConsensusPerFrameUs<16>(frames);
+    double us64 = timeConsensusPerFrameUs<64>(frames);
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "consensus per frame: 4x4 %.2f us, 8x8 %.2f us", us16, us64);
+    TEST_MESSAGE(msg);
+
+    // 8x8 frame period at 15 Hz is 66ms; consensus must be a tiny fraction
+    TEST_ASSERT_TRUE(us64 < 1000.0);
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_4x4_all_zones_valid);
+    RUN_TEST(test_8x8_all_zones_valid);
+    RUN_TEST(test_8x8_rejects_obstacle_cluster);
+    RUN_TEST(test_8x8_min_valid_zones);
+    RUN_TEST(test_8x8_last_zone_used);
+    RUN_TEST(test_consensus_timing_per_frame);
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);
+    UNITY_BEGIN();
+    RUN_TEST(test_4x4_all_zones_valid);
+    RUN_TEST(test_8x8_all_zones_valid);
+    RUN_TEST(test_8x8_rejects_obstacle_cluster);
+    RUN_TEST(test_8x8_min_valid_zones);
+    RUN_TEST(test_8x8_last_zone_used);
+    RUN_TEST(test_consensus_timing_per_frame);
+    UNITY_END();
+}
+
+void loop() {}
+#endif
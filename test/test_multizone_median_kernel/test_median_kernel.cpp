@@ -0,0 +1,269 @@
+/**
+ * @file test_median_kernel.cpp
+ * @brief Correctness and benchmark tests for the MedianSelect kernel
+ *
+ * Checks the sorting network / quickselect paths against the previous
+ * insertion-sort median (lower middle for even counts) over all zone
+ * counts up to 64, and prints a per-call timing comparison for common
+ * valid-zone distributions.
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#include <chrono>
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cstdio>
+#include <cstring>
+#include "utils/MedianSelect.h"
+
+// ============================================
+// Reference (previous HeightController::computeMedian)
+// ============================================
+
+uint16_t insertionSortMedian(uint16_t* values, uint8_t count) {
+    if (count == 0) return 0;
+    if (count == 1) return values[0];
+    for (uint8_t i = 1; i < count; i++) {
+        uint16_t key = values[i];
+        int8_t j = i - 1;
+        while (j >= 0 && values[j] > key) {
+            values[j + 1] = values[j];
+            j--;
+        }
+        values[j + 1] = key;
+    }
+    if (count % 2 == 0) {
+        return values[count / 2 - 1];
+    }
+    return values[count / 2];
+}
+
+// ============================================
+// Input generators
+// ============================================
+
+enum class Distribution { NOISY_FLOOR, SORTED, REVERSED, DUPLICATES, BIMODAL };
+
+static uint32_t lcgState = 1;
+
+static uint16_t nextRandom() {
+    lcgState = lcgState * 1103515245u + 12345u;
+    return static_cast<uint16_t>(lcgState >> 16);
+}
+
+static void fillValues(uint16_t* values, uint8_t count, Distribution dist) {
+    for (uint8_t i = 0; i < count; i++) {
+        switch (dist) {
+            case Distribution::NOISY_FLOOR:
+                values[i] = 850 + (nextRandom() % 21);
+                break;
+            case Distribution::SORTED:
+                values[i] = 800 + i * 3;
+                break;
+            case Distribution::REVERSED:
+                values[i] = 1000 - i * 3;
+                break;
+            case Distribution::DUPLICATES:
+                values[i] = 850 + (nextRandom() % 3);
+                break;
+            case Distribution::BIMODAL:
+                // Desk underside and a chair seat in the field of view
+                values[i] = (nextRandom() % 3 == 0) ? 420 + (nextRandom() % 10)
+                                                     : 850 + (nextRandom() % 10);
+                break;
+        }
+    }
+}
+
+static unsigned long nowMicros() {
+#ifdef NATIVE_TEST
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#else
+    return micros();
+#endif
+}
+
+void setUp(void) {
+    lcgState = 1;
+}
+
+void tearDown(void) {}
+
+// ============================================
+// Tests
+// ============================================
+
+/**
+ * @test Edge cases match previous behaviour
+ */
+void test_kernel_empty_and_single(void) {
+    uint16_t values[] = {850};
+    TEST_ASSERT_EQUAL_UINT16(0, MedianSelect::lowerMedian(values, 0));
+    TEST_ASSERT_EQUAL_UINT16(850, MedianSelect::lowerMedian(values, 1));
+}
+
+/**
+ * @test Even counts return the lower middle on both paths
+ */
+void test_kernel_even_count_lower_middle(void) {
+    uint16_t small[] = {800, 850, 840, 860};
+    TEST_ASSERT_EQUAL_UINT16(840, MedianSelect::lowerMedian(small, 4));
+
+    uint16_t large[64];
+    for (uint8_t i = 0; i < 64; i++) {
+        large[i] = 1000 - i;  // 937..1000
+    }
+    // Sorted index 31 -> 937 + 31
+    TEST_ASSERT_EQUAL_UINT16(968, MedianSelect::lowerMedian(large, 64));
+}
+
+/**
+ * @test Sorting network sorts every 0/1 input (zero-one principle)
+ */
+void test_network_sorts_all_binary_inputs(void) {
+    for (uint32_t mask = 0; mask < (1u << 16); mask++) {
+        uint16_t v[16];
+        for (uint8_t i = 0; i < 16; i++) {
+            v[i] = (mask >> i) & 1u;
+        }
+        MedianSelect::sortNetwork16(v);
+        for (uint8_t i = 1; i < 16; i++) {
+            if (v[i - 1] > v[i]) {
+                TEST_FAIL_MESSAGE("network failed to sort binary input");
+            }
+        }
+    }
+}
+
+/**
+ * @test Kernel matches insertion sort for every count 1..64 and distribution
+ */
+void test_kernel_matches_reference(void) {
+    const Distribution dists[] = {Distribution::NOISY_FLOOR, Distribution::SORTED,
+                                  Distribution::REVERSED, Distribution::DUPLICATES,
+                                  Distribution::BIMODAL};
+    for (uint8_t count = 1; count <= 64; count++) {
+        for (Distribution dist : dists) {
+            for (uint8_t trial = 0; trial < 20; trial++) {
+                uint16_t a[64];
+                uint16_t b[64];
+                fillValues(a, count, dist);
+                memcpy(b, a, count * sizeof(uint16_t));
+
+                uint16_t expected = insertionSortMedian(a, count);
+                uint16_t actual = MedianSelect::lowerMedian(b, count);
+                if (expected != actual) {
+                    char msg[80];
+                    snprintf(msg, sizeof(msg), "count=%u dist=%d: expected %u got %u",
+                             count, static_cast<int>(dist), expected, actual);
+                    TEST_FAIL_MESSAGE(msg);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @test Extreme values (0 and UINT16_MAX) do not disturb network padding
+ */
+void test_kernel_extreme_values(void) {
+    uint16_t values[] = {UINT16_MAX, 0, UINT16_MAX, 0, UINT16_MAX};
+    TEST_ASSERT_EQUAL_UINT16(UINT16_MAX, MedianSelect::lowerMedian(values, 5));
+
+    uint16_t pair[] = {UINT16_MAX, 0};
+    TEST_ASSERT_EQUAL_UINT16(0, MedianSelect::lowerMedian(pair, 2));
+}
+
+// ============================================
+// Benchmark
+// ============================================
+
+typedef uint16_t (*MedianFn)(uint16_t*, uint8_t);
+
+static double timePerCallNs(MedianFn fn, uint8_t count, Distribution dist, uint32_t iterations) {
+    const uint8_t SETS = 32;
+    uint16_t inputs[SETS][64];
+    for (uint8_t s = 0; s < SETS; s++) {
+        fillValues(inputs[s], count, dist);
+    }
+
+    volatile uint32_t sink = 0;
+    uint16_t work[64];
+    unsigned long start = nowMicros();
+    for (uint32_t it = 0; it < iterations; it++) {
+        memcpy(work, inputs[it % SETS], count * sizeof(uint16_t));
+        sink += fn(work, count);
+    }
+    unsigned long elapsed = nowMicros() - start;
+    (void)sink;
+    return elapsed * 1000.0 / iterations;
+}
+
+/**
+ * @test Print insertion sort vs kernel timing across zone counts
+ *
+ * Informational; asserts only that the kernel is not dramatically slower
+ * at 64 zones, where the insertion sort is O(n^2).
+ */
+void test_kernel_benchmark(void) {
+    const uint8_t counts[] = {4, 12, 16, 32, 48, 64};
+    const Distribution dists[] = {Distribution::NOISY_FLOOR, Distribution::REVERSED,
+                                  Distribution::BIMODAL};
+    const char* distNames[] = {"noisy", "reversed", "bimodal"};
+    const uint32_t iterations = 20000;
+
+    double insertion64 = 0;
+    double kernel64 = 0;
+    for (uint8_t d = 0; d < 3; d++) {
+        for (uint8_t count : counts) {
+            double ins = timePerCallNs(insertionSortMedian, count, dists[d], iterations);
+            double ker = timePerCallNs(MedianSelect::lowerMedian, count, dists[d], iterations);
+            char msg[96];
+            snprintf(msg, sizeof(msg), "%-8s n=%2u insertion %7.1f ns  kernel %7.1f ns",
+                     distNames[d], count, ins, ker);
+            TEST_MESSAGE(msg);
+            if (count == 64) {
+                insertion64 += ins;
+                kernel64 += ker;
+            }
+        }
+    }
+
+    TEST_ASSERT_TRUE(kernel64 <= insertion64 * 1.5);
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_kernel_empty_and_single);
+    RUN_TEST(test_kernel_even_count_lower_middle);
+    RUN_TEST(test_network_sorts_all_binary_inputs);
+    RUN_TEST(test_kernel_matches_reference);
+    RUN_TEST(test_kernel_extreme_values);
+    RUN_TEST(test_kernel_benchmark);
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);
+    UNITY_BEGIN();
+    RUN_TEST(test_kernel_empty_and_single);
+    RUN_TEST(test_kernel_even_count_lower_middle);
+    RUN_TEST(test_network_sorts_all_binary_inputs);
+    RUN_TEST(test_kernel_matches_reference);
+    RUN_TEST(test_kernel_extreme_values);
+    RUN_TEST(test_kernel_benchmark);
+    UNITY_END();
+}
+
+void loop() {}
+#endif
@@ -23,12 +23,12 @@ using namespace fakeit;
 #endif
 #include <unity.h>
 #include <cstring>
+#include "utils/MovingAverageFilter.h"
 
 // ============================================
 // Constants (match Config.h)
+// SENSOR_MIN_VALID_MM / SENSOR_MAX_RANGE_MM come from Config.h via the filter
 // ============================================
-constexpr uint16_t SENSOR_MIN_VALID_MM = 10;
-constexpr uint16_t SENSOR_MAX_RANGE_MM = 4000;
 constexpr uint16_t OUTLIER_THRESHOLD_MM = 30;
 constexpr uint8_t MIN_VALID_ZONES = 4;
 constexpr uint8_t MAX_ZONES = 16;
@@ -50,57 +50,6 @@ struct ConsensusResult {
     bool is_reliable;
 };
 
-// ============================================
-// Mock MovingAverageFilter (simplified)
-// ============================================
-
-class MockMovingAverageFilter {
-public:
-    MockMovingAverageFilter(uint8_t window_size) 
-        : window_size_(window_size), count_(0), sum_(0), head_(0) {
-        memset(samples_, 0, sizeof(samples_));
-    }
-    
-    void addSample(uint16_t sample) {
-        if (count_ < window_size_) {
-            samples_[count_++] = sample;
-            sum_ += sample;
-        } else {
-            sum_ -= samples_[head_];
-            samples_[head_] = sample;
-            sum_ += sample;
-            head_ = (head_ + 1) % window_size_;
-        }
-    }
-    
-    uint16_t getAverage() const {
-        if (count_ == 0) return 0;
-        return (uint16_t)(sum_ / count_);
-    }
-    
-    bool isFull() const {
-        return count_ >= window_size_;
-    }
-    
-    void reset() {
-        count_ = 0;
-        sum_ = 0;
-        head_ = 0;
-        memset(samples_, 0, sizeof(samples_));
-    }
-    
-    uint8_t getSampleCount() const {
-        return count_;
-    }
-
-private:
-    uint16_t samples_[10];  // Max window size
-    uint8_t window_size_;
-    uint8_t count_;
-    uint32_t sum_;
-    uint8_t head_;
-};
-
 // ============================================
 // Utility Functions
 // ============================================
@@ -237,7 +186,7 @@ public:
     }
 
 private:
-    MockMovingAverageFilter temporal_filter_;
+    MovingAverageFilter temporal_filter_;
     ConsensusResult last_consensus_;
 };
 
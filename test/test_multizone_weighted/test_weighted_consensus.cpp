@@ -0,0 +1,294 @@
+/**
+ * @file test_weighted_consensus.cpp
+ * @brief Unit tests for confidence-weighted multi-zone consensus
+ *
+ * Mirrors HeightController::computeZoneWeight / computeWeightedMean and
+ * compares per-frame variance of the weighted estimator against the
+ * equal-weight median+mean estimator on simulated frames where zones
+ * have different noise levels (center vs edge vs sunlit corners).
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// ============================================
+// Constants (match Config.h)
+// ============================================
+constexpr uint8_t ZONES = 16;
+constexpr uint8_t MIN_VALID_ZONES = 4;
+constexpr uint16_t OUTLIER_THRESHOLD_MM = 30;
+constexpr uint16_t WEIGHTED_CONSENSUS_MIN_SIGMA_MM = 2;
+constexpr float WEIGHTED_CONSENSUS_SNR_KNEE = 1.0f;
+
+// ============================================
+// Implementation (mirrors HeightController.cpp)
+// ============================================
+
+float computeZoneWeight(uint16_t sigma_mm, uint32_t signal_per_spad, uint32_t ambient_per_spad) {
+    float sigma = (sigma_mm < WEIGHTED_CONSENSUS_MIN_SIGMA_MM)
+        ? static_cast<float>(WEIGHTED_CONSENSUS_MIN_SIGMA_MM)
+        : static_cast<float>(sigma_mm);
+    float snrFactor = 1.0f;
+    if (ambient_per_spad > 0) {
+        float snr = static_cast<float>(signal_per_spad) / static_cast<float>(ambient_per_spad);
+        snrFactor = snr / (snr + WEIGHTED_CONSENSUS_SNR_KNEE);
+    }
+    return snrFactor / (sigma * sigma);
+}
+
+uint16_t computeMean(const uint16_t* values, uint8_t count) {
+    if (count == 0) return 0;
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < count; i++) sum += values[i];
+    return static_cast<uint16_t>(sum / count);
+}
+
+uint16_t computeWeightedMean(const uint16_t* values, const float* weights, uint8_t count) {
+    if (count == 0) return 0;
+    float weightedSum = 0.0f;
+    float weightTotal = 0.0f;
+    for (uint8_t i = 0; i < count; i++) {
+        weightedSum += weights[i] * values[i];
+        weightTotal += weights[i];
+    }
+    if (weightTotal <= 0.0f) return computeMean(values, count);
+    return static_cast<uint16_t>(weightedSum / weightTotal + 0.5f);
+}
+
+uint16_t computeMedian(uint16_t* values, uint8_t count) {
+    for (uint8_t i = 1; i < count; i++) {
+        uint16_t key = values[i];
+        int8_t j = i - 1;
+        while (j >= 0 && values[j] > key) {
+            values[j + 1] = values[j];
+            j--;
+        }
+        values[j + 1] = key;
+    }
+    return values[(count - 1) / 2];
+}
+
+struct Zone {
+    uint16_t distance_mm;
+    uint16_t sigma_mm;
+    uint32_t signal_per_spad;
+    uint32_t ambient_per_spad;
+};
+
+/**
+ * @brief Median outlier filter followed by plain or weighted mean
+ */
+uint16_t consensus(const Zone* zones, uint8_t count, bool weighted) {
+    if (count < MIN_VALID_ZONES) return 0;
+
+    uint16_t sorted[ZONES];
+    for (uint8_t i = 0; i < count; i++) sorted[i] = zones[i].distance_mm;
+    uint16_t median = computeMedian(sorted, count);
+
+    uint16_t kept[ZONES];
+    float weights[ZONES];
+    uint8_t keptCount = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t d = zones[i].distance_mm;
+        uint16_t dev = (d > median) ? d - median : median - d;
+        if (dev <= OUTLIER_THRESHOLD_MM) {
+            weights[keptCount] = computeZoneWeight(zones[i].sigma_mm, zones[i].signal_per_spad,
+                                                   zones[i].ambient_per_spad);
+            kept[keptCount++] = d;
+        }
+    }
+    return weighted ? computeWeightedMean(kept, weights, keptCount)
+                    : computeMean(kept, keptCount);
+}
+
+// ============================================
+// Simulation helpers
+// ============================================
+
+static uint32_t lcgState = 1;
+
+static double uniform01() {
+    lcgState = lcgState * 1103515245u + 12345u;
+    return ((lcgState >> 8) & 0xFFFFFF) / 16777216.0 + 1e-9;
+}
+
+static double gaussian() {
+    // Box-Muller
+    return std::sqrt(-2.0 * std::log(uniform01())) * std::cos(2.0 * M_PI * uniform01());
+}
+
+/**
+ * @brief Fill a 4x4 frame: quiet center, noisier edges, sunlit corners
+ */
+static void simulateFrame(Zone* zones, uint16_t truth) {
+    for (uint8_t i = 0; i < ZONES; i++) {
+        uint8_t row = i / 4;
+        uint8_t col = i % 4;
+        bool edgeRow = (row == 0 || row == 3);
+        bool edgeCol = (col == 0 || col == 3);
+        if (edgeRow && edgeCol) {
+            zones[i].sigma_mm = 12;
+            zones[i].signal_per_spad = 40;
+            zones[i].ambient_per_spad = 60;
+        } else if (edgeRow || edgeCol) {
+            zones[i].sigma_mm = 6;
+            zones[i].signal_per_spad = 120;
+            zones[i].ambient_per_spad = 20;
+        } else {
+            zones[i].sigma_mm = 2;
+            zones[i].signal_per_spad = 300;
+            zones[i].ambient_per_spad = 10;
+        }
+        double d = truth + gaussian() * zones[i].sigma_mm;
+        zones[i].distance_mm = static_cast<uint16_t>(d + 0.5);
+    }
+}
+
+void setUp(void) {
+    lcgState = 1;
+}
+
+void tearDown(void) {}
+
+// ============================================
+// Tests
+// ============================================
+
+/**
+ * @test Lower sigma gives higher weight (inverse variance)
+ */
+void test_weight_inverse_variance(void) {
+    float w2 = computeZoneWeight(2, 100, 0);
+    float w4 = computeZoneWeight(4, 100, 0);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.25f, w2);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 4.0f, w2 / w4);
+}
+
+/**
+ * @test Sigma below floor is clamped (no divide by zero, no runaway weight)
+ */
+void test_weight_sigma_floor(void) {
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, computeZoneWeight(2, 100, 0), computeZoneWeight(0, 100, 0));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, computeZoneWeight(2, 100, 0), computeZoneWeight(1, 100, 0));
+}
+
+/**
+ * @test High ambient relative to signal reduces weight
+ */
+void test_weight_ambient_penalty(void) {
+    float dark = computeZoneWeight(5, 100, 0);
+    float equal = computeZoneWeight(5, 100, 100);
+    float bright = computeZoneWeight(5, 100, 400);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, dark * 0.5f, equal);
+    TEST_ASSERT_TRUE(bright < equal);
+}
+
+/**
+ * @test Equal weights reduce to the plain mean (rounded)
+ */
+void test_weighted_mean_equal_weights(void) {
+    uint16_t values[] = {850, 852, 854, 856};
+    float weights[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    TEST_ASSERT_EQUAL_UINT16(853, computeWeightedMean(values, weights, 4));
+}
+
+/**
+ * @test Weighted mean is pulled toward the high-confidence zone
+ */
+void test_weighted_mean_favors_confident_zone(void) {
+    uint16_t values[] = {850, 870};
+    float weights[] = {computeZoneWeight(2, 300, 10), computeZoneWeight(10, 50, 50)};
+    uint16_t result = computeWeightedMean(values, weights, 2);
+    TEST_ASSERT_TRUE(result < 852);
+}
+
+/**
+ * @test Zero total weight falls back to the plain mean
+ */
+void test_weighted_mean_zero_weights(void) {
+    uint16_t values[] = {800, 900};
+    float weights[] = {0.0f, 0.0f};
+    TEST_ASSERT_EQUAL_UINT16(850, computeWeightedMean(values, weights, 2));
+}
+
+/**
+ * @test Weighted consensus has lower per-frame variance on mixed-noise frames
+ *
+ * Prints both standard deviations and the moving-average window the
+ * weighted estimator needs to match the equal-weight estimator at the
+ * default window of 5.
+ */
+void test_weighted_consensus_reduces_variance(void) {
+    const uint16_t truth = 850;
+    const uint32_t frames = 5000;
+    double sumU = 0, sumSqU = 0, sumW = 0, sumSqW = 0;
+
+    Zone zones[ZONES];
+    for (uint32_t f = 0; f < frames; f++) {
+        simulateFrame(zones, truth);
+        double u = consensus(zones, ZONES, false);
+        double w = consensus(zones, ZONES, true);
+        sumU += u;
+        sumSqU += u * u;
+        sumW += w;
+        sumSqW += w * w;
+    }
+
+    double meanU = sumU / frames;
+    double meanW = sumW / frames;
+    double varU = sumSqU / frames - meanU * meanU;
+    double varW = sumSqW / frames - meanW * meanW;
+
+    // Window N gives variance var/N; match varU/5
+    double equivalentWindow = 5.0 * varW / varU;
+
+    char msg[128];
+    snprintf(msg, sizeof(msg),
+             "per-frame sigma: median-mean %.2f mm, weighted %.2f mm; window 5 -> %.1f",
+             std::sqrt(varU), std::sqrt(varW), equivalentWindow);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_TRUE(varW < varU * 0.75);
+    TEST_ASSERT_FLOAT_WITHIN(1.5, truth, meanW);
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_weight_inverse_variance);
+    RUN_TEST(test_weight_sigma_floor);
+    RUN_TEST(test_weight_ambient_penalty);
+    RUN_TEST(test_weighted_mean_equal_weights);
+    RUN_TEST(test_weighted_mean_favors_confident_zone);
+    RUN_TEST(test_weighted_mean_zero_weights);
+    RUN_TEST(test_weighted_consensus_reduces_variance);
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);
+    UNITY_BEGIN();
+    RUN_TEST(test_weight_inverse_variance);
+    RUN_TEST(test_weight_sigma_floor);
+    RUN_TEST(test_weight_ambient_penalty);
+    RUN_TEST(test_weighted_mean_equal_weights);
+    RUN_TEST(test_weighted_mean_favors_confident_zone);
+    RUN_TEST(test_weighted_mean_zero_weights);
+    RUN_TEST(test_weighted_consensus_reduces_variance);
+    UNITY_END();
+}
+
+void loop() {}
+#endif
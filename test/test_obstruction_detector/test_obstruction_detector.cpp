@@ -0,0 +1,241 @@
+/**
+ * @file test_obstruction_detector.cpp
+ * @brief Unit tests for the obstruction detector used while lowering
+ *
+ * Feeds near-zone masks the way HeightController::checkObstruction()
+ * builds them (bit n = zone n much shorter than the floor) to the 4x4
+ * and 8x8 detectors. Zone n is row n / N, column n % N.
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#include <chrono>
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cstdio>
+#include "utils/ObstructionDetector.h"
+
+typedef FixedObstructionDetector<4> Detector4;
+typedef FixedObstructionDetector<8> Detector8;
+
+// ============================================
+// Helpers
+// ============================================
+
+template <uint8_t N>
+static uint64_t zoneBit(uint8_t row, uint8_t col) {
+    return 1ULL << (row * N + col);
+}
+
+// ============================================
+// Tests
+// ============================================
+
+/**
+ * @test Nothing is reported before arm() or after disarm()
+ */
+void test_disarmed_never_trips(void) {
+    Detector4 detector(2);
+    TEST_ASSERT_FALSE(detector.isArmed());
+    TEST_ASSERT_FALSE(detector.update(0));
+    TEST_ASSERT_FALSE(detector.update(0xFFFF));
+
+    detector.arm();
+    TEST_ASSERT_FALSE(detector.update(0));
+    detector.disarm();
+    TEST_ASSERT_FALSE(detector.update(0xFFFF));
+    TEST_ASSERT_FALSE(detector.isTripped());
+}
+
+/**
+ * @test Zones already short in the first frame after arm() are the scene
+ */
+void test_reference_frame_is_ignored(void) {
+    Detector4 detector(2);
+    uint64_t chairLegs = zoneBit<4>(0, 0) | zoneBit<4>(0, 1) | zoneBit<4>(1, 0);
+    detector.arm();
+    TEST_ASSERT_FALSE(detector.update(chairLegs));
+    for (int frame = 0; frame < 20; frame++) {
+        TEST_ASSERT_FALSE(detector.update(chairLegs));
+    }
+    // A chair leg dropping out and coming back is not new either
+    TEST_ASSERT_FALSE(detector.update(zoneBit<4>(0, 0)));
+    TEST_ASSERT_FALSE(detector.update(chairLegs));
+    TEST_ASSERT_FALSE(detector.isTripped());
+}
+
+/**
+ * @test Two adjacent new zones trip on the frame they appear
+ */
+void test_new_cluster_trips_at_once(void) {
+    Detector4 detector(2);
+    detector.arm();
+    TEST_ASSERT_FALSE(detector.update(0));
+    TEST_ASSERT_FALSE(detector.update(0));
+
+    uint64_t box = zoneBit<4>(2, 1) | zoneBit<4>(2, 2);
+    TEST_ASSERT_TRUE(detector.update(box));
+    TEST_ASSERT_TRUE(detector.isTripped());
+    TEST_ASSERT_TRUE(detector.getZones() == box);
+    TEST_ASSERT_EQUAL_UINT8(2, detector.getNewZoneCount());
+}
+
+/**
+ * @test Single new zones, even several of them, are noise
+ */
+void test_isolated_zones_do_not_trip(void) {
+    Detector4 detector(2);
+    detector.arm();
+    TEST_ASSERT_FALSE(detector.update(0));
+
+    TEST_ASSERT_FALSE(detector.update(zoneBit<4>(1, 1)));
+    // Diagonal neighbours are not adjacent
+    TEST_ASSERT_FALSE(detector.update(zoneBit<4>(1, 1) | zoneBit<4>(2, 2) | zoneBit<4>(0, 3)));
+    // Row wrap-around: end of row 0 and start of row 1 are not neighbours
+    TEST_ASSERT_FALSE(detector.update(zoneBit<4>(0, 3) | zoneBit<4>(1, 0)));
+    TEST_ASSERT_FALSE(detector.isTripped());
+}
+
+/**
+ * @test An object in the reference trips once its cluster grows by minZones
+ */
+void test_growing_cluster_trips(void) {
+    Detector4 detector(2);
+    uint64_t object = zoneBit<4>(1, 1);
+    detector.arm();
+    TEST_ASSERT_FALSE(detector.update(object));
+
+    // Grows by one zone: not yet
+    object |= zoneBit<4>(1, 2);
+    TEST_ASSERT_FALSE(detector.update(object));
+
+    // Two new zones, joined to each other only through the old one
+    object |= zoneBit<4>(0, 1) | zoneBit<4>(2, 2);
+    TEST_ASSERT_TRUE(detector.update(object));
+    TEST_ASSERT_EQUAL_UINT8(3, detector.getNewZoneCount());
+    TEST_ASSERT_EQUAL_UINT8(4, Detector4::countZones(detector.getZones()));
+}
+
+/**
+ * @test Once tripped the detection holds until re-armed, which takes a new reference
+ */
+void test_latched_until_rearmed(void) {
+    Detector4 detector(2);
+    uint64_t box = zoneBit<4>(3, 0) | zoneBit<4>(3, 1);
+    detector.arm();
+    detector.update(0);
+    TEST_ASSERT_TRUE(detector.update(box));
+    TEST_ASSERT_FALSE(detector.update(0));
+    TEST_ASSERT_TRUE(detector.isTripped());
+
+    // Re-armed with the box still there: it is part of the new scene
+    detector.arm();
+    TEST_ASSERT_FALSE(detector.isTripped());
+    TEST_ASSERT_FALSE(detector.update(box));
+    TEST_ASSERT_FALSE(detector.update(box));
+    TEST_ASSERT_FALSE(detector.isTripped());
+}
+
+/**
+ * @test 8x8: whole grid, last row/column edges and the 64-bit top zone
+ */
+void test_grid_8x8(void) {
+    Detector8 detector(4);
+    detector.arm();
+    detector.update(0);
+
+    // 2x2 block in the bottom-right corner (includes zone 63)
+    uint64_t corner = zoneBit<8>(6, 6) | zoneBit<8>(6, 7) | zoneBit<8>(7, 6) | zoneBit<8>(7, 7);
+    TEST_ASSERT_FALSE(detector.update(corner & ~zoneBit<8>(7, 7)));
+    TEST_ASSERT_TRUE(detector.update(corner));
+    TEST_ASSERT_EQUAL_UINT8(4, detector.getNewZoneCount());
+
+    // Object filling the view
+    detector.arm();
+    detector.update(0);
+    TEST_ASSERT_TRUE(detector.update(~0ULL));
+    TEST_ASSERT_EQUAL_UINT8(64, Detector8::countZones(detector.getZones()));
+
+    // Column 7 and column 0 of the next row do not join
+    detector.arm();
+    detector.update(0);
+    TEST_ASSERT_FALSE(detector.update(zoneBit<8>(2, 6) | zoneBit<8>(2, 7) |
+                                      zoneBit<8>(3, 0) | zoneBit<8>(3, 1)));
+}
+
+/**
+ * @test Worst-case frame (many separate new zones) costs little per frame
+ */
+void test_benchmark_8x8(void) {
+#ifdef NATIVE_TEST
+    // Checkerboard: 32 isolated new zones, one flood fill each
+    uint64_t checker = 0;
+    for (uint8_t zone = 0; zone < 64; zone++) {
+        if (((zone / 8) + (zone % 8)) % 2 == 0) {
+            checker |= 1ULL << zone;
+        }
+    }
+    const int FRAMES = 20000;
+    Detector8 detector(4);
+    detector.arm();
+    detector.update(0);
+    volatile bool tripped = false;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FRAMES; i++) {
+        tripped = detector.update(checker);
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    TEST_ASSERT_FALSE(tripped);
+
+    char message[96];
+    snprintf(message, sizeof(message), "8x8 checkerboard frame: %.2f us", us / FRAMES);
+    TEST_MESSAGE(message);
+#endif
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_disarmed_never_trips);
+    RUN_TEST(test_reference_frame_is_ignored);
+    RUN_TEST(test_new_cluster_trips_at_once);
+    RUN_TEST(test_isolated_zones_do_not_trip);
+    RUN_TEST(test_growing_cluster_trips);
+    RUN_TEST(test_latched_until_rearmed);
+    RUN_TEST(test_grid_8x8);
+    RUN_TEST(test_benchmark_8x8);
+
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    UNITY_BEGIN();
+
+    RUN_TEST(test_disarmed_never_trips);
+    RUN_TEST(test_reference_frame_is_ignored);
+    RUN_TEST(test_new_cluster_trips_at_once);
+    RUN_TEST(test_isolated_zones_do_not_trip);
+    RUN_TEST(test_growing_cluster_trips);
+    RUN_TEST(test_latched_until_rearmed);
+    RUN_TEST(test_grid_8x8);
+    RUN_TEST(test_benchmark_8x8);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
+#endif
@@ -0,0 +1,358 @@
+/**
+ * @file test_outlier_threshold.cpp
+ * @brief Adaptive (MAD) outlier threshold tests and replay benchmark
+ *
+ * Uses ZoneConsensus.h directly for the threshold arithmetic, and
+ * TraceReplay.h to run the same encoded trace through the consensus with
+ * the fixed and the adaptive rule and compare what each one rejects.
+ *
+ * Native only: set DESK_TRACE=/path/to/trace.bin (downloaded from
+ * GET /trace) to also compare both rules on a recorded trace.
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#include <cstdlib>
+#include <vector>
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include "utils/ZoneConsensus.h"
+#include "utils/FrameTrace.h"
+#include "utils/TraceReplay.h"
+
+static const uint8_t ZONES = 16;
+static const uint32_t FRAMES = 400;
+
+static ZoneConsensus::OutlierRule adaptiveRule() {
+    ZoneConsensus::OutlierRule rule = {true, DEFAULT_OUTLIER_MIN_MM, DEFAULT_OUTLIER_MAX_MM};
+    return rule;
+}
+
+// ============================================
+// Synthetic sessions
+// ============================================
+
+static uint32_t rngState = 1;
+
+static float uniform() {
+    rngState = rngState * 1103515245u + 12345u;
+    return ((rngState >> 8) & 0xFFFF) / 65536.0f;
+}
+
+static float gaussian() {
+    float u1 = uniform();
+    float u2 = uniform();
+    if (u1 < 1e-6f) u1 = 1e-6f;
+    return sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
+
+/**
+ * @struct Scenario
+ * @brief Floor at distance_mm with per-zone noise, dropouts and obstructions
+ */
+struct Scenario {
+    const char* name;
+    uint16_t distance_mm;
+    float noise_mm;
+    uint8_t dropout_percent;
+    uint16_t obstacle_mask;        ///< Zones covered by the obstruction
+    int16_t obstacle_height_mm;    ///< How far it stands proud of the floor
+};
+
+/**
+ * @brief Encode FRAMES frames of a scenario at 15 Hz
+ */
+static size_t encodeScenario(const Scenario& s, uint8_t* out) {
+    FrameTraceEncoder encoder;
+    encoder.reset(ZONES, 0);
+    size_t len = encoder.encodeHeader(out);
+
+    TraceFrame frame;
+    rngState = 1;
+    for (uint32_t i = 0; i < FRAMES; i++) {
+        frame.timestamp_us = i * 66667u;
+        frame.frame_counter = i + 1;
+        for (uint8_t zone = 0; zone < ZONES; zone++) {
+            float d = s.distance_mm + gaussian() * s.noise_mm;
+            if (s.obstacle_mask & (1u << zone)) {
+                d -= s.obstacle_height_mm;
+            }
+            frame.status[zone] = 5;
+            frame.distance_mm[zone] = static_cast<int16_t>(lroundf(d));
+            if (uniform() * 100.0f < s.dropout_percent) {
+                frame.status[zone] = 255;
+                frame.distance_mm[zone] = 0;
+            }
+        }
+        len += encoder.encode(frame, out + len);
+        encoder.accept(frame);
+    }
+    return len;
+}
+
+/**
+ * @struct RejectionStats
+ * @brief What one rule did over a replay
+ */
+struct RejectionStats {
+    uint32_t frames;
+    uint32_t unreliable;       ///< Frames the consensus gave up on
+    uint32_t weak;             ///< Reliable frames resting on fewer than zones/4 inliers
+    uint32_t valid_zones;
+    uint32_t outliers;
+    double abs_error_mm;       ///< Summed |consensus - floor| over reliable frames
+    uint32_t threshold_sum;
+};
+
+static RejectionStats replayWith(const uint8_t* data, size_t len,
+                                 const ZoneConsensus::OutlierRule& rule, uint16_t floor_mm) {
+    RejectionStats stats = {0, 0, 0, 0, 0, 0.0, 0};
+    TraceReplay replay(data, len);
+    replay.setOutlierRule(rule);
+    ReplayStep step;
+    while (replay.next(step)) {
+        stats.frames++;
+        if (!step.consensus.is_reliable) {
+            stats.unreliable++;
+            continue;
+        }
+        uint8_t kept = step.consensus.valid_zone_count - step.consensus.outlier_count;
+        if (kept < replay.getZones() / 4) {
+            stats.weak++;
+        }
+        stats.valid_zones += step.consensus.valid_zone_count;
+        stats.outliers += step.consensus.outlier_count;
+        stats.threshold_sum += step.consensus.outlier_threshold_mm;
+        if (floor_mm > 0) {
+            stats.abs_error_mm += fabs(static_cast<double>(step.consensus.consensus_distance_mm) - floor_mm);
+        }
+    }
+    return stats;
+}
+
+static void printStats(const char* name, const char* rule, const RejectionStats& s) {
+    uint32_t reliable = s.frames - s.unreliable;
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "%-24s %-8s zones rejected %5.2f%%, outliers/frame %.2f, unreliable %lu, weak %lu, "
+             "mean threshold %4.1f mm, mean |error| %.2f mm",
+             name, rule,
+             s.valid_zones ? 100.0 * s.outliers / s.valid_zones : 0.0,
+             reliable ? (double)s.outliers / reliable : 0.0,
+             (unsigned long)s.unreliable, (unsigned long)s.weak,
+             reliable ? (double)s.threshold_sum / reliable : 0.0,
+             reliable ? s.abs_error_mm / reliable : 0.0);
+    TEST_MESSAGE(msg);
+}
+
+static uint8_t traceBuf[FRAME_TRACE_HEADER_BYTES + FRAMES * FRAME_TRACE_MAX_FRAME_BYTES];
+
+static void compareRules(const Scenario& s, RejectionStats& fixedOut, RejectionStats& adaptiveOut) {
+    size_t len = encodeScenario(s, traceBuf);
+    fixedOut = replayWith(traceBuf, len, ZoneConsensus::fixedOutlierRule(), s.distance_mm);
+    adaptiveOut = replayWith(traceBuf, len, adaptiveRule(), s.distance_mm);
+    printStats(s.name, "fixed", fixedOut);
+    printStats(s.name, "adaptive", adaptiveOut);
+}
+
+void setUp(void) {
+    rngState = 1;
+}
+
+void tearDown(void) {}
+
+// ============================================
+// Threshold arithmetic
+// ============================================
+
+/**
+ * @test MAD is the lower median of absolute deviations
+ */
+void test_median_abs_deviation(void) {
+    const uint16_t values[] = {800, 802, 798, 805, 795, 900};
+    TEST_ASSERT_EQUAL_UINT16(2, ZoneConsensus::medianAbsDeviation(values, 6, 800));
+
+    const uint16_t flat[] = {700, 700, 700, 700};
+    TEST_ASSERT_EQUAL_UINT16(0, ZoneConsensus::medianAbsDeviation(flat, 4, 700));
+    TEST_ASSERT_EQUAL_UINT16(0, ZoneConsensus::medianAbsDeviation(flat, 0, 700));
+}
+
+/**
+ * @test Adaptive threshold scales with spread and is clamped to its bounds
+ */
+void test_threshold_scaled_and_clamped(void) {
+    ZoneConsensus::OutlierRule rule = {true, 15, 60};
+
+    // Quiet frame: 3.5 x 1.4826 x 1 = 5.2 mm -> lower bound
+    const uint16_t quiet[] = {800, 801, 799, 800, 801, 799, 800, 800};
+    TEST_ASSERT_EQUAL_UINT16(15, ZoneConsensus::outlierThreshold(quiet, 8, 800, rule));
+
+    // Noisy frame: MAD 8 -> 3.5 x 1.4826 x 8 = 41.5 mm
+    const uint16_t noisy[] = {1200, 1208, 1192, 1210, 1190, 1216, 1184, 1200};
+    TEST_ASSERT_EQUAL_UINT16(8, ZoneConsensus::medianAbsDeviation(noisy, 8, 1200));
+    TEST_ASSERT_EQUAL_UINT16(42, ZoneConsensus::outlierThreshold(noisy, 8, 1200, rule));
+
+    // Very noisy frame -> upper bound
+    const uint16_t wild[] = {1200, 1240, 1160, 1250, 1150, 1260, 1140, 1200};
+    TEST_ASSERT_EQUAL_UINT16(60, ZoneConsensus::outlierThreshold(wild, 8, 1200, rule));
+
+    // Inverted bounds collapse to the lower one
+    ZoneConsensus::OutlierRule inverted = {true, 40, 20};
+    TEST_ASSERT_EQUAL_UINT16(40, ZoneConsensus::outlierThreshold(quiet, 8, 800, inverted));
+
+    // Fixed rule ignores the spread
+    TEST_ASSERT_EQUAL_UINT16(MULTI_ZONE_OUTLIER_THRESHOLD_MM,
+                             ZoneConsensus::outlierThreshold(wild, 8, 1200,
+                                                             ZoneConsensus::fixedOutlierRule()));
+}
+
+/**
+ * @test An obstruction covering 6 of 16 zones does not inflate the threshold
+ */
+void test_threshold_robust_to_obstruction(void) {
+    uint16_t values[16];
+    for (uint8_t i = 0; i < 16; i++) {
+        values[i] = (i < 6) ? 450 : static_cast<uint16_t>(900 + (i % 3) - 1);
+    }
+    ConsensusResult result = ZoneConsensus::combine(values, nullptr, nullptr, 16,
+                                                    MULTI_ZONE_MIN_VALID_ZONES, nullptr,
+                                                    adaptiveRule());
+    TEST_ASSERT_TRUE(result.is_reliable);
+    TEST_ASSERT_EQUAL_UINT16(DEFAULT_OUTLIER_MIN_MM, result.outlier_threshold_mm);
+    TEST_ASSERT_EQUAL_UINT8(6, result.outlier_count);
+    TEST_ASSERT_UINT16_WITHIN(1, 900, result.consensus_distance_mm);
+}
+
+/**
+ * @test Default combine() keeps the fixed threshold and reports it
+ */
+void test_default_rule_is_fixed(void) {
+    const uint16_t values[] = {800, 829, 831, 771, 769, 800};
+    ConsensusResult result = ZoneConsensus::combine(values, nullptr, nullptr, 6, 4);
+    TEST_ASSERT_EQUAL_UINT16(MULTI_ZONE_OUTLIER_THRESHOLD_MM, result.outlier_threshold_mm);
+    TEST_ASSERT_EQUAL_UINT8(2, result.outlier_count);
+
+    // Too few zones: no median, no threshold
+    ConsensusResult few = ZoneConsensus::combine(values, nullptr, nullptr, 2, 4);
+    TEST_ASSERT_FALSE(few.is_reliable);
+    TEST_ASSERT_EQUAL_UINT16(0, few.outlier_threshold_mm);
+}
+
+// ============================================
+// Replay benchmark
+// ============================================
+
+/**
+ * @test Short range, quiet: a 20 mm cable passes the fixed threshold, not the adaptive one
+ */
+void test_replay_short_range_cable(void) {
+    const Scenario s = {"short range, cable", 350, 1.5f, 0, (1u << 12) | (1u << 13), 20};
+    RejectionStats fixedStats, adaptiveStats;
+    compareRules(s, fixedStats, adaptiveStats);
+
+    TEST_ASSERT_TRUE(fixedStats.outliers < FRAMES / 10);
+    TEST_ASSERT_TRUE(adaptiveStats.outliers >= 2 * FRAMES * 95 / 100);
+    TEST_ASSERT_TRUE(adaptiveStats.abs_error_mm < fixedStats.abs_error_mm / 2);
+}
+
+/**
+ * @test Long range in sunlight: the fixed threshold throws away genuine floor zones
+ */
+void test_replay_long_range_sunlit(void) {
+    const Scenario s = {"long range, sunlit", 1200, 14.0f, 40, 0, 0};
+    RejectionStats fixedStats, adaptiveStats;
+    compareRules(s, fixedStats, adaptiveStats);
+
+    TEST_ASSERT_TRUE(adaptiveStats.outliers * 10 < fixedStats.outliers * 7);
+    TEST_ASSERT_TRUE(adaptiveStats.weak <= fixedStats.weak);
+    TEST_ASSERT_TRUE(adaptiveStats.unreliable <= fixedStats.unreliable);
+}
+
+/**
+ * @test Chair legs far off the floor are rejected by both rules
+ */
+void test_replay_chair_legs(void) {
+    const Scenario s = {"mid range, chair legs", 900, 4.0f, 5, 0x000F, 400};
+    RejectionStats fixedStats, adaptiveStats;
+    compareRules(s, fixedStats, adaptiveStats);
+
+    TEST_ASSERT_TRUE(adaptiveStats.abs_error_mm <= fixedStats.abs_error_mm + 0.5 * FRAMES);
+    TEST_ASSERT_EQUAL_UINT32(fixedStats.unreliable, adaptiveStats.unreliable);
+}
+
+#ifdef NATIVE_TEST
+
+static bool readFile(const char* path, std::vector<uint8_t>& data) {
+    FILE* f = fopen(path, "rb");
+    if (f == nullptr) {
+        return false;
+    }
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(f);
+    return true;
+}
+
+/**
+ * @test Compare both rules on a recorded trace given in DESK_TRACE (skipped when unset)
+ */
+void test_replay_recorded_trace(void) {
+    const char* path = getenv("DESK_TRACE");
+    if (path == nullptr) {
+        TEST_IGNORE_MESSAGE("DESK_TRACE not set");
+        return;
+    }
+
+    std::vector<uint8_t> data;
+    TEST_ASSERT_TRUE_MESSAGE(readFile(path, data), "Cannot read DESK_TRACE");
+    RejectionStats fixedStats = replayWith(data.data(), data.size(),
+                                           ZoneConsensus::fixedOutlierRule(), 0);
+    RejectionStats adaptiveStats = replayWith(data.data(), data.size(), adaptiveRule(), 0);
+    printStats(path, "fixed", fixedStats);
+    printStats(path, "adaptive", adaptiveStats);
+    TEST_ASSERT_TRUE(fixedStats.frames > 0);
+}
+
+#endif
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_median_abs_deviation);
+    RUN_TEST(test_threshold_scaled_and_clamped);
+    RUN_TEST(test_threshold_robust_to_obstruction);
+    RUN_TEST(test_default_rule_is_fixed);
+    RUN_TEST(test_replay_short_range_cable);
+    RUN_TEST(test_replay_long_range_sunlit);
+    RUN_TEST(test_replay_chair_legs);
+    RUN_TEST(test_replay_recorded_trace);
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);
+    UNITY_BEGIN();
+    RUN_TEST(test_median_abs_deviation);
+    RUN_TEST(test_threshold_scaled_and_clamped);
+    RUN_TEST(test_threshold_robust_to_obstruction);
+    RUN_TEST(test_default_rule_is_fixed);
+    RUN_TEST(test_replay_short_range_cable);
+    RUN_TEST(test_replay_long_range_sunlit);
+    RUN_TEST(test_replay_chair_legs);
+    UNITY_END();
+}
+
+void loop() {}
+#endif
@@ -0,0 +1,166 @@
+/**
+ * @file test_period_jitter.cpp
+ * @brief Unit tests for the control period statistics served by GET /control
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include "utils/PeriodJitter.h"
+
+static const uint32_t NOMINAL_US = 1000;
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================
+// Tests
+// ============================================
+
+/**
+ * @test Nothing is reported before the second wake-up
+ */
+void test_first_wake_starts_period(void) {
+    PeriodJitter jitter(NOMINAL_US);
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.getCount());
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.getP99JitterUs());
+
+    jitter.record(5000);
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.getCount());
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.getAvgPeriodUs());
+    TEST_ASSERT_EQUAL_UINT32(NOMINAL_US, jitter.getNominalUs());
+}
+
+/**
+ * @test An exact schedule has no jitter
+ */
+void test_exact_schedule(void) {
+    PeriodJitter jitter(NOMINAL_US);
+    for (uint32_t i = 0; i <= 100; i++) {
+        jitter.record(i * NOMINAL_US);
+    }
+    TEST_ASSERT_EQUAL_UINT32(100, jitter.getCount());
+    TEST_ASSERT_EQUAL_UINT32(NOMINAL_US, jitter.getMinPeriodUs());
+    TEST_ASSERT_EQUAL_UINT32(NOMINAL_US, jitter.getAvgPeriodUs());
+    TEST_ASSERT_EQUAL_UINT32(NOMINAL_US, jitter.getMaxPeriodUs());
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.getMaxJitterUs());
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.getP99JitterUs());
+}
+
+/**
+ * @test Early and late wake-ups both count as jitter
+ */
+void test_early_and_late(void) {
+    PeriodJitter jitter(NOMINAL_US);
+    jitter.record(0);
+    jitter.record(1300);    // 300 us late
+    jitter.record(2000);    // 700 us period: 300 us early
+    jitter.record(3000);
+    TEST_ASSERT_EQUAL_UINT32(3, jitter.getCount());
+    TEST_ASSERT_EQUAL_UINT32(700, jitter.getMinPeriodUs());
+    TEST_ASSERT_EQUAL_UINT32(1300, jitter.getMaxPeriodUs());
+    TEST_ASSERT_EQUAL_UINT32(1000, jitter.getAvgPeriodUs());
+    TEST_ASSERT_EQUAL_UINT32(300, jitter.getMaxJitterUs());
+    TEST_ASSERT_EQUAL_UINT32(200, jitter.getAvgJitterUs());
+}
+
+/**
+ * @test One outlier in a thousand stays out of the p99, ten don't
+ */
+void test_p99(void) {
+    PeriodJitter jitter(NOMINAL_US);
+    uint32_t t = 0;
+    jitter.record(t);
+    for (uint32_t i = 0; i < 1000; i++) {
+        // 120 us jitter (third bin), one 900 us hiccup
+        t += (i == 500) ? NOMINAL_US + 900 : NOMINAL_US + 120;
+        jitter.record(t);
+    }
+    TEST_ASSERT_EQUAL_UINT32(150, jitter.getP99JitterUs());
+    TEST_ASSERT_EQUAL_UINT32(900, jitter.getMaxJitterUs());
+
+    for (uint32_t i = 0; i < 10; i++) {
+        t += NOMINAL_US + 900;
+        jitter.record(t);
+    }
+    TEST_ASSERT_EQUAL_UINT32(900, jitter.getP99JitterUs());
+}
+
+/**
+ * @test Jitter past the histogram range reports the maximum
+ */
+void test_open_last_bin(void) {
+    PeriodJitter jitter(NOMINAL_US);
+    jitter.record(0);
+    jitter.record(NOMINAL_US + 5000);
+    TEST_ASSERT_EQUAL_UINT32(5000, jitter.getP99JitterUs());
+    TEST_ASSERT_EQUAL_UINT32(5000, jitter.getMaxJitterUs());
+}
+
+/**
+ * @test Wake-up times wrap with micros()
+ */
+void test_micros_wrap(void) {
+    PeriodJitter jitter(NOMINAL_US);
+    jitter.record(0xFFFFFFFFu - 499);
+    jitter.record(500);
+    TEST_ASSERT_EQUAL_UINT32(NOMINAL_US, jitter.getMaxPeriodUs());
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.getMaxJitterUs());
+}
+
+/**
+ * @test Reset drops the samples and the period in progress
+ */
+void test_reset(void) {
+    PeriodJitter jitter(NOMINAL_US);
+    jitter.record(0);
+    jitter.record(3000);
+    jitter.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.getCount());
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.getMaxJitterUs());
+
+    jitter.record(10000);
+    jitter.record(11000);
+    TEST_ASSERT_EQUAL_UINT32(1, jitter.getCount());
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.getMaxJitterUs());
+}
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_first_wake_starts_period);
+    RUN_TEST(test_exact_schedule);
+    RUN_TEST(test_early_and_late);
+    RUN_TEST(test_p99);
+    RUN_TEST(test_open_last_bin);
+    RUN_TEST(test_micros_wrap);
+    RUN_TEST(test_reset);
+
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    UNITY_BEGIN();
+
+    RUN_TEST(test_first_wake_starts_period);
+    RUN_TEST(test_exact_schedule);
+    RUN_TEST(test_early_and_late);
+    RUN_TEST(test_p99);
+    RUN_TEST(test_open_last_bin);
+    RUN_TEST(test_micros_wrap);
+    RUN_TEST(test_reset);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Empty
+}
+#endif
@@ -13,6 +13,7 @@ using namespace fakeit;
 #else
 #include <Arduino.h>
 #endif
+#include "utils/HeightUnits.h"
 
 // Constants matching PresetManager
 const char* NVS_NAMESPACE = "presets";
@@ -34,12 +35,12 @@ void tearDown(void) {
  * Test NVS key format for preset height
  */
 void test_nvs_key_format_height(void) {
-    // Key format should be "h1", "h2", etc. for heights
+    // Key format should be "m1", "m2", etc. for heights (mm)
     char key[4];
     for (int slot = 1; slot <= MAX_PRESETS; slot++) {
-        snprintf(key, sizeof(key), "h%d", slot);
+        snprintf(key, sizeof(key), "m%d", slot);
         TEST_ASSERT_TRUE(strlen(key) == 2);
-        TEST_ASSERT_EQUAL('h', key[0]);
+        TEST_ASSERT_EQUAL('m', key[0]);
         TEST_ASSERT_TRUE(key[1] >= '1' && key[1] <= '5');
     }
 }
@@ -66,14 +67,14 @@ void test_nvs_key_format_name(void) {
  * Test save operation creates correct keys
  */
 void test_save_creates_correct_keys(void) {
-    // Saving slot 3 should create keys "h3" and "n3"
+    // Saving slot 3 should create keys "m3" and "n3"
     uint8_t slot = 3;
     char height_key[4], name_key[4];
     
-    snprintf(height_key, sizeof(height_key), "h%d", slot);
+    snprintf(height_key, sizeof(height_key), "m%d", slot);
     snprintf(name_key, sizeof(name_key), "n%d", slot);
     
-    TEST_ASSERT_EQUAL_STRING("h3", height_key);
+    TEST_ASSERT_EQUAL_STRING("m3", height_key);
     TEST_ASSERT_EQUAL_STRING("n3", name_key);
 }
 
@@ -81,14 +82,14 @@ void test_save_creates_correct_keys(void) {
  * Test load operation uses correct keys
  */
 void test_load_uses_correct_keys(void) {
-    // Loading slot 2 should read keys "h2" and "n2"
+    // Loading slot 2 should read keys "m2" and "n2"
     uint8_t slot = 2;
     char height_key[4], name_key[4];
     
-    snprintf(height_key, sizeof(height_key), "h%d", slot);
+    snprintf(height_key, sizeof(height_key), "m%d", slot);
     snprintf(name_key, sizeof(name_key), "n%d", slot);
     
-    TEST_ASSERT_EQUAL_STRING("h2", height_key);
+    TEST_ASSERT_EQUAL_STRING("m2", height_key);
     TEST_ASSERT_EQUAL_STRING("n2", name_key);
 }
 
@@ -97,10 +98,10 @@ void test_load_uses_correct_keys(void) {
  */
 void test_default_values_when_missing(void) {
     // When NVS key doesn't exist, should return defaults
-    float default_height = 0.0f;
+    uint16_t default_height_mm = 0;
     const char* default_name = "";
     
-    TEST_ASSERT_EQUAL_FLOAT(0.0f, default_height);
+    TEST_ASSERT_EQUAL_UINT16(0, default_height_mm);
     TEST_ASSERT_EQUAL_STRING("", default_name);
 }
 
@@ -109,14 +110,29 @@ void test_default_values_when_missing(void) {
 // ============================================================================
 
 /**
- * Test height stored as float
+ * Test height stored as integer millimeters
  */
-void test_height_stored_as_float(void) {
-    // Height should be stored with 1 decimal precision
-    float height = 75.5f;
+void test_height_stored_as_mm(void) {
+    // 0.1cm API resolution maps exactly onto uint16_t mm
+    uint16_t height_mm = HeightUnits::cmToMm(75.5f);
     
-    // Verify float representation
-    TEST_ASSERT_FLOAT_WITHIN(0.1f, 75.5f, height);
+    TEST_ASSERT_EQUAL_UINT16(755, height_mm);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 75.5f, HeightUnits::mmToCm(height_mm));
+}
+
+/**
+ * Test legacy float cm entries migrate to mm
+ */
+void test_legacy_float_height_migration(void) {
+    // Pre-mm firmware wrote float cm under "h{slot}"
+    char legacy_key[4];
+    snprintf(legacy_key, sizeof(legacy_key), "h%d", 4);
+    TEST_ASSERT_EQUAL_STRING("h4", legacy_key);
+    
+    // Stored float values round to the nearest mm
+    TEST_ASSERT_EQUAL_UINT16(1100, HeightUnits::cmToMm(110.0f));
+    TEST_ASSERT_EQUAL_UINT16(723, HeightUnits::cmToMm(72.3f));
+    TEST_ASSERT_EQUAL_UINT16(0, HeightUnits::cmToMm(0.0f));  // Disabled stays disabled
 }
 
 /**
@@ -134,12 +150,12 @@ void test_name_stored_as_string(void) {
  */
 void test_slots_persisted_independently(void) {
     // Each slot should have its own keys
-    const char* expected_height_keys[] = {"h1", "h2", "h3", "h4", "h5"};
+    const char* expected_height_keys[] = {"m1", "m2", "m3", "m4", "m5"};
     const char* expected_name_keys[] = {"n1", "n2", "n3", "n4", "n5"};
     
     for (int i = 0; i < MAX_PRESETS; i++) {
         char height_key[4], name_key[4];
-        snprintf(height_key, sizeof(height_key), "h%d", i + 1);
+        snprintf(height_key, sizeof(height_key), "m%d", i + 1);
         snprintf(name_key, sizeof(name_key), "n%d", i + 1);
         
         TEST_ASSERT_EQUAL_STRING(expected_height_keys[i], height_key);
@@ -229,7 +245,8 @@ int main(int argc, char **argv) {
     RUN_TEST(test_default_values_when_missing);
     
     // Data type tests
-    RUN_TEST(test_height_stored_as_float);
+    RUN_TEST(test_height_stored_as_mm);
+    RUN_TEST(test_legacy_float_height_migration);
     RUN_TEST(test_name_stored_as_string);
     RUN_TEST(test_slots_persisted_independently);
     
@@ -259,7 +276,8 @@ void setup() {
     RUN_TEST(test_default_values_when_missing);
     
     // Data type tests
-    RUN_TEST(test_height_stored_as_float);
+    RUN_TEST(test_height_stored_as_mm);
+    RUN_TEST(test_legacy_float_height_migration);
     RUN_TEST(test_name_stored_as_string);
     RUN_TEST(test_slots_persisted_independently);
     
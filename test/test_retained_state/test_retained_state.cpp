@@ -0,0 +1,140 @@
+/**
+ * @file test_retained_state.cpp
+ * @brief Unit tests for the RTC memory block used by warm restart
+ *
+ * The block is placed in static storage without a constructor run, as
+ * with RTC_NOINIT_ATTR; its contents are filled with garbage to model a
+ * power-on.
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cstring>
+#include "utils/RetainedState.h"
+
+struct Snapshot {
+    uint16_t height_mm;
+    uint16_t samples[4];
+    uint8_t count;
+};
+
+static RetainedState<Snapshot> retained;
+
+static Snapshot makeSnapshot() {
+    Snapshot snapshot = {};
+    snapshot.height_mm = 742;
+    snapshot.samples[0] = 1010;
+    snapshot.samples[1] = 1012;
+    snapshot.samples[2] = 1008;
+    snapshot.count = 3;
+    return snapshot;
+}
+
+void setUp(void) {
+    // Power-on: RTC memory holds whatever was there
+    memset((void*)&retained, 0xA5, sizeof(retained));
+}
+
+void tearDown(void) {}
+
+// ============================================
+// Tests
+// ============================================
+
+/**
+ * @test Garbage (power-on) is rejected and the output left untouched
+ */
+void test_garbage_rejected(void) {
+    Snapshot out = {};
+    out.height_mm = 1;
+    TEST_ASSERT_FALSE(retained.load(out));
+    TEST_ASSERT_EQUAL_UINT16(1, out.height_mm);
+}
+
+/**
+ * @test A saved snapshot survives (warm reset) byte for byte
+ */
+void test_save_load_round_trip(void) {
+    retained.save(makeSnapshot());
+
+    Snapshot out = {};
+    TEST_ASSERT_TRUE(retained.load(out));
+    TEST_ASSERT_EQUAL_UINT16(742, out.height_mm);
+    TEST_ASSERT_EQUAL_UINT16(1012, out.samples[1]);
+    TEST_ASSERT_EQUAL_UINT8(3, out.count);
+}
+
+/**
+ * @test Later saves replace earlier ones
+ */
+void test_save_overwrites(void) {
+    retained.save(makeSnapshot());
+    Snapshot next = makeSnapshot();
+    next.height_mm = 1100;
+    retained.save(next);
+
+    Snapshot out = {};
+    TEST_ASSERT_TRUE(retained.load(out));
+    TEST_ASSERT_EQUAL_UINT16(1100, out.height_mm);
+}
+
+/**
+ * @test invalidate() drops the snapshot
+ */
+void test_invalidate(void) {
+    retained.save(makeSnapshot());
+    retained.invalidate();
+
+    Snapshot out = {};
+    TEST_ASSERT_FALSE(retained.load(out));
+}
+
+/**
+ * @test Any flipped bit in the block is detected
+ */
+void test_corruption_detected(void) {
+    retained.save(makeSnapshot());
+
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(&retained);
+    Snapshot out;
+    for (size_t i = 0; i < sizeof(retained); i++) {
+        bytes[i] ^= 0x10;
+        TEST_ASSERT_FALSE(retained.load(out));
+        bytes[i] ^= 0x10;
+    }
+    TEST_ASSERT_TRUE(retained.load(out));
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_garbage_rejected);
+    RUN_TEST(test_save_load_round_trip);
+    RUN_TEST(test_save_overwrites);
+    RUN_TEST(test_invalidate);
+    RUN_TEST(test_corruption_detected);
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);
+    UNITY_BEGIN();
+    RUN_TEST(test_garbage_rejected);
+    RUN_TEST(test_save_load_round_trip);
+    RUN_TEST(test_save_overwrites);
+    RUN_TEST(test_invalidate);
+    RUN_TEST(test_corruption_detected);
+    UNITY_END();
+}
+
+void loop() {}
+#endif
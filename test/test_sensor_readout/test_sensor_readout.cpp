@@ -0,0 +1,137 @@
+/**
+ * @file test_sensor_readout.cpp
+ * @brief Unit tests for the per-frame readout size of each readout profile
+ *
+ * Uses SensorReadout.h directly. Profiles are passed explicitly so the
+ * test doesn't depend on the VL53L5CX_DISABLE_* flags of the native build.
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cstdio>
+#include "utils/SensorReadout.h"
+
+using namespace SensorReadout;
+
+// Profiles as configured in platformio.ini
+static const uint16_t LEAN = ALL_FIELDS & ~(NB_SPADS_ENABLED | NB_TARGET_DETECTED |
+                                            REFLECTANCE_PERCENT | MOTION_INDICATOR);
+static const uint16_t MINIMAL = DISTANCE_MM | TARGET_STATUS;
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================
+// Tests
+// ============================================
+
+/**
+ * @test Driver default (every output) matches the ULD data_read_size
+ */
+void test_full_readout_size(void) {
+    TEST_ASSERT_EQUAL_UINT16(532, frameBytes(ALL_FIELDS, 16));
+    TEST_ASSERT_EQUAL_UINT16(1444, frameBytes(ALL_FIELDS, 64));
+}
+
+/**
+ * @test Lean profile keeps only what median and weighted consensus read
+ */
+void test_lean_readout_size(void) {
+    TEST_ASSERT_EQUAL_UINT16(280, frameBytes(LEAN, 16));
+    TEST_ASSERT_EQUAL_UINT16(904, frameBytes(LEAN, 64));
+    TEST_ASSERT_TRUE(hasConfidenceFields(LEAN));
+}
+
+/**
+ * @test Minimal profile reads distance and status only
+ */
+void test_minimal_readout_size(void) {
+    TEST_ASSERT_EQUAL_UINT16(108, frameBytes(MINIMAL, 16));
+    TEST_ASSERT_EQUAL_UINT16(252, frameBytes(MINIMAL, 64));
+    TEST_ASSERT_FALSE(hasConfidenceFields(MINIMAL));
+}
+
+/**
+ * @test Mandatory blocks remain with no optional output
+ */
+void test_fixed_overhead(void) {
+    TEST_ASSERT_EQUAL_UINT16(FIXED_BYTES, frameBytes(0, 16));
+    TEST_ASSERT_EQUAL_UINT16(FIXED_BYTES, frameBytes(0, 64));
+    TEST_ASSERT_EQUAL_UINT16(0, blockBytes(MINIMAL, AMBIENT_PER_SPAD, 64));
+    TEST_ASSERT_EQUAL_UINT16(36, blockBytes(MINIMAL, DISTANCE_MM, 32));
+}
+
+/**
+ * @test Per-target blocks scale with targets per zone, per-zone blocks don't
+ */
+void test_targets_per_zone_scaling(void) {
+    uint16_t one = frameBytes(DISTANCE_MM | AMBIENT_PER_SPAD, 16, 1);
+    uint16_t two = frameBytes(DISTANCE_MM | AMBIENT_PER_SPAD, 16, 2);
+    TEST_ASSERT_EQUAL_UINT16(2 * 16, two - one);
+}
+
+/**
+ * @test Ideal bus time at 400 kHz and the per-frame saving of each profile
+ */
+void test_bus_time(void) {
+    TEST_ASSERT_EQUAL_UINT32(22500, busTimeUs(1000, 400000));
+    TEST_ASSERT_EQUAL_UINT32(9000, busTimeUs(1000, 1000000));
+
+    const uint8_t grids[] = {16, 64};
+    char msg[128];
+    for (uint8_t i = 0; i < 2; i++) {
+        uint32_t full = busTimeUs(frameBytes(ALL_FIELDS, grids[i]), 400000);
+        uint32_t lean = busTimeUs(frameBytes(LEAN, grids[i]), 400000);
+        uint32_t minimal = busTimeUs(frameBytes(MINIMAL, grids[i]), 400000);
+        snprintf(msg, sizeof(msg), "%u zones @400kHz: full %lu us, lean %lu us, minimal %lu us",
+                 grids[i], (unsigned long)full, (unsigned long)lean, (unsigned long)minimal);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_TRUE(lean < full * 2 / 3);
+        TEST_ASSERT_TRUE(minimal < full / 4);
+    }
+}
+
+/**
+ * @test Native build has no DISABLE flags: all outputs enabled
+ */
+void test_enabled_fields_from_flags(void) {
+    TEST_ASSERT_EQUAL_HEX16(ALL_FIELDS, ENABLED_FIELDS);
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_full_readout_size);
+    RUN_TEST(test_lean_readout_size);
+    RUN_TEST(test_minimal_readout_size);
+    RUN_TEST(test_fixed_overhead);
+    RUN_TEST(test_targets_per_zone_scaling);
+    RUN_TEST(test_bus_time);
+    RUN_TEST(test_enabled_fields_from_flags);
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);
+    UNITY_BEGIN();
+    RUN_TEST(test_full_readout_size);
+    RUN_TEST(test_lean_readout_size);
+    RUN_TEST(test_minimal_readout_size);
+    RUN_TEST(test_fixed_overhead);
+    RUN_TEST(test_targets_per_zone_scaling);
+    RUN_TEST(test_bus_time);
+    UNITY_END();
+}
+
+void loop() {}
+#endif
@@ -0,0 +1,271 @@
+/**
+ * @file test_sensor_supervisor.cpp
+ * @brief Unit tests for sensor fault detection and recovery escalation
+ *
+ * Uses SensorSupervisor.h directly with simulated time. The last test
+ * drives a simulated sensor through one glitch per recovery step and
+ * reports the mean time from detection to the first good frame.
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cstdio>
+#include "utils/SensorSupervisor.h"
+
+static const uint32_t IDLE_PERIOD_MS = 1000 / RANGING_FREQUENCY_IDLE_HZ;
+static const uint32_t ACTIVE_PERIOD_MS = 1000 / RANGING_FREQUENCY_ACTIVE_HZ;
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================
+// Tests
+// ============================================
+
+/**
+ * @test Frames on time never trigger recovery
+ */
+void test_healthy_sensor(void) {
+    SensorSupervisor supervisor;
+    for (uint32_t t = 0; t < 10000; t += IDLE_PERIOD_MS) {
+        supervisor.onFrame(t);
+        TEST_ASSERT_EQUAL(SensorRecoveryAction::NONE, supervisor.poll(t + IDLE_PERIOD_MS / 2, IDLE_PERIOD_MS));
+    }
+    TEST_ASSERT_FALSE(supervisor.isRecovering());
+    TEST_ASSERT_EQUAL_UINT32(0, supervisor.getStarvationCount());
+}
+
+/**
+ * @test A frame overdue by more than the margin starts recovery at the first step
+ */
+void test_starvation_detected(void) {
+    SensorSupervisor supervisor;
+    supervisor.onFrame(1000);
+
+    uint32_t limit = 1000 + IDLE_PERIOD_MS + SENSOR_STARVATION_MARGIN_MS;
+    TEST_ASSERT_EQUAL(SensorRecoveryAction::NONE, supervisor.poll(limit, IDLE_PERIOD_MS));
+    TEST_ASSERT_EQUAL(SensorRecoveryAction::BUS_CLEAR, supervisor.poll(limit + 1, IDLE_PERIOD_MS));
+    TEST_ASSERT_TRUE(supervisor.isRecovering());
+    TEST_ASSERT_EQUAL_UINT32(1, supervisor.getStarvationCount());
+    TEST_ASSERT_EQUAL_UINT32(1, supervisor.getActionCount(SensorRecoveryAction::BUS_CLEAR));
+}
+
+/**
+ * @test Consecutive read errors start recovery; an error followed by a good frame doesn't
+ */
+void test_read_errors_detected(void) {
+    SensorSupervisor supervisor;
+    for (uint8_t i = 0; i < SENSOR_MAX_CONSECUTIVE_ERRORS - 1; i++) {
+        supervisor.onReadError();
+    }
+    supervisor.onFrame(10);
+    supervisor.onReadError();
+    TEST_ASSERT_EQUAL(SensorRecoveryAction::NONE, supervisor.poll(20, ACTIVE_PERIOD_MS));
+
+    for (uint8_t i = 1; i < SENSOR_MAX_CONSECUTIVE_ERRORS; i++) {
+        supervisor.onReadError();
+    }
+    TEST_ASSERT_EQUAL(SensorRecoveryAction::BUS_CLEAR, supervisor.poll(30, ACTIVE_PERIOD_MS));
+    TEST_ASSERT_EQUAL_UINT32(1, supervisor.getErrorFaultCount());
+    TEST_ASSERT_EQUAL_UINT32(0, supervisor.getStarvationCount());
+    TEST_ASSERT_EQUAL_UINT32(2 * SENSOR_MAX_CONSECUTIVE_ERRORS - 1, supervisor.getReadErrorCount());
+}
+
+/**
+ * @test Steps escalate after their wait window, not before
+ */
+void test_escalation_order(void) {
+    SensorSupervisor supervisor;
+    uint32_t t = 5000;
+    TEST_ASSERT_EQUAL(SensorRecoveryAction::BUS_CLEAR, supervisor.poll(t, ACTIVE_PERIOD_MS));
+
+    TEST_ASSERT_EQUAL(SensorRecoveryAction::NONE,
+                      supervisor.poll(t + SENSOR_RECOVERY_STEP_WAIT_MS - 1, ACTIVE_PERIOD_MS));
+    t += SENSOR_RECOVERY_STEP_WAIT_MS;
+    TEST_ASSERT_EQUAL(SensorRecoveryAction::WIRE_REINIT, supervisor.poll(t, ACTIVE_PERIOD_MS));
+    t += SENSOR_RECOVERY_STEP_WAIT_MS;
+    TEST_ASSERT_EQUAL(SensorRecoveryAction::SENSOR_RESET, supervisor.poll(t, ACTIVE_PERIOD_MS));
+    TEST_ASSERT_EQUAL(SensorRecoveryAction::SENSOR_RESET, supervisor.getStep());
+
+    TEST_ASSERT_EQUAL(SensorRecoveryAction::NONE,
+                      supervisor.poll(t + SENSOR_RECOVERY_RESET_WAIT_MS - 1, ACTIVE_PERIOD_MS));
+}
+
+/**
+ * @test A sensor that stays dead is reset with doubling backoff up to the cap
+ */
+void test_reset_backoff(void) {
+    SensorSupervisor supervisor;
+    uint32_t t = 5000;
+    supervisor.poll(t, ACTIVE_PERIOD_MS);
+    t += SENSOR_RECOVERY_STEP_WAIT_MS;
+    supervisor.poll(t, ACTIVE_PERIOD_MS);
+    t += SENSOR_RECOVERY_STEP_WAIT_MS;
+    TEST_ASSERT_EQUAL(SensorRecoveryAction::SENSOR_RESET, supervisor.poll(t, ACTIVE_PERIOD_MS));
+
+    uint32_t wait = SENSOR_RECOVERY_RESET_WAIT_MS;
+    for (uint8_t i = 0; i < 8; i++) {
+        t += wait;
+        TEST_ASSERT_EQUAL(SensorRecoveryAction::SENSOR_RESET, supervisor.poll(t, ACTIVE_PERIOD_MS));
+        wait = (wait * 2 > SENSOR_RECOVERY_MAX_BACKOFF_MS) ? SENSOR_RECOVERY_MAX_BACKOFF_MS : wait * 2;
+        TEST_ASSERT_EQUAL(SensorRecoveryAction::NONE, supervisor.poll(t + wait - 1, ACTIVE_PERIOD_MS));
+    }
+    TEST_ASSERT_EQUAL_UINT32(SENSOR_RECOVERY_MAX_BACKOFF_MS, wait);
+    TEST_ASSERT_EQUAL_UINT32(9, supervisor.getActionCount(SensorRecoveryAction::SENSOR_RESET));
+    TEST_ASSERT_EQUAL_UINT32(0, supervisor.getRecoveryCount());
+}
+
+/**
+ * @test The first good frame ends recovery and lands in the histogram
+ */
+void test_recovery_recorded(void) {
+    SensorSupervisor supervisor;
+    supervisor.poll(2000, ACTIVE_PERIOD_MS);
+    supervisor.onFrame(2080);
+
+    TEST_ASSERT_FALSE(supervisor.isRecovering());
+    TEST_ASSERT_EQUAL(SensorRecoveryAction::NONE, supervisor.getStep());
+    TEST_ASSERT_EQUAL_UINT32(1, supervisor.getRecoveryCount());
+    TEST_ASSERT_EQUAL_UINT32(80, supervisor.getLastRecoveryMs());
+    TEST_ASSERT_EQUAL_UINT32(80, supervisor.getMaxRecoveryMs());
+    TEST_ASSERT_EQUAL_UINT32(1, supervisor.getHistogramCount(1));  // 50..100 ms
+
+    // Next fault starts over at the first step
+    TEST_ASSERT_EQUAL(SensorRecoveryAction::BUS_CLEAR, supervisor.poll(5000, ACTIVE_PERIOD_MS));
+}
+
+/**
+ * @test Histogram bins cover every duration; the last one is open-ended
+ */
+void test_histogram_bins(void) {
+    SensorSupervisor supervisor;
+    const uint32_t durations[] = {0, 49, 50, 999, 1000, 4999, 5000, 600000};
+    const uint8_t bins[] = {0, 0, 1, 4, 5, 6, 7, 7};
+    uint32_t t = 1000;
+    for (uint8_t i = 0; i < 8; i++) {
+        t += 1000000;
+        supervisor.poll(t, ACTIVE_PERIOD_MS);
+        t += durations[i];
+        supervisor.onFrame(t);
+    }
+
+    uint32_t expected[SensorSupervisor::HISTOGRAM_BINS] = {0};
+    for (uint8_t i = 0; i < 8; i++) {
+        expected[bins[i]]++;
+    }
+    for (uint8_t bin = 0; bin < SensorSupervisor::HISTOGRAM_BINS; bin++) {
+        TEST_ASSERT_EQUAL_UINT32(expected[bin], supervisor.getHistogramCount(bin));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, SensorSupervisor::getHistogramBoundMs(SensorSupervisor::HISTOGRAM_BINS - 1));
+    TEST_ASSERT_EQUAL_UINT32(600000, supervisor.getMaxRecoveryMs());
+}
+
+/**
+ * @test Restarting ranging (profile switch) resets the starvation clock
+ */
+void test_ranging_start_resets_clock(void) {
+    SensorSupervisor supervisor;
+    supervisor.onFrame(0);
+    supervisor.onRangingStart(900);  // Switched to idle just before a frame was due
+    TEST_ASSERT_EQUAL(SensorRecoveryAction::NONE, supervisor.poll(2000, IDLE_PERIOD_MS));
+    TEST_ASSERT_FALSE(supervisor.isRecovering());
+}
+
+/**
+ * Simulated sensor: silent from the glitch until the step that fixes it
+ * has run, then frames at the active rate. Returns detection-to-frame ms.
+ */
+static uint32_t simulateGlitch(SensorRecoveryAction fixedBy, uint32_t resetUploadMs) {
+    SensorSupervisor supervisor;
+    uint32_t t = 0;
+    supervisor.onFrame(t);
+    bool healthy = false;
+    uint32_t nextFrameMs = 0;
+
+    // Acquisition pass every 10 ms (the task wakes on data-ready or timeout)
+    for (t = 10; t < 60000; t += 10) {
+        if (healthy && t >= nextFrameMs) {
+            supervisor.onFrame(t);
+            return supervisor.getLastRecoveryMs();
+        }
+        SensorRecoveryAction action = supervisor.poll(t, supervisor.isRecovering() ? ACTIVE_PERIOD_MS
+                                                                                   : IDLE_PERIOD_MS);
+        if (action == SensorRecoveryAction::NONE) {
+            continue;
+        }
+        if (action == SensorRecoveryAction::SENSOR_RESET) {
+            t += resetUploadMs;  // begin() blocks the pass
+        }
+        supervisor.onRangingStart(t);
+        if (action == fixedBy) {
+            healthy = true;
+            nextFrameMs = t + ACTIVE_PERIOD_MS;
+        }
+    }
+    return 0xFFFFFFFF;
+}
+
+/**
+ * @test Mean detection-to-first-frame time over one glitch per step is under a second
+ */
+void test_mean_time_to_recover(void) {
+    const SensorRecoveryAction steps[] = {SensorRecoveryAction::BUS_CLEAR,
+                                          SensorRecoveryAction::WIRE_REINIT,
+                                          SensorRecoveryAction::SENSOR_RESET};
+    uint32_t total = 0;
+    char msg[96];
+    for (uint8_t i = 0; i < 3; i++) {
+        uint32_t ms = simulateGlitch(steps[i], 500);  // ~84 KB at 1 MHz
+        snprintf(msg, sizeof(msg), "fixed by %s: %lu ms after detection",
+                 SensorSupervisor::actionName(steps[i]), (unsigned long)ms);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_TRUE(ms < 2000);
+        total += ms;
+    }
+    snprintf(msg, sizeof(msg), "mean time to recover: %lu ms", (unsigned long)(total / 3));
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(total / 3 < 1000);
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_healthy_sensor);
+    RUN_TEST(test_starvation_detected);
+    RUN_TEST(test_read_errors_detected);
+    RUN_TEST(test_escalation_order);
+    RUN_TEST(test_reset_backoff);
+    RUN_TEST(test_recovery_recorded);
+    RUN_TEST(test_histogram_bins);
+    RUN_TEST(test_ranging_start_resets_clock);
+    RUN_TEST(test_mean_time_to_recover);
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);
+    UNITY_BEGIN();
+    RUN_TEST(test_healthy_sensor);
+    RUN_TEST(test_starvation_detected);
+    RUN_TEST(test_read_errors_detected);
+    RUN_TEST(test_escalation_order);
+    RUN_TEST(test_reset_backoff);
+    RUN_TEST(test_recovery_recorded);
+    RUN_TEST(test_histogram_bins);
+    RUN_TEST(test_ranging_start_resets_clock);
+    RUN_TEST(test_mean_time_to_recover);
+    UNITY_END();
+}
+
+void loop() {}
+#endif
@@ -0,0 +1,440 @@
+/**
+ * @file test_trace_replay.cpp
+ * @brief Unit tests for the binary frame trace format and its replay source
+ *
+ * The replay tests write a synthetic desk session (stationary noise, a
+ * move, a zone blocked by an obstruction) to a file, read it back and run
+ * it through ZoneConsensus and the temporal filters.
+ *
+ * Native only: set DESK_TRACE=/path/to/trace.bin (downloaded from
+ * GET /trace) to also replay a recorded trace and print its statistics.
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cstdio>
+#include <cstring>
+#include "utils/FrameTrace.h"
+#include "utils/TraceReplay.h"
+
+static const uint8_t ZONES = 16;
+
+// ============================================
+// Helpers
+// ============================================
+
+static uint32_t rngState = 1;
+
+static uint32_t nextRandom() {
+    rngState = rngState * 1103515245u + 12345u;
+    return (rngState >> 16) & 0x7FFF;
+}
+
+/**
+ * @brief Desk frame: all zones at distance_mm +-2 mm, zone 3 blocked at 300 mm
+ */
+static void makeFrame(TraceFrame& frame, uint32_t index, uint32_t timestampUs,
+                      uint16_t distance_mm) {
+    frame.timestamp_us = timestampUs;
+    frame.frame_counter = index;
+    for (uint8_t zone = 0; zone < ZONES; zone++) {
+        frame.status[zone] = 5;
+        frame.distance_mm[zone] = static_cast<int16_t>(distance_mm + (nextRandom() % 5) - 2);
+    }
+    frame.status[3] = 9;
+    frame.distance_mm[3] = 300;
+    // An occasional dropout in one corner
+    if (nextRandom() % 50 == 0) {
+        frame.status[15] = 255;
+        frame.distance_mm[15] = 0;
+    }
+}
+
+/**
+ * @brief Desk distance at frame i of the synthetic session
+ *
+ * 15 Hz: 10 s at 700 mm, 10 s raising at 30 mm/s, then at 1000 mm.
+ */
+static uint16_t sessionDistance(uint32_t i) {
+    if (i < 150) return 700;
+    if (i < 300) return static_cast<uint16_t>(700 + (i - 150) * 2);
+    return 1000;
+}
+
+/**
+ * @brief Encode frameCount session frames into out
+ */
+static size_t encodeSession(uint8_t* out, size_t capacity, uint32_t frameCount) {
+    FrameTraceEncoder encoder;
+    encoder.reset(ZONES, 0);
+    size_t len = encoder.encodeHeader(out);
+
+    TraceFrame frame;
+    rngState = 1;
+    for (uint32_t i = 0; i < frameCount; i++) {
+        makeFrame(frame, i + 1, 5000000u + i * 66667u, sessionDistance(i));
+        if (len + FRAME_TRACE_MAX_FRAME_BYTES > capacity) {
+            break;
+        }
+        len += encoder.encode(frame, out + len);
+        encoder.accept(frame);
+    }
+    return len;
+}
+
+void setUp(void) {
+    rngState = 1;
+}
+
+void tearDown(void) {}
+
+// ============================================
+// Tests
+// ============================================
+
+/**
+ * @test Varint and zigzag round-trip edge values
+ */
+void test_varint_zigzag_round_trip(void) {
+    const uint32_t values[] = {0, 1, 127, 128, 16383, 16384, 0x0FFFFFFF, 0xFFFFFFFF};
+    uint8_t buf[8];
+    for (uint8_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        size_t n = FrameTrace::putVarint(values[i], buf);
+        uint32_t decoded;
+        TEST_ASSERT_EQUAL(n, FrameTrace::getVarint(buf, n, decoded));
+        TEST_ASSERT_EQUAL_UINT32(values[i], decoded);
+        // One byte short is truncated
+        TEST_ASSERT_EQUAL(0, FrameTrace::getVarint(buf, n - 1, decoded));
+    }
+
+    const int32_t deltas[] = {0, -1, 1, -2, 4000, -4000, 32767, -32768, 65535, -65535};
+    for (uint8_t i = 0; i < sizeof(deltas) / sizeof(deltas[0]); i++) {
+        TEST_ASSERT_EQUAL_INT32(deltas[i], FrameTrace::unzigzag(FrameTrace::zigzag(deltas[i])));
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, FrameTrace::zigzag(-1));
+    TEST_ASSERT_EQUAL_UINT32(2, FrameTrace::zigzag(1));
+}
+
+/**
+ * @test Frames decode exactly, including timestamp wrap and extreme distances
+ */
+void test_encode_decode_round_trip(void) {
+    static uint8_t buf[64 * FRAME_TRACE_MAX_FRAME_BYTES];
+    static TraceFrame frames[64];
+    FrameTraceEncoder encoder;
+    encoder.reset(64, 0x8000000000000001ULL);
+    size_t len = encoder.encodeHeader(buf);
+
+    for (uint8_t f = 0; f < 64; f++) {
+        frames[f].timestamp_us = 0xFFFF0000u + f * 66667u;   // Wraps
+        frames[f].frame_counter = 1000 + f * (f % 3 + 1);
+        for (uint8_t zone = 0; zone < 64; zone++) {
+            frames[f].status[zone] = static_cast<uint8_t>(nextRandom() % 4 == 0 ? nextRandom() : 5);
+            frames[f].distance_mm[zone] = static_cast<int16_t>(nextRandom() * 2 - 32768);
+        }
+        frames[f].distance_mm[0] = (f % 2) ? 32767 : -32768;
+        len += encoder.encode(frames[f], buf + len);
+        encoder.accept(frames[f]);
+    }
+
+    FrameTraceReader reader(buf, len);
+    TEST_ASSERT_TRUE(reader.isValid());
+    TEST_ASSERT_EQUAL_UINT8(64, reader.getZones());
+    TEST_ASSERT_TRUE(reader.getZoneMask() == 0x8000000000000001ULL);
+
+    TraceFrame decoded;
+    for (uint8_t f = 0; f < 64; f++) {
+        TEST_ASSERT_TRUE(reader.next(decoded));
+        TEST_ASSERT_EQUAL_UINT32(frames[f].timestamp_us, decoded.timestamp_us);
+        TEST_ASSERT_EQUAL_UINT32(frames[f].frame_counter, decoded.frame_counter);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(frames[f].status, decoded.status, 64);
+        TEST_ASSERT_EQUAL_INT16_ARRAY(frames[f].distance_mm, decoded.distance_mm, 64);
+    }
+    TEST_ASSERT_FALSE(reader.next(decoded));
+    TEST_ASSERT_FALSE(reader.isTruncated());
+}
+
+/**
+ * @test A stationary 4x4 desk costs well under half the raw frame size
+ */
+void test_stationary_frames_are_compact(void) {
+    static uint8_t buf[32768];
+    const uint32_t frames = 500;
+    FrameTraceEncoder encoder;
+    encoder.reset(ZONES, 0);
+    size_t len = 0;
+    TraceFrame frame;
+    for (uint32_t i = 0; i < frames; i++) {
+        makeFrame(frame, i + 1, i * 66667u, 720);
+        len += encoder.encode(frame, buf + len);
+        encoder.accept(frame);
+    }
+
+    const size_t rawFrameBytes = 4 + 4 + ZONES * (1 + 2);
+    double perFrame = static_cast<double>(len) / frames;
+    printf("Stationary 4x4: %.1f bytes/frame (raw %u)\n", perFrame, (unsigned)rawFrameBytes);
+    TEST_ASSERT_TRUE(perFrame < rawFrameBytes / 2.0);
+}
+
+/**
+ * @test A frame encoded but not accepted (dropped) does not corrupt later frames
+ */
+void test_dropped_frame_keeps_chain(void) {
+    uint8_t buf[4 * FRAME_TRACE_MAX_FRAME_BYTES];
+    uint8_t scratch[FRAME_TRACE_MAX_FRAME_BYTES];
+    FrameTraceEncoder encoder;
+    encoder.reset(ZONES, 0);
+    size_t len = encoder.encodeHeader(buf);
+
+    TraceFrame f1, f2, f3;
+    makeFrame(f1, 1, 100000, 700);
+    makeFrame(f2, 2, 166667, 900);
+    makeFrame(f3, 3, 233334, 710);
+    len += encoder.encode(f1, buf + len);
+    encoder.accept(f1);
+    encoder.encode(f2, scratch);               // Buffer full: never stored
+    len += encoder.encode(f3, buf + len);
+    encoder.accept(f3);
+
+    TraceReplay replay(buf, len);
+    ReplayStep step;
+    TEST_ASSERT_TRUE(replay.next(step));
+    TEST_ASSERT_TRUE(replay.next(step));
+    TEST_ASSERT_EQUAL_UINT32(3, step.frame.frame_counter);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(f3.distance_mm, step.frame.distance_mm, ZONES);
+    TEST_ASSERT_EQUAL_UINT32(1, step.missed_frames);
+    TEST_ASSERT_EQUAL_UINT32(1, replay.getMissedCount());
+    TEST_ASSERT_FALSE(replay.next(step));
+}
+
+/**
+ * @test A trace cut mid-frame yields every complete frame, then reports truncation
+ */
+void test_truncated_trace(void) {
+    static uint8_t buf[16384];
+    size_t len = encodeSession(buf, sizeof(buf), 20);
+
+    FrameTraceReader reader(buf, len - 3);
+    TraceFrame frame;
+    uint32_t frames = 0;
+    while (reader.next(frame)) {
+        frames++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(19, frames);
+    TEST_ASSERT_TRUE(reader.isTruncated());
+}
+
+/**
+ * @test Unknown magic, version or zone count is rejected
+ */
+void test_bad_header_rejected(void) {
+    uint8_t buf[FRAME_TRACE_HEADER_BYTES];
+    FrameTraceEncoder encoder;
+    encoder.reset(ZONES, 0);
+    encoder.encodeHeader(buf);
+    TEST_ASSERT_TRUE(FrameTraceReader(buf, sizeof(buf)).isValid());
+
+    TEST_ASSERT_FALSE(FrameTraceReader(buf, sizeof(buf) - 1).isValid());
+    buf[4] = FRAME_TRACE_VERSION + 1;
+    TEST_ASSERT_FALSE(FrameTraceReader(buf, sizeof(buf)).isValid());
+    buf[4] = FRAME_TRACE_VERSION;
+    buf[5] = 32;
+    TEST_ASSERT_FALSE(FrameTraceReader(buf, sizeof(buf)).isValid());
+    buf[5] = ZONES;
+    buf[0] = 'X';
+    TEST_ASSERT_FALSE(FrameTraceReader(buf, sizeof(buf)).isValid());
+
+    TraceFrame frame;
+    TEST_ASSERT_FALSE(FrameTraceReader(buf, sizeof(buf)).next(frame));
+}
+
+/**
+ * @test Replay runs consensus (obstruction zone rejected) and both temporal filters
+ */
+void test_replay_filters_session(void) {
+    static uint8_t buf[32768];
+    size_t len = encodeSession(buf, sizeof(buf), 450);
+
+    TraceReplay replay(buf, len);
+    TEST_ASSERT_TRUE(replay.isValid());
+    ReplayStep step;
+    int16_t rampVelocity = 0;
+    while (replay.next(step)) {
+        TEST_ASSERT_TRUE(step.consensus.is_reliable);
+        TEST_ASSERT_TRUE(step.consensus.outlier_count >= 1);   // Zone 3 at 300 mm
+        if (step.frame.frame_counter == 280) {
+            rampVelocity = step.velocity_mm_s;
+        }
+        if (step.frame.frame_counter == 150) {
+            TEST_ASSERT_UINT16_WITHIN(3, 700, step.average_mm);
+            TEST_ASSERT_UINT16_WITHIN(3, 700, step.kalman_mm);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(450, replay.getFrameCount());
+    TEST_ASSERT_EQUAL_UINT32(450, replay.getReliableCount());
+    TEST_ASSERT_EQUAL_UINT32(0, replay.getMissedCount());
+    TEST_ASSERT_UINT16_WITHIN(3, 1000, step.average_mm);
+    TEST_ASSERT_UINT16_WITHIN(3, 1000, step.kalman_mm);
+    // Late in the raise: 2 mm/frame x 15 Hz
+    TEST_ASSERT_INT16_WITHIN(5, 30, rampVelocity);
+}
+
+/**
+ * @test A masked zone is skipped by the replayed consensus
+ */
+void test_replay_applies_header_mask(void) {
+    uint8_t buf[FRAME_TRACE_HEADER_BYTES + FRAME_TRACE_MAX_FRAME_BYTES];
+    FrameTraceEncoder encoder;
+    encoder.reset(ZONES, 1ULL << 3);
+    size_t len = encoder.encodeHeader(buf);
+    TraceFrame frame;
+    makeFrame(frame, 1, 0, 800);
+    len += encoder.encode(frame, buf + len);
+
+    TraceReplay replay(buf, len);
+    ReplayStep step;
+    TEST_ASSERT_TRUE(replay.next(step));
+    TEST_ASSERT_TRUE(step.consensus.is_reliable);
+    TEST_ASSERT_EQUAL_UINT8(0, step.consensus.outlier_count);
+    TEST_ASSERT_UINT16_WITHIN(2, 800, step.consensus.consensus_distance_mm);
+}
+
+#ifdef NATIVE_TEST
+
+static double nowSeconds() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count() / 1e6;
+}
+
+static bool readFile(const char* path, std::vector<uint8_t>& data) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(file);
+    return true;
+}
+
+/**
+ * @test An hour of 15 Hz frames survives a file round trip and replays at
+ *       thousands of frames per second
+ */
+void test_replay_from_file_throughput(void) {
+    const uint32_t frames = 15 * 3600;
+    std::vector<uint8_t> encoded(FRAME_TRACE_HEADER_BYTES + frames * 32);
+    encoded.resize(encodeSession(encoded.data(), encoded.size(), frames));
+
+    char path[] = "/tmp/desk_trace_XXXXXX";
+    int fd = mkstemp(path);
+    TEST_ASSERT_TRUE(fd >= 0);
+    FILE* file = fdopen(fd, "wb");
+    TEST_ASSERT_EQUAL(encoded.size(), fwrite(encoded.data(), 1, encoded.size(), file));
+    fclose(file);
+
+    std::vector<uint8_t> data;
+    TEST_ASSERT_TRUE(readFile(path, data));
+    remove(path);
+    TEST_ASSERT_EQUAL(encoded.size(), data.size());
+
+    double start = nowSeconds();
+    TraceReplay replay(data.data(), data.size());
+    ReplayStep step;
+    while (replay.next(step)) {
+    }
+    double elapsed = nowSeconds() - start;
+
+    double fps = replay.getFrameCount() / elapsed;
+    printf("Replayed %lu frames (%lu bytes, %.1f bytes/frame) in %.3f s: %.0f frames/s\n",
+           (unsigned long)replay.getFrameCount(), (unsigned long)data.size(),
+           static_cast<double>(data.size()) / replay.getFrameCount(), elapsed, fps);
+    TEST_ASSERT_EQUAL_UINT32(frames, replay.getFrameCount());
+    TEST_ASSERT_FALSE(replay.isTruncated());
+    TEST_ASSERT_UINT16_WITHIN(3, 1000, step.kalman_mm);
+    TEST_ASSERT_TRUE(fps > 10000.0);
+}
+
+/**
+ * @test Replay a recorded trace given in DESK_TRACE (skipped when unset)
+ */
+void test_replay_recorded_trace(void) {
+    const char* path = getenv("DESK_TRACE");
+    if (path == nullptr) {
+        TEST_IGNORE_MESSAGE("DESK_TRACE not set");
+        return;
+    }
+
+    std::vector<uint8_t> data;
+    TEST_ASSERT_TRUE_MESSAGE(readFile(path, data), "Cannot read DESK_TRACE");
+    TraceReplay replay(data.data(), data.size());
+    TEST_ASSERT_TRUE_MESSAGE(replay.isValid(), "Not a frame trace");
+
+    ReplayStep step;
+    uint32_t firstUs = 0;
+    uint32_t lastUs = 0;
+    uint32_t outliers = 0;
+    while (replay.next(step)) {
+        if (replay.getFrameCount() == 1) {
+            firstUs = step.frame.timestamp_us;
+        }
+        lastUs = step.frame.timestamp_us;
+        outliers += step.consensus.outlier_count;
+    }
+    printf("%s: %u zones, %lu frames over %.1f s, %lu reliable, %lu missed, %lu outliers%s\n",
+           path, replay.getZones(), (unsigned long)replay.getFrameCount(),
+           (lastUs - firstUs) / 1e6, (unsigned long)replay.getReliableCount(),
+           (unsigned long)replay.getMissedCount(), (unsigned long)outliers,
+           replay.isTruncated() ? " (truncated)" : "");
+    TEST_ASSERT_TRUE(replay.getFrameCount() > 0);
+}
+
+#endif
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_varint_zigzag_round_trip);
+    RUN_TEST(test_encode_decode_round_trip);
+    RUN_TEST(test_stationary_frames_are_compact);
+    RUN_TEST(test_dropped_frame_keeps_chain);
+    RUN_TEST(test_truncated_trace);
+    RUN_TEST(test_bad_header_rejected);
+    RUN_TEST(test_replay_filters_session);
+    RUN_TEST(test_replay_applies_header_mask);
+    RUN_TEST(test_replay_from_file_throughput);
+    RUN_TEST(test_replay_recorded_trace);
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);
+    UNITY_BEGIN();
+    RUN_TEST(test_varint_zigzag_round_trip);
+    RUN_TEST(test_encode_decode_round_trip);
+    RUN_TEST(test_stationary_frames_are_compact);
+    RUN_TEST(test_dropped_frame_keeps_chain);
+    RUN_TEST(test_truncated_trace);
+    RUN_TEST(test_bad_header_rejected);
+    RUN_TEST(test_replay_filters_session);
+    RUN_TEST(test_replay_applies_header_mask);
+    UNITY_END();
+}
+
+void loop() {}
+#endif
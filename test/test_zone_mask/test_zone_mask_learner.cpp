@@ -0,0 +1,327 @@
+/**
+ * @file test_zone_mask_learner.cpp
+ * @brief Unit tests for the learned static obstruction zone mask
+ *
+ * Uses ZoneMaskLearner.h directly. The consensus helper mirrors
+ * HeightController::computeMultiZoneConsensus (mask applied before zone
+ * validation, learner fed against the median of the unmasked valid zones).
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include "utils/ZoneMaskLearner.h"
+#include "utils/MedianSelect.h"
+
+// ============================================
+// Frame model
+// ============================================
+
+template <uint8_t ZoneCount>
+struct Frame {
+    uint16_t distance_mm[ZoneCount];
+    uint8_t status[ZoneCount];
+};
+
+struct ConsensusOut {
+    uint16_t distance_mm;
+    uint8_t valid_zones;
+    uint8_t outliers;
+    bool reliable;
+};
+
+static bool isZoneValid(uint8_t status, uint16_t distance) {
+    if (status != 5 && status != 6 && status != 9) return false;
+    return distance >= SENSOR_MIN_VALID_MM && distance <= SENSOR_MAX_RANGE_MM;
+}
+
+/**
+ * @brief Median-filtered mean of unmasked zones, optionally feeding a learner
+ */
+template <uint8_t ZoneCount>
+static ConsensusOut consensus(const Frame<ZoneCount>& f, uint64_t mask,
+                              FixedZoneMaskLearner<ZoneCount>* learner = nullptr) {
+    ConsensusOut out = {0, 0, 0, false};
+    uint16_t valid[ZoneCount];
+    uint8_t n = 0;
+    for (uint8_t z = 0; z < ZoneCount; z++) {
+        if (mask & (1ULL << z)) continue;
+        if (isZoneValid(f.status[z], f.distance_mm[z])) valid[n++] = f.distance_mm[z];
+    }
+    out.valid_zones = n;
+    if (n < ZoneCount / 4) return out;
+
+    uint16_t scratch[ZoneCount];
+    for (uint8_t i = 0; i < n; i++) scratch[i] = valid[i];
+    uint16_t median = MedianSelect::lowerMedian(scratch, n);
+
+    if (learner != nullptr && learner->isActive()) {
+        for (uint8_t z = 0; z < ZoneCount; z++) {
+            bool consistent = false;
+            if (isZoneValid(f.status[z], f.distance_mm[z])) {
+                uint16_t d = f.distance_mm[z];
+                consistent = ((d >= median) ? d - median : median - d) <= MULTI_ZONE_OUTLIER_THRESHOLD_MM;
+            }
+            learner->observe(z, consistent);
+        }
+        learner->endFrame();
+    }
+
+    uint32_t sum = 0;
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        uint16_t dev = (valid[i] >= median) ? valid[i] - median : median - valid[i];
+        if (dev <= MULTI_ZONE_OUTLIER_THRESHOLD_MM) {
+            sum += valid[i];
+            kept++;
+        }
+    }
+    out.outliers = n - kept;
+    out.distance_mm = static_cast<uint16_t>(sum / kept);
+    out.reliable = true;
+    return out;
+}
+
+static uint32_t lcgState = 1;
+
+static double uniform01() {
+    lcgState = lcgState * 1103515245u + 12345u;
+    return ((lcgState >> 8) & 0xFFFFFF) / 16777216.0 + 1e-9;
+}
+
+static double gaussian() {
+    return std::sqrt(-2.0 * std::log(uniform01())) * std::cos(2.0 * M_PI * uniform01());
+}
+
+/**
+ * @brief Desk scene: floor everywhere, plus optional fixed and intermittent obstructions
+ *
+ * @param trayZones Bitmask of zones covered by a cable tray (floor - 45 mm)
+ * @param deadZones Bitmask of zones that always report an invalid status
+ * @param legZone Zone hit by a chair leg in legPercent of frames (255 = none)
+ */
+template <uint8_t ZoneCount>
+static void simulateFrame(Frame<ZoneCount>& f, uint16_t floorMm, uint64_t trayZones,
+                          uint64_t deadZones, uint8_t legZone, uint8_t legPercent) {
+    for (uint8_t z = 0; z < ZoneCount; z++) {
+        double d = floorMm + gaussian() * 4.0;
+        if (trayZones & (1ULL << z)) {
+            d = floorMm - 45.0 + gaussian() * 8.0;
+        }
+        if (z == legZone && uniform01() * 100.0 < legPercent) {
+            d = floorMm - 300.0;
+        }
+        f.distance_mm[z] = static_cast<uint16_t>(d + 0.5);
+        f.status[z] = (deadZones & (1ULL << z)) ? 255 : 5;
+    }
+}
+
+template <uint8_t ZoneCount>
+static uint64_t learn(uint64_t trayZones, uint64_t deadZones, uint8_t legZone,
+                      uint8_t legPercent, uint16_t frames) {
+    FixedZoneMaskLearner<ZoneCount> learner;
+    Frame<ZoneCount> f;
+    learner.start(frames);
+    while (learner.isActive()) {
+        simulateFrame(f, 700, trayZones, deadZones, legZone, legPercent);
+        consensus(f, 0, &learner);
+    }
+    return learner.computeMask(ZONE_MASK_INCONSISTENT_PERCENT, ZoneCount / 2);
+}
+
+/**
+ * @brief 64-bit mask compare (Unity's 64-bit asserts are not enabled in this build)
+ */
+static void assertMask(uint64_t expected, uint64_t actual) {
+    char msg[64];
+    snprintf(msg, sizeof(msg), "expected 0x%016llX, got 0x%016llX",
+             (unsigned long long)expected, (unsigned long long)actual);
+    TEST_ASSERT_TRUE_MESSAGE(expected == actual, msg);
+}
+
+void setUp(void) {
+    lcgState = 1;
+}
+
+void tearDown(void) {}
+
+// ============================================
+// Tests
+// ============================================
+
+/**
+ * @test Run ends after the requested frame count
+ */
+void test_learner_frame_counting(void) {
+    ZoneMaskLearner learner;
+    TEST_ASSERT_FALSE(learner.isActive());
+    TEST_ASSERT_FALSE(learner.isComplete());
+
+    learner.start(3);
+    TEST_ASSERT_TRUE(learner.isActive());
+    TEST_ASSERT_FALSE(learner.endFrame());
+    TEST_ASSERT_FALSE(learner.endFrame());
+    TEST_ASSERT_TRUE(learner.endFrame());
+    TEST_ASSERT_FALSE(learner.isActive());
+    TEST_ASSERT_TRUE(learner.isComplete());
+    TEST_ASSERT_EQUAL_UINT16(3, learner.getFramesObserved());
+
+    // Further frames are ignored once complete
+    TEST_ASSERT_FALSE(learner.endFrame());
+    TEST_ASSERT_EQUAL_UINT16(3, learner.getFramesObserved());
+}
+
+/**
+ * @test Cancelled run is not complete and restarting clears counters
+ */
+void test_learner_cancel_and_restart(void) {
+    ZoneMaskLearner learner;
+    learner.start(10);
+    learner.observe(2, false);
+    learner.endFrame();
+    learner.cancel();
+    TEST_ASSERT_FALSE(learner.isActive());
+    TEST_ASSERT_FALSE(learner.isComplete());
+
+    learner.start(10);
+    TEST_ASSERT_EQUAL_UINT16(0, learner.getInconsistentCount(2));
+    TEST_ASSERT_EQUAL_UINT16(0, learner.getFramesObserved());
+}
+
+/**
+ * @test Threshold is inclusive and computed on observed frames
+ */
+void test_learner_threshold(void) {
+    FixedZoneMaskLearner<16> learner;
+    learner.start(10);
+    for (uint8_t frame = 0; frame < 10; frame++) {
+        learner.observe(0, false);                 // 100%
+        learner.observe(1, frame == 0);            // 90%
+        learner.observe(2, frame < 2);             // 80%
+        learner.endFrame();
+    }
+    uint64_t mask = learner.computeMask(90, 8);
+    TEST_ASSERT_TRUE(mask & (1ULL << 0));
+    TEST_ASSERT_TRUE(mask & (1ULL << 1));
+    TEST_ASSERT_FALSE(mask & (1ULL << 2));
+    TEST_ASSERT_EQUAL_UINT8(2, FixedZoneMaskLearner<16>::countMasked(mask));
+}
+
+/**
+ * @test Cable tray and dead zones are masked, floor and chair leg are not
+ */
+void test_static_obstructions_masked(void) {
+    const uint64_t tray = (1ULL << 0) | (1ULL << 1) | (1ULL << 4);
+    const uint64_t dead = (1ULL << 15);
+    uint64_t mask = learn<16>(tray, dead, 10, 40, ZONE_MASK_LEARN_FRAMES);
+
+    assertMask(tray | dead, mask);
+}
+
+/**
+ * @test Mask never takes more than half the grid; worst zones win
+ */
+void test_mask_capped_to_half_grid(void) {
+    FixedZoneMaskLearner<16> learner;
+    learner.start(100);
+    for (uint8_t frame = 0; frame < 100; frame++) {
+        // Zones 0-11 always bad; zones 0-3 additionally count once more early on
+        for (uint8_t z = 0; z < 12; z++) {
+            learner.observe(z, (z >= 4) && frame == 0);
+        }
+        learner.endFrame();
+    }
+    uint64_t mask = learner.computeMask(90, 8);
+    TEST_ASSERT_EQUAL_UINT8(8, FixedZoneMaskLearner<16>::countMasked(mask));
+    assertMask(0x0F, mask & 0x0F);  // The four worst stay masked
+}
+
+/**
+ * @test Learning works on the 8x8 grid (bits above 31)
+ */
+void test_mask_8x8_high_zones(void) {
+    const uint64_t tray = (1ULL << 40) | (1ULL << 41) | (1ULL << 48) | (1ULL << 63);
+    uint64_t mask = learn<64>(tray, 0, 255, 0, ZONE_MASK_LEARN_FRAMES);
+    assertMask(tray, mask);
+}
+
+/**
+ * @test Masking a near-floor tray removes its bias and the per-frame rejections
+ *
+ * A tray 45 mm above the floor is close enough that a few noisy tray samples
+ * slip under the 30 mm outlier threshold and pull the mean up. With the
+ * learned mask the consensus uses floor zones only.
+ */
+void test_mask_stabilizes_consensus(void) {
+    const uint64_t tray = (1ULL << 0) | (1ULL << 1) | (1ULL << 4) | (1ULL << 5) | (1ULL << 8);
+    uint64_t mask = learn<16>(tray, 0, 255, 0, ZONE_MASK_LEARN_FRAMES);
+    assertMask(tray, mask);
+
+    lcgState = 7;
+    Frame<16> f;
+    double errOpen = 0, errMasked = 0;
+    uint32_t outliersOpen = 0, outliersMasked = 0, validatedOpen = 0, validatedMasked = 0;
+    const uint32_t frames = 2000;
+    for (uint32_t i = 0; i < frames; i++) {
+        simulateFrame(f, 700, tray, 0, 255, 0);
+        ConsensusOut open = consensus(f, 0);
+        ConsensusOut masked = consensus(f, mask);
+        errOpen += std::fabs(open.distance_mm - 700.0);
+        errMasked += std::fabs(masked.distance_mm - 700.0);
+        outliersOpen += open.outliers;
+        outliersMasked += masked.outliers;
+        validatedOpen += open.valid_zones;
+        validatedMasked += masked.valid_zones;
+    }
+
+    char msg[160];
+    snprintf(msg, sizeof(msg),
+             "mean abs error %.2f -> %.2f mm, outliers/frame %.2f -> %.2f, zones validated/frame %.1f -> %.1f",
+             errOpen / frames, errMasked / frames,
+             (double)outliersOpen / frames, (double)outliersMasked / frames,
+             (double)validatedOpen / frames, (double)validatedMasked / frames);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_TRUE(errMasked < errOpen * 0.75);
+    TEST_ASSERT_TRUE(outliersMasked < outliersOpen / 10 + 1);
+    TEST_ASSERT_TRUE(validatedMasked < validatedOpen);
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_learner_frame_counting);
+    RUN_TEST(test_learner_cancel_and_restart);
+    RUN_TEST(test_learner_threshold);
+    RUN_TEST(test_static_obstructions_masked);
+    RUN_TEST(test_mask_capped_to_half_grid);
+    RUN_TEST(test_mask_8x8_high_zones);
+    RUN_TEST(test_mask_stabilizes_consensus);
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);
+    UNITY_BEGIN();
+    RUN_TEST(test_learner_frame_counting);
+    RUN_TEST(test_learner_cancel_and_restart);
+    RUN_TEST(test_learner_threshold);
+    RUN_TEST(test_static_obstructions_masked);
+    RUN_TEST(test_mask_capped_to_half_grid);
+    RUN_TEST(test_mask_8x8_high_zones);
+    RUN_TEST(test_mask_stabilizes_consensus);
+    UNITY_END();
+}
+
+void loop() {}
+#endif
@@ -0,0 +1,366 @@
+/**
+ * @file test_zone_temporal_filter.cpp
+ * @brief Unit tests for the per-zone temporal filter ahead of the consensus
+ *
+ * Uses ZoneTemporalFilter.h and ZoneConsensus::fromZones() directly, in the
+ * order HeightController::processFrame() runs them with
+ * {"zoneFilter":"exponential"}.
+ */
+
+#ifdef NATIVE_TEST
+#include <ArduinoFake.h>
+using namespace fakeit;
+#include <chrono>
+#else
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include "utils/ZoneTemporalFilter.h"
+#include "utils/ZoneConsensus.h"
+
+static const uint8_t VALID = 5;
+static const uint8_t NO_TARGET = 255;
+
+// ============================================
+// Helpers
+// ============================================
+
+template <uint8_t ZoneCount>
+static void fill(uint8_t* status, int16_t* distance, int16_t mm) {
+    for (uint8_t z = 0; z < ZoneCount; z++) {
+        status[z] = VALID;
+        distance[z] = mm;
+    }
+}
+
+static unsigned long nowMicros() {
+#ifdef NATIVE_TEST
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#else
+    return micros();
+#endif
+}
+
+/// Deterministic uniform noise in [-range, range]
+static int16_t noise(uint32_t& seed, int16_t range) {
+    seed = seed * 1103515245u + 12345u;
+    return static_cast<int16_t>((seed >> 16) % (2 * range + 1)) - range;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================
+// Kernel
+// ============================================
+
+/**
+ * @test A zone's first valid reading is output as is
+ */
+void test_first_frame_passes_through(void) {
+    FixedZoneTemporalFilter<16> filter(1, 3);
+    uint8_t status[16];
+    int16_t distance[16];
+    fill<16>(status, distance, 800);
+    distance[3] = 812;
+
+    filter.apply(status, distance);
+
+    TEST_ASSERT_EQUAL_INT16(800, distance[0]);
+    TEST_ASSERT_EQUAL_INT16(812, distance[3]);
+    TEST_ASSERT_EQUAL_UINT16(812, filter.getEstimate(3));
+    TEST_ASSERT_EQUAL_UINT8(0, filter.getBridgedCount());
+}
+
+/**
+ * @test Small steps are smoothed with alpha = 1/2^shift and converge
+ */
+void test_exponential_smoothing(void) {
+    FixedZoneTemporalFilter<16> filter(1, 3);
+    uint8_t status[16];
+    int16_t distance[16];
+    fill<16>(status, distance, 800);
+    filter.apply(status, distance);
+
+    fill<16>(status, distance, 820);
+    filter.apply(status, distance);
+    TEST_ASSERT_EQUAL_INT16(810, distance[0]);
+
+    fill<16>(status, distance, 820);
+    filter.apply(status, distance);
+    TEST_ASSERT_EQUAL_INT16(815, distance[0]);
+
+    for (int i = 0; i < 20; i++) {
+        fill<16>(status, distance, 820);
+        filter.apply(status, distance);
+    }
+    TEST_ASSERT_EQUAL_INT16(820, distance[0]);
+
+    // Shift 0 is a pass-through
+    FixedZoneTemporalFilter<16> passThrough(0, 3);
+    fill<16>(status, distance, 800);
+    passThrough.apply(status, distance);
+    fill<16>(status, distance, 820);
+    passThrough.apply(status, distance);
+    TEST_ASSERT_EQUAL_INT16(820, distance[0]);
+}
+
+/**
+ * @test A step beyond the outlier threshold restarts the zone (obstacle is not smeared)
+ */
+void test_jump_restarts_zone(void) {
+    FixedZoneTemporalFilter<16> filter(1, 3);
+    uint8_t status[16];
+    int16_t distance[16];
+    fill<16>(status, distance, 800);
+    filter.apply(status, distance);
+
+    fill<16>(status, distance, 800);
+    distance[5] = 800 - MULTI_ZONE_OUTLIER_THRESHOLD_MM - 200;  // chair leg
+    filter.apply(status, distance);
+
+    TEST_ASSERT_EQUAL_INT16(800 - MULTI_ZONE_OUTLIER_THRESHOLD_MM - 200, distance[5]);
+    TEST_ASSERT_EQUAL_INT16(800, distance[4]);
+}
+
+/**
+ * @test Dropouts are bridged for holdFrames frames with the estimate, then passed through
+ */
+void test_dropout_bridged_for_hold_frames(void) {
+    FixedZoneTemporalFilter<16> filter(1, 3);
+    uint8_t status[16];
+    int16_t distance[16];
+    fill<16>(status, distance, 800);
+    distance[7] = 806;
+    filter.apply(status, distance);
+
+    for (uint8_t frame = 1; frame <= 3; frame++) {
+        fill<16>(status, distance, 800);
+        status[7] = NO_TARGET;
+        distance[7] = 0;
+        filter.apply(status, distance);
+
+        TEST_ASSERT_EQUAL_UINT8(VALID, status[7]);
+        TEST_ASSERT_EQUAL_INT16(806, distance[7]);
+        TEST_ASSERT_EQUAL_UINT8(1, filter.getBridgedCount());
+        TEST_ASSERT_TRUE(filter.getBridgedMask() == (1ULL << 7));
+    }
+
+    fill<16>(status, distance, 800);
+    status[7] = NO_TARGET;
+    distance[7] = 0;
+    filter.apply(status, distance);
+    TEST_ASSERT_EQUAL_UINT8(NO_TARGET, status[7]);
+    TEST_ASSERT_EQUAL_INT16(0, distance[7]);
+    TEST_ASSERT_EQUAL_UINT8(0, filter.getBridgedCount());
+
+    // Back after the bridge expired: restarts from the new reading
+    fill<16>(status, distance, 800);
+    distance[7] = 790;
+    filter.apply(status, distance);
+    TEST_ASSERT_EQUAL_INT16(790, distance[7]);
+}
+
+/**
+ * @test Zones that never were valid are left alone; reset() forgets estimates
+ */
+void test_never_valid_and_reset(void) {
+    FixedZoneTemporalFilter<16> filter(1, 3);
+    uint8_t status[16];
+    int16_t distance[16];
+    fill<16>(status, distance, 800);
+    status[0] = NO_TARGET;
+    distance[0] = 4;
+    filter.apply(status, distance);
+    TEST_ASSERT_EQUAL_UINT8(NO_TARGET, status[0]);
+    TEST_ASSERT_EQUAL_INT16(4, distance[0]);
+    TEST_ASSERT_EQUAL_UINT16(0, filter.getEstimate(0));
+
+    filter.reset();
+    fill<16>(status, distance, 800);
+    status[1] = NO_TARGET;
+    filter.apply(status, distance);
+    TEST_ASSERT_EQUAL_UINT8(NO_TARGET, status[1]);
+    TEST_ASSERT_EQUAL_UINT8(0, filter.getBridgedCount());
+}
+
+/**
+ * @test Bridged zones get their last valid sigma, valid zones keep theirs
+ */
+void test_sigma_bridged(void) {
+    FixedZoneTemporalFilter<16> filter(1, 3);
+    uint8_t status[16];
+    int16_t distance[16];
+    uint16_t sigma[16];
+    fill<16>(status, distance, 800);
+    for (uint8_t z = 0; z < 16; z++) sigma[z] = 3;
+    sigma[2] = 5;
+    filter.apply(status, distance, sigma);
+
+    fill<16>(status, distance, 800);
+    status[2] = NO_TARGET;
+    for (uint8_t z = 0; z < 16; z++) sigma[z] = 4;
+    sigma[2] = 0;
+    filter.apply(status, distance, sigma);
+
+    TEST_ASSERT_EQUAL_UINT16(5, sigma[2]);
+    TEST_ASSERT_EQUAL_UINT16(4, sigma[3]);
+}
+
+/**
+ * @test 8x8 grid: high zones are tracked and bridged like low ones
+ */
+void test_8x8_high_zones(void) {
+    FixedZoneTemporalFilter<64> filter(1, 3);
+    uint8_t status[64];
+    int16_t distance[64];
+    fill<64>(status, distance, 900);
+    filter.apply(status, distance);
+
+    fill<64>(status, distance, 900);
+    status[63] = NO_TARGET;
+    status[40] = NO_TARGET;
+    filter.apply(status, distance);
+
+    TEST_ASSERT_TRUE(filter.getBridgedMask() == ((1ULL << 63) | (1ULL << 40)));
+    TEST_ASSERT_EQUAL_INT16(900, distance[63]);
+}
+
+// ============================================
+// Pipeline
+// ============================================
+
+/**
+ * @test Flickering zones on an uneven floor: consensus step noise drops
+ *
+ * Floor offsets of up to ±12 mm per zone, ±3 mm noise, and a quarter of
+ * the zones valid only half the time. Without the filter the set of
+ * zones behind the mean changes every frame; with it the set is stable
+ * and the per-zone noise is halved.
+ */
+void test_flicker_step_noise_reduced(void) {
+    const uint8_t zones = 16;
+    const int16_t floorOffset[zones] = {-12, -8, -4, 0, 4, 8, 12, -10, 10, -6, 6, -2, 2, 0, 9, -9};
+    ZoneTemporalFilter filter;
+    uint32_t seed = 7;
+
+    double sumSqRaw = 0.0;
+    double sumSqFiltered = 0.0;
+    int prevRaw = -1;
+    int prevFiltered = -1;
+    const int frames = 2000;
+    for (int f = 0; f < frames; f++) {
+        uint8_t status[zones];
+        int16_t distance[zones];
+        for (uint8_t z = 0; z < zones; z++) {
+            status[z] = VALID;
+            distance[z] = 800 + floorOffset[z] + noise(seed, 3);
+            if ((z % 4) == 0 && (noise(seed, 1) > 0)) {
+                status[z] = NO_TARGET;
+            }
+        }
+
+        ConsensusResult raw = ZoneConsensus::fromZones(status, distance, zones);
+        filter.apply(status, distance);
+        ConsensusResult filtered = ZoneConsensus::fromZones(status, distance, zones);
+        TEST_ASSERT_TRUE(raw.is_reliable);
+        TEST_ASSERT_TRUE(filtered.is_reliable);
+
+        if (f > 10) {
+            double dRaw = raw.consensus_distance_mm - prevRaw;
+            double dFiltered = filtered.consensus_distance_mm - prevFiltered;
+            sumSqRaw += dRaw * dRaw;
+            sumSqFiltered += dFiltered * dFiltered;
+        }
+        prevRaw = raw.consensus_distance_mm;
+        prevFiltered = filtered.consensus_distance_mm;
+    }
+
+    double rmsRaw = sqrt(sumSqRaw / (frames - 11));
+    double rmsFiltered = sqrt(sumSqFiltered / (frames - 11));
+    char msg[96];
+    snprintf(msg, sizeof(msg), "frame-to-frame consensus step RMS: %.2f -> %.2f mm",
+             rmsRaw, rmsFiltered);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_TRUE(rmsFiltered < rmsRaw * 0.6);
+}
+
+/**
+ * @test Kernel cost per frame against the consensus it feeds
+ *
+ * The filter is a few linear passes over the zones; the consensus does a
+ * median selection. Asserts the filter stays cheaper at 64 zones.
+ */
+void test_benchmark_per_frame_cost(void) {
+    const uint32_t frames = 20000;
+    FixedZoneTemporalFilter<64> filter(1, 3);
+    uint8_t status[64];
+    int16_t distance[64];
+    uint32_t seed = 3;
+    volatile uint32_t sink = 0;
+
+    unsigned long filterUs = 0;
+    unsigned long consensusUs = 0;
+    for (uint32_t f = 0; f < frames; f++) {
+        for (uint8_t z = 0; z < 64; z++) {
+            status[z] = (noise(seed, 10) == 0) ? NO_TARGET : VALID;
+            distance[z] = 800 + noise(seed, 5);
+        }
+        unsigned long t0 = nowMicros();
+        filter.apply(status, distance);
+        unsigned long t1 = nowMicros();
+        ConsensusResult result = ZoneConsensus::fromZones(status, distance, 64);
+        unsigned long t2 = nowMicros();
+        sink += result.consensus_distance_mm;
+        filterUs += t1 - t0;
+        consensusUs += t2 - t1;
+    }
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "64 zones: filter %.0f ns/frame, consensus %.0f ns/frame",
+             filterUs * 1000.0 / frames, consensusUs * 1000.0 / frames);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_TRUE(filterUs <= consensusUs);
+}
+
+// ============================================
+// Test Runner
+// ============================================
+
+#ifdef NATIVE_TEST
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_frame_passes_through);
+    RUN_TEST(test_exponential_smoothing);
+    RUN_TEST(test_jump_restarts_zone);
+    RUN_TEST(test_dropout_bridged_for_hold_frames);
+    RUN_TEST(test_never_valid_and_reset);
+    RUN_TEST(test_sigma_bridged);
+    RUN_TEST(test_8x8_high_zones);
+    RUN_TEST(test_flicker_step_noise_reduced);
+    RUN_TEST(test_benchmark_per_frame_cost);
+    return UNITY_END();
+}
+#else
+void setup() {
+    delay(2000);
+    UNITY_BEGIN();
+    RUN_TEST(test_first_frame_passes_through);
+    RUN_TEST(test_exponential_smoothing);
+    RUN_TEST(test_jump_restarts_zone);
+    RUN_TEST(test_dropout_bridged_for_hold_frames);
+    RUN_TEST(test_never_valid_and_reset);
+    RUN_TEST(test_sigma_bridged);
+    RUN_TEST(test_8x8_high_zones);
+    RUN_TEST(test_flicker_step_noise_reduced);
+    RUN_TEST(test_benchmark_per_frame_cost);
+    UNITY_END();
+}
+
+void loop() {}
+#endif